@@ -0,0 +1,108 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "Animator.h"
+
+
+// ---- Class Implementation ----
+
+Animator::Animator()
+{
+}
+
+void Animator::Start(Type type, int tileIdx, double now, double duration, bool hold)
+{
+	Animation animation;
+	animation.type = type;
+	animation.tileIdx = tileIdx;
+	animation.startTime = now;
+	animation.duration = duration;
+	animation.hold = hold;
+
+	m_changed = true;
+
+	for (Animation& other : m_animations)
+	{
+		if ((other.type == type) && (other.tileIdx == tileIdx))
+		{
+			other = animation;
+			return;
+		}
+	}
+
+	m_animations.push_back(animation);
+}
+
+void Animator::Clear()
+{
+	if (!m_animations.empty())
+		m_changed = true;
+
+	m_animations.clear();
+}
+
+bool Animator::Update(double now)
+{
+	bool changed(m_changed);
+	m_changed = false;
+
+	// Drop whatever was over already, unless it is held at its last frame.
+	for (auto iter = m_animations.begin(); iter != m_animations.end();)
+	{
+		if ((iter->progress >= 1.0f) && !iter->hold)
+		{
+			iter = m_animations.erase(iter);
+			changed = true;
+		}
+		else
+			++iter;
+	}
+
+	for (Animation& animation : m_animations)
+	{
+		float progress(1.0f);
+		if (animation.duration > 0.0)
+			progress = juce::jlimit(0.0f, 1.0f, static_cast<float>((now - animation.startTime) / animation.duration));
+
+		if (progress != animation.progress)
+		{
+			animation.progress = progress;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+const std::vector<Animator::Animation>& Animator::GetAnimations() const
+{
+	return m_animations;
+}
@@ -0,0 +1,136 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+// ---- Class Definition ----
+
+/**
+ * Keeps track of the transient effects on the window, such as explosions and spills. 
+ * Each animation has a start time and a duration, and is moved on by the clock (see Update()),
+ * never by painting: painting only reads the progress of each animation, and may happen 
+ * as often or as rarely as the OS likes, on any thread, without changing what comes next.
+ */
+class Animator
+{
+public:
+	/**
+	 * Kinds of animations.
+	 */
+	enum Type
+	{
+		ANIM_EXPLOSION = 0,
+		ANIM_SPILL,
+		ANIM_FLASH
+	};
+
+	/**
+	 * A running animation.
+	 */
+	struct Animation
+	{
+		Type type = ANIM_EXPLOSION;
+
+		/**
+		 * Index of the board tile the animation is on, i.e. col + (row * numCols). -1 if none.
+		 */
+		int tileIdx = -1;
+
+		/**
+		 * Start time and duration, in milliseconds.
+		 */
+		double startTime = 0.0;
+		double duration = 0.0;
+
+		/**
+		 * If true, the animation stays at its last frame once it is over, until it is stopped. 
+		 * Otherwise, it is removed.
+		 */
+		bool hold = false;
+
+		/**
+		 * How far the animation has run as of the last Update(), from 0 to 1.
+		 */
+		float progress = 0.0f;
+	};
+
+	/**
+	 * Class constructor.
+	 */
+	Animator();
+
+	/**
+	 * Start an animation. If one of the same type is already running on the same tile, it starts over.
+	 *
+	 * @param type		Kind of animation.
+	 * @param tileIdx	Index of the board tile to animate, or -1 if none.
+	 * @param now		Current time, in milliseconds, see juce::Time::getMillisecondCounterHiRes().
+	 * @param duration	Duration of the animation, in milliseconds.
+	 * @param hold		See Animation::hold.
+	 */
+	void Start(Type type, int tileIdx, double now, double duration, bool hold = false);
+
+	/**
+	 * Stop all animations, e.g. when a new round starts.
+	 */
+	void Clear();
+
+	/**
+	 * Move all animations on to the given time. Animations which were over at the previous call are removed,
+	 * so that their last frame, which normally shows nothing, gets drawn once.
+	 *
+	 * @param now		Current time, in milliseconds, see juce::Time::getMillisecondCounterHiRes().
+	 * @return	True if anything moved, or was removed, since the last call.
+	 */
+	bool Update(double now);
+
+	/**
+	 * Get all animations, as of the last call to Update(). 
+	 */
+	const std::vector<Animation>& GetAnimations() const;
+
+private:
+	/**
+	 * Animations which are running, or are over and held.
+	 */
+	std::vector<Animation> m_animations;
+
+	/**
+	 * True if animations were started or stopped since the last Update().
+	 */
+	bool m_changed = false;
+
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Animator)
+};
@@ -0,0 +1,112 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "AutoPlayer.h"
+
+
+// ---- Helper types and constants ----
+
+const int AutoPlayer::MOVE_TIME_BUDGET(20);
+
+
+// ---- Class Implementation ----
+
+AutoPlayer::AutoPlayer()
+	:	juce::Thread("AutoPlayer")
+{
+
+}
+
+AutoPlayer::~AutoPlayer()
+{
+	stopThread(2000);
+}
+
+void AutoPlayer::run()
+{
+	while (!threadShouldExit())
+	{
+		Planner::Situation situation;
+		bool search(false);
+		{
+			const juce::ScopedLock lock(m_lock);
+			if (m_requestPending)
+			{
+				situation = m_situation;
+				m_requestPending = false;
+				search = true;
+			}
+		}
+
+		if (search)
+		{
+			Planner planner(situation);
+			Planner::Move move = planner.FindMove(std::chrono::milliseconds(MOVE_TIME_BUDGET));
+
+			const juce::ScopedLock lock(m_lock);
+
+			// Only hand over the result if no newer situation came in meanwhile.
+			if (!m_requestPending)
+			{
+				m_move = move;
+				m_moveReady = true;
+			}
+		}
+
+		// Stop the AutoPlayer until RequestMove() calls notify().
+		else
+			wait(-1);
+	}
+}
+
+void AutoPlayer::RequestMove(const Planner::Situation& situation)
+{
+	{
+		const juce::ScopedLock lock(m_lock);
+		m_situation = situation;
+		m_requestPending = true;
+		m_moveReady = false;
+	}
+
+	notify();
+}
+
+bool AutoPlayer::PopMove(Planner::Move& move)
+{
+	const juce::ScopedLock lock(m_lock);
+	if (!m_moveReady)
+		return false;
+
+	move = m_move;
+	m_moveReady = false;
+
+	return true;
+}
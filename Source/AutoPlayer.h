@@ -0,0 +1,113 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Planner.h"
+
+
+// ---- Class Definition ----
+
+/**
+ * Bot which plays the game during the attract mode. The decision of where to place the next pipe
+ * is taken by a Planner running on this dedicated thread, so that the GUI stays smooth.
+ * The MainComponent hands over the current game situation with RequestMove(), and later
+ * picks up the result with PopMove() on the message thread.
+ */
+class AutoPlayer : public juce::Thread
+{
+public:
+	/**
+	 * Maximum time the Planner is given to decide on a move, in milliseconds.
+	 */
+	static const int MOVE_TIME_BUDGET;
+
+	/**
+	 * Class constructor.
+	 */
+	AutoPlayer();
+
+	/**
+	 * Class destructor. Stops the thread.
+	 */
+	~AutoPlayer() override;
+
+	/**
+	 * Reimplemented from juce::Thread.
+	 */
+	void run() override;
+
+	/**
+	 * Wake up the AutoPlayer to search for a move in the given situation.
+	 * Any move found for a previous situation, but not picked up yet, is discarded.
+	 *
+	 * @param situation	Copy of the current game situation.
+	 */
+	void RequestMove(const Planner::Situation& situation);
+
+	/**
+	 * Pick up the move found for the last requested situation, if the search is done.
+	 *
+	 * @param move	Will be set to the move found.
+	 * @return	True if a move was available.
+	 */
+	bool PopMove(Planner::Move& move);
+
+private:
+	/**
+	 * Protects m_situation, m_move and the flags below.
+	 */
+	juce::CriticalSection m_lock;
+
+	/**
+	 * Situation for which a move was requested.
+	 */
+	Planner::Situation m_situation;
+
+	/**
+	 * Best move found for m_situation.
+	 */
+	Planner::Move m_move;
+
+	/**
+	 * True if RequestMove() was called and the search has not started yet.
+	 */
+	bool m_requestPending = false;
+
+	/**
+	 * True if m_move is ready to be picked up by PopMove().
+	 */
+	bool m_moveReady = false;
+
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AutoPlayer)
+};
@@ -0,0 +1,274 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "BatchSimulator.h"
+#include "Board.h"
+#include "Queue.h"
+#include "Randomizer.h"
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define BATCH_KERNEL_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#include <emmintrin.h>
+	#define BATCH_KERNEL_SSE2 1
+#endif
+
+
+// ---- Helper types and constants ----
+
+/**
+ * Number of games advanced at once by the kernel in Tick().
+ */
+#if defined(BATCH_KERNEL_AVX2)
+static const int SIMD_WIDTH(8);
+#elif defined(BATCH_KERNEL_SSE2)
+static const int SIMD_WIDTH(4);
+#else
+static const int SIMD_WIDTH(1);
+#endif
+
+/**
+ * Pump rate and countdown of the first level.
+ */
+static const int DEFAULT_OOZE_PER_PUMP(1 * OOZE_PER_PERCENT);
+static const int DEFAULT_COUNTDOWN(320);
+
+
+// ---- Class Implementation ----
+
+BatchSimulator::Game::Game(unsigned int seed, int numCols, int numRows, int queueSize)
+	: randomizer(new Randomizer(seed)),
+	board(new Board(numCols, numRows, randomizer.get())),
+	queue(new Queue(queueSize, randomizer.get()))
+{
+
+}
+
+BatchSimulator::Game::~Game()
+{
+	// Board and Queue hold on to the Randomizer, delete them first.
+	queue.reset();
+	board.reset();
+}
+
+BatchSimulator::BatchSimulator(int numGames, int numCols, int numRows, int queueSize)
+	: m_numAlive(0)
+{
+	int paddedSize = ((numGames + SIMD_WIDTH - 1) / SIMD_WIDTH) * SIMD_WIDTH;
+	m_levels.resize(paddedSize, MIN_OOZE_LEVEL);
+	m_rates.resize(paddedSize, 0);
+	m_countdowns.resize(paddedSize, 0);
+	m_scores.resize(paddedSize, 0);
+	m_aliveMasks.resize(paddedSize, 0);
+
+	m_games.reserve(numGames);
+	for (int i = 0; i < numGames; i++)
+	{
+		m_games.emplace_back(new Game(static_cast<unsigned int>(i), numCols, numRows, queueSize));
+		Reset(i, static_cast<unsigned int>(i), DEFAULT_OOZE_PER_PUMP, DEFAULT_COUNTDOWN);
+	}
+}
+
+BatchSimulator::~BatchSimulator()
+{
+
+}
+
+const char* BatchSimulator::GetKernelName()
+{
+#if defined(BATCH_KERNEL_AVX2)
+	return "AVX2";
+#elif defined(BATCH_KERNEL_SSE2)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
+
+int BatchSimulator::GetNumGames() const
+{
+	return static_cast<int>(m_games.size());
+}
+
+int BatchSimulator::GetNumAlive() const
+{
+	return m_numAlive;
+}
+
+void BatchSimulator::Reset(int game, unsigned int seed, int oozePerPump, int countdown)
+{
+	Game& g = *m_games[game];
+	g.randomizer->SetSeed(seed);
+	g.board->Reset();
+	g.queue->Reset();
+
+	if (m_aliveMasks[game] == 0)
+		m_numAlive++;
+
+	m_levels[game] = MIN_OOZE_LEVEL;
+	m_rates[game] = oozePerPump;
+	m_countdowns[game] = countdown;
+	m_scores[game] = 0;
+	m_aliveMasks[game] = ~0;
+}
+
+int BatchSimulator::Tick(int numTicks)
+{
+	int paddedSize = static_cast<int>(m_levels.size());
+	int* levels = m_levels.data();
+	const int* rates = m_rates.data();
+	int* countdowns = m_countdowns.data();
+	const int* aliveMasks = m_aliveMasks.data();
+
+	for (int tick = 0; (tick < numTicks) && (m_numAlive > 0); tick++)
+	{
+		for (int i = 0; i < paddedSize; i += SIMD_WIDTH)
+		{
+			// Games still counting down only decrement their countdown, all others pump.
+			// Bit i of fullMask is set for games whose pipe is full after this tick.
+#if defined(BATCH_KERNEL_AVX2)
+			__m256i alive = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aliveMasks + i));
+			__m256i countdown = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(countdowns + i));
+			__m256i waiting = _mm256_and_si256(_mm256_cmpgt_epi32(countdown, _mm256_setzero_si256()), alive);
+			countdown = _mm256_add_epi32(countdown, waiting);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(countdowns + i), countdown);
+
+			__m256i pumping = _mm256_andnot_si256(waiting, alive);
+			__m256i rate = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(rates + i)), pumping);
+			__m256i level = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(levels + i)), rate);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(levels + i), level);
+
+			__m256i full = _mm256_and_si256(_mm256_cmpgt_epi32(level, _mm256_set1_epi32(MAX_OOZE_LEVEL - 1)), pumping);
+			int fullMask = _mm256_movemask_ps(_mm256_castsi256_ps(full));
+#elif defined(BATCH_KERNEL_SSE2)
+			__m128i alive = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aliveMasks + i));
+			__m128i countdown = _mm_loadu_si128(reinterpret_cast<const __m128i*>(countdowns + i));
+			__m128i waiting = _mm_and_si128(_mm_cmpgt_epi32(countdown, _mm_setzero_si128()), alive);
+			countdown = _mm_add_epi32(countdown, waiting);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(countdowns + i), countdown);
+
+			__m128i pumping = _mm_andnot_si128(waiting, alive);
+			__m128i rate = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rates + i)), pumping);
+			__m128i level = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(levels + i)), rate);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(levels + i), level);
+
+			__m128i full = _mm_and_si128(_mm_cmpgt_epi32(level, _mm_set1_epi32(MAX_OOZE_LEVEL - 1)), pumping);
+			int fullMask = _mm_movemask_ps(_mm_castsi128_ps(full));
+#else
+			int fullMask(0);
+			if (aliveMasks[i] != 0)
+			{
+				if (countdowns[i] > 0)
+					countdowns[i]--;
+				else
+				{
+					levels[i] += rates[i];
+					if (levels[i] >= MAX_OOZE_LEVEL)
+						fullMask = 1;
+				}
+			}
+#endif
+
+			// Scalar path, only for the games whose pipe just filled up.
+			while (fullMask != 0)
+			{
+				int lane = 0;
+				while ((fullMask & (1 << lane)) == 0)
+					lane++;
+
+				fullMask &= ~(1 << lane);
+				Transition(i + lane);
+			}
+		}
+	}
+
+	return m_numAlive;
+}
+
+void BatchSimulator::Stop(int game)
+{
+	if (m_aliveMasks[game] != 0)
+	{
+		m_aliveMasks[game] = 0;
+		m_numAlive--;
+	}
+}
+
+void BatchSimulator::Transition(int game)
+{
+	Board* board = m_games[game]->board.get();
+
+	// The pipe on the Board is still empty, so it ends up with the exact accumulated level.
+	// The Board's clock moves on by the ticks it took, so that delayed starter tiles release their ooze on time.
+	int numPumps = (m_levels[game] - MIN_OOZE_LEVEL) / m_rates[game];
+	bool contained = board->Pump(m_levels[game], numPumps);
+	m_scores[game] = board->GetScoreValue();
+
+	// The ooze always enters the next pipe with an empty way.
+	m_levels[game] = MIN_OOZE_LEVEL;
+
+	if (!contained)
+	{
+		m_aliveMasks[game] = 0;
+		m_numAlive--;
+	}
+}
+
+Board* BatchSimulator::GetBoard(int game) const
+{
+	return m_games[game]->board.get();
+}
+
+Queue* BatchSimulator::GetQueue(int game) const
+{
+	return m_games[game]->queue.get();
+}
+
+bool BatchSimulator::IsAlive(int game) const
+{
+	return (m_aliveMasks[game] != 0);
+}
+
+int BatchSimulator::GetScore(int game) const
+{
+	return m_scores[game];
+}
+
+int BatchSimulator::GetCountdown(int game) const
+{
+	return m_countdowns[game];
+}
+
+int BatchSimulator::GetOozeLevel(int game) const
+{
+	return m_levels[game];
+}
@@ -0,0 +1,168 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <vector>
+#include <memory>
+
+
+// ---- Forward declarations ----
+
+class Board;
+class Queue;
+class Randomizer;
+
+
+// ---- Class Definition ----
+
+/**
+ * Engine which simulates thousands of independent rounds at once, e.g. for balance sweeps.
+ *
+ * Most ticks of a round only add the pump rate to the ooze level of one pipe, and count down until the ooze
+ * starts flowing. Therefore the oozing pipe's level, the pump rate, the countdown and the score of all games are
+ * kept in struct-of-arrays form, and advanced with AVX2 or SSE2 kernels (whichever the build targets), falling back 
+ * to plain C++ otherwise. Only the games whose pipe just filled up go through Board::Pump(), which moves the ooze 
+ * on to the neighboring pipe or detects a spill. Because a pipe always starts empty once the ooze flows into it, 
+ * handing Board::Pump() the accumulated level, and the number of ticks it took, gives the exact same results 
+ * as pumping the Board at every tick.
+ *
+ * Note that while a pipe fills up, its ooze level is only held by the BatchSimulator (see GetOozeLevel()), 
+ * the pipe on the Board itself remains empty until it is full. Pipes can be placed on the Boards between
+ * calls to Tick(), following the usual game rules (see Board::PlaceTile()).
+ */
+class BatchSimulator
+{
+public:
+	/**
+	 * Class constructor. All games start with the rules of the first level, see Reset().
+	 *
+	 * @param numGames	Number of independent games to simulate.
+	 * @param numCols	Number of columns on each Board.
+	 * @param numRows	Number of rows on each Board.
+	 * @param queueSize	Number of pipes visible in each Queue.
+	 */
+	BatchSimulator(int numGames, int numCols = 10, int numRows = 7, int queueSize = 5);
+
+	/**
+	 * Class destructor.
+	 */
+	~BatchSimulator();
+
+	/**
+	 * Get the name of the instruction set used by Tick(), e.g. "AVX2".
+	 */
+	static const char* GetKernelName();
+
+	int GetNumGames() const;
+
+	/**
+	 * Get the number of games in which the ooze has not spilled yet.
+	 */
+	int GetNumAlive() const;
+
+	/**
+	 * Start a new round on the given game.
+	 *
+	 * @param game			Index of the game.
+	 * @param seed			Seed for the game's Randomizer, which determines the starting tile and the queue.
+	 * @param oozePerPump	Ooze pumped into the pipes at every tick, once the countdown is over.
+	 * @param countdown		Number of ticks until the ooze starts flowing.
+	 */
+	void Reset(int game, unsigned int seed, int oozePerPump, int countdown);
+
+	/**
+	 * Advance all games by the given number of ticks.
+	 *
+	 * @param numTicks	Number of ticks to simulate.
+	 * @return	The number of games in which the ooze has not spilled yet.
+	 */
+	int Tick(int numTicks = 1);
+
+	/**
+	 * End the round of the given game right away, e.g. once its outcome is settled (see Board::IsSpillInevitable()).
+	 * The game is no longer alive, and its score stays as it is.
+	 *
+	 * @param game	Index of the game.
+	 */
+	void Stop(int game);
+
+	Board* GetBoard(int game) const;
+
+	Queue* GetQueue(int game) const;
+
+	bool IsAlive(int game) const;
+
+	int GetScore(int game) const;
+
+	int GetCountdown(int game) const;
+
+	/**
+	 * Get the ooze level of the pipe the ooze is currently flowing through, in the given game.
+	 */
+	int GetOozeLevel(int game) const;
+
+private:
+	/**
+	 * Objects making up a single game.
+	 */
+	struct Game
+	{
+		Game(unsigned int seed, int numCols, int numRows, int queueSize);
+		~Game();
+
+		std::unique_ptr<Randomizer> randomizer;
+		std::unique_ptr<Board> board;
+		std::unique_ptr<Queue> queue;
+	};
+
+	/**
+	 * Hand the accumulated ooze level of the given game over to its Board, after its pipe filled up.
+	 */
+	void Transition(int game);
+
+	std::vector<std::unique_ptr<Game>> m_games;
+
+	/**
+	 * Per-game state, padded to a multiple of the SIMD width with games which are never alive.
+	 */
+	std::vector<int> m_levels;
+	std::vector<int> m_rates;
+	std::vector<int> m_countdowns;
+	std::vector<int> m_scores;
+
+	/**
+	 * All bits set for games in which the ooze has not spilled yet, 0 otherwise.
+	 */
+	std::vector<int> m_aliveMasks;
+
+	int m_numAlive;
+};
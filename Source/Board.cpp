@@ -30,33 +30,326 @@ SOFTWARE.
 
 #include "Board.h"
 #include "Randomizer.h"
+#include "WorkerPool.h"
+#include "PressureField.h"
+#include "Queue.h"
+#include <assert.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
 
 
 // ---- Helper types and constants ----
 
 const int Board::MAX_NUM_BOMBS(5);
 const int Board::SCORE_FOR_FREE_BOMB(50);
+const int Board::CHUNK_SIZE(32);
+const int Board::ENDLESS_SIZE(16384);
+const int Board::MAX_NUM_SOURCES(1024);
+const int Board::MAX_NUM_FRONTS(4096);
+
+/**
+ * CHUNK_SIZE as a power of two, so that tile coordinates can be split into chunk and tile by shifting and masking.
+ */
+static constexpr int CHUNK_SHIFT = 5;
+static constexpr int CHUNK_MASK = (1 << CHUNK_SHIFT) - 1;
+
+/**
+ * Number of calls to Pump() between two passes of CompactChunks().
+ */
+static constexpr int COMPACT_INTERVAL = 64;
+
+/**
+ * Number of calls to Pump() a chunk must go without being accessed, before it is packed or freed.
+ * At the fastest ooze level this still amounts to many seconds.
+ */
+static constexpr int CHUNK_IDLE_PUMPS = 1024;
+
+/**
+ * Range of the random delay, in calls to Pump(), before each additional source releases its ooze.
+ */
+static constexpr int SOURCE_MIN_DELAY = 100;
+static constexpr int SOURCE_MAX_DELAY = 2000;
+
+/**
+ * Number of board tiles per source, at the least. See Board::SetNumSources().
+ */
+static constexpr int TILES_PER_SOURCE = 16;
+
+/**
+ * Fewer flow fronts than this are pumped on the calling thread, as handing them to the 
+ * WorkerPool would take longer than pumping them.
+ */
+static constexpr int PARALLEL_MIN_FRONTS = 256;
+
+/**
+ * Steps of the PressureField per percent of a pipe pumped, so that faster levels also spread the ooze faster.
+ */
+static constexpr int PRESSURE_STEPS_PER_OOZE = 16;
+
+/**
+ * Smallest rise in the fill level of a PressureField tile which is shown in its pipe.
+ */
+static const int PRESSURE_SHOW_STEP(PressureField::FULL_FILL / 64);
+
+/**
+ * Ooze which may leak out of open ends in the pressure game mode before the round is over, a quarter of a tile.
+ */
+static const int PRESSURE_SPILL_LIMIT(PressureField::FULL_FILL / 4);
+
+/**
+ * Fill level at which a closed pipeline bursts in the pressure game mode, which also ends the round.
+ */
+static const int PRESSURE_BURST_FILL(PressureField::FULL_FILL * 3);
+
+/**
+ * Chance, in percent, for any tile of an endless board to hold a pipe from the start.
+ */
+static constexpr int ENDLESS_PIPE_PERCENT = 12;
+
+/**
+ * Layout of a packed tile, see Board::PackTile(). The lowest bits hold the TilePiece::Type.
+ */
+static constexpr unsigned short PACKED_TYPE_MASK = 0x001f;
+static constexpr int PACKED_DIR_SHIFT = 5;				//< Pipe::Direction the ooze left the pipe through (entered, for a Junction), 3 bits.
+static constexpr int PACKED_WAY_SHIFT = 8;				//< Cross::Way drawn on the background, 2 bits.
+static constexpr unsigned short PACKED_FULL = 0x0400;		//< The pipe, or the horizontal way of a Cross, is full.
+static constexpr unsigned short PACKED_VERT_FULL = 0x0800;	//< The vertical way of a Cross is full.
+
+static bool IsSettled(int level)
+{
+	return ((level == MIN_OOZE_LEVEL) || (level >= MAX_OOZE_LEVEL));
+}
+
+/**
+ * Get the offset within Board::Chunk::projected of the way the ooze leaves a pipe through the given opening.
+ */
+static int GetProjectedWay(Pipe::Direction exit)
+{
+	return ((exit == Pipe::DIR_N) || (exit == Pipe::DIR_S)) ? 1 : 0;
+}
 
 
 // ---- Class Implementation ----
 
-Board::Board(int numCols, int numRows)
-	:	m_numCols(numCols), 
-		m_numRows(numRows)
+Board::Board(int numCols, int numRows, Randomizer* rand, bool endless)
+	:	m_numSources(1),
+		m_workers(nullptr),
+		m_pressureMode(false),
+		m_projectionBase(0),
+		m_projectionForks(false),
+		m_numCols(endless ? ENDLESS_SIZE : numCols), 
+		m_numRows(endless ? ENDLESS_SIZE : numRows),
+		m_endless(endless),
+		m_topology(Topology::KIND_RECTANGULAR, m_numCols, m_numRows),
+		m_seed(0),
+		m_numChunkCols((m_numCols + CHUNK_MASK) >> CHUNK_SHIFT),
+		m_clock(0),
+		m_randomizer(rand)
 {
+	assert((1 << CHUNK_SHIFT) == CHUNK_SIZE);
+
+	if (m_randomizer == nullptr)
+		m_randomizer = Randomizer::GetInstance();
+
+	m_chunks.resize(m_numChunkCols * ((m_numRows + CHUNK_MASK) >> CHUNK_SHIFT));
+
+	// Every front is on a pipe of its own, except for the branches of a junction.
+	long long maxNumFronts = std::min(static_cast<long long>(MAX_NUM_FRONTS), static_cast<long long>(m_numCols) * m_numRows * Pipe::MAX_NUM_EXITS);
+	m_frontSlotBits = 1;
+	while ((1LL << m_frontSlotBits) < (maxNumFronts * 2))
+		m_frontSlotBits++;
+	m_frontSlots.resize(static_cast<size_t>(1) << m_frontSlotBits);
+
 	Reset();
 }
 
 Board::~Board()
 {
-	// Clear all tiles
-	for (int i = 0; i < GetNumCols(); i++)
+	FreeChunks();
+}
+
+bool Board::IsEndless() const
+{
+	return m_endless;
+}
+
+void Board::SetNumSources(int numSources)
+{
+	m_numSources = std::max(1, std::min(MAX_NUM_SOURCES, numSources));
+}
+
+void Board::SetWorkerPool(WorkerPool* workers)
+{
+	m_workers = workers;
+}
+
+void Board::SetPressureMode(bool pressure)
+{
+	m_pressureMode = pressure;
+}
+
+bool Board::IsPressureMode() const
+{
+	return (m_pressure != nullptr);
+}
+
+void Board::SetTopology(Topology::Kind kind)
+{
+	if (kind != m_topology.GetKind())
+	{
+		m_topology = Topology(kind, m_numCols, m_numRows);
+		RebuildProjection();
+	}
+}
+
+const Topology& Board::GetTopology() const
+{
+	return m_topology;
+}
+
+int Board::GetNumFronts() const
+{
+	return static_cast<int>(m_fronts.size());
+}
+
+void Board::GetFrontCoords(int idx, int& col, int& row) const
+{
+	col = m_fronts.at(idx).col;
+	row = m_fronts.at(idx).row;
+}
+
+int Board::GetPumpsUntilRelease(int idx) const
+{
+	return std::max(0, m_fronts.at(idx).releasePump - m_clock);
+}
+
+int Board::GetNumProjectedPipes() const
+{
+	// The first pipe of the path is the one the ooze is flowing into already.
+	return std::max(0, static_cast<int>(m_projection.size()) - 1);
+}
+
+void Board::GetProjectedPipe(int idx, int& col, int& row) const
+{
+	const ProjectedPipe& projected = m_projection.at(idx + 1);
+	col = projected.col;
+	row = projected.row;
+}
+
+int Board::GetOozeUntilProjectedPipe(int idx) const
+{
+	if (m_projection.empty())
+		return 0;
+
+	// The oozing pipe has to fill up first, and then every pipe on the way.
+	const ProjectedPipe& oozing = m_projection.front();
+	const Pipe* pipe = static_cast<const Pipe*>(GetTile(oozing.col, oozing.row));
+	const Cross* cross = dynamic_cast<const Cross*>(pipe);
+	int level = pipe->GetOozeLevel();
+	if (cross != nullptr)
+		level = cross->GetOozeLevel(((oozing.exit == Pipe::DIR_E) || (oozing.exit == Pipe::DIR_W)) ? Cross::WAY_HORIZONTAL : Cross::WAY_VERTICAL);
+
+	return std::max(0, MAX_OOZE_LEVEL - level) + (idx * MAX_OOZE_LEVEL);
+}
+
+bool Board::GetProjectedSpill(int& col, int& row, Pipe::Direction& dir) const
+{
+	if (m_projection.empty() || m_projectionForks)
+		return false;
+
+	const ProjectedPipe& last = m_projection.back();
+	col = last.col;
+	row = last.row;
+	dir = last.exit;
+	return true;
+}
+
+int Board::GetProjectedScore() const
+{
+	int score(m_score);
+	for (int pos = 0; pos < static_cast<int>(m_projection.size()); pos++)
+		score += GetProjectedPipeScore(pos);
+
+	return score;
+}
+
+bool Board::IsSpillInevitable(const Queue& queue, int oozePerPlacement, int oozeOffset) const
+{
+	if ((m_fronts.size() != 1) || m_projection.empty() || m_projectionForks || (oozePerPlacement <= 0))
+		return false;
+
+	// Number of pipes the player can place before the given amount of ooze has been pumped. The first one right away.
+	auto placementsUntil = [oozePerPlacement, oozeOffset](int ooze)
+	{
+		ooze += oozeOffset;
+		return (ooze > 0) ? ((ooze / oozePerPlacement) + 1) : 0;
+	};
+
+	// Whether one of the pipes the player can place in time would let the ooze flow in through the given opening.
+	// Pipes placed elsewhere first bring the later pipes of the queue up. Beyond the visible ones, any pipe may come.
+	int queueSize = queue.GetSize();
+	auto fitsInTime = [&queue, queueSize](Pipe::Direction inFlowDir, int numPlacements, TilePiece::Type replaced)
 	{
-		for (int j = 0; j < GetNumRows(); j++)
+		Pipe::Direction exits[Pipe::MAX_NUM_EXITS];
+		for (int i = 0; i < numPlacements; i++)
 		{
-			delete m_tileMap[Coord(i, j)];
+			if (i >= queueSize)
+				return (queue.GetTileType(queueSize - 1) != TilePiece::TYPE_NONE);
+
+			TilePiece::Type t = queue.GetTileType(i);
+			if (t == TilePiece::TYPE_NONE)
+				return false;
+
+			if ((t != replaced) && (Pipe::GetExitDirections(t, inFlowDir, exits) > 0))
+				return true;
 		}
+
+		return false;
+	};
+
+	// Without bombs in hand, the next one is restored once the pipes filled on the way have scored enough.
+	// By then, the ooze is already flowing into the next pipe, so only the pipes after that one can be replaced.
+	int numProjected = GetNumProjectedPipes();
+	int bombOoze = (m_numBombs > 0) ? 0 : INT_MAX;
+	int scoreUntilFreeBomb(m_scoreUntilFreeBomb);
+	for (int pos = 0; (pos < numProjected) && (bombOoze == INT_MAX); pos++)
+	{
+		scoreUntilFreeBomb += GetProjectedPipeScore(pos);
+		if (scoreUntilFreeBomb >= SCORE_FOR_FREE_BOMB)
+			bombOoze = GetOozeUntilProjectedPipe(pos);
 	}
+
+	// Replacing any projected pipe with another one the ooze can flow into changes its path.
+	for (int i = 0; i < numProjected; i++)
+	{
+		int ooze = GetOozeUntilProjectedPipe(i);
+		if (bombOoze >= ooze)
+			continue;
+
+		const ProjectedPipe& projected = m_projection[i + 1];
+		TilePiece::Type t = GetTileType(projected.col, projected.row);
+		if (fitsInTime(Pipe::GetOppositeDirection(m_projection[i].exit), placementsUntil(ooze), t))
+			return false;
+	}
+
+	// The ooze spills over the edge of the board, or onto a tile which is going to stay the way it is.
+	const ProjectedPipe& last = m_projection.back();
+	int col(last.col);
+	int row(last.row);
+	if (!m_topology.StepTowards(col, row, last.exit) || (FindProjectedPipe(col, row) >= 0))
+		return true;
+
+	// An empty tile can take any pipe. A pipe can be replaced using a bomb, unless the ooze got to it already.
+	int ooze = GetOozeUntilProjectedPipe(numProjected);
+	TilePiece* tile = GetTile(col, row);
+	Pipe* pipe = dynamic_cast<Pipe*>(tile);
+	if ((pipe != nullptr) && (!pipe->IsEmpty() || pipe->IsStart() || (FindFront(pipe) != nullptr) || (bombOoze >= ooze)))
+		return true;
+
+	return !fitsInTime(Pipe::GetOppositeDirection(last.exit), placementsUntil(ooze), tile->GetType());
 }
 
 void Board::Reset()
@@ -65,54 +358,157 @@ void Board::Reset()
 	m_scoreUntilFreeBomb = 0;
 	m_numBombs = MAX_NUM_BOMBS;
 
-	// Fill the board with (empty) tiles.
-	for (int i = 0; i < GetNumCols(); i++)
+	// Chunks are filled with (empty) tiles as they get used.
+	FreeChunks();
+	ResetPressure();
+
+	// Only endless boards draw a seed, so that regular boards get the same random sequence as ever.
+	if (m_endless)
+		m_seed = static_cast<unsigned int>(m_randomizer->GetWithinRange(0, INT_MAX));
+
+	// Set random starting tile
+	CreateRandomStart();
+	IndexFronts();
+	RebuildProjection();
+}
+
+void Board::Reset(const std::vector<TilePiece::Type>& layout, int numBombs)
+{
+	assert(static_cast<int>(layout.size()) == m_numCols * m_numRows);
+
+	m_score = 0;
+	m_scoreUntilFreeBomb = 0;
+	m_numBombs = numBombs;
+
+	FreeChunks();
+	ResetPressure();
+
+	for (int i = 0; i < static_cast<int>(layout.size()); i++)
 	{
-		for (int j = 0; j < GetNumRows(); j++)
-		{
-			if (m_tileMap.count(Coord(i, j)) > 0)
-				delete m_tileMap[Coord(i, j)];
+		int col(i % m_numCols);
+		int row(i / m_numCols);
+		TilePiece*& tile = GetTileRef(col, row, true);
+		delete tile;
+		tile = TilePiece::CreateTile(layout[i], m_randomizer);
+		if (m_pressure != nullptr)
+			m_pressure->SetTile(col, row, layout[i]);
 
-			m_tileMap[Coord(i, j)] = TilePiece::CreateTile();
+		// The ooze starts flowing from the starter tile.
+		Pipe* pipe = dynamic_cast<Pipe*>(tile);
+		if ((pipe != nullptr) && pipe->IsStart())
+		{
+			assert(m_fronts.empty());
+			Front front;
+			front.tile = pipe;
+			front.col = col;
+			front.row = row;
+			m_fronts.push_back(front);
+			m_sources.push_back(std::make_pair(col, row));
 		}
 	}
 
-	// Set random starting tile
-	CreateRandomStart();
+	assert(m_fronts.size() == 1);
+	IndexFronts();
+	RebuildProjection();
 }
 
 TilePiece::Type Board::GetTileType(int col, int row) const
 {
-	return m_tileMap.at(Coord(col, row))->GetType();
+	return GetTile(col, row)->GetType();
 }
 
 TilePiece* Board::GetTile(int col, int row) const
 {
-	return m_tileMap.at(Coord(col, row));
+	return GetTileRef(col, row);
+}
+
+TilePiece*& Board::GetTileRef(int col, int row, bool modify) const
+{
+	assert((col >= 0) && (col < m_numCols) && (row >= 0) && (row < m_numRows));
+
+	int chunkIdx((col >> CHUNK_SHIFT) + ((row >> CHUNK_SHIFT) * m_numChunkCols));
+	Chunk* chunk = m_chunks.at(chunkIdx).get();
+	if ((chunk == nullptr) || chunk->tiles.empty())
+		chunk = LoadChunk(chunkIdx);
+
+	chunk->lastUse = m_clock;
+	if (modify)
+		chunk->modified = true;
+
+	return chunk->tiles[(col & CHUNK_MASK) + ((row & CHUNK_MASK) * chunk->numCols)];
 }
 
 TilePiece* Board::GetOozingTile() const
 {
-	return m_oozingTile;
+	// Follow the first front which is still flowing, or else the one which spilled last.
+	return m_fronts.empty() ? m_lastSpill.tile : m_fronts.front().tile;
+}
+
+void Board::GetOozingCoords(int& col, int& row) const
+{
+	const Front& front(m_fronts.empty() ? m_lastSpill : m_fronts.front());
+	col = front.col;
+	row = front.row;
 }
 
 void Board::ReplaceTile(int col, int row, TilePiece::Type t)
 {
-	Coord c(col, row);
+	TilePiece*& tile = GetTileRef(col, row, true);
 
 	// If the old tile wasn't empty (was a pipe), we mark the replacement tile
 	// so that an explosion graphic can be drawn over it.
-	bool explode = (m_tileMap[c]->GetType() != TilePiece::TYPE_NONE);
+	bool explode = (tile->GetType() != TilePiece::TYPE_NONE);
 
-	delete m_tileMap[c];
-	m_tileMap[c] = TilePiece::CreateTile(t);
+	delete tile;
+	tile = TilePiece::CreateTile(t, m_randomizer);
+	if (m_pressure != nullptr)
+		m_pressure->SetTile(col, row, t);
 
 	if (explode)
 	{
-		Pipe* pipe = dynamic_cast<Pipe*>(m_tileMap[c]);
+		Pipe* pipe = dynamic_cast<Pipe*>(tile);
 		if (pipe != nullptr)
+		{
 			pipe->Explode();
+
+			// The same tile may be bombed again while its last explosion is still fading.
+			std::pair<int, int> coords(col, row);
+			if (std::find(m_explosions.begin(), m_explosions.end(), coords) == m_explosions.end())
+				m_explosions.push_back(coords);
+		}
 	}
+
+	UpdateProjection(col, row);
+}
+
+Board::Placement Board::GetPlacement(int col, int row) const
+{
+	TilePiece* tile = GetTile(col, row);
+	if (tile->GetType() == TilePiece::TYPE_NONE)
+		return PLACEMENT_EMPTY;
+
+	Pipe* pipe = dynamic_cast<Pipe*>(tile);
+	if ((pipe != nullptr) &&
+		(pipe->IsEmpty()) &&			// Only empty tiles can be replaced.
+		(!pipe->IsStart()) &&			// Cannot replace starter tiles.
+		(FindFront(pipe) == nullptr) &&		// Cannot pull the pipe away from under the ooze.
+		((m_pressure == nullptr) || (m_pressure->GetFill(col, row) == 0.0f)) &&	// Nor once the ooze seeps into it, in pressure mode.
+		(m_numBombs > 0))				// Need bombs to replace existing pipe tiles.
+		return PLACEMENT_BOMB;
+
+	return PLACEMENT_NONE;
+}
+
+Board::Placement Board::PlaceTile(int col, int row, TilePiece::Type t)
+{
+	Placement placement = GetPlacement(col, row);
+	if (placement == PLACEMENT_BOMB)
+		PopBomb();
+
+	if (placement != PLACEMENT_NONE)
+		ReplaceTile(col, row, t);
+
+	return placement;
 }
 
 int Board::GetNumCols() const
@@ -125,105 +521,660 @@ int Board::GetNumRows() const
 	return m_numRows;
 }
 
-bool Board::Pump(float amount)
+bool Board::Pump(int amount, int numPumps)
 {
-	bool ret(false);
+	// Every now and then, let go of the chunks the ooze has left far behind.
+	int lastClock(m_clock);
+	m_clock += std::max(1, numPumps);
+	if ((m_clock / COMPACT_INTERVAL) != (lastClock / COMPACT_INTERVAL))
+		CompactChunks();
+
+	if (m_pressure != nullptr)
+		return PumpPressure(amount);
+
+	// First pump ooze into the pipe of every front. This only touches the fronts' own pipes,
+	// so with many fronts, it is split across the worker threads without any locking.
+	int numFronts(static_cast<int>(m_fronts.size()));
+	if ((m_workers != nullptr) && (numFronts >= PARALLEL_MIN_FRONTS))
+		m_workers->ParallelFor(numFronts, [this, amount](int begin, int end) { PumpFronts(begin, end, amount); });
+	else
+		PumpFronts(0, numFronts, amount);
 
-	Pipe* oozingPipe = dynamic_cast<Pipe*>(m_oozingTile);
-	if (oozingPipe != nullptr)
+	// Then let the fronts with full pipes flow on into their neighbors. This is done one front at a time,
+	// in worklist order, so that fronts reaching the same pipe always resolve the same way. Every front 
+	// can fork at most once per Pump(), so the room needed for new branches is known up front.
+	m_fronts.reserve(std::min(numFronts * Pipe::MAX_NUM_EXITS, MAX_NUM_FRONTS));
+	for (int i = 0; i < numFronts; i++)
 	{
-		oozingPipe->Pump(amount);
-		if (oozingPipe->IsFull())
+		if (m_fronts[i].full)
 		{
-			m_score += oozingPipe->GetScoreValue();
+			AddScore(m_fronts[i].scoreGained);
+			AdvanceFront(i);
+			if (!m_fronts[i].flowing)
+				m_lastSpill = m_fronts[i];
+		}
+	}
 
-			// Once this score reaches SCORE_FOR_FREE_BOMB, the number of available 
-			// bombs will increase by one. After that, the score until the next restored
-			// bomb will be 0 again.
-			m_scoreUntilFreeBomb += oozingPipe->GetScoreValue();
-			if (m_scoreUntilFreeBomb >= SCORE_FOR_FREE_BOMB)
-			{
-				if (m_numBombs < MAX_NUM_BOMBS)
-					m_numBombs++;
+	// Take the fronts which have spilled off the worklist, keeping the order of the others.
+	// This moves the fronts behind them, so their indices need updating.
+	int numKept(0);
+	for (int i = 0; i < static_cast<int>(m_fronts.size()); i++)
+	{
+		if (!m_fronts[i].flowing)
+			continue;
 
-				m_scoreUntilFreeBomb = 0;
-			}
+		if (i != numKept)
+		{
+			ReindexFront(i, numKept);
+			m_fronts[numKept] = m_fronts[i];
+		}
 
-			Pipe::Direction outFlowDir = oozingPipe->GetFlowDirection();
-			Pipe::Direction inFlowDir = Pipe::GetOppositeDirection(outFlowDir);
+		numKept++;
+	}
+	m_fronts.resize(numKept);
+	AdvanceProjection();
 
-			// Returns null if ooze flowing out of bounds, 
-			// and cast will fail if ooze is spilling on empty tile.
-			Pipe* neighbor = dynamic_cast<Pipe*>(FindNeighbor(oozingPipe, outFlowDir));
-			if ((neighbor != nullptr) &&
-				(neighbor->HasOpening(inFlowDir)) &&	// Neighbor has an opening in the right spot.
-				(neighbor->SetFlowEntry(inFlowDir)))	// Able to set the ooze entry point.
-			{
-				// Now the ooze is flowing into the neighbor
-				m_oozingTile = neighbor;
+	return !m_fronts.empty();
+}
 
-				// Ooze saved.
-				ret = true;
-			}
+void Board::AddScore(int score)
+{
+	m_score += score;
+
+	// Once this score reaches SCORE_FOR_FREE_BOMB, the number of available 
+	// bombs will increase by one. After that, the score until the next restored
+	// bomb will be 0 again.
+	m_scoreUntilFreeBomb += score;
+	if (m_scoreUntilFreeBomb >= SCORE_FOR_FREE_BOMB)
+	{
+		if (m_numBombs < MAX_NUM_BOMBS)
+			m_numBombs++;
+
+		m_scoreUntilFreeBomb = 0;
+	}
+}
+
+void Board::PumpFronts(int begin, int end, int amount)
+{
+	for (int i = begin; i < end; i++)
+	{
+		Front& front = m_fronts[i];
+		front.full = false;
+		front.scoreGained = 0;
+
+		if (!front.flowing || (m_clock < front.releasePump))
+			continue;
 
-			// Spill!
-			else
-				ret = false;
+		Pipe* pipe = static_cast<Pipe*>(front.tile);
+
+		// The pipe may already be full, if the front had to wait for another one to move on.
+		if (!pipe->IsFull())
+		{
+			pipe->Pump(amount);
+			if (pipe->IsFull())
+				front.scoreGained = pipe->GetScoreValue();
 		}
-		else
+
+		front.full = pipe->IsFull();
+	}
+}
+
+void Board::AdvanceFront(int idx)
+{
+	Front& front = m_fronts[idx];
+	Pipe* pipe = static_cast<Pipe*>(front.tile);
+
+	// The ooze leaving a junction forks. The first branch carries on with this front, 
+	// the others get fronts of their own, which leave the junction with the next Pump().
+	Junction* junction = dynamic_cast<Junction*>(pipe);
+	if ((junction != nullptr) && (front.exit == Pipe::DIR_NONE))
+	{
+		Pipe::Direction exits[Pipe::MAX_NUM_EXITS];
+		int numExits = Pipe::GetExitDirections(junction->GetType(), junction->GetEntryDirection(), exits);
+		for (int i = 1; (i < numExits) && (static_cast<int>(m_fronts.size()) < MAX_NUM_FRONTS); i++)
 		{
-			// This pipe not full yet -> nothing more to do.
-			ret = true;
+			Front branch(front);
+			branch.exit = exits[i];
+			branch.full = false;
+			m_fronts.push_back(branch);
+			IndexFront(static_cast<int>(m_fronts.size()) - 1);
 		}
+
+		front.exit = exits[0];
 	}
 
-	return ret;
+	Pipe::Direction outFlowDir = (front.exit != Pipe::DIR_NONE) ? front.exit : pipe->GetFlowDirection();
+	Pipe::Direction inFlowDir = Pipe::GetOppositeDirection(outFlowDir);
+
+	// Neighbor is null if ooze flowing out of bounds, 
+	// and cast will fail if ooze is spilling on empty tile.
+	int col(front.col);
+	int row(front.row);
+	Pipe* neighbor(nullptr);
+	if (m_topology.StepTowards(col, row, outFlowDir))
+		neighbor = dynamic_cast<Pipe*>(GetTileRef(col, row, true));
+
+	// Only one front can flow through a pipe at a time. If another front is still filling 
+	// the other way of a Cross-Pipe, wait for it to move on. Waiting on a front which is 
+	// itself waiting could go round in circles, so that counts as a spill.
+	const Front* other = (neighbor != nullptr) ? FindFront(neighbor) : nullptr;
+	if (other != nullptr)
+	{
+		Cross* cross = dynamic_cast<Cross*>(neighbor);
+		Cross::Way way = ((outFlowDir == Pipe::DIR_E) || (outFlowDir == Pipe::DIR_W)) ? Cross::WAY_HORIZONTAL : Cross::WAY_VERTICAL;
+		Pipe::Direction otherDir = (cross != nullptr) ? cross->GetFlowDirection() : Pipe::DIR_NONE;
+		Cross::Way otherWay = ((otherDir == Pipe::DIR_E) || (otherDir == Pipe::DIR_W)) ? Cross::WAY_HORIZONTAL : Cross::WAY_VERTICAL;
+		if ((cross != nullptr) && !other->full && (otherWay != way) && (cross->GetOozeLevel(way) == MIN_OOZE_LEVEL))
+			return;
+
+		front.flowing = false;
+		UnindexFront(idx);
+		return;
+	}
+
+	if ((neighbor != nullptr) &&
+		(neighbor->HasOpening(inFlowDir)) &&	// Neighbor has an opening in the right spot.
+		(neighbor->SetFlowEntry(inFlowDir)))	// Able to set the ooze entry point.
+	{
+		// Now the ooze is flowing into the neighbor
+		UnindexFront(idx);
+		front.tile = neighbor;
+		front.col = col;
+		front.row = row;
+		front.exit = Pipe::DIR_NONE;
+		IndexFront(idx);
+	}
+
+	// Spill!
+	else
+	{
+		front.flowing = false;
+		UnindexFront(idx);
+	}
 }
 
-TilePiece* Board::FindNeighbor(TilePiece* tile, Pipe::Direction dir) /*const*/
+void Board::RebuildProjection()
 {
-	TilePiece* ret(nullptr);
+	ClearProjection();
+	m_projectionForks = false;
 
-	// Get the coordinates of the passed pipe.
-	Coord coord;
-	for (auto it = m_tileMap.begin(); it != m_tileMap.end(); ++it)
+	// The pressure game mode has no path to follow.
+	if (m_fronts.empty() || (m_pressure != nullptr))
+		return;
+
+	const Front& front = m_fronts.front();
+	const Pipe* pipe = static_cast<const Pipe*>(front.tile);
+
+	ProjectedPipe oozing;
+	oozing.col = front.col;
+	oozing.row = front.row;
+	oozing.exit = (front.exit != Pipe::DIR_NONE) ? front.exit : pipe->GetFlowDirection();
+	m_projection.push_back(oozing);
+	SetProjectedSerial(oozing.col, oozing.row, oozing.exit, m_projectionBase);
+
+	// A junction the ooze has yet to leave forks right here.
+	if ((dynamic_cast<const Junction*>(pipe) != nullptr) && (front.exit == Pipe::DIR_NONE))
+		m_projectionForks = true;
+
+	ExtendProjection();
+}
+
+void Board::AdvanceProjection()
+{
+	if (m_fronts.empty() || (m_pressure != nullptr))
+	{
+		ClearProjection();
+		return;
+	}
+
+	const Front& front = m_fronts.front();
+	auto follows = [&front](const ProjectedPipe& projected)
+	{
+		Pipe::Direction exit = (front.exit != Pipe::DIR_NONE) ? front.exit : static_cast<const Pipe*>(front.tile)->GetFlowDirection();
+		return ((projected.col == front.col) && (projected.row == front.row) && (projected.exit == exit));
+	};
+
+	// Still filling the same pipe.
+	if (!m_projection.empty() && follows(m_projection.front()))
+		return;
+
+	// Flowed on into the next pipe, as projected. Only the pipe it left is dropped.
+	if ((m_projection.size() > 1) && follows(m_projection[1]))
+	{
+		const ProjectedPipe& left = m_projection.front();
+		SetProjectedSerial(left.col, left.row, left.exit, -1);
+		m_projection.pop_front();
+		m_projectionBase++;
+		return;
+	}
+
+	// The front spilled, and another one is first now, or it went somewhere unexpected.
+	RebuildProjection();
+}
+
+void Board::ExtendProjection()
+{
+	if (m_projection.empty())
+		return;
+
+	while (!m_projectionForks)
+	{
+		const ProjectedPipe& last = m_projection.back();
+		Pipe::Direction inFlowDir = Pipe::GetOppositeDirection(last.exit);
+		int col(last.col);
+		int row(last.row);
+		if (!m_topology.StepTowards(col, row, last.exit))
+			return;
+
+		// Same rules as AdvanceFront(), without touching the pipe.
+		const Pipe* neighbor = dynamic_cast<const Pipe*>(GetTile(col, row));
+		if ((neighbor == nullptr) || !neighbor->HasOpening(inFlowDir))
+			return;
+
+		Pipe::Direction exits[Pipe::MAX_NUM_EXITS];
+		int numExits = Pipe::GetExitDirections(neighbor->GetType(), inFlowDir, exits);
+		if (numExits == 0)
+			return;
+
+		// The ooze only flows through empty pipes, or the empty way of a Cross-Pipe, and not twice through the same one.
+		const Cross* cross = dynamic_cast<const Cross*>(neighbor);
+		if (cross != nullptr)
+		{
+			Cross::Way way = ((exits[0] == Pipe::DIR_E) || (exits[0] == Pipe::DIR_W)) ? Cross::WAY_HORIZONTAL : Cross::WAY_VERTICAL;
+			if ((cross->GetOozeLevel(way) != MIN_OOZE_LEVEL) || (GetProjectedSerial(col, row, exits[0]) >= 0))
+				return;
+		}
+		else if (!neighbor->IsEmpty() || (FindProjectedPipe(col, row) >= 0))
+			return;
+
+		ProjectedPipe next;
+		next.col = col;
+		next.row = row;
+		next.exit = exits[0];
+		SetProjectedSerial(col, row, next.exit, m_projectionBase + static_cast<int>(m_projection.size()));
+		m_projection.push_back(next);
+
+		// Past a junction, the ooze forks.
+		if (numExits > 1)
+			m_projectionForks = true;
+	}
+}
+
+void Board::UpdateProjection(int col, int row)
+{
+	if (m_projection.empty())
+		return;
+
+	// A replaced pipe on the path cuts it short, right before that pipe. The oozing pipe itself is never replaced 
+	// by the player, but if it is, there is nothing left to keep.
+	int serial = FindProjectedPipe(col, row);
+	if (serial == m_projectionBase)
+	{
+		RebuildProjection();
+		return;
+	}
+
+	if (serial > m_projectionBase)
+	{
+		while (m_projectionBase + static_cast<int>(m_projection.size()) > serial)
+		{
+			const ProjectedPipe& dropped = m_projection.back();
+			SetProjectedSerial(dropped.col, dropped.row, dropped.exit, -1);
+			m_projection.pop_back();
+		}
+
+		m_projectionForks = false;
+		ExtendProjection();
+		return;
+	}
+
+	// A new pipe where the ooze would have spilled extends the path.
+	const ProjectedPipe& last = m_projection.back();
+	int nextCol(last.col);
+	int nextRow(last.row);
+	if (!m_projectionForks && m_topology.StepTowards(nextCol, nextRow, last.exit) && (nextCol == col) && (nextRow == row))
+		ExtendProjection();
+}
+
+void Board::ClearProjection()
+{
+	for (const ProjectedPipe& projected : m_projection)
+		SetProjectedSerial(projected.col, projected.row, projected.exit, -1);
+
+	m_projection.clear();
+}
+
+void Board::SetProjectedSerial(int col, int row, Pipe::Direction exit, int serial)
+{
+	Chunk* chunk = m_chunks[(col >> CHUNK_SHIFT) + ((row >> CHUNK_SHIFT) * m_numChunkCols)].get();
+	assert((chunk != nullptr) && !chunk->projected.empty());
+
+	int& entry = chunk->projected[(((col & CHUNK_MASK) + ((row & CHUNK_MASK) * chunk->numCols)) * 2) + GetProjectedWay(exit)];
+	chunk->numProjected += ((serial >= 0) ? 1 : 0) - ((entry >= 0) ? 1 : 0);
+	entry = serial;
+}
+
+int Board::GetProjectedSerial(int col, int row, Pipe::Direction exit) const
+{
+	// Projected pipes keep their chunks loaded, so an unloaded chunk has none.
+	const Chunk* chunk = m_chunks[(col >> CHUNK_SHIFT) + ((row >> CHUNK_SHIFT) * m_numChunkCols)].get();
+	if ((chunk == nullptr) || chunk->projected.empty())
+		return -1;
+
+	return chunk->projected[(((col & CHUNK_MASK) + ((row & CHUNK_MASK) * chunk->numCols)) * 2) + GetProjectedWay(exit)];
+}
+
+int Board::GetProjectedPipeScore(int pos) const
+{
+	const ProjectedPipe& projected = m_projection[pos];
+	const Pipe* pipe = static_cast<const Pipe*>(GetTile(projected.col, projected.row));
+
+	// The oozing pipe may have scored already. Starter pipes never do.
+	if (((pos == 0) && pipe->IsFull()) || pipe->IsStart())
+		return 0;
+
+	// Junctions score for every opening the ooze leaves through.
+	const Junction* junction = dynamic_cast<const Junction*>(pipe);
+	if (junction != nullptr)
+	{
+		Pipe::Direction entry = (pos == 0) ? junction->GetEntryDirection() : Pipe::GetOppositeDirection(m_projection[pos - 1].exit);
+		Pipe::Direction exits[Pipe::MAX_NUM_EXITS];
+		return TilePiece::JUNCTION_SCORE_VALUE_PER_EXIT * Pipe::GetExitDirections(junction->GetType(), entry, exits);
+	}
+
+	const Cross* cross = dynamic_cast<const Cross*>(pipe);
+	if (cross == nullptr)
+		return TilePiece::PIPE_SCORE_VALUE;
+
+	bool horizontal = ((projected.exit == Pipe::DIR_E) || (projected.exit == Pipe::DIR_W));
+	if (cross->GetOozeLevel(horizontal ? Cross::WAY_VERTICAL : Cross::WAY_HORIZONTAL) >= MAX_OOZE_LEVEL)
+		return TilePiece::CROSS_PIPE_SCORE_VALUE;
+
+	int otherSerial = GetProjectedSerial(projected.col, projected.row, horizontal ? Pipe::DIR_N : Pipe::DIR_E);
+	if ((otherSerial >= 0) && (otherSerial < m_projectionBase + pos))
+		return TilePiece::CROSS_PIPE_SCORE_VALUE;
+
+	return TilePiece::PIPE_SCORE_VALUE;
+}
+
+int Board::FindProjectedPipe(int col, int row) const
+{
+	// Any pipe may be entered either way, though only a Cross-Pipe both ways.
+	int serial(-1);
+	for (Pipe::Direction exit : { Pipe::DIR_E, Pipe::DIR_N })
+	{
+		int waySerial = GetProjectedSerial(col, row, exit);
+		if ((waySerial >= 0) && ((serial < 0) || (waySerial < serial)))
+			serial = waySerial;
+	}
+
+	return serial;
+}
+
+void Board::ResetPressure()
+{
+	// The PressureField holds every tile of the board, which is more than endless boards can afford.
+	// It also only knows rectangular boards, with the ooze leaking out over the edges.
+	if (!m_pressureMode || m_endless || (m_topology.GetKind() != Topology::KIND_RECTANGULAR))
+		m_pressure.reset();
+	else if (m_pressure == nullptr)
+		m_pressure.reset(new PressureField(m_numCols, m_numRows));
+	else
+		m_pressure->Reset();
+}
+
+bool Board::PumpPressure(int amount)
+{
+	// Ooze is pumped into every starter tile which has released its ooze.
+	m_inlets.clear();
+	for (const Front& front : m_fronts)
+	{
+		if (m_clock >= front.releasePump)
+			m_inlets.push_back(std::make_pair(front.col, front.row));
+	}
+
+	// The more ooze per pump, the more steps, so that each step pumps the same amount. 
+	// A pipe still takes as long to fill as it does the regular way.
+	int numSteps = std::max(1, ((amount * PRESSURE_STEPS_PER_OOZE) + OOZE_PER_PERCENT - 1) / OOZE_PER_PERCENT);
+	int inflow = static_cast<int>((static_cast<long long>(amount) * PressureField::FULL_FILL) / MAX_OOZE_LEVEL);
+	m_pressure->Step(m_inlets, inflow, numSteps, m_workers);
+
+	// Only the pipes whose fill level rose enough to look any different are updated.
+	m_pressure->CollectRisen(PRESSURE_SHOW_STEP, m_risen);
+	for (const std::pair<int, int>& coords : m_risen)
+		ShowPressure(coords.first, coords.second);
+
+	if ((m_pressure->GetSpilled() < PRESSURE_SPILL_LIMIT) && 
+		(m_pressure->GetPeakFill() < PRESSURE_BURST_FILL))
+		return true;
+
+	// The round is over. The spill is shown where the ooze leaks the most, or else at the first starter tile.
+	int col(0);
+	int row(0);
+	if (m_pressure->FindWorstLeak(col, row))
+	{
+		m_lastSpill = Front();
+		m_lastSpill.col = col;
+		m_lastSpill.row = row;
+		m_lastSpill.tile = GetTile(col, row);
+	}
+	else if (!m_fronts.empty())
+		m_lastSpill = m_fronts.front();
+
+	m_lastSpill.flowing = false;
+	UnindexFronts();
+	m_fronts.clear();
+
+	return false;
+}
+
+void Board::ShowPressure(int col, int row)
+{
+	Pipe* pipe = dynamic_cast<Pipe*>(GetTileRef(col, row, true));
+	if (pipe == nullptr)
+		return;
+
+	int fill = std::min(PressureField::FULL_FILL, m_pressure->GetFill(col, row));
+	int level = static_cast<int>((static_cast<long long>(fill) * MAX_OOZE_LEVEL) / PressureField::FULL_FILL);
+
+	// The ooze seems to come in from the fullest neighbor. Starter pipes know their flow direction from the start.
+	if (pipe->IsEmpty() && !pipe->IsStart())
+	{
+		if (!pipe->SetFlowEntry(m_pressure->GetInflowDirection(col, row)))
+			return;
+	}
+
+	// Both ways of a Cross-Pipe fill up together, and score one after the other.
+	Cross* cross = dynamic_cast<Cross*>(pipe);
+	if (cross != nullptr)
+	{
+		for (Cross::Way way : { Cross::WAY_HORIZONTAL, Cross::WAY_VERTICAL })
+		{
+			if (cross->GetOozeLevel(way) < level)
+			{
+				cross->SetOozeLevel(way, level);
+				if (level >= MAX_OOZE_LEVEL)
+					AddScore(cross->GetScoreValue());
+			}
+		}
+	}
+
+	else if (pipe->GetOozeLevel() < level)
+	{
+		pipe->SetOozeLevel(level);
+		if (pipe->IsFull())
+			AddScore(pipe->GetScoreValue());
+	}
+}
+
+const Board::Front* Board::FindFront(const TilePiece* tile) const
+{
+	// The fronts on a pipe all follow the slot it hashes to, up to the next free slot.
+	int mask = static_cast<int>(m_frontSlots.size()) - 1;
+	int first(-1);
+	for (int slot = GetFrontSlot(tile); m_frontSlots[slot].tile != nullptr; slot = (slot + 1) & mask)
+	{
+		const FrontSlot& entry = m_frontSlots[slot];
+		if ((entry.tile == tile) && ((first < 0) || (entry.idx < first)))
+			first = entry.idx;
+	}
+
+	return (first >= 0) ? &m_fronts[first] : nullptr;
+}
+
+int Board::GetFrontSlot(const TilePiece* tile) const
+{
+	// Fibonacci hashing: the top bits of the product depend on all bits of the pointer.
+	unsigned long long hash = static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(tile) >> 4) * 0x9e3779b97f4a7c15ULL;
+	return static_cast<int>(hash >> (64 - m_frontSlotBits));
+}
+
+void Board::IndexFront(int idx)
+{
+	int mask = static_cast<int>(m_frontSlots.size()) - 1;
+	int slot = GetFrontSlot(m_fronts[idx].tile);
+	while (m_frontSlots[slot].tile != nullptr)
+		slot = (slot + 1) & mask;
+
+	m_frontSlots[slot].tile = m_fronts[idx].tile;
+	m_frontSlots[slot].idx = idx;
+}
+
+void Board::UnindexFront(int idx)
+{
+	int mask = static_cast<int>(m_frontSlots.size()) - 1;
+	const TilePiece* tile = m_fronts[idx].tile;
+	int hole = GetFrontSlot(tile);
+	while ((m_frontSlots[hole].tile != tile) || (m_frontSlots[hole].idx != idx))
+	{
+		if (m_frontSlots[hole].tile == nullptr)
+			return;
+
+		hole = (hole + 1) & mask;
+	}
+
+	// Without tombstones, the entries after the freed slot move up into it, unless that would put them 
+	// before the slot they hash to.
+	for (int slot = (hole + 1) & mask; m_frontSlots[slot].tile != nullptr; slot = (slot + 1) & mask)
+	{
+		int home = GetFrontSlot(m_frontSlots[slot].tile);
+		if (((slot - home) & mask) >= ((slot - hole) & mask))
+		{
+			m_frontSlots[hole] = m_frontSlots[slot];
+			hole = slot;
+		}
+	}
+
+	m_frontSlots[hole] = FrontSlot();
+}
+
+void Board::ReindexFront(int oldIdx, int newIdx)
+{
+	int mask = static_cast<int>(m_frontSlots.size()) - 1;
+	const TilePiece* tile = m_fronts[oldIdx].tile;
+	for (int slot = GetFrontSlot(tile); m_frontSlots[slot].tile != nullptr; slot = (slot + 1) & mask)
 	{
-		if (it->second == tile)
+		if ((m_frontSlots[slot].tile == tile) && (m_frontSlots[slot].idx == oldIdx))
 		{
-			coord = it->first;
-			break;
+			m_frontSlots[slot].idx = newIdx;
+			return;
 		}
 	}
+}
+
+void Board::IndexFronts()
+{
+	for (int i = 0; i < static_cast<int>(m_fronts.size()); i++)
+	{
+		if (m_fronts[i].flowing)
+			IndexFront(i);
+	}
+}
 
-	// Advance coord in the desired direction
-	switch (dir)
+void Board::UnindexFronts()
+{
+	// Only the fronts which have not spilled are indexed, so this leaves every slot free again.
+	for (int i = 0; i < static_cast<int>(m_fronts.size()); i++)
+	{
+		if (m_fronts[i].flowing)
+			UnindexFront(i);
+	}
+}
+
+TilePiece* Board::FindNeighbor(TilePiece* tile, Pipe::Direction dir) const
+{
+	// Get the coordinates of the passed pipe.
+	int col(-1);
+	int row(-1);
+	const Front* front = FindFront(tile);
+	if (front != nullptr)
+	{
+		col = front->col;
+		row = front->row;
+	}
+	else
 	{
-		case Pipe::DIR_N:
-			coord.second -= 1;
-			break;
-		case Pipe::DIR_S:
-			coord.second += 1;
-			break;
-		case Pipe::DIR_E:
-			coord.first += 1;
-			break;
-		case Pipe::DIR_W:
-			coord.first -= 1;
-			break;
-		default:
-			break;
+		// Tiles of chunks which are not allocated cannot have been handed out.
+		for (int chunkIdx : m_liveChunks)
+		{
+			const Chunk& chunk = *m_chunks[chunkIdx];
+			auto it = std::find(chunk.tiles.begin(), chunk.tiles.end(), tile);
+			if (it != chunk.tiles.end())
+			{
+				int i = static_cast<int>(it - chunk.tiles.begin());
+				col = ((chunkIdx % m_numChunkCols) << CHUNK_SHIFT) + (i % chunk.numCols);
+				row = ((chunkIdx / m_numChunkCols) << CHUNK_SHIFT) + (i / chunk.numCols);
+				break;
+			}
+		}
 	}
 
-	// Check bounds
-	if ((coord.first >= 0) && (coord.first < m_numCols) &&
-		(coord.second >= 0) && (coord.second < m_numRows))
+	if (col < 0)
+		return nullptr;
+
+	return FindNeighbor(col, row, dir);
+}
+
+TilePiece* Board::FindNeighbor(int col, int row, Pipe::Direction dir) const
+{
+	// Advance coords in the desired direction, and check bounds.
+	if (!m_topology.StepTowards(col, row, dir))
+		return nullptr;
+
+	return GetTile(col, row);
+}
+
+bool Board::PopExplosions()
+{
+	bool ret(false);
+
+	for (int i = 0; i < static_cast<int>(m_explosions.size()); )
 	{
-		ret = m_tileMap[coord];
+		Pipe* pipe = dynamic_cast<Pipe*>(GetTile(m_explosions[i].first, m_explosions[i].second));
+		if ((pipe != nullptr) && (pipe->GetExplosion() > 0))
+		{
+			pipe->PopExplosion();
+			ret = true;
+		}
+
+		// Forget about explosions which have faded out.
+		if ((pipe == nullptr) || (pipe->GetExplosion() == 0))
+		{
+			m_explosions[i] = m_explosions.back();
+			m_explosions.pop_back();
+		}
+		else
+			i++;
 	}
 
 	return ret;
 }
 
+int Board::GetNumLiveChunks() const
+{
+	return static_cast<int>(m_liveChunks.size());
+}
+
 int Board::GetScoreValue() const
 {
 	return m_score;
@@ -231,28 +1182,78 @@ int Board::GetScoreValue() const
 
 void Board::CreateRandomStart()
 {
-	// Determine a random position on the board.
-	Randomizer* rand = Randomizer::GetInstance();
-	int startPosInt = rand->GetWithinRange(0, (m_numCols * m_numRows) - 1);
-	Coord startCoord(startPosInt % m_numCols, static_cast<int>(startPosInt / m_numCols));
+	Randomizer* rand = m_randomizer;
+	m_fronts.clear();
+	m_sources.clear();
 
-	TilePiece::Type starterType(TilePiece::TYPE_NONE);
-	bool search(true);
-	while (search)
+	// On endless boards, sources are placed around the middle, as far from the edges as it gets.
+	// The more sources, the larger that area.
+	int spread(CHUNK_SIZE);
+	while ((spread * spread) < (m_numSources * TILES_PER_SOURCE * 4))
+		spread *= 2;
+
+	int numSources = std::min(m_numSources, std::max(1, (m_numCols * m_numRows) / TILES_PER_SOURCE));
+	std::vector<TilePiece::Type> starterTypes;
+	while (static_cast<int>(m_fronts.size()) < numSources)
 	{
-		// Get a random starter tile
-		starterType = static_cast<TilePiece::Type>(rand->GetWithinRange(TilePiece::TYPE_START_N, TilePiece::TYPE_START_W));
+		// Determine a random position on the board.
+		int startCol(0);
+		int startRow(0);
+		if (m_endless)
+		{
+			int startPosInt = rand->GetWithinRange(0, (spread * spread) - 1);
+			startCol = (m_numCols / 2) + (startPosInt % spread);
+			startRow = (m_numRows / 2) + (startPosInt / spread);
+		}
+		else
+		{
+			int startPosInt = rand->GetWithinRange(0, (m_numCols * m_numRows) - 1);
+			startCol = startPosInt % m_numCols;
+			startRow = static_cast<int>(startPosInt / m_numCols);
+		}
+
+		// Keep sources apart, so that each has some room to start with.
+		bool tooClose(false);
+		for (const std::pair<int, int>& other : m_sources)
+			tooClose |= ((std::abs(other.first - startCol) <= 1) && (std::abs(other.second - startRow) <= 1));
+
+		if (tooClose)
+			continue;
+
+		TilePiece::Type starterType(TilePiece::TYPE_NONE);
+		bool search(true);
+		while (search)
+		{
+			// Get a random starter tile
+			starterType = static_cast<TilePiece::Type>(rand->GetWithinRange(TilePiece::TYPE_START_N, TilePiece::TYPE_START_W));
+
+			// Keep trying with random starter tiles until we find one with at least two tiles in front of it,
+			// rather than facing the wall. Starter types are listed in the same order as the directions they face.
+			Pipe::Direction facing = static_cast<Pipe::Direction>(Pipe::DIR_N + (starterType - TilePiece::TYPE_START_N));
+			int col(startCol);
+			int row(startRow);
+			search = !(m_topology.StepTowards(col, row, facing) && m_topology.StepTowards(col, row, facing));
+		}
+
+		// The first source releases its ooze right away, the others are staggered.
+		Front front;
+		front.col = startCol;
+		front.row = startRow;
+		if (!m_fronts.empty())
+			front.releasePump = rand->GetWithinRange(SOURCE_MIN_DELAY, SOURCE_MAX_DELAY);
 
-		// Keep trying with random starter tiles until we find one which is not facing the wall.
-		search = (((startCoord.first <= 1) && (starterType == TilePiece::TYPE_START_W)) ||
-			((startCoord.first >= (m_numCols - 2)) && (starterType == TilePiece::TYPE_START_E)) ||
-			((startCoord.second <= 1) && (starterType == TilePiece::TYPE_START_N)) ||
-			((startCoord.second >= (m_numRows - 2)) && (starterType == TilePiece::TYPE_START_S)));
+		m_fronts.push_back(front);
+		m_sources.push_back(std::make_pair(startCol, startRow));
+		starterTypes.push_back(starterType);
 	}
 
-	// Set starter tile.
-	ReplaceTile(startCoord.first, startCoord.second, starterType);
-	m_oozingTile = m_tileMap[startCoord];
+	// Set starter tiles. All of them must be known before their chunks get generated, see GenerateChunk().
+	for (int i = 0; i < numSources; i++)
+	{
+		Front& front = m_fronts[i];
+		ReplaceTile(front.col, front.row, starterTypes[i]);
+		front.tile = GetTile(front.col, front.row);
+	}
 }
 
 int Board::GetNumBombs() const
@@ -271,7 +1272,284 @@ bool Board::PopBomb()
 	return false;
 }
 
-int Board::GetPercentUntilFreeBomb()
+int Board::GetPercentUntilFreeBomb() const
 {
 	return static_cast<int>((m_scoreUntilFreeBomb * 100) / SCORE_FOR_FREE_BOMB);
-}
\ No newline at end of file
+}
+
+Board::Chunk* Board::LoadChunk(int chunkIdx) const
+{
+	std::unique_ptr<Chunk>& chunk = m_chunks[chunkIdx];
+	if (chunk == nullptr)
+	{
+		int chunkCol(chunkIdx % m_numChunkCols);
+		int chunkRow(chunkIdx / m_numChunkCols);
+
+		chunk.reset(new Chunk());
+		chunk->numCols = std::min(CHUNK_SIZE, m_numCols - (chunkCol << CHUNK_SHIFT));
+		chunk->numRows = std::min(CHUNK_SIZE, m_numRows - (chunkRow << CHUNK_SHIFT));
+		GenerateChunk(*chunk, chunkIdx);
+	}
+	else
+	{
+		chunk->tiles.resize(chunk->packed.size());
+		for (int i = 0; i < static_cast<int>(chunk->packed.size()); i++)
+			chunk->tiles[i] = UnpackTile(chunk->packed[i]);
+
+		chunk->packed.clear();
+		chunk->packed.shrink_to_fit();
+	}
+
+	chunk->projected.assign(chunk->tiles.size() * 2, -1);
+
+	m_liveChunks.push_back(chunkIdx);
+
+	return chunk.get();
+}
+
+void Board::GenerateChunk(Chunk& chunk, int chunkIdx) const
+{
+	int numTiles(chunk.numCols * chunk.numRows);
+	chunk.tiles.resize(numTiles, nullptr);
+
+	if (!m_endless)
+	{
+		for (int i = 0; i < numTiles; i++)
+			chunk.tiles[i] = TilePiece::CreateTile(TilePiece::TYPE_NONE, m_randomizer);
+
+		return;
+	}
+
+	// Every chunk has its own seed, so that a freed chunk comes back exactly 
+	// the same, regardless of the order in which chunks are generated.
+	unsigned int seed(m_seed ^ (static_cast<unsigned int>(chunkIdx) * 2654435761u));
+	Randomizer rand(seed);
+
+	int firstCol((chunkIdx % m_numChunkCols) << CHUNK_SHIFT);
+	int firstRow((chunkIdx / m_numChunkCols) << CHUNK_SHIFT);
+	for (int i = 0; i < numTiles; i++)
+	{
+		TilePiece::Type t(TilePiece::TYPE_NONE);
+		if (rand.GetWithinRange(0, 99) < ENDLESS_PIPE_PERCENT)
+			t = static_cast<TilePiece::Type>(rand.GetWithinRange(TilePiece::TYPE_VERTICAL, TilePiece::TYPE_CROSS));
+
+		// Leave some room around the starter tiles.
+		int col(firstCol + (i % chunk.numCols));
+		int row(firstRow + (i / chunk.numCols));
+		for (const std::pair<int, int>& source : m_sources)
+		{
+			if ((std::abs(col - source.first) <= 1) && (std::abs(row - source.second) <= 1))
+				t = TilePiece::TYPE_NONE;
+		}
+
+		chunk.tiles[i] = TilePiece::CreateTile(t, &rand);
+	}
+}
+
+void Board::CompactChunks()
+{
+	// Keep the chunks around the pipe of every front, as the fronts hold on to their pipes.
+	// The last spilled front is kept as well, since its pipe is still reported as oozing.
+	// Chunks beyond the edges of the board are left out, rather than wrapping around to the other side.
+	int numChunkRows = static_cast<int>(m_chunks.size()) / m_numChunkCols;
+	auto keepAround = [this, numChunkRows](const Front& front)
+	{
+		int frontChunkCol(front.col >> CHUNK_SHIFT);
+		int frontChunkRow(front.row >> CHUNK_SHIFT);
+		for (int chunkRow = std::max(0, frontChunkRow - 1); chunkRow <= std::min(numChunkRows - 1, frontChunkRow + 1); chunkRow++)
+		{
+			for (int chunkCol = std::max(0, frontChunkCol - 1); chunkCol <= std::min(m_numChunkCols - 1, frontChunkCol + 1); chunkCol++)
+				m_frontChunks.push_back(chunkCol + (chunkRow * m_numChunkCols));
+		}
+	};
+
+	m_frontChunks.clear();
+	for (const Front& front : m_fronts)
+		keepAround(front);
+	if (m_lastSpill.tile != nullptr)
+		keepAround(m_lastSpill);
+	std::sort(m_frontChunks.begin(), m_frontChunks.end());
+
+	for (int i = 0; i < static_cast<int>(m_liveChunks.size()); )
+	{
+		int chunkIdx(m_liveChunks[i]);
+
+		// Also keep those which are still in use, e.g. being looked at.
+		bool keep = (std::binary_search(m_frontChunks.begin(), m_frontChunks.end(), chunkIdx) ||
+			((m_clock - m_chunks[chunkIdx]->lastUse) < CHUNK_IDLE_PUMPS));
+
+		if (!keep && EvictChunk(chunkIdx))
+		{
+			m_liveChunks[i] = m_liveChunks.back();
+			m_liveChunks.pop_back();
+		}
+		else
+			i++;
+	}
+}
+
+bool Board::EvictChunk(int chunkIdx)
+{
+	std::unique_ptr<Chunk>& chunk = m_chunks[chunkIdx];
+
+	// The ooze is about to reach the projected pipes.
+	if (chunk->numProjected > 0)
+		return false;
+
+	// Pipes which are still exploding, or only part full, have to stay as they are.
+	std::vector<unsigned short> packed;
+	if (chunk->modified)
+	{
+		packed.resize(chunk->tiles.size());
+		for (int i = 0; i < static_cast<int>(chunk->tiles.size()); i++)
+		{
+			if (!PackTile(chunk->tiles[i], packed[i]))
+				return false;
+		}
+	}
+
+	for (TilePiece* tile : chunk->tiles)
+		delete tile;
+
+	// Unmodified chunks can be generated again from scratch.
+	if (!chunk->modified)
+		chunk.reset();
+	else
+	{
+		chunk->tiles.clear();
+		chunk->tiles.shrink_to_fit();
+		chunk->projected.clear();
+		chunk->projected.shrink_to_fit();
+		chunk->packed.swap(packed);
+	}
+
+	return true;
+}
+
+void Board::FreeChunks()
+{
+	for (std::unique_ptr<Chunk>& chunk : m_chunks)
+	{
+		if (chunk != nullptr)
+		{
+			for (TilePiece* tile : chunk->tiles)
+				delete tile;
+
+			chunk.reset();
+		}
+	}
+
+	m_liveChunks.clear();
+	m_explosions.clear();
+	UnindexFronts();
+	m_fronts.clear();
+	m_sources.clear();
+	m_lastSpill = Front();
+	m_projection.clear();
+	m_clock = 0;
+}
+
+bool Board::PackTile(const TilePiece* tile, unsigned short& packed)
+{
+	packed = static_cast<unsigned short>(tile->GetType());
+
+	const Pipe* pipe = dynamic_cast<const Pipe*>(tile);
+	if (pipe == nullptr)
+		return true;
+
+	if (pipe->GetExplosion() > 0)
+		return false;
+
+	// Junctions have several exits, so the one opening they were entered through is kept instead.
+	const Junction* junction = dynamic_cast<const Junction*>(tile);
+	Pipe::Direction dir((junction != nullptr) ? junction->GetEntryDirection() : pipe->GetFlowDirection());
+	packed |= static_cast<unsigned short>(dir << PACKED_DIR_SHIFT);
+
+	const Cross* cross = dynamic_cast<const Cross*>(tile);
+	if (cross != nullptr)
+	{
+		int horizLevel(cross->GetOozeLevel(Cross::WAY_HORIZONTAL));
+		int vertLevel(cross->GetOozeLevel(Cross::WAY_VERTICAL));
+		if (!IsSettled(horizLevel) || !IsSettled(vertLevel))
+			return false;
+
+		packed |= static_cast<unsigned short>(cross->GetBackgroundWay() << PACKED_WAY_SHIFT);
+		if (horizLevel >= MAX_OOZE_LEVEL)
+			packed |= PACKED_FULL;
+		if (vertLevel >= MAX_OOZE_LEVEL)
+			packed |= PACKED_VERT_FULL;
+	}
+	else
+	{
+		if (!IsSettled(pipe->GetOozeLevel()))
+			return false;
+
+		if (pipe->IsFull())
+			packed |= PACKED_FULL;
+	}
+
+	return true;
+}
+
+TilePiece* Board::UnpackTile(unsigned short packed)
+{
+	TilePiece::Type t(static_cast<TilePiece::Type>(packed & PACKED_TYPE_MASK));
+	Pipe::Direction flowDir(static_cast<Pipe::Direction>((packed >> PACKED_DIR_SHIFT) & 0x07));
+
+	if (t == TilePiece::TYPE_NONE)
+		return new TilePiece();
+
+	// Fill the pipes through their openings, so that they end up in the same state 
+	// as they were left by the ooze, including the ways of a Cross which were used up.
+	if (t == TilePiece::TYPE_CROSS)
+	{
+		Cross* cross = new Cross(static_cast<Cross::Way>((packed >> PACKED_WAY_SHIFT) & 0x03));
+		bool horizFull((packed & PACKED_FULL) != 0);
+		bool vertFull((packed & PACKED_VERT_FULL) != 0);
+
+		// The way the ooze flowed through last is filled last, so that it ends up with the same flow direction.
+		bool flowingHoriz((flowDir == Pipe::DIR_E) || (flowDir == Pipe::DIR_W));
+		if (flowingHoriz ? vertFull : horizFull)
+		{
+			cross->SetFlowEntry(flowingHoriz ? Pipe::DIR_N : Pipe::DIR_W);
+			cross->Pump(MAX_OOZE_LEVEL);
+		}
+		if (flowingHoriz ? horizFull : vertFull)
+		{
+			cross->SetFlowEntry(Pipe::GetOppositeDirection(flowDir));
+			cross->Pump(MAX_OOZE_LEVEL);
+		}
+
+		return cross;
+	}
+
+	if (Junction::IsJunction(t))
+	{
+		Junction* junction = new Junction(t);
+		if ((packed & PACKED_FULL) != 0)
+		{
+			junction->SetFlowEntry(flowDir);
+			junction->Pump(MAX_OOZE_LEVEL);
+		}
+
+		return junction;
+	}
+
+	Pipe* pipe = new Pipe(t);
+	if ((packed & PACKED_FULL) != 0)
+	{
+		// Starter pipes know their flow direction from the start.
+		for (int entry = Pipe::DIR_N; !pipe->IsStart() && (entry <= Pipe::DIR_W); entry++)
+		{
+			if (Pipe::GetExitDirection(t, static_cast<Pipe::Direction>(entry)) == flowDir)
+			{
+				pipe->SetFlowEntry(static_cast<Pipe::Direction>(entry));
+				break;
+			}
+		}
+
+		pipe->Pump(MAX_OOZE_LEVEL);
+	}
+
+	return pipe;
+}
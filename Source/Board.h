@@ -31,8 +31,18 @@ SOFTWARE.
 #pragma once
 
 #include <vector>
-#include <map>
+#include <deque>
+#include <memory>
 #include "TilePiece.h"
+#include "Topology.h"
+
+
+// ---- Forward declarations ----
+
+class Randomizer;
+class Queue;
+class WorkerPool;
+class PressureField;
 
 
 // ---- Class Definition ----
@@ -53,16 +63,188 @@ public:
 	 */
 	static const int SCORE_FOR_FREE_BOMB;
 
+	/**
+	 * Width and height, in tiles, of the chunks in which the board's tiles are stored. 
+	 * Chunks are only allocated once one of their tiles is first accessed.
+	 */
+	static const int CHUNK_SIZE;
+
+	/**
+	 * Number of columns and rows of an endless board. Only the chunks the ooze and 
+	 * the player actually get to are ever allocated, so for all practical purposes there is no edge.
+	 */
+	static const int ENDLESS_SIZE;
+
+	/**
+	 * Largest number of starter tiles on the board, see SetNumSources().
+	 */
+	static const int MAX_NUM_SOURCES;
+
+	/**
+	 * Largest number of flow fronts on the board at once. Every junction the ooze flows through adds to the
+	 * fronts, see Junction. Branches which would go beyond this are lost, just as if they had spilled.
+	 */
+	static const int MAX_NUM_FRONTS;
+
+	/**
+	 * What placing a new pipe on a given tile of the board would involve.
+	 */
+	enum Placement
+	{
+		PLACEMENT_NONE = 0,	//< The tile cannot be replaced.
+		PLACEMENT_EMPTY,	//< The tile is empty, the pipe can be placed for free.
+		PLACEMENT_BOMB		//< The tile holds an unused pipe, which a bomb can replace.
+	};
+
 	/**
 	 * Class constructor.
+	 *
+	 * @param numCols	Number of columns on the board.
+	 * @param numRows	Number of rows on the board.
+	 * @param rand		Randomizer used to place the starting tile and create new pipes. 
+	 *					If null, the Randomizer singleton is used.
+	 * @param endless	If true, numCols and numRows are ignored and the board spans ENDLESS_SIZE tiles 
+	 *					in both directions, with pipes scattered about it from the start.
 	 */
-	Board(int numCols, int numRows);
+	Board(int numCols, int numRows, Randomizer* rand = nullptr, bool endless = false);
 
 	/**
-	 * Class destructor. Deletes all entries in m_tileMap.
+	 * Class destructor. Deletes all allocated chunks and their tiles.
 	 */
 	virtual ~Board();
 
+	/**
+	 * True if this board was created as an endless board.
+	 */
+	bool IsEndless() const;
+
+	/**
+	 * Set the number of starter tiles placed by the next call to Reset(). The first one releases 
+	 * its ooze right away, the others after a random delay each. Every source has its own flow front,
+	 * and the round goes on until the ooze of all of them has spilled. Puzzles always have a single source.
+	 *
+	 * @param numSources	Number of starter tiles, limited to 1 to MAX_NUM_SOURCES, 
+	 *						and to one per 16 tiles of the board.
+	 */
+	void SetNumSources(int numSources);
+
+	/**
+	 * Set the threads used by Pump() to advance many flow fronts at once. 
+	 *
+	 * @param workers	Worker threads, which must outlive this Board. If null, all fronts are pumped on the calling thread.
+	 */
+	void SetWorkerPool(WorkerPool* workers);
+
+	/**
+	 * Switch to the pressure game mode, or back, with the next call to Reset(). In pressure mode, the ooze 
+	 * spreads through all connected pipes at once, see PressureField. The round ends once too much of it 
+	 * has leaked out of open ends, or once the pressure in a closed pipeline gets too high. 
+	 * Endless and toroidal boards always play the regular way.
+	 *
+	 * @param pressure	True for the pressure game mode.
+	 */
+	void SetPressureMode(bool pressure);
+
+	/**
+	 * True if the current round is played in the pressure game mode, see SetPressureMode().
+	 */
+	bool IsPressureMode() const;
+
+	/**
+	 * Change how the tiles of the board connect to each other, see Topology. Takes effect right away, 
+	 * but is meant to be called before Reset(), so that the starter tiles are placed accordingly.
+	 *
+	 * @param kind	Layout of the board. Boards are rectangular unless set otherwise.
+	 */
+	void SetTopology(Topology::Kind kind);
+
+	/**
+	 * Get how the tiles of the board connect to each other.
+	 */
+	const Topology& GetTopology() const;
+
+	/**
+	 * Get the number of flow fronts whose ooze has not spilled yet. There is one per starter tile 
+	 * to begin with, including those which have not released their ooze yet, and one more for each 
+	 * additional branch of every junction the ooze has flowed through.
+	 */
+	int GetNumFronts() const;
+
+	/**
+	 * Get the coordinates of the pipe a flow front is currently flowing into.
+	 *
+	 * @param idx	Index of the front. Sources come first, in the order they were placed, followed by branches in the order they forked.
+	 * @param col	Returns the column of the front's pipe.
+	 * @param row	Returns the row of the front's pipe.
+	 */
+	void GetFrontCoords(int idx, int& col, int& row) const;
+
+	/**
+	 * Get the number of calls to Pump() until the starter tile of the given front releases its ooze.
+	 * Zero once the ooze is flowing.
+	 */
+	int GetPumpsUntilRelease(int idx) const;
+
+	/**
+	 * Get the number of pipes the ooze of the first front is going to flow through next, one after the other, 
+	 * before it spills or forks. These are the empty pipes already connected ahead of the pipe it is currently 
+	 * flowing into (see GetOozingCoords()), kept up to date by Pump() and ReplaceTile(). Only the first front 
+	 * is followed, so other fronts getting in its way are not accounted for. Always 0 in the pressure game mode.
+	 */
+	int GetNumProjectedPipes() const;
+
+	/**
+	 * Get the coordinates of one of the pipes the ooze of the first front is going to flow through next.
+	 *
+	 * @param idx	Index of the pipe, in the order the ooze reaches them. See GetNumProjectedPipes().
+	 * @param col	Returns the column of the pipe.
+	 * @param row	Returns the row of the pipe.
+	 */
+	void GetProjectedPipe(int idx, int& col, int& row) const;
+
+	/**
+	 * Get the amount of ooze still to be pumped, until the ooze of the first front reaches one of its projected pipes.
+	 *
+	 * @param idx	Index of the pipe, see GetProjectedPipe(). With GetNumProjectedPipes(), the amount until 
+	 *				the last of them is full, and the ooze spills or forks.
+	 * @return	Amount of ooze, in fixed point units (see OOZE_PER_PERCENT).
+	 */
+	int GetOozeUntilProjectedPipe(int idx) const;
+
+	/**
+	 * Get where the ooze of the first front is going to spill, once it has flowed through all projected pipes.
+	 *
+	 * @param col	Returns the column of the pipe the ooze spills from: the last projected pipe, or the oozing pipe if there are none.
+	 * @param row	Returns the row of that pipe.
+	 * @param dir	Returns the opening through which the ooze spills.
+	 * @return	False if there is no front, or if the ooze is going to fork at a junction instead.
+	 */
+	bool GetProjectedSpill(int& col, int& row, Pipe::Direction& dir) const;
+
+	/**
+	 * Get the score the round ends with, if the ooze of the first front flows through all projected pipes and then spills.
+	 * Once the spill is inevitable, this is the most the round can still score: bombing a projected pipe before the ooze 
+	 * gets there cuts the path short, and the round ends with less.
+	 */
+	int GetProjectedScore() const;
+
+	/**
+	 * Check whether the ooze can no longer get any further than GetProjectedSpill() says, no matter which pipes the player 
+	 * places from now on, so that the round ends with GetProjectedScore() at the most. This is the case once no pipe which 
+	 * would take the ooze any further can reach the tile it spills onto in time, and no bomb is available in time to replace 
+	 * a projected pipe with another one it could flow into. The player may still bomb a projected pipe with one the ooze 
+	 * cannot flow into, making it spill earlier. Only one flow front is ever proven to be bound to spill.
+	 * Takes as long as the projected path, which is far less than a tick.
+	 *
+	 * @param queue				Pipes the player gets to place next. Those beyond the visible ones may be any pipe.
+	 * @param oozePerPlacement	Ooze pumped, at the least, in between two pipes placed by the player.
+	 * @param oozeOffset		Added to the ooze until the ooze reaches each pipe. Positive for the ooze which would 
+	 *							be pumped while the countdown runs out, negative for ooze pumped but not on the board yet.
+	 * @return	True if the ooze is proven to spill where projected, or earlier. False if the player might still prevent it, 
+	 *			or if the ooze forks or there are several fronts.
+	 */
+	bool IsSpillInevitable(const Queue& queue, int oozePerPlacement, int oozeOffset = 0) const;
+
 	/**
 	 * Get the type of the tile at the given coordinates.
 	 * 
@@ -73,27 +255,53 @@ public:
 	TilePiece::Type GetTileType(int col, int row) const;
 
 	/**
-	 * Get the tile at the desired location.
+	 * Get the tile at the desired location. The chunk holding it is allocated or unpacked if needed.
+	 * The returned pointer remains valid until the next call to Pump() or Reset().
 	 */
 	TilePiece* GetTile(int col, int row) const;
 
 	void ReplaceTile(int col, int row, TilePiece::Type t);
 
+	/**
+	 * Check whether a new pipe could be placed on the given tile by the player.
+	 * Empty tiles can always be used. Pipes can be replaced using a bomb, unless they 
+	 * are starter tiles, already contain ooze, or are the pipe ooze is currently flowing into.
+	 *
+	 * @param col	Column of desired tile.
+	 * @param row	Row of desired tile.
+	 * @return	The kind of placement possible on that tile.
+	 */
+	Placement GetPlacement(int col, int row) const;
+
+	/**
+	 * Place a new pipe on the given tile, following the same rules as GetPlacement().
+	 * If an existing pipe needs to be replaced, one of the available bombs is expended.
+	 *
+	 * @param col	Column of desired tile.
+	 * @param row	Row of desired tile.
+	 * @param t		Type of the new pipe.
+	 * @return	The kind of placement which took place. PLACEMENT_NONE if the tile was left untouched.
+	 */
+	Placement PlaceTile(int col, int row, TilePiece::Type t);
+
 	int GetNumRows() const;
 
 	int GetNumCols() const;
 
 	/**
 	 * Pump ooze into the pipes on the board. This method is called at every tick.
-	 * Whichever pipe is m_oozingTile currently, will have its Pump() method called,
-	 * and thus the amount of ooze inside it increased.
+	 * The pipe each flow front is currently in will have its Pump() method called,
+	 * and thus the amount of ooze inside it increased. Full pipes pass the ooze on to their neighbor.
 	 * 
-	 * @param amount	Amount of ooze to insert. The higher the level, 
-	 *					the more ooze amount will be pumped every tick.
-	 * @return	True if the ooze is still contained within m_oozingTile or it's neighbor.
-	 *			False if the ooze has now spilled.
+	 * @param amount	Amount of ooze to insert, in fixed point units (see OOZE_PER_PERCENT). 
+	 *					The higher the level, the more ooze amount will be pumped every tick.
+	 * @param numPumps	Number of ticks the amount was pumped over, if it was gathered elsewhere first 
+	 *					(see BatchSimulator). The clock which releases the starter tiles and ages the chunks 
+	 *					advances by this many pumps, though the amount is inserted all at once.
+	 * @return	True if the ooze of any front is still contained within its pipe or that pipe's neighbor.
+	 *			False if the ooze of all fronts has now spilled.
 	 */
-	bool Pump(float amount);
+	bool Pump(int amount, int numPumps = 1);
 
 	/**
 	 * Resets score, bombs, clears all tiles, and repositions starting tile
@@ -101,9 +309,62 @@ public:
 	 */
 	void Reset();
 
+	/**
+	 * Resets score and bombs, and fills the board with the given layout of tiles, 
+	 * e.g. the pre-placed tiles of a puzzle.
+	 *
+	 * @param layout	Type of every tile, indexed by col + (row * numCols). Must contain exactly one starter tile.
+	 * @param numBombs	Number of bombs available this round.
+	 */
+	void Reset(const std::vector<TilePiece::Type>& layout, int numBombs);
+
+	/**
+	 * Place the starter tiles at random positions, see SetNumSources().
+	 */
 	void CreateRandomStart();
 
-	TilePiece* FindNeighbor(TilePiece* p, Pipe::Direction d) /*const*/; // TODO: const deadlock
+	/**
+	 * Get the tile next to the given one. Only tiles which are currently allocated are searched 
+	 * for the given pointer, so prefer the overload taking coordinates whenever they are known.
+	 *
+	 * @param p	Tile whose neighbor to find.
+	 * @param d	Direction of the neighbor.
+	 * @return	The neighboring tile, or null if p is not on the board or d points over the edge.
+	 */
+	TilePiece* FindNeighbor(TilePiece* p, Pipe::Direction d) const;
+
+	/**
+	 * Get the tile next to the given coordinates.
+	 *
+	 * @param col	Column of the tile whose neighbor to find.
+	 * @param row	Row of the tile whose neighbor to find.
+	 * @param d		Direction of the neighbor.
+	 * @return	The neighboring tile, or null if d points over the edge of a rectangular board, see SetTopology().
+	 */
+	TilePiece* FindNeighbor(int col, int row, Pipe::Direction d) const;
+
+	/**
+	 * Fade out the explosions on all replaced pipes by one step. This method is called at every tick.
+	 *
+	 * @return	True if any pipe was still exploding.
+	 */
+	bool PopExplosions();
+
+	/**
+	 * Get the number of chunks whose tiles are currently allocated, for diagnostics.
+	 * This stays bounded no matter how far the ooze travels, as chunks it has left 
+	 * behind are eventually packed or freed.
+	 */
+	int GetNumLiveChunks() const;
+
+	/**
+	 * Get the coordinates of the pipe on the board, in which the ooze level is currently increasing.
+	 * With several sources, this is the first front whose ooze has not spilled yet. 
+	 *
+	 * @param col	Returns the column of the oozing tile.
+	 * @param row	Returns the row of the oozing tile.
+	 */
+	void GetOozingCoords(int& col, int& row) const;
 
 	/**
 	 * Get the score gained so far in this round.
@@ -135,24 +396,406 @@ public:
 	 *
 	 * @return	Score until next restored bomb, in percent.
 	 */
-	int GetPercentUntilFreeBomb();
+	int GetPercentUntilFreeBomb() const;
 
 	/**
 	 * Get the pipe on the board, in which the ooze level is currently increasing.
+	 * With several sources, this is the first front whose ooze has not spilled yet. 
+	 * Once all have spilled, it is the pipe the ooze spilled from last.
 	 */
 	TilePiece* GetOozingTile() const;
 
 private:
 	/**
-	 * Pipe piece in which the ooze level is currently increasing.
+	 * Ooze flowing from one of the starter tiles, or from one of the branches of a junction.
+	 */
+	struct Front
+	{
+		TilePiece* tile = nullptr;	//< Pipe the ooze is currently flowing into.
+		int col = 0;
+		int row = 0;
+		Pipe::Direction exit = Pipe::DIR_NONE;	//< Opening the ooze leaves through, if not the pipe's flow direction.
+		int releasePump = 0;		//< Value of m_clock from which on the starter tile releases its ooze.
+		bool flowing = true;		//< False once the ooze has spilled.
+		bool full = false;			//< Set by PumpFronts() if the pipe is full, and the ooze needs to move on.
+		int scoreGained = 0;		//< Set by PumpFronts() to the score of the pipe, if it was filled up.
+	};
+
+	/**
+	 * Entry of m_frontSlots.
+	 */
+	struct FrontSlot
+	{
+		const TilePiece* tile = nullptr;	//< Pipe the ooze of the front is flowing into. Null if the slot is free.
+		int idx = -1;						//< Index of the front within m_fronts.
+	};
+
+	/**
+	 * Pump ooze into the pipes of the given range of fronts. Each front only touches its own entry of m_fronts,
+	 * and its own pipe. Only the branches of a junction share a pipe, which is full by then and only looked at.
+	 * So ranges can be processed in parallel.
+	 *
+	 * @param begin		Index of the first front to pump.
+	 * @param end		Index after the last front to pump.
+	 * @param amount	Amount of ooze to insert.
+	 */
+	void PumpFronts(int begin, int end, int amount);
+
+	/**
+	 * Let the ooze of a front with a full pipe flow on into the neighboring pipe, or spill.
+	 * Fronts leaving a junction fork, and the new fronts are added to the end of m_fronts.
+	 *
+	 * @param idx	Index of the front within m_fronts.
+	 */
+	void AdvanceFront(int idx);
+
+	/**
+	 * Get a front whose ooze is flowing into the given pipe, if any. Fronts which have spilled are ignored.
+	 * If several branches of a junction are on the pipe, this is the first of them within m_fronts.
+	 * Looked up in m_frontSlots, so it takes the same time no matter how many fronts there are.
 	 */
-	TilePiece* m_oozingTile;
+	const Front* FindFront(const TilePiece* tile) const;
+
+	/**
+	 * Get the slot of m_frontSlots at which the search for the fronts on the given pipe starts.
+	 */
+	int GetFrontSlot(const TilePiece* tile) const;
+
+	/**
+	 * Add a front to m_frontSlots, once its ooze flows into a new pipe.
+	 *
+	 * @param idx	Index of the front within m_fronts.
+	 */
+	void IndexFront(int idx);
+
+	/**
+	 * Remove a front from m_frontSlots, once it leaves its pipe or spills.
+	 *
+	 * @param idx	Index of the front within m_fronts.
+	 */
+	void UnindexFront(int idx);
+
+	/**
+	 * Update the index of a front within m_frontSlots, after it moved to another entry of m_fronts.
+	 *
+	 * @param oldIdx	Index of the front before it moved.
+	 * @param newIdx	Index of the front now.
+	 */
+	void ReindexFront(int oldIdx, int newIdx);
+
+	/**
+	 * Add all fronts which have not spilled to m_frontSlots, after they were set up for a new round.
+	 */
+	void IndexFronts();
+
+	/**
+	 * Remove all fronts from m_frontSlots, before m_fronts is cleared.
+	 */
+	void UnindexFronts();
+
+	/**
+	 * Create, clear or drop the PressureField for a new round, depending on SetPressureMode().
+	 */
+	void ResetPressure();
+
+	/**
+	 * Pump() for the pressure game mode. Steps the PressureField, and shows its fill levels in the pipes.
+	 * The fronts stay on their starter tiles, which serve as the inlets.
+	 */
+	bool PumpPressure(int amount);
+
+	/**
+	 * Show the fill level of the given tile of the PressureField in its pipe, and score the pipe once it is full.
+	 */
+	void ShowPressure(int col, int row);
+
+	/**
+	 * Add the score of a newly filled pipe, and restore a bomb once enough has been scored.
+	 */
+	void AddScore(int score);
+
+	/**
+	 * One of the pipes on the path of the first front, see GetNumProjectedPipes().
+	 */
+	struct ProjectedPipe
+	{
+		int col = 0;
+		int row = 0;
+		Pipe::Direction exit = Pipe::DIR_NONE;	//< Opening the ooze is going to leave the pipe through.
+	};
+
+	/**
+	 * Follow the first front anew, from the pipe its ooze is currently flowing into.
+	 */
+	void RebuildProjection();
+
+	/**
+	 * Keep m_projection in step with the first front, after it may have moved on. If it has only flowed into 
+	 * the next projected pipe, the pipe it left is dropped, otherwise the projection is rebuilt.
+	 */
+	void AdvanceProjection();
+
+	/**
+	 * Follow the connected pipes on from the last projected pipe, for as long as the ooze could flow through them.
+	 */
+	void ExtendProjection();
+
+	/**
+	 * Drop the projected pipes from the given one on, after its tile was replaced, and follow the pipes anew from there.
+	 * If the tile lies right beyond the last projected pipe, the projection is extended instead.
+	 */
+	void UpdateProjection(int col, int row);
+
+	/**
+	 * Drop all pipes from m_projection, and their serial numbers from the chunks.
+	 */
+	void ClearProjection();
+
+	/**
+	 * Store the serial number of a projected pipe with its tile, see Chunk::projected. 
+	 * The tile's chunk has to be loaded, which it is once the pipe has been looked at.
+	 *
+	 * @param col		Column of the pipe.
+	 * @param row		Row of the pipe.
+	 * @param exit		Opening the ooze is going to leave the pipe through. Each way of a Cross-Pipe has its own serial number.
+	 * @param serial	Serial number of the pipe, or -1 once it is no longer projected.
+	 */
+	void SetProjectedSerial(int col, int row, Pipe::Direction exit, int serial);
+
+	/**
+	 * Get the serial number of the projected pipe at the given tile and way, or -1 if there is none. See SetProjectedSerial().
+	 */
+	int GetProjectedSerial(int col, int row, Pipe::Direction exit) const;
+
+	/**
+	 * Get the serial number (see m_projectionBase) of the first projected pipe at the given tile, or -1 if there is none.
+	 */
+	int FindProjectedPipe(int col, int row) const;
+
+	/**
+	 * Get the score gained once the ooze has filled the given pipe of m_projection, see GetProjectedScore().
+	 * A Cross-Pipe scores the bonus if its other way is full already, or gets filled earlier on the path.
+	 *
+	 * @param pos	Position of the pipe within m_projection.
+	 */
+	int GetProjectedPipeScore(int pos) const;
+
+	/**
+	 * Square section of the board, see CHUNK_SIZE. Chunks on the right and bottom edge may be smaller.
+	 */
+	struct Chunk
+	{
+		int numCols = 0;
+		int numRows = 0;
+
+		/**
+		 * Tiles of the chunk, indexed by col + (row * numCols) relative to the chunk. Empty while packed.
+		 */
+		std::vector<TilePiece*> tiles;
+
+		/**
+		 * Tiles of the chunk in packed form, see PackTile(). Empty unless packed.
+		 */
+		std::vector<unsigned short> packed;
+
+		/**
+		 * False as long as the chunk holds exactly what GenerateChunk() put in it, in which 
+		 * case it can simply be freed, and generated again the next time it is needed.
+		 */
+		bool modified = false;
+
+		/**
+		 * Value of m_clock when one of the chunk's tiles was last accessed.
+		 */
+		int lastUse = 0;
+
+		/**
+		 * Serial number (see m_projectionBase) of the projected pipe on every tile, by way: ((col + (row * numCols)) * 2),
+		 * plus one for the vertical way of a Cross-Pipe. -1 where no pipe is projected. Empty while packed.
+		 */
+		std::vector<int> projected;
+
+		/**
+		 * Number of entries of projected which are not -1. Chunks with projected pipes are never evicted.
+		 */
+		int numProjected = 0;
+	};
+
+	/**
+	 * Get a reference to the tile pointer stored at the given location, allocating or unpacking its chunk if needed.
+	 *
+	 * @param col		Column of desired tile.
+	 * @param row		Row of desired tile.
+	 * @param modify	Set to true if the tile is going to be replaced, so that its chunk is not regenerated later.
+	 */
+	TilePiece*& GetTileRef(int col, int row, bool modify = false) const;
+
+	/**
+	 * Allocate the tiles of the given chunk, either by generating them or by unpacking them.
+	 *
+	 * @param chunkIdx	Index of the chunk within m_chunks.
+	 * @return	The chunk, with its tiles allocated.
+	 */
+	Chunk* LoadChunk(int chunkIdx) const;
+
+	/**
+	 * Fill a newly allocated chunk with its initial tiles. On endless boards these are 
+	 * scattered pipes, which only depend on m_seed and the chunk's location.
+	 */
+	void GenerateChunk(Chunk& chunk, int chunkIdx) const;
+
+	/**
+	 * Free or pack the chunks which have not been accessed for a while, and are not close to the ooze.
+	 */
+	void CompactChunks();
+
+	/**
+	 * Free the tiles of the given chunk. Unmodified chunks are freed altogether.
+	 *
+	 * @return	False if the chunk holds tiles which cannot be packed, and was left untouched.
+	 */
+	bool EvictChunk(int chunkIdx);
+
+	/**
+	 * Delete all chunks and their tiles.
+	 */
+	void FreeChunks();
+
+	/**
+	 * Store the given tile in 16 bits. Only tiles whose pipes are either empty or full can be packed,
+	 * as they are all the ooze leaves behind. 
+	 *
+	 * @param tile		Tile to pack.
+	 * @param packed	Returns the packed tile.
+	 * @return	False if the tile cannot be packed.
+	 */
+	static bool PackTile(const TilePiece* tile, unsigned short& packed);
+
+	/**
+	 * Create a tile from its packed form, see PackTile().
+	 */
+	static TilePiece* UnpackTile(unsigned short packed);
+
+	/**
+	 * Worklist of the flow fronts whose ooze has not spilled yet, see GetFrontCoords(). Each knows 
+	 * the coordinates of its pipe, so that its neighbors can be found without searching the board.
+	 * Spilled fronts are removed at the end of each Pump(). Its capacity carries over from round to round, 
+	 * so fronts come and go without any allocations.
+	 */
+	std::vector<Front> m_fronts;
+
+	/**
+	 * Open-addressed hash table with linear probing, holding every front which has not spilled, by the pipe 
+	 * its ooze is flowing into. Only the branches of a junction share a pipe. See FindFront(). It is sized once, 
+	 * to at least twice the number of fronts the board can ever hold, so it never fills up, and keeping it 
+	 * up to date never allocates.
+	 */
+	std::vector<FrontSlot> m_frontSlots;
+
+	/**
+	 * Size of m_frontSlots as a power of two.
+	 */
+	int m_frontSlotBits;
+
+	/**
+	 * The front which spilled last, returned by GetOozingTile() once all have spilled.
+	 */
+	Front m_lastSpill;
+
+	/**
+	 * Location of every starter tile, which GenerateChunk() keeps clear of pipes.
+	 */
+	std::vector<std::pair<int, int>> m_sources;
+
+	/**
+	 * Number of starter tiles placed by CreateRandomStart().
+	 */
+	int m_numSources;
+
+	/**
+	 * Threads used to pump many fronts at once. Can be null.
+	 */
+	WorkerPool* m_workers;
+
+	/**
+	 * True if the pressure game mode was chosen, see SetPressureMode().
+	 */
+	bool m_pressureMode;
+
+	/**
+	 * Path of the first front: the pipe its ooze is currently flowing into, followed by the projected pipes, 
+	 * see GetNumProjectedPipes(). Pipes are dropped from the front as the ooze moves on, and from the back 
+	 * as tiles get replaced, so that every update only touches the part of the path which changed.
+	 */
+	std::deque<ProjectedPipe> m_projection;
+
+	/**
+	 * Serial number of the first pipe in m_projection. Pipes keep their serial number for as long as they are projected.
+	 */
+	int m_projectionBase;
+
+	/**
+	 * True if the last pipe in m_projection is a junction, where the ooze forks instead of spilling.
+	 */
+	bool m_projectionForks;
+
+	/**
+	 * Fill levels of the current round in the pressure game mode. Null when playing the regular way.
+	 */
+	std::unique_ptr<PressureField> m_pressure;
+
+	/**
+	 * Buffers passed to m_pressure with every Pump(), kept from pump to pump to avoid allocations.
+	 */
+	std::vector<std::pair<int, int>> m_inlets;
+	std::vector<std::pair<int, int>> m_risen;
 
 	int m_numCols;
 	int m_numRows;
 
-	typedef std::pair<int, int> Coord;
-	std::map<Coord, TilePiece*> m_tileMap;
+	bool m_endless;
+
+	/**
+	 * Neighbors of every tile, see SetTopology().
+	 */
+	Topology m_topology;
+
+	/**
+	 * Seed of the pipes scattered on an endless board. Drawn from m_randomizer on every Reset().
+	 */
+	unsigned int m_seed;
+
+	/**
+	 * All chunks of the board, row by row. The tile at (col, row) is found in the chunk at index 
+	 * (col / CHUNK_SIZE) + ((row / CHUNK_SIZE) * m_numChunkCols). Null until first accessed.
+	 */
+	mutable std::vector<std::unique_ptr<Chunk>> m_chunks;
+	int m_numChunkCols;
+
+	/**
+	 * Indices of the chunks whose tiles are currently allocated.
+	 */
+	mutable std::vector<int> m_liveChunks;
+
+	/**
+	 * Chunks around the fronts, collected by CompactChunks(). Kept from pass to pass to avoid allocations.
+	 */
+	std::vector<int> m_frontChunks;
+
+	/**
+	 * Number of calls to Pump() since the last Reset(). Used to tell how long ago a chunk was last accessed.
+	 */
+	int m_clock;
+
+	/**
+	 * Coordinates of the replaced pipes whose explosion has not faded out yet.
+	 */
+	std::vector<std::pair<int, int>> m_explosions;
+
+	/**
+	 * Randomizer used to place the starting tile and create new pipes.
+	 */
+	Randomizer* m_randomizer;
 
 	int m_score;
 
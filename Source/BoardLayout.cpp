@@ -0,0 +1,161 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "BoardLayout.h"
+#include "Board.h"
+
+
+
+// ---- Helper types and constants ----
+
+/**
+ * Number of tiles which fit in the board area at the default zoom.
+ */
+static const int VIEW_COLS(10);
+static const int VIEW_ROWS(7);
+
+
+// ---- Class Implementation ----
+
+BoardLayout::BoardLayout()
+{
+}
+
+BoardLayout::BoardLayout(int width, int height)
+{
+	// Scale tiles according to the game window's both width and height.
+	int minDimension = std::min<int>(width, static_cast<int>(height * 1.4516f));
+	m_tileSize = static_cast<int>(minDimension / 13.0f);
+	int halfTile = m_tileSize / 2;
+
+	// All other proportions were tuned on the default 900x620 window.
+	m_boardOrigin = juce::Point<int>(static_cast<int>(width / 5.114f), static_cast<int>(height / 7.75f));
+	m_queueOrigin = juce::Point<int>(width / 18, static_cast<int>(height / 1.3757f));
+	m_oozeMeterRect = juce::Rectangle<int>(static_cast<int>(width / 12.05f), 30, 22, static_cast<int>(height / 5.2542f));
+
+	m_levelLabelRect = juce::Rectangle<int>(static_cast<int>(width / 5.114f), 20, static_cast<int>(width / 9.7826f), halfTile);
+	m_levelNumberRect = juce::Rectangle<int>(static_cast<int>(width / 3.375f), 20, static_cast<int>(width / 17.31f), halfTile);
+	m_scoreLabelRect = juce::Rectangle<int>(static_cast<int>(width / 2.8421f), 20, static_cast<int>(width / 9.7826f), halfTile);
+	m_scoreNumberRect = juce::Rectangle<int>(static_cast<int>(width / 2.1880f), 20, static_cast<int>(width / 5.625f), halfTile);
+
+	m_bombsOrigin = juce::Point<int>(static_cast<int>(width / 1.6749f), 20);
+	m_fastForwardRect = juce::Rectangle<float>(width / 18.0f, height / 1.1245f, 70.0f, 45.0f).toNearestInt();
+
+	m_infoTextRect = juce::Rectangle<int>(m_boardOrigin.getX(), height - 50, static_cast<int>(width / 5.625f), 40);
+	m_hyperlinkRect = juce::Rectangle<int>(static_cast<int>(width / 1.8f), height - 50, static_cast<int>(width / 2.4545f), 40);
+}
+
+int BoardLayout::GetTileSize() const
+{
+	return m_tileSize;
+}
+
+int BoardLayout::GetTilePitch() const
+{
+	return m_tileSize - 1;
+}
+
+juce::Rectangle<int> BoardLayout::GetBoardRect() const
+{
+	// Neighbouring tiles share a pixel, so the last tile of each row and column adds one more.
+	return juce::Rectangle<int>(m_boardOrigin.getX(), m_boardOrigin.getY(), 
+								VIEW_COLS * GetTilePitch() + 1, VIEW_ROWS * GetTilePitch() + 1);
+}
+
+juce::Point<int> BoardLayout::GetQueueTileOrigin(int index) const
+{
+	return juce::Point<int>(m_queueOrigin.getX(), m_queueOrigin.getY() - index * GetTilePitch());
+}
+
+juce::Rectangle<int> BoardLayout::GetQueueRect(int numTiles) const
+{
+	int top = GetQueueTileOrigin(std::max(0, numTiles - 1)).getY();
+	int bottom = m_queueOrigin.getY() + m_tileSize;
+
+	return juce::Rectangle<int>(m_queueOrigin.getX(), top, m_tileSize, bottom - top);
+}
+
+juce::Rectangle<int> BoardLayout::GetOozeMeterRect() const
+{
+	return m_oozeMeterRect;
+}
+
+juce::Rectangle<int> BoardLayout::GetLevelLabelRect() const
+{
+	return m_levelLabelRect;
+}
+
+juce::Rectangle<int> BoardLayout::GetLevelNumberRect() const
+{
+	return m_levelNumberRect;
+}
+
+juce::Rectangle<int> BoardLayout::GetScoreLabelRect() const
+{
+	return m_scoreLabelRect;
+}
+
+juce::Rectangle<int> BoardLayout::GetScoreNumberRect() const
+{
+	return m_scoreNumberRect;
+}
+
+juce::Rectangle<int> BoardLayout::GetScoreRect() const
+{
+	return m_levelLabelRect.getUnion(m_levelNumberRect).getUnion(m_scoreLabelRect).getUnion(m_scoreNumberRect);
+}
+
+juce::Rectangle<int> BoardLayout::GetBombRect(int index) const
+{
+	int halfTile = m_tileSize / 2;
+
+	return juce::Rectangle<int>(m_bombsOrigin.getX() + index * GetTilePitch(), m_bombsOrigin.getY(), halfTile, halfTile);
+}
+
+juce::Rectangle<int> BoardLayout::GetBombsRect() const
+{
+	return GetBombRect(0).getUnion(GetBombRect(Board::MAX_NUM_BOMBS - 1));
+}
+
+juce::Rectangle<int> BoardLayout::GetFastForwardRect() const
+{
+	return m_fastForwardRect;
+}
+
+juce::Rectangle<int> BoardLayout::GetInfoTextRect() const
+{
+	return m_infoTextRect;
+}
+
+juce::Rectangle<int> BoardLayout::GetHyperlinkRect() const
+{
+	return m_hyperlinkRect;
+}
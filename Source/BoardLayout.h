@@ -0,0 +1,144 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+// ---- Class Definition ----
+
+/**
+ * Positions and sizes of everything on the game window: the board, the queue and the HUD.
+ * Computed once per window size, and shared by painting and mouse input, so that both always agree.
+ * Tiles overlap their neighbours by one pixel, so that adjacent frames merge into a single line.
+ */
+class BoardLayout
+{
+public:
+	/**
+	 * Class constructor, for an empty window.
+	 */
+	BoardLayout();
+
+	/**
+	 * Class constructor.
+	 *
+	 * @param width		Width of the game window, in pixels.
+	 * @param height	Height of the game window, in pixels.
+	 */
+	BoardLayout(int width, int height);
+
+	/**
+	 * Get the width & height of a tile piece, in pixels.
+	 */
+	int GetTileSize() const;
+
+	/**
+	 * Get the distance between the origins of two neighbouring tiles, in pixels.
+	 */
+	int GetTilePitch() const;
+
+	/**
+	 * Get the area of the window in which the board is shown. At the default zoom, 
+	 * it fits a 10x7 board exactly. Larger boards are scrolled and zoomed within it, see BoardView.
+	 */
+	juce::Rectangle<int> GetBoardRect() const;
+
+	/**
+	 * Get the origin of a tile in the queue.
+	 *
+	 * @param index		Position in the queue, 0 being the next tile, which is the bottommost.
+	 */
+	juce::Point<int> GetQueueTileOrigin(int index) const;
+
+	/**
+	 * Get the rectangle occupied by the queue, not counting the frame around its next tile.
+	 *
+	 * @param numTiles	Number of tiles in the queue.
+	 */
+	juce::Rectangle<int> GetQueueRect(int numTiles) const;
+
+	/**
+	 * Get the rectangle occupied by the vial showing the countdown until the ooze starts flowing.
+	 */
+	juce::Rectangle<int> GetOozeMeterRect() const;
+
+	/**
+	 * Get the rectangles of the labels and numbers on the top of the window.
+	 */
+	juce::Rectangle<int> GetLevelLabelRect() const;
+	juce::Rectangle<int> GetLevelNumberRect() const;
+	juce::Rectangle<int> GetScoreLabelRect() const;
+	juce::Rectangle<int> GetScoreNumberRect() const;
+
+	/**
+	 * Get the rectangle covering all labels and numbers on the top of the window.
+	 */
+	juce::Rectangle<int> GetScoreRect() const;
+
+	/**
+	 * Get the rectangle occupied by a bomb.
+	 *
+	 * @param index		Index of the bomb, starting at 0 on the left.
+	 */
+	juce::Rectangle<int> GetBombRect(int index) const;
+
+	/**
+	 * Get the rectangle occupied by all bombs.
+	 */
+	juce::Rectangle<int> GetBombsRect() const;
+
+	/**
+	 * Get the rectangle occupied by the fast-forward button.
+	 */
+	juce::Rectangle<int> GetFastForwardRect() const;
+
+	/**
+	 * Get the rectangles of the version info text and of the hyperlink at the bottom of the window.
+	 */
+	juce::Rectangle<int> GetInfoTextRect() const;
+	juce::Rectangle<int> GetHyperlinkRect() const;
+
+private:
+	int m_tileSize = 0;
+	juce::Point<int> m_boardOrigin;
+	juce::Point<int> m_queueOrigin;
+	juce::Rectangle<int> m_oozeMeterRect;
+	juce::Rectangle<int> m_levelLabelRect;
+	juce::Rectangle<int> m_levelNumberRect;
+	juce::Rectangle<int> m_scoreLabelRect;
+	juce::Rectangle<int> m_scoreNumberRect;
+	juce::Point<int> m_bombsOrigin;
+	juce::Rectangle<int> m_fastForwardRect;
+	juce::Rectangle<int> m_infoTextRect;
+	juce::Rectangle<int> m_hyperlinkRect;
+};
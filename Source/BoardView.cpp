@@ -0,0 +1,227 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "BoardView.h"
+
+
+
+// ---- Helper types and constants ----
+
+const int BoardView::MIN_TILE_SIZE(4);
+const int BoardView::LOD_TILE_SIZE(16);
+const int BoardView::MAX_ZOOM(4);
+const float BoardView::ZOOM_STEP(1.25f);
+
+
+// ---- Class Implementation ----
+
+BoardView::BoardView()
+{
+}
+
+void BoardView::SetBounds(juce::Rectangle<int> area, int defaultTileSize, int numCols, int numRows)
+{
+	if ((numCols != m_numCols) || (numRows != m_numRows) || (m_tileSize <= 0))
+	{
+		// A new board starts off at the default zoom, from its top-left corner.
+		m_zoom = 1.0f;
+		m_scroll = juce::Point<int>(0, 0);
+		m_area = area;
+		m_defaultTileSize = defaultTileSize;
+		m_numCols = numCols;
+		m_numRows = numRows;
+		UpdateTileSize();
+	}
+
+	else
+	{
+		// Keep the same spot of the board in the middle, at the same zoom.
+		int pitch = GetTilePitch();
+		float centreX = (m_scroll.getX() + (m_area.getWidth() / 2.0f)) / pitch;
+		float centreY = (m_scroll.getY() + (m_area.getHeight() / 2.0f)) / pitch;
+
+		m_area = area;
+		m_defaultTileSize = defaultTileSize;
+		UpdateTileSize();
+
+		pitch = GetTilePitch();
+		m_scroll = juce::Point<int>(juce::roundToInt(centreX * pitch - (m_area.getWidth() / 2.0f)), 
+									juce::roundToInt(centreY * pitch - (m_area.getHeight() / 2.0f)));
+	}
+
+	ClampScroll();
+}
+
+juce::Rectangle<int> BoardView::GetArea() const
+{
+	return m_area;
+}
+
+int BoardView::GetTileSize() const
+{
+	return m_tileSize;
+}
+
+int BoardView::GetTilePitch() const
+{
+	return m_tileSize - 1;
+}
+
+bool BoardView::IsDetailed() const
+{
+	return (m_tileSize >= LOD_TILE_SIZE);
+}
+
+juce::Rectangle<int> BoardView::GetTileRect(int col, int row) const
+{
+	return juce::Rectangle<int>(m_area.getX() - m_scroll.getX() + col * GetTilePitch(),
+								m_area.getY() - m_scroll.getY() + row * GetTilePitch(),
+								m_tileSize, m_tileSize);
+}
+
+juce::Rectangle<int> BoardView::GetBoardBounds() const
+{
+	return juce::Rectangle<int>(m_area.getX() - m_scroll.getX(), m_area.getY() - m_scroll.getY(),
+								m_numCols * GetTilePitch() + 1, m_numRows * GetTilePitch() + 1);
+}
+
+bool BoardView::GetCellAt(juce::Point<int> pos, int& col, int& row) const
+{
+	int pitch = GetTilePitch();
+	int x = pos.getX() - m_area.getX() + m_scroll.getX();
+	int y = pos.getY() - m_area.getY() + m_scroll.getY();
+	if ((pitch <= 0) || !m_area.contains(pos) || (x < 0) || (y < 0))
+		return false;
+
+	// Each tile's last pixel is the next tile's first one. The earlier tile wins it.
+	int c = std::max(0, x - 1) / pitch;
+	int r = std::max(0, y - 1) / pitch;
+	if ((c >= m_numCols) || (r >= m_numRows))
+		return false;
+
+	col = c;
+	row = r;
+	return true;
+}
+
+juce::Rectangle<int> BoardView::GetVisibleCells() const
+{
+	int pitch = GetTilePitch();
+	if (pitch <= 0)
+		return juce::Rectangle<int>();
+
+	// Pixels of the board within the view, counted from the board's top-left corner.
+	juce::Rectangle<int> board(0, 0, m_numCols * pitch + 1, m_numRows * pitch + 1);
+	juce::Rectangle<int> visible(board.getIntersection(m_area.withPosition(m_scroll)));
+	if (visible.isEmpty())
+		return juce::Rectangle<int>();
+
+	// A pixel shared by two tiles shows a bit of both.
+	int firstCol = std::max(0, visible.getX() - 1) / pitch;
+	int firstRow = std::max(0, visible.getY() - 1) / pitch;
+	int endCol = std::min(m_numCols, ((visible.getRight() - 1) / pitch) + 1);
+	int endRow = std::min(m_numRows, ((visible.getBottom() - 1) / pitch) + 1);
+
+	return juce::Rectangle<int>(firstCol, firstRow, endCol - firstCol, endRow - firstRow);
+}
+
+bool BoardView::Zoom(float steps, juce::Point<int> anchor)
+{
+	if ((m_tileSize <= 0) || (m_defaultTileSize <= 0))
+		return false;
+
+	int oldTileSize = m_tileSize;
+	float minZoom = static_cast<float>(MIN_TILE_SIZE) / m_defaultTileSize;
+	m_zoom = juce::jlimit(std::min(minZoom, 1.0f), static_cast<float>(MAX_ZOOM), m_zoom * std::pow(ZOOM_STEP, steps));
+	UpdateTileSize();
+	if (m_tileSize == oldTileSize)
+		return false;
+
+	// Same spot of the board under the anchor, in tiles, before and after.
+	int oldPitch = oldTileSize - 1;
+	int anchorX = anchor.getX() - m_area.getX();
+	int anchorY = anchor.getY() - m_area.getY();
+	float tileX = static_cast<float>(m_scroll.getX() + anchorX) / oldPitch;
+	float tileY = static_cast<float>(m_scroll.getY() + anchorY) / oldPitch;
+
+	m_scroll = juce::Point<int>(juce::roundToInt(tileX * GetTilePitch()) - anchorX,
+								juce::roundToInt(tileY * GetTilePitch()) - anchorY);
+	ClampScroll();
+
+	return true;
+}
+
+bool BoardView::Pan(int deltaX, int deltaY)
+{
+	juce::Point<int> oldScroll(m_scroll);
+	m_scroll -= juce::Point<int>(deltaX, deltaY);
+	ClampScroll();
+
+	return (m_scroll != oldScroll);
+}
+
+bool BoardView::CentreOn(int col, int row)
+{
+	juce::Point<int> oldScroll(m_scroll);
+	int halfTile = m_tileSize / 2;
+	m_scroll = juce::Point<int>(col * GetTilePitch() + halfTile - (m_area.getWidth() / 2),
+								row * GetTilePitch() + halfTile - (m_area.getHeight() / 2));
+	ClampScroll();
+
+	return (m_scroll != oldScroll);
+}
+
+void BoardView::UpdateTileSize()
+{
+	m_tileSize = 0;
+	if (m_defaultTileSize > 0)
+		m_tileSize = std::max(std::min(MIN_TILE_SIZE, m_defaultTileSize), juce::roundToInt(m_defaultTileSize * m_zoom));
+}
+
+void BoardView::ClampScroll()
+{
+	int boardWidth = m_numCols * GetTilePitch() + 1;
+	int boardHeight = m_numRows * GetTilePitch() + 1;
+
+	int x = m_scroll.getX();
+	if (boardWidth <= m_area.getWidth())
+		x = (boardWidth - m_area.getWidth()) / 2;
+	else
+		x = juce::jlimit(0, boardWidth - m_area.getWidth(), x);
+
+	int y = m_scroll.getY();
+	if (boardHeight <= m_area.getHeight())
+		y = (boardHeight - m_area.getHeight()) / 2;
+	else
+		y = juce::jlimit(0, boardHeight - m_area.getHeight(), y);
+
+	m_scroll = juce::Point<int>(x, y);
+}
@@ -0,0 +1,196 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+// ---- Class Definition ----
+
+/**
+ * The part of the board on display, and how large its tiles are. The board is shown within a fixed area 
+ * of the window (see BoardLayout::GetBoardRect()), which boards of any size can be panned and zoomed in.
+ * Like BoardLayout, it is shared by painting and mouse input, and everything is computed arithmetically,
+ * so that nothing here depends on the size of the board.
+ *
+ * Tiles overlap their neighbours by one pixel, as in BoardLayout. At the default zoom, the tiles have 
+ * the layout's tile size. Below LOD_TILE_SIZE, tiles are too small for their pipes to be made out, 
+ * and are drawn as flat colours instead, see IsDetailed().
+ */
+class BoardView
+{
+public:
+	/**
+	 * Smallest tile size, in pixels, when zoomed out all the way.
+	 */
+	static const int MIN_TILE_SIZE;
+
+	/**
+	 * Tile size, in pixels, below which tiles are drawn as flat colours.
+	 */
+	static const int LOD_TILE_SIZE;
+
+	/**
+	 * How far the view can be zoomed in, as a multiple of the default tile size.
+	 */
+	static const int MAX_ZOOM;
+
+	/**
+	 * Factor by which the tiles grow with each zoom step, see Zoom().
+	 */
+	static const float ZOOM_STEP;
+
+	/**
+	 * Class constructor, for an empty view.
+	 */
+	BoardView();
+
+	/**
+	 * Set the area of the window in which the board is shown, and the size of the board.
+	 * When only the area changes, e.g. on a resize, the zoom is scaled along and the same cells stay in the middle.
+	 * A new board size goes back to the default zoom, with the top-left corner of the board in view.
+	 *
+	 * @param area				Area of the window covered by the view.
+	 * @param defaultTileSize	Tile size at the default zoom, in pixels.
+	 * @param numCols			Number of columns on the board.
+	 * @param numRows			Number of rows on the board.
+	 */
+	void SetBounds(juce::Rectangle<int> area, int defaultTileSize, int numCols, int numRows);
+
+	/**
+	 * Get the area of the window covered by the view.
+	 */
+	juce::Rectangle<int> GetArea() const;
+
+	/**
+	 * Get the width & height of a tile piece at the current zoom, in pixels.
+	 */
+	int GetTileSize() const;
+
+	/**
+	 * Get the distance between the origins of two neighbouring tiles, in pixels.
+	 */
+	int GetTilePitch() const;
+
+	/**
+	 * Check whether tiles are large enough to be drawn with their pipes, or only as flat colours.
+	 */
+	bool IsDetailed() const;
+
+	/**
+	 * Get the rectangle occupied by a tile on the board. It may lie outside the view's area.
+	 *
+	 * @param col	Column of the tile.
+	 * @param row	Row of the tile.
+	 * @return	The tile's rectangle, relative to the game window.
+	 */
+	juce::Rectangle<int> GetTileRect(int col, int row) const;
+
+	/**
+	 * Get the rectangle occupied by the whole board, relative to the game window. It changes with every 
+	 * pan and zoom, and can be used to tell whether the view moved.
+	 */
+	juce::Rectangle<int> GetBoardBounds() const;
+
+	/**
+	 * Find the board tile at a point of the window, in constant time. On the pixel shared by two neighbouring
+	 * tiles, the one at the top or left wins.
+	 *
+	 * @param pos		Point on the game window.
+	 * @param col		Set to the column of the tile at pos, if any.
+	 * @param row		Set to the row of the tile at pos, if any.
+	 * @return	False if there is no tile at pos, or pos lies outside the view's area.
+	 */
+	bool GetCellAt(juce::Point<int> pos, int& col, int& row) const;
+
+	/**
+	 * Get the columns and rows of all tiles which are at least partly visible.
+	 *
+	 * @return	The visible cells, as column, row, number of columns and number of rows.
+	 */
+	juce::Rectangle<int> GetVisibleCells() const;
+
+	/**
+	 * Zoom in or out, keeping the board still at the given point.
+	 *
+	 * @param steps		Number of zoom steps. Positive steps zoom in, negative ones zoom out.
+	 * @param anchor	Point on the game window which stays on the same spot of the board.
+	 * @return	True if the view changed.
+	 */
+	bool Zoom(float steps, juce::Point<int> anchor);
+
+	/**
+	 * Move the board within the view, as far as the board reaches.
+	 *
+	 * @param deltaX	Horizontal distance to move the board by, in pixels.
+	 * @param deltaY	Vertical distance to move the board by, in pixels.
+	 * @return	True if the view changed.
+	 */
+	bool Pan(int deltaX, int deltaY);
+
+	/**
+	 * Move the board so that the given tile ends up in the middle of the view, as far as the board reaches.
+	 *
+	 * @param col	Column of the tile.
+	 * @param row	Row of the tile.
+	 * @return	True if the view changed.
+	 */
+	bool CentreOn(int col, int row);
+
+private:
+	/**
+	 * Work out the tile size from the default tile size and the zoom.
+	 */
+	void UpdateTileSize();
+
+	/**
+	 * Keep the board from being scrolled away. Boards smaller than the view are centred within it.
+	 */
+	void ClampScroll();
+
+	juce::Rectangle<int> m_area;
+	int m_defaultTileSize = 0;
+	int m_tileSize = 0;
+
+	/**
+	 * Tile size as a multiple of the default tile size.
+	 */
+	float m_zoom = 1.0f;
+
+	int m_numCols = 0;
+	int m_numRows = 0;
+
+	/**
+	 * Point of the board, in pixels from its top-left corner, shown at the top-left corner of the view's area.
+	 */
+	juce::Point<int> m_scroll;
+};
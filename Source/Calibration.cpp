@@ -0,0 +1,381 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "Calibration.h"
+#include "BatchSimulator.h"
+#include "WorkerPool.h"
+#include "Planner.h"
+#include "Board.h"
+#include "Queue.h"
+#include <algorithm>
+#include <cmath>
+
+
+// ---- Helper types and constants ----
+
+/**
+ * Hand-picked ooze pumped per tick, in hundredths of a percent of a pipe (see OOZE_PER_PERCENT), 
+ * and countdown in ticks, of the first levels.
+ */
+static const int OOZE_PER_LEVEL[] = {
+	100,	// Level 1
+	120,	// Level 2
+	140,	// Level 3
+	150,	// Level 4
+	160,	// Level 5
+	180,	// Level 6
+	200,	// Level 7
+	220,	// Level 8
+	250,	// Level 9
+	300,	// Level 10
+	350,	// Level 11
+	500		// Level 12
+};
+
+static_assert(OOZE_PER_PERCENT == 100, "OOZE_PER_LEVEL is given in hundredths of a percent.");
+
+static const int COUNTDOWN_PER_LEVEL[] = {
+	320,	// Level 1
+	290,	// Level 2
+	260,	// Level 3
+	230,	// Level 4
+	200,	// Level 5
+	180,	// Level 6
+	160,	// Level 7
+	140,	// Level 8
+	120,	// Level 9
+	100,	// Level 10
+	80,		// Level 11
+	60		// Level 12
+};
+
+static const int NUM_HAND_PICKED_LEVELS(sizeof(OOZE_PER_LEVEL) / sizeof(*OOZE_PER_LEVEL));
+
+/**
+ * Beyond the hand-picked levels, the ooze gets faster by this factor, and the countdown 
+ * shorter by this many ticks, per point of the difficulty scale.
+ */
+static const float OOZE_GROWTH_PER_DIFFICULTY(1.1f);
+static const int COUNTDOWN_DECREASE_PER_DIFFICULTY(5);
+static const int MIN_COUNTDOWN(30);
+
+/**
+ * Number of rounds simulated together by one BatchSimulator.
+ */
+static const int BATCH_SIZE(64);
+
+const float DifficultyCalibrator::MAX_DIFFICULTY(24.0f);
+
+
+// ---- Class Implementation ----
+
+std::vector<LevelSettings> LevelSettings::GetDefaults()
+{
+	std::vector<LevelSettings> levels(NUM_HAND_PICKED_LEVELS);
+	for (int i = 0; i < NUM_HAND_PICKED_LEVELS; i++)
+	{
+		levels[i].oozePerPump = OOZE_PER_LEVEL[i];
+		levels[i].countdown = COUNTDOWN_PER_LEVEL[i];
+	}
+
+	return levels;
+}
+
+DifficultyCalibrator::DifficultyCalibrator(const Config& config, WorkerPool& workers)
+	: m_config(config),
+	m_workers(workers)
+{
+	if (m_config.policies.empty())
+		m_config.policies.push_back({ 2, 20 });
+
+	// Every policy plays the same number of rounds, in full batches.
+	int numPolicies = static_cast<int>(m_config.policies.size());
+	int batchesPerPolicy = std::max(1, (m_config.numRoundsPerPoint + (numPolicies * BATCH_SIZE) - 1) / (numPolicies * BATCH_SIZE));
+	m_config.numRoundsPerPoint = batchesPerPolicy * numPolicies * BATCH_SIZE;
+}
+
+LevelSettings DifficultyCalibrator::GetSettingsAtDifficulty(float difficulty)
+{
+	difficulty = std::max(0.0f, std::min(difficulty, MAX_DIFFICULTY));
+
+	LevelSettings settings;
+	float lastHandPicked = static_cast<float>(NUM_HAND_PICKED_LEVELS);
+	if (difficulty > lastHandPicked)
+	{
+		float extra = difficulty - lastHandPicked;
+		settings.oozePerPump = static_cast<int>(std::lround(OOZE_PER_LEVEL[NUM_HAND_PICKED_LEVELS - 1] * std::pow(OOZE_GROWTH_PER_DIFFICULTY, extra)));
+		settings.countdown = std::max(MIN_COUNTDOWN, 
+			static_cast<int>(std::lround(COUNTDOWN_PER_LEVEL[NUM_HAND_PICKED_LEVELS - 1] - (extra * COUNTDOWN_DECREASE_PER_DIFFICULTY))));
+
+		return settings;
+	}
+
+	// Interpolate between the two closest hand-picked levels. Below level 1, 
+	// the step between the first two levels is extended backwards.
+	int idx = std::max(0, std::min(static_cast<int>(difficulty) - 1, NUM_HAND_PICKED_LEVELS - 2));
+	float frac = difficulty - static_cast<float>(idx + 1);
+	settings.oozePerPump = static_cast<int>(std::lround(OOZE_PER_LEVEL[idx] + (frac * (OOZE_PER_LEVEL[idx + 1] - OOZE_PER_LEVEL[idx]))));
+	settings.countdown = static_cast<int>(std::lround(COUNTDOWN_PER_LEVEL[idx] + (frac * (COUNTDOWN_PER_LEVEL[idx + 1] - COUNTDOWN_PER_LEVEL[idx]))));
+
+	return settings;
+}
+
+float DifficultyCalibrator::GetTargetPassRate(int level) const
+{
+	if (m_config.numLevels <= 1)
+		return m_config.firstPassRate;
+
+	float pos = static_cast<float>(level - 1) / static_cast<float>(m_config.numLevels - 1);
+
+	return m_config.firstPassRate * std::pow(m_config.lastPassRate / m_config.firstPassRate, pos);
+}
+
+std::vector<float> DifficultyCalibrator::Sweep(const std::vector<float>& difficulties)
+{
+	int numPolicies = static_cast<int>(m_config.policies.size());
+	int batchesPerPolicy = m_config.numRoundsPerPoint / (numPolicies * BATCH_SIZE);
+	int batchesPerPoint = batchesPerPolicy * numPolicies;
+	int numBatches = static_cast<int>(difficulties.size()) * batchesPerPoint;
+
+	// Each batch only writes its own counter, so no locking is needed.
+	std::vector<int> numPassed(numBatches, 0);
+	m_workers.ParallelFor(numBatches, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			int point = i / batchesPerPoint;
+			int policy = (i % batchesPerPoint) / batchesPerPolicy;
+			int batch = i % batchesPerPolicy;
+
+			// The same seeds are played at every point.
+			unsigned int firstSeed = m_config.firstSeed + static_cast<unsigned int>(batch * BATCH_SIZE);
+			numPassed[i] = PlayBatch(GetSettingsAtDifficulty(difficulties[point]), m_config.policies[policy], firstSeed, BATCH_SIZE);
+		}
+	});
+
+	std::vector<float> passRates;
+	for (int point = 0; point < static_cast<int>(difficulties.size()); point++)
+	{
+		Sample sample = { difficulties[point], 0, m_config.numRoundsPerPoint };
+		for (int i = 0; i < batchesPerPoint; i++)
+			sample.numPassed += numPassed[(point * batchesPerPoint) + i];
+
+		m_samples.push_back(sample);
+		passRates.push_back(static_cast<float>(sample.numPassed) / static_cast<float>(sample.numPlayed));
+	}
+
+	m_numRoundsPlayed += static_cast<long long>(difficulties.size()) * m_config.numRoundsPerPoint;
+
+	return passRates;
+}
+
+std::vector<LevelSettings> DifficultyCalibrator::Calibrate()
+{
+	// First sweep across the whole difficulty scale.
+	std::vector<float> difficulties;
+	float spacing = MAX_DIFFICULTY / static_cast<float>(std::max(1, m_config.numSweepPoints - 1));
+	for (int i = 0; i < m_config.numSweepPoints; i++)
+		difficulties.push_back(i * spacing);
+
+	Sweep(difficulties);
+
+	std::vector<float> passRates;
+	std::vector<float> levelDifficulties(Fit(passRates));
+
+	// Then zoom in on each level's difficulty, with ever closer points on either side of it.
+	for (int refinement = 0; refinement < m_config.numRefinements; refinement++)
+	{
+		spacing *= 0.5f;
+
+		difficulties.clear();
+		for (float difficulty : levelDifficulties)
+		{
+			for (float offset : { -spacing, 0.0f, spacing })
+			{
+				float point = std::max(0.0f, std::min(difficulty + offset, MAX_DIFFICULTY));
+				if (std::find(difficulties.begin(), difficulties.end(), point) == difficulties.end())
+					difficulties.push_back(point);
+			}
+		}
+
+		Sweep(difficulties);
+		levelDifficulties = Fit(passRates);
+	}
+
+	std::vector<LevelSettings> levels;
+	for (int i = 0; i < static_cast<int>(levelDifficulties.size()); i++)
+	{
+		LevelSettings settings(GetSettingsAtDifficulty(levelDifficulties[i]));
+		settings.passRate = passRates[i];
+		levels.push_back(settings);
+	}
+
+	return levels;
+}
+
+long long DifficultyCalibrator::GetNumRoundsPlayed() const
+{
+	return m_numRoundsPlayed;
+}
+
+int DifficultyCalibrator::PlayBatch(const LevelSettings& settings, const Policy& policy, unsigned int firstSeed, int numRounds) const
+{
+	BatchSimulator simulator(numRounds, m_config.numCols, m_config.numRows, m_config.queueSize);
+	for (int i = 0; i < numRounds; i++)
+		simulator.Reset(i, firstSeed + static_cast<unsigned int>(i), settings.oozePerPump, settings.countdown);
+
+	// Once a round has passed, the rest of it makes no difference, so the bot stops playing it.
+	std::vector<bool> passed(numRounds, false);
+	int numPassed = 0;
+	int numPlaying = numRounds;
+
+	Planner::Situation situation;
+	while (numPlaying > 0)
+	{
+		numPlaying = 0;
+		for (int i = 0; i < numRounds; i++)
+		{
+			if (passed[i])
+				continue;
+
+			if (simulator.GetScore(i) >= m_config.scoreToAdvance)
+			{
+				passed[i] = true;
+				numPassed++;
+				continue;
+			}
+
+			if (!simulator.IsAlive(i))
+				continue;
+
+			Board* board = simulator.GetBoard(i);
+			Queue* queue = simulator.GetQueue(i);
+
+			// Once nothing the bot does can take the ooze beyond where it is headed, the round cannot score more than 
+			// projected. If that falls short, the round is lost. Otherwise the bot might still bomb a projected pipe 
+			// and spill early, so the round plays on. The bot gets to move every few ticks, and the Board has not 
+			// seen the ooze in the current pipe yet.
+			int oozeOffset = (simulator.GetCountdown(i) * settings.oozePerPump) - simulator.GetOozeLevel(i);
+			if ((board->GetProjectedScore() < m_config.scoreToAdvance) &&
+				board->IsSpillInevitable(*queue, settings.oozePerPump * policy.ticksPerMove, oozeOffset))
+			{
+				simulator.Stop(i);
+				continue;
+			}
+
+			numPlaying++;
+			situation.Capture(*board, *queue);
+
+			// No time limit, so that the results do not depend on the machine.
+			Planner planner(situation);
+			Planner::Move move = planner.FindMove(std::chrono::microseconds(0), policy.lookahead);
+			if (move.IsValid() && (board->GetPlacement(move.col, move.row) != Board::PLACEMENT_NONE))
+				board->PlaceTile(move.col, move.row, queue->Pop());
+		}
+
+		simulator.Tick(policy.ticksPerMove);
+	}
+
+	return numPassed;
+}
+
+std::vector<float> DifficultyCalibrator::Fit(std::vector<float>& passRates) const
+{
+	// Merge all samples measured at the same difficulty.
+	std::vector<Sample> samples(m_samples);
+	std::sort(samples.begin(), samples.end(), [](const Sample& a, const Sample& b) { return a.difficulty < b.difficulty; });
+
+	// Pool adjacent violators: the pass rate can only go down as the difficulty goes up, 
+	// so neighboring samples which break this rule (due to noise) are merged into one block.
+	struct Block
+	{
+		double weightedDifficulty;
+		int numPassed;
+		int numPlayed;
+
+		float GetDifficulty() const { return static_cast<float>(weightedDifficulty / numPlayed); }
+		double GetPassRate() const { return static_cast<double>(numPassed) / numPlayed; }
+	};
+
+	std::vector<Block> blocks;
+	for (const Sample& sample : samples)
+	{
+		blocks.push_back({ static_cast<double>(sample.difficulty) * sample.numPlayed, sample.numPassed, sample.numPlayed });
+		while ((blocks.size() > 1) && (blocks[blocks.size() - 2].GetPassRate() <= blocks.back().GetPassRate()))
+		{
+			Block last(blocks.back());
+			blocks.pop_back();
+			blocks.back().weightedDifficulty += last.weightedDifficulty;
+			blocks.back().numPassed += last.numPassed;
+			blocks.back().numPlayed += last.numPlayed;
+		}
+	}
+
+	// Intersect the smoothed curve with each level's target.
+	std::vector<float> difficulties;
+	passRates.clear();
+	for (int level = 1; level <= m_config.numLevels; level++)
+	{
+		double target = GetTargetPassRate(level);
+
+		size_t idx = 0;
+		while ((idx < blocks.size()) && (blocks[idx].GetPassRate() > target))
+			idx++;
+
+		float difficulty;
+		double passRate;
+		if (idx == 0)
+		{
+			// Even the easiest settings are too hard.
+			difficulty = blocks.front().GetDifficulty();
+			passRate = blocks.front().GetPassRate();
+		}
+		else if (idx == blocks.size())
+		{
+			// Even the hardest settings are too easy.
+			difficulty = blocks.back().GetDifficulty();
+			passRate = blocks.back().GetPassRate();
+		}
+		else
+		{
+			const Block& easier(blocks[idx - 1]);
+			const Block& harder(blocks[idx]);
+			double frac = (easier.GetPassRate() - target) / (easier.GetPassRate() - harder.GetPassRate());
+			difficulty = easier.GetDifficulty() + static_cast<float>(frac * (harder.GetDifficulty() - easier.GetDifficulty()));
+			passRate = target;
+		}
+
+		difficulties.push_back(difficulty);
+		passRates.push_back(static_cast<float>(passRate));
+	}
+
+	return difficulties;
+}
@@ -0,0 +1,243 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include "TilePiece.h"
+#include <vector>
+
+
+// ---- Forward declarations ----
+
+class WorkerPool;
+
+
+// ---- Class Definition ----
+
+/**
+ * Rules of a difficulty level: how fast the ooze flows, and how long it takes to start flowing.
+ */
+struct LevelSettings
+{
+	/**
+	 * Amount of ooze pumped per tick, in fixed point units (see OOZE_PER_PERCENT).
+	 */
+	int oozePerPump = 1 * OOZE_PER_PERCENT;
+
+	/**
+	 * Number of ticks until the ooze starts flowing.
+	 */
+	int countdown = 0;
+
+	/**
+	 * Share of rounds, between 0 and 1, in which the reference bots reach the score needed to advance 
+	 * to the next level. Only known for calibrated levels, 0 otherwise.
+	 */
+	float passRate = 0.0f;
+
+	/**
+	 * Get the original, hand-picked settings of the first levels.
+	 */
+	static std::vector<LevelSettings> GetDefaults();
+};
+
+
+/**
+ * Tool which fits the settings of each difficulty level, so that the share of rounds won by a set of 
+ * reference bots follows a target curve from level to level.
+ *
+ * All possible settings are lined up along a single difficulty scale, which goes through the hand-picked 
+ * settings of the first levels (see GetSettingsAtDifficulty()), and continues beyond the last one. 
+ * The pass rate is measured at many points along the scale by playing thousands of rounds with Planner 
+ * bots on BatchSimulator games, spread across all threads of a WorkerPool. The measured curve is 
+ * then smoothed into a non-increasing one, and intersected with the target pass rate of each level. 
+ * Further sweeps around the intersections refine the result. Every point of a sweep plays the same 
+ * seeds, so that differences between points only come from the settings.
+ */
+class DifficultyCalibrator
+{
+public:
+	/**
+	 * Highest point of the difficulty scale.
+	 */
+	static const float MAX_DIFFICULTY;
+
+	/**
+	 * A reference bot.
+	 */
+	struct Policy
+	{
+		/**
+		 * Number of queue pieces the bot's Planner looks ahead.
+		 */
+		int lookahead;
+
+		/**
+		 * Number of ticks between two placements.
+		 */
+		int ticksPerMove;
+	};
+
+	/**
+	 * Calibration options.
+	 */
+	struct Config
+	{
+		/**
+		 * Number of levels to calibrate.
+		 */
+		int numLevels = 20;
+
+		/**
+		 * Target pass rate of the first and the last level. Levels in between follow a geometric curve.
+		 * The defaults roughly match the curve of the hand-picked levels, as played by the default policies.
+		 */
+		float firstPassRate = 0.8f;
+		float lastPassRate = 0.07f;
+
+		/**
+		 * Points a round must be worth to pass the level, see Controller::MIN_SCORE_TO_ADVANCE.
+		 */
+		int scoreToAdvance = 200;
+
+		/**
+		 * Reference bots. Each point of a sweep is played by all bots, with the same number of rounds each.
+		 */
+		std::vector<Policy> policies = { { 2, 10 }, { 2, 20 }, { 2, 30 } };
+
+		/**
+		 * Number of rounds played at each point of a sweep, by all policies together.
+		 */
+		int numRoundsPerPoint = 1024;
+
+		/**
+		 * Number of points of the first sweep, which covers the whole difficulty scale.
+		 */
+		int numSweepPoints = 25;
+
+		/**
+		 * Number of further sweeps around the fitted difficulty of each level.
+		 */
+		int numRefinements = 2;
+
+		/**
+		 * Seed of the first round played at each point.
+		 */
+		unsigned int firstSeed = 1;
+
+		int numCols = 10;
+		int numRows = 7;
+		int queueSize = 5;
+	};
+
+	/**
+	 * Class constructor.
+	 *
+	 * @param config	Calibration options.
+	 * @param workers	Threads on which the rounds are played.
+	 */
+	DifficultyCalibrator(const Config& config, WorkerPool& workers);
+
+	/**
+	 * Get the level settings at a given point of the difficulty scale. Integer points up to the number of
+	 * hand-picked levels return the hand-picked settings. In between, settings are interpolated, and beyond
+	 * the last hand-picked level, the ooze speeds up and the countdown shortens at a steady pace.
+	 *
+	 * @param difficulty	Point on the difficulty scale, from 0 to MAX_DIFFICULTY.
+	 * @return	The level settings. Its passRate is not set.
+	 */
+	static LevelSettings GetSettingsAtDifficulty(float difficulty);
+
+	/**
+	 * Get the pass rate the given level should have.
+	 *
+	 * @param level		The difficulty level, starting at 1.
+	 */
+	float GetTargetPassRate(int level) const;
+
+	/**
+	 * Measure the pass rate of the reference bots at each of the given points of the difficulty scale.
+	 *
+	 * @param difficulties	Points on the difficulty scale.
+	 * @return	The share of rounds passed at each point.
+	 */
+	std::vector<float> Sweep(const std::vector<float>& difficulties);
+
+	/**
+	 * Run all sweeps, and fit the settings of each level to the target pass rates.
+	 *
+	 * @return	The settings of each level, starting with level 1.
+	 */
+	std::vector<LevelSettings> Calibrate();
+
+	/**
+	 * Get the total number of rounds played so far.
+	 */
+	long long GetNumRoundsPlayed() const;
+
+private:
+	/**
+	 * Pass rate measured at one point of the difficulty scale.
+	 */
+	struct Sample
+	{
+		float difficulty;
+		int numPassed;
+		int numPlayed;
+	};
+
+	/**
+	 * Play a batch of rounds with the same settings and policy.
+	 *
+	 * @param settings	Rules of the level to play.
+	 * @param policy	Bot placing the pipes.
+	 * @param firstSeed	Seed of the first round. The other rounds use the seeds following it.
+	 * @param numRounds	Number of rounds to play at once.
+	 * @return	Number of rounds in which scoreToAdvance was reached.
+	 */
+	int PlayBatch(const LevelSettings& settings, const Policy& policy, unsigned int firstSeed, int numRounds) const;
+
+	/**
+	 * Find the difficulty of each level, from all samples measured so far. 
+	 *
+	 * @param passRates	Will be set to the pass rate of the fitted curve at each level's difficulty.
+	 * @return	The difficulty of each level, starting with level 1.
+	 */
+	std::vector<float> Fit(std::vector<float>& passRates) const;
+
+	Config m_config;
+
+	WorkerPool& m_workers;
+
+	std::vector<Sample> m_samples;
+
+	long long m_numRoundsPlayed = 0;
+};
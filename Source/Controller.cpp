@@ -32,11 +32,26 @@ SOFTWARE.
 #include "Board.h"
 #include "Queue.h"
 #include "Randomizer.h"
+#include "WorkerPool.h"
 
 
 // ---- Helper types and constants ----
 
 const int Controller::MIN_SCORE_TO_ADVANCE(200);
+const int Controller::MIN_BOARD_SIZE(4);
+const int Controller::MAX_BOARD_SIZE(2048);
+
+/**
+ * Ooze pumped per tick, and ticks until the ooze starts flowing, in puzzle mode.
+ * The countdown only starts once all pipes of the puzzle have been placed.
+ */
+static const int PUZZLE_OOZE_PER_PUMP(5 * OOZE_PER_PERCENT / 2);
+static const int PUZZLE_COUNTDOWN(25);
+
+/**
+ * Factor by which the ooze flows faster in fast-forward mode.
+ */
+static const int FAST_FORWARD_FACTOR(10);
 
 
 /**
@@ -53,7 +68,7 @@ Controller::Controller()
 	m_singleton = this;
 
 	// Create board
-	m_board.reset(new Board(10, 7));
+	m_board.reset(new Board(m_numCols, m_numRows));
 
 	// Create queue
 	m_queue.reset(new Queue(5));
@@ -66,6 +81,12 @@ Controller::Controller()
 	// Initialize max score 
 	InitApplicationProperties();
 
+	// Use calibrated level settings, if there are any.
+	m_levelConfig.Load(LevelConfig::GetDefaultFile());
+
+	// Map the puzzle file, if there is one. Puzzles are only decoded once played.
+	m_puzzles.Open(PuzzleDatabase::GetDefaultFile());
+
 	// Init sounds.
 	InitAudio();
 }
@@ -171,18 +192,18 @@ bool Controller::HigherScoreThan(std::pair<juce::String, int> const &a, std::pai
 	return a.second > b.second;
 }
 
-bool Controller::Pump()
+bool Controller::Pump(bool wholePipes)
 {
 	int oldScore = m_board->GetScoreValue();
 
 	// Pump more ooze into the board!
-	bool contained = m_board->Pump(GetCurrentOozePerPump());
+	bool contained = m_board->Pump(wholePipes ? MAX_OOZE_LEVEL : GetCurrentOozePerPump());
 
 	// Ooze is still contained in the pipeline.
 	if (contained)
 	{
-		if ((oldScore < MIN_SCORE_TO_ADVANCE) &&
-			(m_board->GetScoreValue() >= MIN_SCORE_TO_ADVANCE))
+		if ((oldScore < GetScoreToAdvance()) &&
+			(m_board->GetScoreValue() >= GetScoreToAdvance()))
 		{
 			// The player just gained enough points 
 			// to advance to the next level. Notify with a sound.
@@ -213,6 +234,19 @@ Controller::ScoreDetails Controller::GetScoreDetails() const
 {
 	ScoreDetails details;
 	details.score = m_board->GetScoreValue();
+	details.puzzle = IsPuzzleMode();
+
+	// Puzzles are scored on their own.
+	if (details.puzzle)
+	{
+		details.bonus = 0;
+		details.carryover = 0;
+		details.total = details.score;
+		details.level = GetDifficultyLevel();
+		details.advance = (details.score >= GetScoreToAdvance());
+
+		return details;
+	}
 
 	// Carryover is the score gained from all previous levels.
 	details.carryover = m_cumulativeScore;
@@ -237,11 +271,148 @@ Controller::ScoreDetails Controller::GetScoreDetails() const
 
 int Controller::GetDifficultyLevel() const
 {
+	if (IsPuzzleMode())
+		return m_puzzle.difficulty;
+
 	return m_difficultyLevel;
 }
 
+int Controller::GetScoreToAdvance() const
+{
+	if (IsPuzzleMode())
+		return m_puzzle.targetScore;
+
+	return MIN_SCORE_TO_ADVANCE;
+}
+
+bool Controller::StartPuzzleMode(const juce::File& file)
+{
+	if (file.existsAsFile())
+		m_puzzles.Open(file);
+
+	if (m_puzzles.GetNumPuzzles() == 0)
+		return false;
+
+	m_puzzleIndex = 0;
+
+	return true;
+}
+
+bool Controller::IsPuzzleMode() const
+{
+	return (m_puzzleIndex >= 0);
+}
+
+int Controller::GetPuzzleNumber() const
+{
+	return m_puzzleIndex + 1;
+}
+
+bool Controller::LoadPuzzle()
+{
+	if (!m_puzzles.GetPuzzle(m_puzzleIndex, m_puzzle) ||
+		(m_puzzle.numCols < MIN_BOARD_SIZE) || (m_puzzle.numCols > MAX_BOARD_SIZE) ||
+		(m_puzzle.numRows < MIN_BOARD_SIZE) || (m_puzzle.numRows > MAX_BOARD_SIZE))
+		return false;
+
+	// Puzzles come with their own board size.
+	if ((m_puzzle.numCols != m_board->GetNumCols()) || 
+		(m_puzzle.numRows != m_board->GetNumRows()) ||
+		m_board->IsEndless())
+		m_board.reset(new Board(m_puzzle.numCols, m_puzzle.numRows));
+
+	// No bombs in puzzles: pipes can only be placed on empty tiles.
+	m_board->SetPressureMode(false);
+	m_board->SetTopology(Topology::KIND_RECTANGULAR);
+	m_board->Reset(m_puzzle.tiles, 0);
+	m_queue->SetSequence(m_puzzle.queue);
+
+	return true;
+}
+
+bool Controller::LoadLevelConfig(const juce::File& file)
+{
+	return m_levelConfig.Load(file);
+}
+
+void Controller::SetBoardSize(int numCols, int numRows, bool endless)
+{
+	m_endless = endless;
+	m_numCols = juce::jlimit(MIN_BOARD_SIZE, MAX_BOARD_SIZE, numCols);
+	m_numRows = juce::jlimit(MIN_BOARD_SIZE, MAX_BOARD_SIZE, numRows);
+}
+
+void Controller::SetRule(Controller::Rule rule, int value)
+{
+	switch (rule)
+	{
+		case RULE_NUM_SOURCES:
+			SetNumSources(value);
+			break;
+		case RULE_BRANCHING_PIPES:
+			SetBranchingPipes(value != 0);
+			break;
+		case RULE_PRESSURE_MODE:
+			SetPressureMode(value != 0);
+			break;
+		case RULE_TOPOLOGY:
+			SetTopology(static_cast<Topology::Kind>(juce::jlimit(0, Topology::KIND_MAX - 1, value)));
+			break;
+		default:
+			break;
+	}
+}
+
+void Controller::SetNumSources(int numSources)
+{
+	m_numSources = juce::jlimit(1, Board::MAX_NUM_SOURCES, numSources);
+	if ((m_numSources > 1) && (m_workers == nullptr))
+		m_workers.reset(new WorkerPool());
+}
+
+void Controller::SetBranchingPipes(bool branching)
+{
+	m_branchingPipes = branching;
+}
+
+void Controller::SetPressureMode(bool pressure)
+{
+	m_pressureMode = pressure;
+
+	// Large boards are stepped on all cores.
+	if (m_pressureMode && (m_workers == nullptr))
+		m_workers.reset(new WorkerPool());
+}
+
+void Controller::SetTopology(Topology::Kind kind)
+{
+	m_topology = kind;
+}
+
 void Controller::Reset(Controller::Command cmd)
 {
+	if (IsPuzzleMode())
+	{
+		// Move on to the next puzzle, or retry the current one.
+		if (cmd == Controller::CMD_CONTINUE)
+			m_puzzleIndex = (m_puzzleIndex + 1) % m_puzzles.GetNumPuzzles();
+
+		// A corrupt puzzle would leave the board unplayable, so go back to regular rounds.
+		if (!LoadPuzzle())
+		{
+			m_puzzleIndex = -1;
+			m_queue->SetSequence(std::vector<TilePiece::Type>());
+			cmd = Controller::CMD_RESTART;
+		}
+
+		else
+		{
+			m_fastForward = false;
+			m_state = STATE_RUNNING;
+			return;
+		}
+	}
+
 	// If re restart at lvl 1, clear total score
 	if (cmd == Controller::CMD_RESTART)
 	{
@@ -258,66 +429,59 @@ void Controller::Reset(Controller::Command cmd)
 		m_difficultyLevel += 1;
 	}
 
+	// A new board size, or the end of puzzle mode, needs a new board.
+	if (m_endless != m_board->IsEndless())
+		m_board.reset(new Board(m_numCols, m_numRows, nullptr, m_endless));
+	else if (!m_endless &&
+		((m_numCols != m_board->GetNumCols()) || (m_numRows != m_board->GetNumRows())))
+		m_board.reset(new Board(m_numCols, m_numRows));
+
+	// A change in the number of sources only takes effect when the board is reset.
+	m_board->SetWorkerPool(m_workers.get());
+	m_board->SetNumSources(m_numSources);
+	m_board->SetPressureMode(m_pressureMode);
+	m_board->SetTopology(m_topology);
 	m_board->Reset();
+
+	m_queue->SetBranchingPipes(m_branchingPipes);
 	m_queue->Reset();
 	m_fastForward = false;
 	m_state = STATE_RUNNING;
 }
 
-float Controller::GetCurrentOozePerPump() const
-{
-	static const float oozePerLevel[] = {
-		1.0F, // Level 1
-		1.2F, // Level 2
-		1.4F, // Level 3
-		1.5F, // Level 4
-		1.6F, // Level 5
-		1.8F, // Level 6
-		2.0F, // Level 7
-		2.2F, // Level 8
-		2.5F, // Level 9
-		3.0F, // Level 10
-		3.5F, // Level 11
-		5.0F  // Level 12
-	};
-
-	// m_difficultyLevel starts at 1
-	int arraySize = sizeof(oozePerLevel) / sizeof(*oozePerLevel);
-	int level = m_difficultyLevel - 1;
-	if (level >= arraySize)
-		level = arraySize - 1;
+int Controller::GetCurrentOozePerPump() const
+{
+	int oozePerPump = m_levelConfig.GetLevel(m_difficultyLevel).oozePerPump;
+	if (IsPuzzleMode())
+		oozePerPump = PUZZLE_OOZE_PER_PUMP;
 
 	// If fast-forward button is currently toggled on, increase ooze per pump.
 	if (m_fastForward)
-		return oozePerLevel[level] * 10.0f;
+		return oozePerPump * FAST_FORWARD_FACTOR;
 
-	return oozePerLevel[level];
+	return oozePerPump;
+}
+
+bool Controller::IsSpillInevitable(int ticksUntilPump, int ticksPerPlacement) const
+{
+	// Puzzles wait for the player to place all their pipes.
+	if (IsPuzzleMode() && (ticksUntilPump > 0) && !m_queue->IsEmpty())
+		return false;
+
+	// Fast-forward can be toggled off again at any time, so the time left is counted at the regular pace.
+	int oozePerPump = GetCurrentOozePerPump();
+	if (m_fastForward)
+		oozePerPump /= FAST_FORWARD_FACTOR;
+
+	return m_board->IsSpillInevitable(*m_queue, oozePerPump * ticksPerPlacement, oozePerPump * ticksUntilPump);
 }
 
 int Controller::GetCurrentCountdown() const
 {
-	static const int countdownPerLevel[] = {
-		320,	// Level 1
-		290,	// Level 2
-		260,	// Level 3
-		230,	// Level 4
-		200,	// Level 5
-		180,	// Level 6
-		160,	// Level 7
-		140,	// Level 8
-		120,	// Level 9
-		100,	// Level 10
-		80,		// Level 11
-		60		// Level 12
-	};
-
-	// m_difficultyLevel starts at 1
-	int arraySize = sizeof(countdownPerLevel) / sizeof(*countdownPerLevel);
-	int level = m_difficultyLevel - 1;
-	if (level >= arraySize)
-		level = arraySize - 1;
-
-	return countdownPerLevel[level];
+	if (IsPuzzleMode())
+		return PUZZLE_COUNTDOWN;
+
+	return m_levelConfig.GetLevel(m_difficultyLevel).countdown;
 }
 
 bool Controller::GetFastForward() const
@@ -31,6 +31,9 @@ SOFTWARE.
 #pragma once
 
 #include <JuceHeader.h>
+#include "PuzzleDatabase.h"
+#include "LevelConfig.h"
+#include "Topology.h"
 
 
 // ---- Forware declarations ----
@@ -38,6 +41,7 @@ SOFTWARE.
 class Board;
 class Queue;
 class Randomizer;
+class WorkerPool;
 
 
 // ---- Helper types and constants ----
@@ -73,6 +77,17 @@ public:
 		CMD_CONTINUE
 	};
 
+	/**
+	 * Rules of regular rounds, which can be changed from the command line. See SetRule().
+	 */
+	enum Rule
+	{
+		RULE_NUM_SOURCES = 0,	//< Number of starter tiles, see SetNumSources().
+		RULE_BRANCHING_PIPES,	//< Nonzero to let junctions join the queue, see SetBranchingPipes().
+		RULE_PRESSURE_MODE,		//< Nonzero for the pressure game mode, see SetPressureMode().
+		RULE_TOPOLOGY			//< A Topology::Kind, see SetTopology().
+	};
+
 	/**
 	 * Game sound IDs.
 	 */
@@ -98,6 +113,7 @@ public:
 		int total;		//< Sum of the cumulative, bonus, and last level scores.
 		int level;		//< Last difficulty level achieved.
 		bool advance;	//< True if score is high enough to advance to next level.
+		bool puzzle;	//< True if the round was a puzzle. Then advance is true if the puzzle was solved.
 	};
 
 	/**
@@ -105,6 +121,12 @@ public:
 	 */
 	static const int MIN_SCORE_TO_ADVANCE;
 
+	/**
+	 * Smallest and largest number of columns or rows on the board, see SetBoardSize().
+	 */
+	static const int MIN_BOARD_SIZE;
+	static const int MAX_BOARD_SIZE;
+
 	/**
 	 * Class destructor.
 	 */
@@ -161,10 +183,12 @@ public:
 	/**
 	 * Pump more Ooze into the Board. Called by MainComponent at every framerate tick.
 	 * 
+	 * @param wholePipes	If true, the ooze fills the rest of each pipe at once, instead of pumping 
+	 *						the amount of the current difficulty level. Used to skip to the results.
 	 * @return	True if the ooze is still contained within the pipeline.
 	 *			False if the ooze has now spilled.
 	 */
-	bool Pump();
+	bool Pump(bool wholePipes = false);
 
 	/**
 	 * Get the current score data, including points gained this round, cumulative points, 
@@ -177,16 +201,96 @@ public:
 	/**
 	 * Get the current level.
 	 *
-	 * @return	The current difficulty level, starting with 1.
+	 * @return	The current difficulty level, starting with 1. In puzzle mode, the puzzle's difficulty rating.
 	 */
 	int GetDifficultyLevel() const;
 
+	/**
+	 * Get the points which need to be gained in one round to advance to the next level, 
+	 * or to solve the current puzzle in puzzle mode.
+	 */
+	int GetScoreToAdvance() const;
+
+	/**
+	 * Switch to puzzle mode, starting with the first puzzle. The game board is set up with the puzzle's 
+	 * pre-placed tiles, and the queue hands out the puzzle's pipes. Call Reset() afterwards to start playing.
+	 *
+	 * @param file	Puzzle file to play. If it doesn't exist, the puzzle file opened at startup is used.
+	 * @return	False if there are no puzzles available.
+	 */
+	bool StartPuzzleMode(const juce::File& file);
+
+	/**
+	 * Check whether the game is in puzzle mode.
+	 */
+	bool IsPuzzleMode() const;
+
+	/**
+	 * Get the number of the current puzzle, starting with 1. 0 if not in puzzle mode.
+	 */
+	int GetPuzzleNumber() const;
+
+	/**
+	 * Replace the settings of all difficulty levels with those in the given level file.
+	 * The level file next to the executable, if any, is loaded at startup.
+	 * While the game is running, this may only be called from the SimulationThread, see SimulationThread::LoadLevelConfig().
+	 *
+	 * @param file	Level file to load, see LevelConfig.
+	 * @return	False if the file could not be loaded. The current settings are kept then.
+	 */
+	bool LoadLevelConfig(const juce::File& file);
+
+	/**
+	 * Set the size of the board for regular rounds. The board is only resized by the next call to Reset().
+	 * Puzzles are always played on a board of the puzzle's own size.
+	 *
+	 * @param numCols	Number of columns, limited to MIN_BOARD_SIZE to MAX_BOARD_SIZE.
+	 * @param numRows	Number of rows, limited to MIN_BOARD_SIZE to MAX_BOARD_SIZE.
+	 * @param endless	If true, the size is ignored and rounds are played on an endless board instead.
+	 */
+	void SetBoardSize(int numCols, int numRows, bool endless = false);
+
+	/**
+	 * Change one of the rules of regular rounds, using the setter for it below. Takes effect with the next call to Reset().
+	 *
+	 * @param rule	The rule to change.
+	 * @param value	New value of the rule, see Rule.
+	 */
+	void SetRule(Rule rule, int value);
+
+	/**
+	 * Set the number of ooze sources on the board for regular rounds, see Board::SetNumSources().
+	 * Takes effect with the next call to Reset().
+	 *
+	 * @param numSources	Number of starter tiles.
+	 */
+	void SetNumSources(int numSources);
+
+	/**
+	 * Let T-junctions and splitters join the queue in regular rounds, see Queue::SetBranchingPipes().
+	 * Takes effect with the next call to Reset().
+	 */
+	void SetBranchingPipes(bool branching);
+
+	/**
+	 * Play regular rounds in the pressure game mode, see Board::SetPressureMode(). Puzzles are always played 
+	 * the regular way. Takes effect with the next call to Reset().
+	 */
+	void SetPressureMode(bool pressure);
+
+	/**
+	 * Change how the tiles of the board connect to each other in regular rounds, see Board::SetTopology(). 
+	 * Puzzles are always played on rectangular boards. Takes effect with the next call to Reset().
+	 */
+	void SetTopology(Topology::Kind kind);
+
 	/**
 	 * Called by MainComponent at the end of every round, when leaving the ScoreWindow.
 	 * It clears up the Board, resets the Queue, and sets state back to STATE_RUNNING.
 	 * 
 	 * @param cmd	If CMD_RESTART, will set level back to 1 and clear all scores.
 	 *				if CMD_CONTINUE, will increase level by 1 and increase cumulative score.
+	 *				In puzzle mode, CMD_RESTART retries the current puzzle, and CMD_CONTINUE moves on to the next one.
 	 */
 	void Reset(Command cmd);
 
@@ -196,6 +300,20 @@ public:
 	 */
 	int GetCurrentCountdown() const;
 
+	/**
+	 * Get the amount of Ooze to be pumped per tick at the current difficulty level, in fixed point units.
+	 */
+	int GetCurrentOozePerPump() const;
+
+	/**
+	 * Check whether nothing the player does can keep the ooze from spilling where it is headed, 
+	 * so that the round may as well skip to its results. See Board::IsSpillInevitable().
+	 *
+	 * @param ticksUntilPump	Ticks left until the ooze starts flowing.
+	 * @param ticksPerPlacement	Least number of ticks in between two pipes placed by the player.
+	 */
+	bool IsSpillInevitable(int ticksUntilPump, int ticksPerPlacement) const;
+
 	/**
 	 * Get the fast-forward flag.
 	 * @return	True if the fast-forward mode is active.
@@ -261,11 +379,6 @@ protected:
 	 */
 	void InitApplicationProperties();
 
-	/**
-	 * Get the amount of Ooze to be pumped per tick at the current difficulty level.
-	 */
-	float GetCurrentOozePerPump() const;
-
 	/**
 	 * Configure and initialize the game's sound engine.
 	 */
@@ -276,6 +389,13 @@ protected:
 	 */
 	void ShutdownAudio();
 
+	/**
+	 * Set up the Board and Queue with the current puzzle.
+	 *
+	 * @return	False if the puzzle could not be loaded.
+	 */
+	bool LoadPuzzle();
+
 	/**
 	 * Triggers a sound to be played immediately by the m_audioMixer.
 	 * This is called from within the AudioThread, after having been woken up via the MainComponent.
@@ -295,11 +415,44 @@ private:
 	 */
 	GameState m_state = STATE_RUNNING;
 
+	/**
+	 * Threads used by the board to pump the ooze of many sources at once. 
+	 * Only created once more than one source is requested.
+	 */
+	std::unique_ptr<WorkerPool> m_workers;
+
 	/**
 	 * Object which keeps track of the tiles on the game board.
 	 */
 	std::unique_ptr<Board> m_board;
 
+	/**
+	 * Size of the board in regular rounds, see SetBoardSize().
+	 */
+	int m_numCols = 10;
+	int m_numRows = 7;
+	bool m_endless = false;
+
+	/**
+	 * Number of ooze sources in regular rounds, see SetNumSources().
+	 */
+	int m_numSources = 1;
+
+	/**
+	 * Whether junctions join the queue in regular rounds, see SetBranchingPipes().
+	 */
+	bool m_branchingPipes = false;
+
+	/**
+	 * Whether regular rounds are played in the pressure game mode, see SetPressureMode().
+	 */
+	bool m_pressureMode = false;
+
+	/**
+	 * Layout of the board in regular rounds, see SetTopology().
+	 */
+	Topology::Kind m_topology = Topology::KIND_RECTANGULAR;
+
 	/**
 	 * Object which keeps track of the tiles on the queue.
 	 */
@@ -310,6 +463,11 @@ private:
 	 */
 	int m_difficultyLevel = 1;
 
+	/**
+	 * Ooze speed and countdown of each difficulty level.
+	 */
+	LevelConfig m_levelConfig;
+
 	/**
 	 * Object which takes care of random number generation. 
 	 * Keep a pointer to the static object so that it can be deleted cleanly on shutdown. 
@@ -327,6 +485,21 @@ private:
 	 */
 	bool m_fastForward = false;
 
+	/**
+	 * Puzzle file, memory-mapped at startup or when switching to puzzle mode.
+	 */
+	PuzzleDatabase m_puzzles;
+
+	/**
+	 * Index of the current puzzle in m_puzzles. -1 if not in puzzle mode.
+	 */
+	int m_puzzleIndex = -1;
+
+	/**
+	 * The current puzzle.
+	 */
+	Puzzle m_puzzle;
+
 	/**
 	 * App properties file used to store player scores.
 	 */
@@ -0,0 +1,197 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "FrameInterpolator.h"
+#include "TilePiece.h"
+
+
+// ---- Class Implementation ----
+
+FrameInterpolator::FrameInterpolator(double duration)
+	: m_duration(duration)
+{
+}
+
+void FrameInterpolator::Capture(const RenderSnapshot& snapshot, double now)
+{
+	int numTiles = static_cast<int>(snapshot.tiles.size());
+	float progress = GetProgress(now);
+
+	// A new round, a new board, or other cells on display, start off where the snapshot is.
+	if ((snapshot.roundNumber != m_roundNumber) ||
+		(snapshot.region != m_region) ||
+		(numTiles != static_cast<int>(m_targetLevels.size())))
+	{
+		m_roundNumber = snapshot.roundNumber;
+		m_region = snapshot.region;
+		m_startLevels.resize(numTiles);
+		m_targetLevels.resize(numTiles);
+		m_tiles.clear();
+		m_tiles.resize(numTiles);
+		for (int i = 0; i < numTiles; i++)
+		{
+			m_targetLevels[i] = GetOozeLevels(snapshot.tiles[i].get());
+			m_startLevels[i] = m_targetLevels[i];
+		}
+
+		m_startCountdown = static_cast<float>(snapshot.countdown);
+		m_targetCountdown = m_startCountdown;
+
+		// Nothing to move.
+		m_startTime = now - m_duration;
+	}
+
+	else
+	{
+		// Move on from wherever the display is now, so that early or late snapshots don't make anything jump.
+		for (int i = 0; i < numTiles; i++)
+		{
+			OozeLevels current;
+			current.first = m_startLevels[i].first + ((m_targetLevels[i].first - m_startLevels[i].first) * progress);
+			current.second = m_startLevels[i].second + ((m_targetLevels[i].second - m_startLevels[i].second) * progress);
+
+			// Ooze only ever rises. Anything else, e.g. a new pipe placed with a bomb, is shown right away.
+			OozeLevels target = GetOozeLevels(snapshot.tiles[i].get());
+			if ((target.first < current.first) || (target.second < current.second))
+				current = target;
+
+			m_startLevels[i] = current;
+			m_targetLevels[i] = target;
+		}
+
+		// Likewise, the countdown only ever goes down.
+		m_startCountdown = std::max(m_startCountdown + ((m_targetCountdown - m_startCountdown) * progress), static_cast<float>(snapshot.countdown));
+		m_targetCountdown = static_cast<float>(snapshot.countdown);
+
+		m_startTime = now;
+	}
+
+	// The tiles of the previous snapshot must not be drawn anymore.
+	m_progress = 0.0f;
+	Interpolate(snapshot, now);
+}
+
+bool FrameInterpolator::Interpolate(const RenderSnapshot& snapshot, double now)
+{
+	// Nothing moves until the next snapshot is captured.
+	if (m_progress >= 1.0f)
+		return false;
+
+	float progress = GetProgress(now);
+	bool moved = (progress != m_progress);
+	m_progress = progress;
+
+	for (int i = 0; i < static_cast<int>(m_tiles.size()); i++)
+	{
+		// Tiles at rest are drawn straight from the snapshot.
+		if ((m_progress >= 1.0f) || (m_startLevels[i] == m_targetLevels[i]))
+		{
+			m_tiles[i] = nullptr;
+			continue;
+		}
+
+		OozeLevels levels;
+		levels.first = m_startLevels[i].first + ((m_targetLevels[i].first - m_startLevels[i].first) * m_progress);
+		levels.second = m_startLevels[i].second + ((m_targetLevels[i].second - m_startLevels[i].second) * m_progress);
+
+		RenderSnapshot::CopyTile(snapshot.tiles[i].get(), m_tiles[i]);
+		SetOozeLevels(m_tiles[i].get(), levels);
+	}
+
+	m_countdown = m_startCountdown + ((m_targetCountdown - m_startCountdown) * m_progress);
+
+	return moved;
+}
+
+const TilePiece* FrameInterpolator::GetTile(const RenderSnapshot& snapshot, int idx) const
+{
+	if ((idx < static_cast<int>(m_tiles.size())) && (m_tiles[idx] != nullptr))
+		return m_tiles[idx].get();
+
+	return snapshot.tiles[idx].get();
+}
+
+float FrameInterpolator::GetCountdown() const
+{
+	return m_countdown;
+}
+
+bool FrameInterpolator::OozeLevels::operator==(const OozeLevels& other) const
+{
+	return ((first == other.first) && (second == other.second));
+}
+
+bool FrameInterpolator::OozeLevels::operator!=(const OozeLevels& other) const
+{
+	return !(*this == other);
+}
+
+FrameInterpolator::OozeLevels FrameInterpolator::GetOozeLevels(const TilePiece* tile)
+{
+	OozeLevels levels;
+
+	const Cross* crossTile = dynamic_cast<const Cross*>(tile);
+	const Pipe* pipe = dynamic_cast<const Pipe*>(tile);
+	if (crossTile != nullptr)
+	{
+		levels.first = static_cast<float>(crossTile->GetOozeLevel(Cross::WAY_HORIZONTAL));
+		levels.second = static_cast<float>(crossTile->GetOozeLevel(Cross::WAY_VERTICAL));
+	}
+	else if (pipe != nullptr)
+	{
+		levels.first = static_cast<float>(pipe->GetOozeLevel());
+	}
+
+	return levels;
+}
+
+void FrameInterpolator::SetOozeLevels(TilePiece* tile, OozeLevels levels)
+{
+	Cross* crossTile = dynamic_cast<Cross*>(tile);
+	Pipe* pipe = dynamic_cast<Pipe*>(tile);
+	if (crossTile != nullptr)
+	{
+		crossTile->SetOozeLevel(Cross::WAY_HORIZONTAL, static_cast<int>(std::lround(levels.first)));
+		crossTile->SetOozeLevel(Cross::WAY_VERTICAL, static_cast<int>(std::lround(levels.second)));
+	}
+	else if (pipe != nullptr)
+	{
+		pipe->SetOozeLevel(static_cast<int>(std::lround(levels.first)));
+	}
+}
+
+float FrameInterpolator::GetProgress(double now) const
+{
+	if (m_duration <= 0.0)
+		return 1.0f;
+
+	return juce::jlimit(0.0f, 1.0f, static_cast<float>((now - m_startTime) / m_duration));
+}
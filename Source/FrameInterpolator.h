@@ -0,0 +1,174 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RenderSnapshot.h"
+
+
+// ---- Forward declarations ----
+
+class TilePiece;
+
+
+// ---- Class Definition ----
+
+/**
+ * Smooths out the game for drawing at the display's frame rate, which is faster than the game clock.
+ * The Ooze fill levels and the countdown are interpolated between the last two snapshots published by
+ * the SimulationThread, so the Ooze flows steadily instead of moving once per tick. This is done on the 
+ * message thread alone: the SimulationThread runs and publishes exactly as before.
+ *
+ * Everything else (pipes, score, bombs, ...) is drawn as published. The interpolated state trails
+ * behind the game by at most one tick.
+ */
+class FrameInterpolator
+{
+public:
+	/**
+	 * Class constructor.
+	 *
+	 * @param duration	Time to move from one snapshot to the next, in milliseconds. 
+	 *					Normally the SimulationThread's TICK_INTERVAL.
+	 */
+	FrameInterpolator(double duration);
+
+	/**
+	 * Start moving towards a newly acquired snapshot, from whatever was on display so far.
+	 * On a new round, when the board changes size, or when the snapshot covers another region of the board,
+	 * the snapshot is taken over without interpolation.
+	 *
+	 * @param snapshot	The new snapshot.
+	 * @param now		Current time, in milliseconds, see juce::Time::getMillisecondCounterHiRes().
+	 */
+	void Capture(const RenderSnapshot& snapshot, double now);
+
+	/**
+	 * Update the interpolated tiles and countdown for a new frame. 
+	 *
+	 * @param snapshot	The snapshot last passed to Capture().
+	 * @param now		Current time, in milliseconds, see juce::Time::getMillisecondCounterHiRes().
+	 * @return	True if anything moved since the last call, i.e. the frame may look different.
+	 */
+	bool Interpolate(const RenderSnapshot& snapshot, double now);
+
+	/**
+	 * Get the tile to draw at the given position on the board: either a copy of the snapshot's tile
+	 * with interpolated Ooze levels, or the snapshot's tile itself. Safe to call from any thread
+	 * while Capture() and Interpolate() are not running.
+	 *
+	 * @param snapshot	The snapshot last passed to Interpolate().
+	 * @param idx		Index of the tile within the snapshot, see RenderSnapshot::GetTileIndex().
+	 * @return	The tile to draw.
+	 */
+	const TilePiece* GetTile(const RenderSnapshot& snapshot, int idx) const;
+
+	/**
+	 * Get the interpolated number of ticks left until the Ooze starts flowing.
+	 */
+	float GetCountdown() const;
+
+private:
+	/**
+	 * Ooze fill levels of a tile: of a Pipe, or of both ways of a Cross. Zero for other tiles.
+	 * Kept as float while interpolating, and only rounded to fixed point when handed to the drawn copy.
+	 */
+	struct OozeLevels
+	{
+		float first = 0.0f;
+		float second = 0.0f;
+
+		bool operator==(const OozeLevels& other) const;
+		bool operator!=(const OozeLevels& other) const;
+	};
+
+	/**
+	 * Get the Ooze fill levels of a tile.
+	 */
+	static OozeLevels GetOozeLevels(const TilePiece* tile);
+
+	/**
+	 * Overwrite the Ooze fill levels of a tile, rounded to the nearest fixed point level. See Pipe::SetOozeLevel().
+	 */
+	static void SetOozeLevels(TilePiece* tile, OozeLevels levels);
+
+	/**
+	 * Get how far the interpolation has moved from the start values to the target values, from 0 to 1.
+	 */
+	float GetProgress(double now) const;
+
+	/**
+	 * Time to move from one snapshot to the next, in milliseconds.
+	 */
+	double m_duration;
+
+	/**
+	 * Time when the interpolation towards the latest snapshot started, in milliseconds.
+	 */
+	double m_startTime = 0.0;
+
+	/**
+	 * Progress at the last call to Interpolate(). Once it reaches 1, nothing moves until the next Capture().
+	 */
+	float m_progress = 1.0f;
+
+	/**
+	 * Round of the latest snapshot. Rounds are never interpolated into each other.
+	 */
+	int m_roundNumber = -1;
+
+	/**
+	 * Cells of the board covered by the latest snapshot, see RenderSnapshot::region.
+	 */
+	juce::Rectangle<int> m_region;
+
+	/**
+	 * Ooze levels of each tile in the snapshot, where the interpolation starts and where it ends.
+	 */
+	std::vector<OozeLevels> m_startLevels;
+	std::vector<OozeLevels> m_targetLevels;
+
+	/**
+	 * Copies of the tiles which are still moving, with interpolated Ooze levels. Null for all others.
+	 */
+	std::vector<std::unique_ptr<TilePiece>> m_tiles;
+
+	/**
+	 * Countdown where the interpolation starts, where it ends, and where it currently is.
+	 */
+	float m_startCountdown = 0.0f;
+	float m_targetCountdown = 0.0f;
+	float m_countdown = 0.0f;
+
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FrameInterpolator)
+};
@@ -0,0 +1,145 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "LayerCompositor.h"
+
+
+
+// ---- Class Implementation ----
+
+LayerCompositor::LayerCompositor(int numThreads)
+	: m_workers(numThreads)
+{
+}
+
+int LayerCompositor::AddLayer(LayerCompositor::Painter painter)
+{
+	Layer layer;
+	layer.painter = painter;
+	m_layers.push_back(layer);
+
+	// The new layer gets its image at the next SetSize().
+	m_width = 0;
+	m_height = 0;
+
+	return static_cast<int>(m_layers.size()) - 1;
+}
+
+void LayerCompositor::SetSize(int width, int height, float scale)
+{
+	if ((width == m_width) &&
+		(height == m_height) &&
+		(scale == m_scale))
+		return;
+
+	m_width = width;
+	m_height = height;
+	m_scale = scale;
+
+	// Layer images have as many pixels as the window covers on the display, so that they are not resampled when composited.
+	int imageWidth = std::max(1, juce::roundToInt(width * scale));
+	int imageHeight = std::max(1, juce::roundToInt(height * scale));
+	for (Layer& layer : m_layers)
+		layer.image = juce::Image(juce::Image::ARGB, imageWidth, imageHeight, true);
+
+	InvalidateAll();
+}
+
+void LayerCompositor::Invalidate(int layerId, juce::Rectangle<int> area)
+{
+	m_layers[layerId].invalidArea.add(area.getIntersection(juce::Rectangle<int>(0, 0, m_width, m_height)));
+}
+
+void LayerCompositor::InvalidateAll()
+{
+	for (Layer& layer : m_layers)
+	{
+		layer.invalidArea.clear();
+		layer.invalidArea.add(juce::Rectangle<int>(0, 0, m_width, m_height));
+	}
+}
+
+void LayerCompositor::Render()
+{
+	m_dirtyLayers.clear();
+	for (int i = 0; i < static_cast<int>(m_layers.size()); i++)
+	{
+		if (!m_layers[i].invalidArea.isEmpty())
+			m_dirtyLayers.push_back(i);
+	}
+
+	if (m_dirtyLayers.empty())
+		return;
+
+	// A single layer is not worth waking up the workers for.
+	if (m_dirtyLayers.size() == 1)
+	{
+		RenderLayer(m_dirtyLayers.front());
+		return;
+	}
+
+	m_workers.ParallelFor(static_cast<int>(m_dirtyLayers.size()), [this](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+				RenderLayer(m_dirtyLayers[i]);
+		});
+}
+
+void LayerCompositor::RenderLayer(int layerId)
+{
+	Layer& layer(m_layers[layerId]);
+	juce::AffineTransform toPhysical(juce::AffineTransform::scale(m_scale));
+
+	// The invalid area, rounded out to whole physical pixels, is wiped and drawn anew. The rest of the layer stays as it was.
+	juce::RectangleList<int> physicalArea;
+	for (const juce::Rectangle<int>& area : layer.invalidArea)
+		physicalArea.add(area.toFloat().transformedBy(toPhysical).getSmallestIntegerContainer());
+
+	for (const juce::Rectangle<int>& area : physicalArea)
+		layer.image.clear(area);
+
+	{
+		juce::Graphics g(layer.image);
+		g.reduceClipRegion(physicalArea);
+		g.addTransform(toPhysical);
+		layer.painter(g);
+	}
+
+	layer.invalidArea.clear();
+}
+
+void LayerCompositor::Composite(juce::Graphics& g) const
+{
+	juce::Rectangle<float> bounds(0.0f, 0.0f, static_cast<float>(m_width), static_cast<float>(m_height));
+
+	for (const Layer& layer : m_layers)
+		g.drawImage(layer.image, bounds);
+}
@@ -0,0 +1,133 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "WorkerPool.h"
+
+
+// ---- Class Definition ----
+
+/**
+ * Stack of retained layers, each of them an image covering the whole window. A layer is only rasterised
+ * anew where it was invalidated, and all layers due for it are rasterised in parallel on a WorkerPool,
+ * with the calling thread taking part. Painting the window then comes down to compositing the layer images.
+ *
+ * The painters of different layers may run at the same time, so they must not share any mutable state.
+ * All methods are to be called from the same thread, usually the message thread.
+ */
+class LayerCompositor
+{
+public:
+	/**
+	 * Function which draws a layer, in window coordinates. The graphics context is clipped to the invalid part of the layer.
+	 */
+	typedef std::function<void(juce::Graphics& g)> Painter;
+
+	/**
+	 * Class constructor.
+	 *
+	 * @param numThreads	Number of threads used for rasterising, including the calling thread. 
+	 *						If 0, one thread per CPU core is used.
+	 */
+	LayerCompositor(int numThreads = 0);
+
+	/**
+	 * Add a layer on top of all layers added before.
+	 *
+	 * @param painter	Function which draws the layer.
+	 * @return	ID of the new layer, to be passed to Invalidate().
+	 */
+	int AddLayer(Painter painter);
+
+	/**
+	 * Set the size of the window covered by the layers. If anything differs from the previous call, 
+	 * all layers are invalidated. Cheap enough to call on every frame.
+	 *
+	 * @param width		Width of the window, in logical pixels.
+	 * @param height	Height of the window, in logical pixels.
+	 * @param scale		Number of physical pixels per logical pixel on the display.
+	 */
+	void SetSize(int width, int height, float scale);
+
+	/**
+	 * Mark part of a layer for rasterising at the next call to Render().
+	 *
+	 * @param layerId	ID of the layer, see AddLayer().
+	 * @param area		The invalid area, in window coordinates.
+	 */
+	void Invalidate(int layerId, juce::Rectangle<int> area);
+
+	/**
+	 * Mark all of every layer for rasterising at the next call to Render().
+	 */
+	void InvalidateAll();
+
+	/**
+	 * Rasterise the invalid parts of all layers, in parallel. Returns once all layers are done.
+	 */
+	void Render();
+
+	/**
+	 * Draw all layers on top of each other, starting with the first one added.
+	 *
+	 * @param g		The graphics context to composite the layers into.
+	 */
+	void Composite(juce::Graphics& g) const;
+
+private:
+	/**
+	 * Rasterise the invalid parts of a layer, and clear its invalid area.
+	 */
+	void RenderLayer(int layerId);
+
+	struct Layer
+	{
+		Painter painter;
+		juce::Image image;
+		juce::RectangleList<int> invalidArea;
+	};
+	std::vector<Layer> m_layers;
+
+	int m_width = 0;
+	int m_height = 0;
+	float m_scale = 1.0f;
+
+	/**
+	 * IDs of the layers rasterised by the current Render() call.
+	 */
+	std::vector<int> m_dirtyLayers;
+
+	WorkerPool m_workers;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LayerCompositor)
+};
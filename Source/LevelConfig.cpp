@@ -0,0 +1,170 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "LevelConfig.h"
+#include "Controller.h"
+#include "WorkerPool.h"
+#include <cmath>
+
+
+// ---- Helper types and constants ----
+
+const juce::String LevelConfig::DEFAULT_FILE_NAME("Levels.xml");
+
+/**
+ * Names of the XML elements and attributes in the level file.
+ */
+static const juce::String TAG_LEVELS("LEVELS");
+static const juce::String TAG_LEVEL("LEVEL");
+static const juce::String ATTR_NUMBER("number");
+static const juce::String ATTR_OOZE_PER_PUMP("oozePerPump");
+static const juce::String ATTR_COUNTDOWN("countdown");
+static const juce::String ATTR_PASS_RATE("passRate");
+
+
+// ---- Class Implementation ----
+
+LevelConfig::LevelConfig()
+	: m_levels(LevelSettings::GetDefaults())
+{
+
+}
+
+juce::File LevelConfig::GetDefaultFile()
+{
+	return juce::File::getSpecialLocation(juce::File::currentExecutableFile).getSiblingFile(DEFAULT_FILE_NAME);
+}
+
+bool LevelConfig::Load(const juce::File& file)
+{
+	if (!file.existsAsFile())
+		return false;
+
+	std::unique_ptr<juce::XmlElement> xml(juce::parseXML(file));
+	if ((xml == nullptr) || !xml->hasTagName(TAG_LEVELS))
+		return false;
+
+	std::vector<LevelSettings> levels;
+	for (int i = 0; i < xml->getNumChildElements(); i++)
+	{
+		juce::XmlElement* child = xml->getChildElement(i);
+		if (!child->hasTagName(TAG_LEVEL))
+			continue;
+
+		// Levels must be listed in order, without gaps.
+		if (child->getIntAttribute(ATTR_NUMBER) != static_cast<int>(levels.size()) + 1)
+			return false;
+
+		LevelSettings settings;
+		settings.oozePerPump = static_cast<int>(std::lround(child->getDoubleAttribute(ATTR_OOZE_PER_PUMP) * OOZE_PER_PERCENT));
+		settings.countdown = child->getIntAttribute(ATTR_COUNTDOWN);
+		settings.passRate = static_cast<float>(child->getDoubleAttribute(ATTR_PASS_RATE));
+		if ((settings.oozePerPump <= 0) || (settings.countdown < 0))
+			return false;
+
+		levels.push_back(settings);
+	}
+
+	if (levels.empty())
+		return false;
+
+	m_levels = levels;
+
+	return true;
+}
+
+bool LevelConfig::Save(const juce::File& file) const
+{
+	juce::XmlElement xml(TAG_LEVELS);
+	for (int i = 0; i < static_cast<int>(m_levels.size()); i++)
+	{
+		juce::XmlElement* child = xml.createNewChildElement(TAG_LEVEL);
+		child->setAttribute(ATTR_NUMBER, i + 1);
+		child->setAttribute(ATTR_OOZE_PER_PUMP, static_cast<double>(m_levels[i].oozePerPump) / OOZE_PER_PERCENT);
+		child->setAttribute(ATTR_COUNTDOWN, m_levels[i].countdown);
+		child->setAttribute(ATTR_PASS_RATE, static_cast<double>(m_levels[i].passRate));
+	}
+
+	return xml.writeTo(file);
+}
+
+int LevelConfig::GetNumLevels() const
+{
+	return static_cast<int>(m_levels.size());
+}
+
+const LevelSettings& LevelConfig::GetLevel(int level) const
+{
+	// Level starts at 1
+	int idx = juce::jlimit(0, static_cast<int>(m_levels.size()) - 1, level - 1);
+
+	return m_levels[idx];
+}
+
+void LevelConfig::SetLevels(const std::vector<LevelSettings>& levels)
+{
+	jassert(!levels.empty());
+	if (!levels.empty())
+		m_levels = levels;
+}
+
+bool LevelConfig::Calibrate(const juce::File& file, int numLevels)
+{
+	WorkerPool workers;
+
+	DifficultyCalibrator::Config config;
+	config.numLevels = juce::jmax(1, numLevels);
+	config.scoreToAdvance = Controller::MIN_SCORE_TO_ADVANCE;
+
+	juce::Logger::writeToLog(juce::String("Calibrating ") + juce::String(config.numLevels) + " levels on " + 
+		juce::String(workers.GetNumThreads()) + " threads...");
+
+	juce::uint32 startTime = juce::Time::getMillisecondCounter();
+	DifficultyCalibrator calibrator(config, workers);
+	std::vector<LevelSettings> levels(calibrator.Calibrate());
+
+	for (int i = 0; i < static_cast<int>(levels.size()); i++)
+	{
+		juce::Logger::writeToLog(juce::String("Level ") + juce::String(i + 1) + 
+			": ooze per pump " + juce::String(static_cast<double>(levels[i].oozePerPump) / OOZE_PER_PERCENT, 2) + 
+			", countdown " + juce::String(levels[i].countdown) + 
+			", pass rate " + juce::String(levels[i].passRate, 3) + 
+			" (target " + juce::String(calibrator.GetTargetPassRate(i + 1), 3) + ")");
+	}
+
+	juce::Logger::writeToLog(juce::String("Played ") + juce::String(calibrator.GetNumRoundsPlayed()) + " rounds in " +
+		juce::String((juce::Time::getMillisecondCounter() - startTime) / 1000.0, 1) + " seconds.");
+
+	LevelConfig levelConfig;
+	levelConfig.SetLevels(levels);
+
+	return levelConfig.Save(file);
+}
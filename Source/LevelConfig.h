@@ -0,0 +1,118 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Calibration.h"
+
+
+// ---- Class Definition ----
+
+/**
+ * Settings of all difficulty levels: ooze speed and countdown. The hand-picked settings are used unless
+ * a level file is loaded, which is usually written by Calibrate(). Levels beyond the last one 
+ * use the settings of the last level.
+ *
+ * The level file is XML, with one LEVEL element per level, in order:
+ * <LEVELS><LEVEL number="1" oozePerPump="1.0" countdown="320" passRate="0.8"/> ... </LEVELS>
+ * The ooze per pump is given in percent of a pipe, and rounded to the fixed point units of OOZE_PER_PERCENT
+ * when loaded, so that levels play the same way everywhere.
+ */
+class LevelConfig
+{
+public:
+	/**
+	 * Name of the level file which is loaded at startup, expected next to the executable.
+	 */
+	static const juce::String DEFAULT_FILE_NAME;
+
+	/**
+	 * Class constructor. Starts with the hand-picked settings.
+	 */
+	LevelConfig();
+
+	/**
+	 * Get the location of the level file which is loaded at startup.
+	 */
+	static juce::File GetDefaultFile();
+
+	/**
+	 * Load the settings of all levels from the given file.
+	 *
+	 * @param file	The level file to load.
+	 * @return	False if the file could not be read, or is not a valid level file. The current settings are kept then.
+	 */
+	bool Load(const juce::File& file);
+
+	/**
+	 * Write the settings of all levels into the given file.
+	 *
+	 * @param file	The file to write. Overwritten if it exists.
+	 * @return	True if the file was written successfully.
+	 */
+	bool Save(const juce::File& file) const;
+
+	/**
+	 * Get the number of levels with their own settings.
+	 */
+	int GetNumLevels() const;
+
+	/**
+	 * Get the settings of the given level.
+	 *
+	 * @param level	The difficulty level, starting at 1.
+	 * @return	The level's settings, or those of the last level if it is beyond the last one.
+	 */
+	const LevelSettings& GetLevel(int level) const;
+
+	/**
+	 * Replace the settings of all levels. 
+	 *
+	 * @param levels	Settings of each level, starting with level 1. Must not be empty.
+	 */
+	void SetLevels(const std::vector<LevelSettings>& levels);
+
+	/**
+	 * Calibrate the given number of levels with a DifficultyCalibrator, using all CPU cores,
+	 * and write the result into a level file. Progress is written to the log.
+	 *
+	 * @param file		The file to write. Overwritten if it exists.
+	 * @param numLevels	Number of levels to calibrate.
+	 * @return	True if the file was written successfully.
+	 */
+	static bool Calibrate(const juce::File& file, int numLevels);
+
+private:
+	std::vector<LevelSettings> m_levels;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelConfig)
+};
@@ -79,14 +79,97 @@ public:
 	 */
 	void initialise(const juce::String& commandLine) override
 	{
-		(void)commandLine;
-
 		// TODO: think about useful commandline options
 		// i.e.: starting level.
+		juce::StringArray args(getCommandLineParameterArray());
+
+		// Offline puzzle generation, without any GUI: --generate-puzzles <count> [file]
+		int generateIdx = args.indexOf("--generate-puzzles");
+		if (generateIdx >= 0)
+		{
+			juce::File file(PuzzleDatabase::GetDefaultFile());
+			if ((args.size() > generateIdx + 2) && !args[generateIdx + 2].startsWith("--"))
+				file = juce::File::getCurrentWorkingDirectory().getChildFile(args[generateIdx + 2]);
+
+			int numPuzzles = args[generateIdx + 1].getIntValue();
+			bool success = (numPuzzles > 0) && PuzzleDatabase::Generate(file, numPuzzles);
+			setApplicationReturnValue(success ? 0 : 1);
+			quit();
+			return;
+		}
+
+		// Offline difficulty calibration, without any GUI: --calibrate <levels> [file]
+		int calibrateIdx = args.indexOf("--calibrate");
+		if (calibrateIdx >= 0)
+		{
+			juce::File file(LevelConfig::GetDefaultFile());
+			if ((args.size() > calibrateIdx + 2) && !args[calibrateIdx + 2].startsWith("--"))
+				file = juce::File::getCurrentWorkingDirectory().getChildFile(args[calibrateIdx + 2]);
+
+			bool success = LevelConfig::Calibrate(file, args[calibrateIdx + 1].getIntValue());
+			setApplicationReturnValue(success ? 0 : 1);
+			quit();
+			return;
+		}
 
 		// Store pointers to the MainWindow and Controller so we can delete them on shutdown.
 		m_mainWindow.reset(new MainWindow(getApplicationName()));
 		m_controller = Controller::GetInstance();
+
+		// The remaining options change the game, which is run by the MainComponent.
+		MainComponent* mainComponent = dynamic_cast<MainComponent*>(m_mainWindow->getContentComponent());
+		if (mainComponent == nullptr)
+			return;
+
+		// Play with the level settings of a given level file: --levels <file>
+		int levelsIdx = args.indexOf("--levels");
+		if ((levelsIdx >= 0) && (args.size() > levelsIdx + 1))
+			mainComponent->LoadLevelConfig(juce::File::getCurrentWorkingDirectory().getChildFile(args[levelsIdx + 1]));
+
+		// Unattended setups, such as kiosks, can start right away in attract mode.
+		if (commandLine.contains("--attract"))
+			mainComponent->StartAttractMode();
+
+		// Play on a board of another size: --board <cols> <rows>
+		int boardIdx = args.indexOf("--board");
+		if ((boardIdx >= 0) && (args.size() > boardIdx + 2))
+			mainComponent->SetBoardSize(args[boardIdx + 1].getIntValue(), args[boardIdx + 2].getIntValue());
+
+		// Play on a board without edges, for as long as the pipeline holds: --endless
+		if (commandLine.contains("--endless"))
+			mainComponent->SetBoardSize(0, 0, true);
+
+		// Release ooze from several starter tiles: --sources <count>
+		int sourcesIdx = args.indexOf("--sources");
+		if ((sourcesIdx >= 0) && (args.size() > sourcesIdx + 1))
+			mainComponent->SetRule(Controller::RULE_NUM_SOURCES, args[sourcesIdx + 1].getIntValue());
+
+		// Let the ooze fork through T-junctions and splitters: --branching
+		if (commandLine.contains("--branching"))
+			mainComponent->SetRule(Controller::RULE_BRANCHING_PIPES, 1);
+
+		// Join opposite edges of the board: --wrap
+		if (commandLine.contains("--wrap"))
+			mainComponent->SetRule(Controller::RULE_TOPOLOGY, Topology::KIND_TOROIDAL);
+
+		// Let the ooze spread through all connected pipes at once: --pressure
+		if (commandLine.contains("--pressure"))
+			mainComponent->SetRule(Controller::RULE_PRESSURE_MODE, 1);
+
+		// Show when the ooze reaches the pipes ahead of it, and where it will spill: --eta
+		if (commandLine.contains("--eta"))
+			mainComponent->SetShowArrivals(true);
+
+		// Start in puzzle mode: --puzzles [file]
+		int puzzlesIdx = args.indexOf("--puzzles");
+		if (puzzlesIdx >= 0)
+		{
+			juce::File file;
+			if ((args.size() > puzzlesIdx + 1) && !args[puzzlesIdx + 1].startsWith("--"))
+				file = juce::File::getCurrentWorkingDirectory().getChildFile(args[puzzlesIdx + 1]);
+
+			mainComponent->StartPuzzleMode(file);
+		}
 	}
 
 	/**
@@ -162,7 +245,7 @@ private:
 	/**
 	 * Pointer to Controller singleton.
 	 */
-	Controller* m_controller;
+	Controller* m_controller = nullptr;
 };
 
 /**
@@ -34,6 +34,15 @@ SOFTWARE.
 #include "Queue.h"
 #include "Randomizer.h"
 #include "ScoreWindow.h"
+#include "AutoPlayer.h"
+#include "SimulationThread.h"
+#include "SpriteCache.h"
+#include "RenderSnapshot.h"
+#include "LayerCompositor.h"
+#include "TileGeometry.h"
+#include "BoardLayout.h"
+#include "FrameInterpolator.h"
+#include "ParticleSystem.h"
 
 
 
@@ -41,12 +50,35 @@ SOFTWARE.
 
 const float MainComponent::OOZE_THICKNESS(15.0f);
 const int MainComponent::GUI_REFRESH_RATE(60);
+const int MainComponent::FRAME_RATE(120);
+const int MainComponent::ATTRACT_IDLE_TIMEOUT(45000);
+const int MainComponent::BOT_CLICK_INTERVAL(600);
+const int MainComponent::SPILL_DISPLAY_TIME(2000);
+const int MainComponent::EXPLOSION_DURATION(480);
+const int MainComponent::SPILL_GROW_TIME(300);
+const int MainComponent::LEVEL_FLASH_DURATION(1000);
+
+/**
+ * Size of an explosion at its start. The star's outer radius is 8 times as much, in pixels.
+ */
+static const float EXPLOSION_SIZE(8.0f);
+
+/**
+ * Number of particles thrown off by an explosion, and splashed by a spill, and number of drips per second from a spill.
+ */
+static const int EXPLOSION_PARTICLES(60);
+static const int SPLASH_PARTICLES(200);
+static const float DRIPS_PER_SECOND(40.0f);
+
+/**
+ * Zoom steps per unit of mouse wheel movement. One notch of a regular mouse wheel is about 0.2 units.
+ */
+static const float ZOOM_STEPS_PER_WHEEL_UNIT(5.0f);
 
 
 // ---- Class Implementation ----
 
 MainComponent::MainComponent()
-	:	m_blockInteraction(0)
 {
 	// Create GUI component wich will work as a clickable hyperlink to our github.
 	m_hyperlink = std::make_unique<juce::HyperlinkButton>(	juce::String("https://github.com/escalonely/PipeDreamer"),
@@ -54,19 +86,62 @@ MainComponent::MainComponent()
 	m_hyperlink->setColour(juce::HyperlinkButton::textColourId, juce::Colours::grey);
 	addAndMakeVisible(m_hyperlink.get());
 
-	setSize(900, 620);
+	// Tiles are drawn once into the sprites of the cache, and then blitted from there on every frame.
+	SpriteCache::Renderer renderer = [this](const TilePiece* tile, juce::Graphics& g)
+		{
+			juce::Point<int> origin(0, 0);
+			DrawTile(tile, origin, g);
+			DrawOoze(tile, origin, g);
+			DrawCrossSecondWay(tile, origin, g);
+			DrawTileDecoration(tile, origin, g);
+		};
+	m_spriteCache = std::make_unique<SpriteCache>(renderer);
+
+	// Board tiles look the same, only scaled to the view's zoom.
+	m_boardSprites = std::make_unique<SpriteCache>([this, renderer](const TilePiece* tile, juce::Graphics& g)
+		{
+			g.addTransform(juce::AffineTransform::scale(static_cast<float>(m_view.GetTileSize()) / m_tileSize));
+			renderer(tile, g);
+		});
+
+	// The window is drawn in layers, rasterised on worker threads, and only composited by paint().
+	// Each layer is rasterised by one thread at a time, so the sprite cache is only used by the board layer.
+	m_compositor = std::make_unique<LayerCompositor>(std::min<int>(LAYER_MAX, std::max<int>(1, static_cast<int>(std::thread::hardware_concurrency()))));
+	m_compositor->AddLayer([this](juce::Graphics& g) { PaintBackground(g); });
+	m_compositor->AddLayer([this](juce::Graphics& g) { PaintBoard(g); });
+	m_compositor->AddLayer([this](juce::Graphics& g) { PaintHud(g); });
+	m_compositor->AddLayer([this](juce::Graphics& g) { PaintEffects(g); });
 
-	// Reset the countdown to the start of the round
-	// (before ooze starts pumping out)
-	m_countDown = Controller::GetInstance()->GetCurrentCountdown();
+	// All particles are allocated up front.
+	m_particles = std::make_unique<ParticleSystem>();
 
-	// GUI-refreh rate
-	startTimer(GUI_REFRESH_RATE);
+	setSize(900, 620);
+
+	// The game runs on its own thread. Until it starts, its first snapshot can already be drawn.
+	m_simulation = std::make_unique<SimulationThread>();
+	m_snapshot = &m_simulation->AcquireSnapshot();
+	UpdateView();
+	m_interpolator = std::make_unique<FrameInterpolator>(SimulationThread::TICK_INTERVAL);
+	m_interpolator->Capture(*m_snapshot, juce::Time::getMillisecondCounterHiRes());
+	m_simulation->startThread();
+
+	// GUI-refreh rate, and frame rate.
+	// JUCE 6.0.7 has no juce::VBlankAttachment to draw on the display's vertical blank. A juce::Timer 
+	// can't stand in for it either, as it only fires every 10 to 16 ms on Windows, so frames are timed
+	// by a juce::HighResolutionTimer instead.
+	juce::Timer::startTimer(GUI_REFRESH_RATE);
+	juce::HighResolutionTimer::startTimer(1000 / FRAME_RATE);
 }
 
 MainComponent::~MainComponent()
 {
+	// No more frames, as the timer thread would otherwise keep asking for them.
+	juce::HighResolutionTimer::stopTimer();
+	cancelPendingUpdate();
 
+	// Stop the AutoPlayer, and then the game, before the Controller goes away.
+	m_autoPlayer = nullptr;
+	m_simulation = nullptr;
 }
 
 int MainComponent::GetTileSize() const
@@ -76,182 +151,621 @@ int MainComponent::GetTileSize() const
 
 void MainComponent::resized()
 {
-	// Scale tiles according to the game window's both width and height.
-	int minDimension = std::min<int>(getLocalBounds().getWidth(), static_cast<int>(getLocalBounds().getHeight() * 1.4516f));
-	m_tileSize = static_cast<int>(minDimension / 13.0f);
+	// Lay out everything once, for both painting and mouse input.
+	m_layout = BoardLayout(getLocalBounds().getWidth(), getLocalBounds().getHeight());
+	m_tileSize = m_layout.GetTileSize();
 
-	m_fastForwardButtonRect = juce::Rectangle<float>(getLocalBounds().getWidth() / 18.0f, getLocalBounds().getHeight() / 1.1245f, 70.0f, 45.0f).toNearestInt();
+	// Likewise scale the fonts, and lay out the labels which use them.
+	for (int i = 0; i < LABEL_MAX; i++)
+		m_fonts[i] = CreateFont(static_cast<LabelID>(i));
+	LayoutLabels();
 
 	// Position the hyperlink
 	m_hyperlink->setFont(GetFont(LABEL_VERSION), false /* do not resize */);
-	m_hyperlink->setBounds(	static_cast<int>(getLocalBounds().getWidth() / 1.8f), 
-							getLocalBounds().getHeight() - 50, 
-							static_cast<int>(getLocalBounds().getWidth() / 2.4545f), 
-							40);
+	m_hyperlink->setBounds(m_layout.GetHyperlinkRect());
+
+	// The board is shown through the view, which keeps its zoom.
+	if (m_snapshot != nullptr)
+		UpdateView();
 
 	// Resize the ScoreWindow, if any.
 	if (m_scoreWindow)
 		m_scoreWindow->resized();
+
+	// Everything moved, so the whole window will be repainted.
+	m_drawnState.valid = false;
+}
+
+void MainComponent::hiResTimerCallback()
+{
+	// Frames are drawn on the message thread. If the previous one hasn't been drawn yet, this one is dropped.
+	triggerAsyncUpdate();
+}
+
+void MainComponent::handleAsyncUpdate()
+{
+	RenderFrame();
 }
 
 void MainComponent::timerCallback()
 {
-	const juce::ScopedLock lock(m_lock);
+	// The game itself runs on the SimulationThread. Here, only pick up the latest snapshot, and react to it.
+	bool fresh(false);
+	m_snapshot = &m_simulation->AcquireSnapshot(&fresh);
+
+	if (m_snapshot->state == Controller::STATE_RUNNING)
+	{
+		// In attract mode, the bot gets its turn to click.
+		if (m_autoPlayer != nullptr)
+			UpdateAutoPlayer();
+	}
 
-	Controller* controller(Controller::GetInstance());
-	Controller::GameState state(controller->GetState());
+	// The end of each round is only dealt with once.
+	else if (m_snapshot->roundNumber != m_stoppedRound)
+	{
+		// Ooze spill! 
+		// Give the player a moment to see where the spill took place,
+		// before covering up the board with the score window.
+		m_stoppedRound = m_snapshot->roundNumber;
+		m_stoppedTime = juce::Time::getMillisecondCounter();
+	}
 
-	if (state == Controller::STATE_RUNNING)
+	else if ((m_handledRound != m_stoppedRound) &&
+		((juce::Time::getMillisecondCounter() - m_stoppedTime) >= static_cast<juce::uint32>(SPILL_DISPLAY_TIME)))
 	{
-		// When it reaches 0, clicks are enabled again.
-		if (m_blockInteraction > 0)
-			m_blockInteraction--;
+		m_handledRound = m_stoppedRound;
+		const Controller::ScoreDetails& details(m_snapshot->scoreDetails);
 
-		// Countdown to start pumping ooze.
-		if (m_countDown > 0)
+		// The bot's round is over. Skip the score window, and let it play on.
+		if (m_autoPlayer != nullptr)
 		{
-			// If fast-forward button is currently toggled on, decrease countdown faster.
-			if (controller->GetFastForward())
-				m_countDown -= 5;
-			else
-				m_countDown -= 1;
+			StartRound(details.advance ? Controller::CMD_CONTINUE : Controller::CMD_RESTART);
 		}
 
 		else
 		{
-			bool contained = controller->Pump();
-			if (!contained)
-			{
-				// Ooze spill! 
-				// Give the player a moment to see where the spill took place,
-				// before covering up the board with the score window.
-				startTimer(2000);
-			}
+			// Start detecting whether the score window is left unattended.
+			m_idleTicks = 0;
+
+			// Position the small AdvanceWindow in the middle of the window,
+			// while the HighScoreWindow will take up the whole window.
+			juce::Point<int> windowOrigin(0, 0);
+			if (details.advance)
+				windowOrigin = juce::Point<int>(getLocalBounds().getWidth() / 3, getLocalBounds().getHeight() / 4);
+
+			// Show scoreboard overlay.
+			m_scoreWindow.reset(ScoreWindow::CreateScoreWindow(details));
+			m_scoreWindow->addChangeListener(this);
+			addAndMakeVisible(m_scoreWindow.get());
+			m_scoreWindow->setTopLeftPosition(windowOrigin);
+			m_scoreWindow->resized();
 		}
 	}
 
-	else if (state == Controller::STATE_STOPPED)
+	else if (m_scoreWindow != nullptr)
 	{
-		// Stop refreshing GUI.
-		stopTimer();
-
-		// Position the small AdvanceWindow in the middle of the window,
-		// while the HighScoreWindow will take up the whole window.
-		Controller::ScoreDetails details(controller->GetScoreDetails());
-		juce::Point<int> windowOrigin(0, 0);
-		if (details.advance)
-			windowOrigin = juce::Point<int>(getLocalBounds().getWidth() / 3, getLocalBounds().getHeight() / 4);
-
-		// Show scoreboard overlay.
-		m_scoreWindow.reset(ScoreWindow::CreateScoreWindow(details));
-		m_scoreWindow->addChangeListener(this);
-		addAndMakeVisible(m_scoreWindow.get());
-		m_scoreWindow->setTopLeftPosition(windowOrigin);
-		m_scoreWindow->resized();
+		// Score window is being displayed. Anyone moving the mouse or typing their name is still around.
+		juce::Point<int> mousePos(getMouseXYRelative());
+		if ((mousePos != m_lastMousePos) || m_scoreWindow->hasKeyboardFocus(true))
+			m_idleTicks = 0;
+		else
+			m_idleTicks++;
+
+		m_lastMousePos = mousePos;
+
+		// Nobody around: let the bot entertain the audience. Puzzles are left alone, though.
+		if (((m_idleTicks * GUI_REFRESH_RATE) >= ATTRACT_IDLE_TIMEOUT) && !m_snapshot->puzzleMode)
+			StartAttractMode();
 	}
 
-	this->repaint();
+	// Start moving the ooze towards the new snapshot. It gets drawn with the next frame.
+	if (fresh)
+	{
+		UpdateView();
+		m_interpolator->Capture(*m_snapshot, juce::Time::getMillisecondCounterHiRes());
+		m_frameDue = true;
+	}
+}
+
+void MainComponent::RenderFrame()
+{
+	double now = juce::Time::getMillisecondCounterHiRes();
+	bool moved = m_interpolator->Interpolate(*m_snapshot, now);
+
+	// Frames may be late, but particles shouldn't jump too far.
+	float seconds = (m_lastFrameTime > 0.0) ? static_cast<float>(juce::jlimit(0.0, 0.1, (now - m_lastFrameTime) / 1000.0)) : 0.0f;
+	m_lastFrameTime = now;
+
+	// Animations run on the clock, no matter how often the window gets painted.
+	if (m_frameDue)
+		StartAnimations(now);
+	moved |= m_animator.Update(now);
+	moved |= UpdateParticles(seconds);
+
+	// Only repaint when there is something new to show, and only where it changed.
+	if (moved || m_frameDue)
+	{
+		m_frameDue = false;
+		RepaintChanges();
+		RenderLayers();
+	}
 }
 
 void MainComponent::mouseDown(const juce::MouseEvent& event)
 {
-	const juce::ScopedLock lock(m_lock);
+	// Any click ends the attract mode, handing the game over to the player.
+	if (m_autoPlayer != nullptr)
+		StopAttractMode();
 
-	Controller* controller(Controller::GetInstance());
+	else if (!event.mods.isRightButtonDown() && !event.mods.isMiddleButtonDown())
+		HandleClick(event.getMouseDownPosition());
+
+	m_dragOffset = juce::Point<int>(0, 0);
+}
+
+void MainComponent::mouseDrag(const juce::MouseEvent& event)
+{
+	if (!event.mods.isRightButtonDown() && !event.mods.isMiddleButtonDown())
+		return;
+
+	// The board follows the mouse.
+	juce::Point<int> offset(event.getOffsetFromDragStart());
+	juce::Point<int> delta(offset - m_dragOffset);
+	m_dragOffset = offset;
+
+	if (m_view.Pan(delta.getX(), delta.getY()))
+		ViewChanged();
+}
+
+void MainComponent::mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel)
+{
+	if (!m_view.GetArea().contains(event.getPosition()))
+		return;
 
-	if ((controller->GetState() == Controller::STATE_RUNNING) &&
-		(m_blockInteraction == 0))
+	float delta = wheel.isReversed ? -wheel.deltaY : wheel.deltaY;
+	if (m_view.Zoom(delta * ZOOM_STEPS_PER_WHEEL_UNIT, event.getPosition()))
+		ViewChanged();
+}
+
+void MainComponent::mouseMagnify(const juce::MouseEvent& event, float scaleFactor)
+{
+	if (!m_view.GetArea().contains(event.getPosition()) || (scaleFactor <= 0.0f))
+		return;
+
+	if (m_view.Zoom(std::log(scaleFactor) / std::log(BoardView::ZOOM_STEP), event.getPosition()))
+		ViewChanged();
+}
+
+void MainComponent::HandleClick(juce::Point<int> clickPos)
+{
+	// The click is only passed on to the SimulationThread, which checks whether the game allows it.
+	// If user clicked on the fast-forward button, toggle fast-forward state. 
+	// Once the round is decided, skip to its results instead.
+	if (m_layout.GetFastForwardRect().contains(clickPos))
 	{
-		juce::Point<int> clickPos = event.getMouseDownPosition();
+		if ((m_snapshot != nullptr) && m_snapshot->spillInevitable)
+			m_simulation->SkipToResults();
+		else
+			m_simulation->ToggleFastForward();
+		return;
+	}
 
-		// If user clicked on the fast-forward button, toggle fast-forward state.
-		// This increases the ooze amount in GetCurrentOozePerPump().
-		if (m_fastForwardButtonRect.contains(clickPos))
+	int col, row;
+	if (m_view.GetCellAt(clickPos, col, row))
+	{
+		// Grab the next piece in the queue, and place it on the board.
+		m_simulation->PlaceTile(col, row);
+	}
+}
+
+void MainComponent::StartAnimations(double now)
+{
+	const RenderSnapshot& snapshot(*m_snapshot);
+	int levelNumber = snapshot.puzzleMode ? snapshot.puzzleNumber : snapshot.difficultyLevel;
+	float tileSize = static_cast<float>(m_view.GetTileSize());
+
+	// A new round clears the board, and whatever was going on there.
+	if (snapshot.roundNumber != m_animatedRound)
+	{
+		m_animator.Clear();
+		m_particles->Clear();
+
+		// Celebrate a new level.
+		if ((m_animatedRound >= 0) && (levelNumber > m_animatedLevel))
+			m_animator.Start(Animator::ANIM_FLASH, -1, now, LEVEL_FLASH_DURATION);
+
+		m_animatedRound = snapshot.roundNumber;
+		m_animatedExplosions.assign(snapshot.tiles.size(), 0);
+		m_animatedRegion = snapshot.region;
+		m_animatedState = snapshot.state;
+	}
+	m_animatedLevel = levelNumber;
+
+	// New explosions can only be told apart within the same cells. Cells coming into view are taken as they are.
+	bool sameCells = ((snapshot.region == m_animatedRegion) && (snapshot.tiles.size() == m_animatedExplosions.size()));
+	if (!sameCells)
+	{
+		m_animatedRegion = snapshot.region;
+		m_animatedExplosions.resize(snapshot.tiles.size());
+	}
+
+	// Pipes replaced with a bomb. The explosion counts down on the game clock, so it only ever goes up on a new bomb.
+	for (int i = 0; i < static_cast<int>(snapshot.tiles.size()); i++)
+	{
+		int explosion(0);
+		const Pipe* pipe = dynamic_cast<const Pipe*>(snapshot.tiles[i].get());
+		if (pipe != nullptr)
+			explosion = pipe->GetExplosion();
+
+		if (sameCells && (explosion > m_animatedExplosions[i]))
 		{
-			controller->SetFastForward(!controller->GetFastForward());
+			int col = snapshot.region.getX() + (i % snapshot.region.getWidth());
+			int row = snapshot.region.getY() + (i / snapshot.region.getWidth());
+			m_animator.Start(Animator::ANIM_EXPLOSION, col + (row * snapshot.numCols), now, EXPLOSION_DURATION);
+			m_particles->Emit(ParticleSystem::KIND_DEBRIS, m_view.GetTileRect(col, row).getCentre().toFloat(), EXPLOSION_PARTICLES, tileSize);
 		}
 
-		else
+		m_animatedExplosions[i] = explosion;
+	}
+
+	// Ooze spill around the oozing tile, once the round is over. It stays until the next round.
+	if ((snapshot.state == Controller::STATE_STOPPED) && 
+		(m_animatedState != Controller::STATE_STOPPED) && 
+		(snapshot.oozingTileIdx >= 0))
+	{
+		m_animator.Start(Animator::ANIM_SPILL, snapshot.oozingTileIdx, now, SPILL_GROW_TIME, true /* hold */);
+		m_particles->Emit(ParticleSystem::KIND_SPLASH, GetSpillCentre(snapshot.oozingTileIdx), SPLASH_PARTICLES, tileSize);
+	}
+
+	m_animatedState = snapshot.state;
+}
+
+bool MainComponent::UpdateParticles(float seconds)
+{
+	// Ooze keeps dripping from a spill, at a steady rate no matter the frame rate.
+	for (const Animator::Animation& animation : m_animator.GetAnimations())
+	{
+		if (animation.type == Animator::ANIM_SPILL)
 		{
-			Board* board(controller->GetBoard());
-			bool replace(false);
-			int boardHStartPos = static_cast<int>(getLocalBounds().getWidth() / 5.114f);
-			int boardVStartPos = static_cast<int>(getLocalBounds().getHeight() / 7.75f);
+			m_drips += seconds * DRIPS_PER_SECOND;
+			int numDrips = static_cast<int>(m_drips);
+			m_drips -= numDrips;
+			m_particles->Emit(ParticleSystem::KIND_DRIP, GetSpillCentre(animation.tileIdx), numDrips, static_cast<float>(m_view.GetTileSize()));
+		}
+	}
+
+	juce::Rectangle<int> oldBounds(m_particles->GetBounds());
+	if ((m_particles->GetNumParticles() == 0) && oldBounds.isEmpty())
+		return false;
+
+	// Repaint where the particles were, and where they are now.
+	m_particles->Update(seconds);
+	Invalidate(LAYER_EFFECTS, oldBounds.getUnion(m_particles->GetBounds()));
+
+	return true;
+}
+
+juce::Point<float> MainComponent::GetSpillCentre(int tileIdx) const
+{
+	juce::Point<float> centre(m_view.GetTileRect(tileIdx % m_snapshot->numCols, tileIdx / m_snapshot->numCols).getCentre().toFloat());
+
+	// Spills only ever happen at the oozing tile.
+	const Pipe* pipe = dynamic_cast<const Pipe*>(m_snapshot->oozingTile.get());
+	if ((pipe == nullptr) || (tileIdx != m_snapshot->oozingTileIdx))
+		return centre;
+
+	// Middle of the small puddle drawn by DrawSpill().
+	float offset = m_view.GetTileSize() * 0.75f;
+	int colStep(0);
+	int rowStep(0);
+	Topology::GetStep(pipe->GetFlowDirection(), colStep, rowStep);
+
+	return centre.translated(colStep * offset, rowStep * offset);
+}
 
-			for (int i = 0; (i < board->GetNumCols()) && !replace; i++)
+juce::Rectangle<int> MainComponent::GetAnimationRect(const Animator::Animation& animation) const
+{
+	switch (animation.type)
+	{
+		case Animator::ANIM_EXPLOSION:
 			{
-				for (int j = 0; (j < board->GetNumRows()) && !replace; j++)
-				{
-					juce::Rectangle<int> tileRect(	boardHStartPos + i * (m_tileSize - 1),
-													boardVStartPos + j * (m_tileSize - 1),
-													m_tileSize, m_tileSize);
-					if (tileRect.contains(clickPos))
-					{
-						// Default sound effect for placing pipes on the grid.
-						Controller::SoundID soundID(Controller::SOUND_CLICK);
-
-						TilePiece* clickedTile = board->GetTile(i, j);
-						replace = (clickedTile->GetType() == TilePiece::TYPE_NONE);
-
-						if (!replace)
-						{
-							Pipe* clickedPipe = dynamic_cast<Pipe*>(clickedTile);
-							if ((clickedPipe != nullptr) &&
-								(clickedPipe->IsEmpty()) &&		// Only empty tiles can be replaced.
-								(!clickedPipe->IsStart()) &&	// Cannot replace starter tiles.
-								(board->PopBomb()))				// Need bombs to replace existing pipe tiles.
-							{
-								replace = true;
-
-								// Sound effect should be explosive instead.
-								soundID = Controller::SOUND_EXPLODE;
-							}
-						}
-
-						if (replace)
-						{
-							// Trigger approproate sound effect.
-							Controller::GetInstance()->QueueSound(soundID);
-
-							// Grab the next piece in the queue, and...
-							TilePiece::Type newType = controller->GetQueue()->Pop();
-
-							// ... place it on the board.
-							board->ReplaceTile(i, j, newType);
-
-							// To prevent accidental double-clicking disable actions for a few frames.
-							static constexpr int framesInteractionBlocked = 5;
-							m_blockInteraction += framesInteractionBlocked;
-						}
-					}
-				}
+				// See DrawExplosion() for the star's outer radius.
+				juce::Rectangle<int> tileRect(m_view.GetTileRect(animation.tileIdx % m_snapshot->numCols, animation.tileIdx / m_snapshot->numCols));
+				int starRadius = static_cast<int>(EXPLOSION_SIZE * 8.0f);
+				return juce::Rectangle<int>(tileRect.getCentreX() - starRadius, tileRect.getCentreY() - starRadius, 
+											2 * starRadius, 2 * starRadius).expanded(1);
+			}
+
+		case Animator::ANIM_SPILL:
+			return m_view.GetTileRect(animation.tileIdx % m_snapshot->numCols, animation.tileIdx / m_snapshot->numCols).expanded(m_view.GetTileSize());
+
+		case Animator::ANIM_FLASH:
+			return m_layout.GetLevelNumberRect();
+
+		default:
+			break;
+	}
+
+	return juce::Rectangle<int>();
+}
+
+void MainComponent::Invalidate(MainComponent::Layer layer, juce::Rectangle<int> area)
+{
+	m_compositor->Invalidate(layer, area);
+	repaint(area);
+}
+
+void MainComponent::RepaintChanges()
+{
+	const RenderSnapshot& snapshot(*m_snapshot);
+	DrawnState& drawn(m_drawnState);
+	bool demo(m_autoPlayer != nullptr);
+
+	// A new round, a new level, or the start or end of the demo change the whole window.
+	if ((!drawn.valid) ||
+		(snapshot.tiles.size() != drawn.tileKeys.size()) ||
+		(snapshot.queueTiles.size() != drawn.queueKeys.size()) ||
+		(snapshot.roundNumber != drawn.roundNumber) ||
+		(snapshot.difficultyLevel != drawn.difficultyLevel) ||
+		(snapshot.puzzleMode != drawn.puzzleMode) ||
+		(demo != drawn.demo))
+	{
+		m_compositor->InvalidateAll();
+		repaint();
+		drawn.valid = true;
+		drawn.tileKeys.assign(snapshot.tiles.size(), 0);
+		drawn.queueKeys.assign(snapshot.queueTiles.size(), 0);
+	}
+
+	// Panning, zooming, or other cells in the snapshot, move the whole board and everything on it.
+	if ((m_view.GetBoardBounds() != drawn.boardBounds) || (snapshot.region != drawn.region))
+	{
+		Invalidate(LAYER_BOARD, m_view.GetArea());
+		Invalidate(LAYER_EFFECTS, getLocalBounds());
+		drawn.tileKeys.assign(snapshot.tiles.size(), 0);
+		drawn.boardBounds = m_view.GetBoardBounds();
+		drawn.region = snapshot.region;
+	}
+
+	// Board tiles. Only the visible ones are compared, so that this takes as long as the view is large, not the board.
+	juce::Rectangle<int> cells(m_view.GetVisibleCells().getIntersection(snapshot.region));
+	for (int row = cells.getY(); row < cells.getBottom(); row++)
+	{
+		for (int col = cells.getX(); col < cells.getRight(); col++)
+		{
+			int idx = snapshot.GetTileIndex(col, row);
+			juce::uint32 key = SpriteCache::GetKey(m_interpolator->GetTile(snapshot, idx));
+			if (key != drawn.tileKeys[idx])
+			{
+				Invalidate(LAYER_BOARD, m_view.GetTileRect(col, row).getIntersection(m_view.GetArea()));
+				drawn.tileKeys[idx] = key;
 			}
 		}
 	}
+
+	// Animations move on every frame, or have just been started or stopped.
+	for (const Animator::Animation& animation : m_animator.GetAnimations())
+		Invalidate(LAYER_EFFECTS, GetAnimationRect(animation));
+
+	// Queue.
+	bool queueChanged(false);
+	for (int i = 0; i < static_cast<int>(snapshot.queueTiles.size()); i++)
+	{
+		juce::uint32 key = (snapshot.queueTiles[i] != nullptr) ? SpriteCache::GetKey(snapshot.queueTiles[i].get()) : 0xffffffff;
+		if (key != drawn.queueKeys[i])
+		{
+			queueChanged = true;
+			drawn.queueKeys[i] = key;
+		}
+	}
+	if (queueChanged)
+		Invalidate(LAYER_BOARD, m_layout.GetQueueRect(static_cast<int>(snapshot.queueTiles.size())).expanded(6));
+
+	// The ooze meter follows the countdown, and then the score.
+	int oozeMeterLevel = GetOozeMeterLevel();
+	if ((oozeMeterLevel != drawn.oozeMeterLevel) || (snapshot.score != drawn.score))
+		Invalidate(LAYER_HUD, m_layout.GetOozeMeterRect().expanded(2));
+
+	if ((snapshot.score != drawn.score) ||
+		(snapshot.scoreToAdvance != drawn.scoreToAdvance) ||
+		(snapshot.puzzleNumber != drawn.puzzleNumber))
+		Invalidate(LAYER_HUD, m_layout.GetScoreRect());
+
+	if ((snapshot.numBombs != drawn.numBombs) || (snapshot.percentUntilFreeBomb != drawn.percentUntilFreeBomb))
+		Invalidate(LAYER_HUD, m_layout.GetBombsRect().expanded(1));
+
+	if ((snapshot.fastForward != drawn.fastForward) || (snapshot.spillInevitable != drawn.spillInevitable))
+		Invalidate(LAYER_HUD, m_layout.GetFastForwardRect().expanded(2));
+
+	// Arrival times count down with every tick, and move along with the ooze.
+	if (m_showArrivals &&
+		((snapshot.projectedPipes != drawn.projectedPipes) ||
+		(snapshot.projectedSpillIdx != drawn.projectedSpillIdx) ||
+		(snapshot.projectedSpillTicks != drawn.projectedSpillTicks)))
+	{
+		for (const std::pair<int, int>& projected : drawn.projectedPipes)
+			Invalidate(LAYER_EFFECTS, GetArrivalRect(projected.first, false));
+		for (const std::pair<int, int>& projected : snapshot.projectedPipes)
+			Invalidate(LAYER_EFFECTS, GetArrivalRect(projected.first, false));
+		if (drawn.projectedSpillIdx >= 0)
+			Invalidate(LAYER_EFFECTS, GetArrivalRect(drawn.projectedSpillIdx, true));
+		if (snapshot.projectedSpillIdx >= 0)
+			Invalidate(LAYER_EFFECTS, GetArrivalRect(snapshot.projectedSpillIdx, true));
+
+		drawn.projectedPipes = snapshot.projectedPipes;
+		drawn.projectedSpillIdx = snapshot.projectedSpillIdx;
+		drawn.projectedSpillTicks = snapshot.projectedSpillTicks;
+	}
+
+	drawn.roundNumber = snapshot.roundNumber;
+	drawn.difficultyLevel = snapshot.difficultyLevel;
+	drawn.puzzleMode = snapshot.puzzleMode;
+	drawn.demo = demo;
+	drawn.oozeMeterLevel = oozeMeterLevel;
+	drawn.score = snapshot.score;
+	drawn.scoreToAdvance = snapshot.scoreToAdvance;
+	drawn.puzzleNumber = snapshot.puzzleNumber;
+	drawn.numBombs = snapshot.numBombs;
+	drawn.percentUntilFreeBomb = snapshot.percentUntilFreeBomb;
+	drawn.fastForward = snapshot.fastForward;
+	drawn.spillInevitable = snapshot.spillInevitable;
+}
+
+void MainComponent::StartRound(Controller::Command cmd)
+{
+	m_simulation->StartRound(cmd);
+	m_idleTicks = 0;
+}
+
+void MainComponent::StartAttractMode()
+{
+	if (m_autoPlayer == nullptr)
+	{
+		// This deletes the unique_ptr, if there was any score window.
+		m_scoreWindow = nullptr;
+
+		m_autoPlayer = std::make_unique<AutoPlayer>();
+		m_autoPlayer->startThread();
+
+		StartRound(Controller::CMD_RESTART);
+		m_ticksUntilBotClick = BOT_CLICK_INTERVAL / GUI_REFRESH_RATE;
+	}
+}
+
+void MainComponent::StopAttractMode()
+{
+	if (m_autoPlayer != nullptr)
+	{
+		// This stops the thread and deletes the unique_ptr.
+		m_autoPlayer = nullptr;
+
+		StartRound(Controller::CMD_RESTART);
+	}
+}
+
+void MainComponent::StartPuzzleMode(const juce::File& file)
+{
+	// Puzzles are played by humans.
+	m_autoPlayer = nullptr;
+	m_scoreWindow = nullptr;
+
+	m_simulation->StartPuzzleMode(file);
+	m_idleTicks = 0;
+}
+
+void MainComponent::LoadLevelConfig(const juce::File& file)
+{
+	m_simulation->LoadLevelConfig(file);
+	m_idleTicks = 0;
+}
+
+void MainComponent::SetBoardSize(int numCols, int numRows, bool endless)
+{
+	m_simulation->SetBoardSize(numCols, numRows, endless);
+	m_idleTicks = 0;
+}
+
+void MainComponent::SetRule(Controller::Rule rule, int value)
+{
+	m_simulation->SetRule(rule, value);
+	m_idleTicks = 0;
+}
+
+void MainComponent::SetShowArrivals(bool show)
+{
+	m_showArrivals = show;
+	m_drawnState.valid = false;
+	m_frameDue = true;
+}
+
+void MainComponent::UpdateView()
+{
+	m_view.SetBounds(m_layout.GetBoardRect(), m_tileSize, m_snapshot->numCols, m_snapshot->numRows);
+
+	// Each round starts with the ooze source in view.
+	if ((m_snapshot->roundNumber != m_viewRound) && (m_snapshot->oozingTileIdx >= 0))
+	{
+		m_view.CentreOn(m_snapshot->oozingTileIdx % m_snapshot->numCols, m_snapshot->oozingTileIdx / m_snapshot->numCols);
+		m_viewRound = m_snapshot->roundNumber;
+	}
+
+	UpdateRegion();
+}
+
+void MainComponent::ViewChanged()
+{
+	// Particles would not follow the board around, so they are dropped. Spills keep dripping, though.
+	m_particles->Clear();
+
+	UpdateRegion();
+	m_frameDue = true;
+}
+
+void MainComponent::UpdateRegion()
+{
+	juce::Rectangle<int> visible(m_view.GetVisibleCells());
+	if (visible.isEmpty())
+		return;
+
+	// Some cells around the visible ones are requested as well, so that panning doesn't run out of tiles
+	// before the next snapshot arrives. After zooming in, a region much larger than needed is given up.
+	juce::Rectangle<int> wanted(visible.expanded(visible.getWidth() / 2, visible.getHeight() / 2));
+	if (m_requestedRegion.contains(visible) &&
+		((m_requestedRegion.getWidth() * m_requestedRegion.getHeight()) <= (4 * wanted.getWidth() * wanted.getHeight())))
+		return;
+
+	if (m_simulation->SetRegion(wanted))
+		m_requestedRegion = wanted;
+}
+
+void MainComponent::UpdateAutoPlayer()
+{
+	// Nothing left to play for in this round.
+	if (m_snapshot->spillInevitable)
+	{
+		m_simulation->SkipToResults();
+		return;
+	}
+
+	// The situation is handed over one tick before the click is due, leaving 
+	// the AutoPlayer a full tick to think, without working on stale information.
+	if (m_ticksUntilBotClick == 1)
+		m_autoPlayer->RequestMove(m_snapshot->situation);
+
+	if (m_ticksUntilBotClick > 0)
+		m_ticksUntilBotClick--;
+
+	// If the AutoPlayer isn't done thinking yet, try again at the next tick.
+	Planner::Move move;
+	if ((m_ticksUntilBotClick == 0) && m_autoPlayer->PopMove(move))
+	{
+		if (move.IsValid())
+		{
+			// On boards larger than the view, the view follows the bot around.
+			if (!m_view.GetArea().contains(m_view.GetTileRect(move.col, move.row).getCentre()) && 
+				m_view.CentreOn(move.col, move.row))
+				ViewChanged();
+
+			HandleClick(m_view.GetTileRect(move.col, move.row).getCentre());
+		}
+
+		// Human players don't click with perfect regularity.
+		static constexpr int jitterTicks = 3;
+		m_ticksUntilBotClick = (BOT_CLICK_INTERVAL / GUI_REFRESH_RATE) + Randomizer::GetInstance()->GetWithinRange(-jitterTicks, jitterTicks);
+	}
 }
 
 void MainComponent::changeListenerCallback(juce::ChangeBroadcaster* source) 
 {
 	(void)source;
 
-	const juce::ScopedLock lock(m_lock);
-
 	if (m_scoreWindow != nullptr)
 	{
 		switch (m_scoreWindow->GetCommand())
 		{
 			case Controller::CMD_RESTART:
 			case Controller::CMD_CONTINUE:
-				{
-					Controller::GetInstance()->Reset(m_scoreWindow->GetCommand());
-
-					// Countdown to ooze pumping.
-					m_countDown = Controller::GetInstance()->GetCurrentCountdown();
-
-					// Restart GUI
-					m_blockInteraction = 0;
-					startTimer(GUI_REFRESH_RATE);
-				}
+				StartRound(m_scoreWindow->GetCommand());
 				break;
 
 			case Controller::CMD_QUIT:
@@ -296,6 +810,14 @@ juce::Colour MainComponent::GetTileColourForLevel(int difficultyLevel)
 }
 
 juce::Font MainComponent::GetFont(LabelID labelID) const
+{
+	if ((labelID >= 0) && (labelID < LABEL_MAX))
+		return m_fonts[labelID];
+
+	return juce::Font();
+}
+
+juce::Font MainComponent::CreateFont(LabelID labelID) const
 {
 	// Scale the font according to the game window's both width and height.
 	int minDimension = std::min<int>(static_cast<int>(getLocalBounds().getWidth() / 1.4516f), getLocalBounds().getHeight());
@@ -307,899 +829,338 @@ juce::Font MainComponent::GetFont(LabelID labelID) const
 			return juce::Font("consolas", (minDimension * 32.0f / 620.0f), juce::Font::plain);
 		case LABEL_BSCORE:
 			return juce::Font("consolas", (minDimension * 32.0f / 620.0f), juce::Font::bold);
+		default:
+			break;
 	}
 
 	return juce::Font();
 }
 
+void MainComponent::LayoutLabels()
+{
+	m_levelLabelText.clear();
+	m_puzzleLabelText.clear();
+	m_scoreLabelText.clear();
+	m_versionText.clear();
+	m_demoText.clear();
+
+	TextCache::AddLine(m_levelLabelText, GetFont(LABEL_SCORE), "Level:", m_layout.GetLevelLabelRect(), juce::Justification::left);
+	TextCache::AddLine(m_puzzleLabelText, GetFont(LABEL_SCORE), "Puzzle:", m_layout.GetLevelLabelRect(), juce::Justification::left);
+	TextCache::AddLine(m_scoreLabelText, GetFont(LABEL_SCORE), "Score:", m_layout.GetScoreLabelRect(), juce::Justification::left);
+
+	// App info
+	juce::String infoText("Pipe Dreamer V");
+	juce::String versionString(JUCE_STRINGIFY(JUCE_APP_VERSION));
+	infoText << versionString;
+	juce::Rectangle<int> textRect(m_layout.GetInfoTextRect());
+	TextCache::AddLine(m_versionText, GetFont(LABEL_VERSION), infoText, textRect, juce::Justification::left);
+
+	// In attract mode, the info is replaced by a hint, which must not run into the hyperlink.
+	textRect.setWidth(m_layout.GetHyperlinkRect().getX() - textRect.getX());
+	TextCache::AddLine(m_demoText, GetFont(LABEL_VERSION), "DEMO - Click to play!", textRect, juce::Justification::left);
+}
+
 void MainComponent::paint(juce::Graphics& g)
 {
-	Board* board(Controller::GetInstance()->GetBoard());
-	Queue* queue(Controller::GetInstance()->GetQueue());
+	// Layers are normally rasterised by timerCallback() already. After a resize, they are due here.
+	RenderLayers();
 
-	int boardHStartPos = static_cast<int>(getLocalBounds().getWidth() / 5.114f);
-	int boardVStartPos = static_cast<int>(getLocalBounds().getHeight() / 7.75f);
+	m_compositor->Composite(g);
+}
+
+void MainComponent::RenderLayers()
+{
+	// Layers and sprites are rendered anew after a resize, a level change, or a move onto a display with another scale.
+	float scale = juce::Component::getApproximateScaleFactorForComponent(this);
+	m_compositor->SetSize(getLocalBounds().getWidth(), getLocalBounds().getHeight(), scale);
+	m_spriteCache->SetStyle(m_tileSize, GetTileColourForLevel(m_snapshot->difficultyLevel), scale);
+	m_boardSprites->SetStyle(m_view.GetTileSize(), GetTileColourForLevel(m_snapshot->difficultyLevel), scale);
+	m_scoreDigits.SetStyle(GetFont(LABEL_SCORE), juce::Colours::grey, scale);
+	m_highlightedScoreDigits.SetStyle(GetFont(LABEL_BSCORE), juce::Colours::yellow, scale);
+	m_levelDigits.SetStyle(GetFont(LABEL_SCORE), GetTileColourForLevel(m_snapshot->difficultyLevel), scale);
+
+	// The layers draw the snapshot picked up by timerCallback(). 
+	// The SimulationThread leaves it alone until the next one is picked up.
+	m_compositor->Render();
+}
 
+void MainComponent::PaintBackground(juce::Graphics& g)
+{
 	// Background colour
 	g.fillAll(juce::Colour(67, 67, 67));
 
-	// Draw countdown to ooze.
-	DrawOozeMeter(juce::Point<int>(static_cast<int>(getLocalBounds().getWidth() / 12.05f), 30), g);
-
-	// Draw current level number and score
-	DrawLevelAndScore(g);
-
-	// Draw app info
+	// Draw app info. In attract mode, let the audience know they can take over.
+	if (m_autoPlayer != nullptr)
+	{
+		g.setColour(juce::Colours::yellow);
+		m_demoText.draw(g);
+	}
+	else
 	{
-		juce::String infoText("Pipe Dreamer V");
-		juce::String versionString(JUCE_STRINGIFY(JUCE_APP_VERSION));
-		infoText << versionString;
-
-		juce::Rectangle<int> textRect(boardHStartPos, getLocalBounds().getHeight() - 50, static_cast<int>(getLocalBounds().getWidth() / 5.625f), 40);
-
-		g.setFont(GetFont(LABEL_VERSION));
 		g.setColour(juce::Colours::grey);
-		g.drawText(infoText, textRect, juce::Justification::left, false);
-		//g.drawRect(textRect, 1);
-
-		//textRect = juce::Rectangle<int>(getLocalBounds().getWidth() - 380, getLocalBounds().getHeight() - 50, 350, 40);
-		//g.drawRect(textRect, 1);
+		m_versionText.draw(g);
 	}
 
-	// Draw bombs
-	DrawBombs(juce::Point<int>(static_cast<int>(getLocalBounds().getWidth() / 1.6749f), 20), g);
-
-	// Draw button to accelerate game speed.
-	DrawFastForwardButton(g);
+	//textRect = juce::Rectangle<int>(getLocalBounds().getWidth() - 380, getLocalBounds().getHeight() - 50, 350, 40);
+	//g.drawRect(textRect, 1);
+}
 
-	// Draw tile queue: queueVStartPos is the origin ob the bottomest tile in the queue
-	int queueVStartPos = static_cast<int>(getLocalBounds().getHeight() / 1.3757f);
-	int queueHStartPos = static_cast<int>(getLocalBounds().getWidth() / 18);
-	for (int i = 0; i < queue->GetSize(); i++)
+void MainComponent::PaintBoard(juce::Graphics& g)
+{
+	// Draw tile queue, starting with the bottommost tile.
+	for (int i = 0; i < static_cast<int>(m_snapshot->queueTiles.size()); i++)
 	{
-		// Pipe shape
-		juce::Point<int> p(queueHStartPos, queueVStartPos - i * (m_tileSize - 1));
-		DrawTile((queue->GetTile(i)), p, g);
-		DrawCrossSecondWay((queue->GetTile(i)), p, g);
-		DrawTileDecoration((queue->GetTile(i)), p, g);
+		// Pipe shape. Puzzles run out of pipes, leaving gaps in the queue.
+		juce::Point<int> p(m_layout.GetQueueTileOrigin(i));
+		const TilePiece* tile = m_snapshot->queueTiles[i].get();
+		if (tile != nullptr)
+			m_spriteCache->DrawTile(tile, p, g);
 
 		if (i == 0)
 		{
 			// Extra frame for the tile at the start of the queue.
 			g.setColour(juce::Colours::limegreen);
-			g.drawRect(queueHStartPos - 4, queueVStartPos - 4, m_tileSize + 8, m_tileSize + 8, 2);
+			g.drawRect(p.getX() - 4, p.getY() - 4, m_tileSize + 8, m_tileSize + 8, 2);
 			g.setColour(juce::Colours::black);
-			g.drawRect(queueHStartPos - 6, queueVStartPos - 6, m_tileSize + 12, m_tileSize + 12, 2);
+			g.drawRect(p.getX() - 6, p.getY() - 6, m_tileSize + 12, m_tileSize + 12, 2);
 		}
 	}
 
-	// Position of the oozing tile. Needed for displaying spills below.
-	juce::Point<int> oozingTileOrigin;
+	// Draw board, within the view. Only the visible tiles are visited, and those outside of the invalid area are skipped.
+	g.reduceClipRegion(m_view.GetArea());
+	juce::Rectangle<int> cells(m_view.GetVisibleCells().getIntersection(m_snapshot->region));
+	if (!m_view.IsDetailed())
+	{
+		DrawBoardOverview(cells, g);
+		return;
+	}
 
-	// Draw board.
-	for (int i = 0; i < board->GetNumCols(); i++)
+	for (int row = cells.getY(); row < cells.getBottom(); row++)
 	{
-		for (int j = 0; j < board->GetNumRows(); j++)
+		for (int col = cells.getX(); col < cells.getRight(); col++)
 		{
-			juce::Point<int> p(boardHStartPos + i * (m_tileSize - 1), boardVStartPos + j * (m_tileSize - 1));
-
-			TilePiece* tile = board->GetTile(i, j);
-
-			DrawTile(tile, p, g);
-			DrawOoze(tile, p, g);
-			DrawCrossSecondWay(tile, p, g);
-			DrawTileDecoration(tile, p, g);
-
-			if (board->GetOozingTile() == tile)
-				oozingTileOrigin = p;
+			juce::Rectangle<int> tileRect(m_view.GetTileRect(col, row));
+			if (g.clipRegionIntersects(tileRect))
+				m_boardSprites->DrawTile(m_interpolator->GetTile(*m_snapshot, m_snapshot->GetTileIndex(col, row)), tileRect.getPosition(), g);
 		}
 	}
-
-	// Draw ooze spillage, if any.
-	DrawSpill(oozingTileOrigin, g);
 }
 
-void MainComponent::DrawLevelAndScore(juce::Graphics& g)
+void MainComponent::DrawBoardOverview(juce::Rectangle<int> cells, juce::Graphics& g)
 {
-	Controller* controller(Controller::GetInstance());
-	int playerScore = controller->GetBoard()->GetScoreValue();
-
-	g.setFont(GetFont(LABEL_SCORE));
-	g.setColour(juce::Colours::grey);
-
-	int halfTile = m_tileSize / 2;
-	juce::Rectangle<int> textRect(	static_cast<int>(getLocalBounds().getWidth() / 5.114f), 20, 
-									static_cast<int>(getLocalBounds().getWidth() / 9.7826f), halfTile);
-	g.drawText("Level:", textRect, juce::Justification::left, false);
-	// g.drawRect(textRect, 1.0f); // frame
-
-	textRect = juce::Rectangle<int>(	static_cast<int>(getLocalBounds().getWidth() / 2.8421f), 20, 
-										static_cast<int>(getLocalBounds().getWidth() / 9.7826f), halfTile);
-	g.drawText("Score:", textRect, juce::Justification::left, false);
-	// g.drawRect(textRect, 1.0f); // frame
-
-	// If score this round is high enough to advance to next difficulty level, highlight the number.
-	if (playerScore >= Controller::MIN_SCORE_TO_ADVANCE)
+	// Light grid behind all tiles, as left by the tiles' frames.
+	g.setColour(juce::Colours::white.withAlpha(0.25f));
+	g.fillRect(m_view.GetBoardBounds().getIntersection(m_view.GetArea()));
+
+	// One flat colour for pipes, and one for pipes with ooze, each filled in one go.
+	juce::RectangleList<int> pipeRects;
+	juce::RectangleList<int> oozeRects;
+	for (int row = cells.getY(); row < cells.getBottom(); row++)
 	{
-		g.setColour(juce::Colours::yellow);
-		g.setFont(GetFont(LABEL_BSCORE));
+		for (int col = cells.getX(); col < cells.getRight(); col++)
+		{
+			const Pipe* pipe = dynamic_cast<const Pipe*>(m_interpolator->GetTile(*m_snapshot, m_snapshot->GetTileIndex(col, row)));
+			if (pipe == nullptr)
+				continue;
+
+			juce::Rectangle<int> tileRect(m_view.GetTileRect(col, row).reduced(1));
+			if (pipe->IsEmpty())
+				pipeRects.addWithoutMerging(tileRect);
+			else
+				oozeRects.addWithoutMerging(tileRect);
+		}
 	}
-	textRect = juce::Rectangle<int>(static_cast<int>(getLocalBounds().getWidth() / 2.1880f), 20, 
-									static_cast<int>(getLocalBounds().getWidth() / 5.625f), halfTile);
-	g.drawText(juce::String(playerScore), textRect, juce::Justification::left, false);
-	// g.drawRect(textRect, 1.0f); // frame
 
-	// Show difficulty level number in this level's tile color.
-	g.setColour(GetTileColourForLevel(controller->GetDifficultyLevel()));
-	textRect = juce::Rectangle<int>(static_cast<int>(getLocalBounds().getWidth() / 3.375f), 20, 
-									static_cast<int>(getLocalBounds().getWidth() / 17.31f), halfTile);
-	g.drawText(juce::String(controller->GetDifficultyLevel()), textRect, juce::Justification::left, false);
-	// g.drawRect(textRect, 1.0f); // frame
+	g.setColour(GetTileColourForLevel(m_snapshot->difficultyLevel));
+	g.fillRectList(pipeRects);
+	g.setColour(juce::Colours::limegreen);
+	g.fillRectList(oozeRects);
 }
 
-void MainComponent::DrawTile(TilePiece* tile, juce::Point<int> origin, juce::Graphics& g)
+void MainComponent::PaintHud(juce::Graphics& g)
 {
-	if (tile->GetType() != TilePiece::TYPE_NONE)
-	{
-		Pipe* pipe = dynamic_cast<Pipe*>(tile);
-		if (pipe != nullptr)
-		{
-			// Draw tile's Background color
-			g.setColour(GetTileColourForLevel(Controller::GetInstance()->GetDifficultyLevel()));
-			g.fillRect(origin.getX(), origin.getY(), m_tileSize, m_tileSize);
-
-			juce::Line<int> line;
-			float pipeThickness = m_tileSize / 3.5f;
-			g.setColour(juce::Colours::black);
-
-			// Ellipse rect used to have nice rounded corners in the elbow pipes.
-			int halfTile = m_tileSize / 2;
-			juce::Rectangle<float> elbowJoint(	origin.getX() + halfTile - (pipeThickness / 2.0f),
-												origin.getY() + halfTile - (pipeThickness / 2.0f),
-												pipeThickness, 
-												pipeThickness);
-
-			switch (pipe->GetType())
-			{
-			case TilePiece::TYPE_START_N:
-				{
-					line = juce::Line<int>(	origin.getX() + halfTile,
-											origin.getY(),
-											origin.getX() + halfTile,
-											origin.getY() + halfTile);
-					g.drawLine(line.toFloat(), pipeThickness);
-					g.fillEllipse(elbowJoint);
-				}
-				break;
-
-			case TilePiece::TYPE_START_S:
-				{
-					line = juce::Line<int>(	origin.getX() + halfTile,
-											origin.getY() + halfTile,
-											origin.getX() + halfTile,
-											origin.getY() + m_tileSize);
-					g.drawLine(line.toFloat(), pipeThickness);
-					g.fillEllipse(elbowJoint);
-				}
-				break;
+	// Draw countdown to ooze.
+	DrawOozeMeter(m_layout.GetOozeMeterRect().getPosition(), g);
 
-			case TilePiece::TYPE_START_E:
-				{
-					line = juce::Line<int>(	origin.getX() + halfTile,
-											origin.getY() + halfTile,
-											origin.getX() + m_tileSize,
-											origin.getY() + halfTile);
-					g.drawLine(line.toFloat(), pipeThickness);
-					g.fillEllipse(elbowJoint);
-				}
-				break;
+	// Draw current level number and score
+	DrawLevelAndScore(g);
 
-			case TilePiece::TYPE_START_W:
-				{
-					line = juce::Line<int>(	origin.getX() + halfTile,
-											origin.getY() + halfTile,
-											origin.getX(), 
-											origin.getY() + halfTile);
-					g.drawLine(line.toFloat(), pipeThickness);
-					g.fillEllipse(elbowJoint);
-				}
-				break;
+	// Draw bombs
+	DrawBombs(g);
 
-			case TilePiece::TYPE_VERTICAL:
-				{
-					line = juce::Line<int>(	origin.getX() + halfTile,
-											origin.getY(), 
-											origin.getX() + halfTile,
-											origin.getY() + m_tileSize);
-					g.drawLine(line.toFloat(), pipeThickness);
-				}
-				break;
+	// Draw button to accelerate game speed.
+	DrawFastForwardButton(g);
+}
 
-			case TilePiece::TYPE_HORIZONTAL:
-				{
-					line = juce::Line<int>(	origin.getX(), 
-											origin.getY() + halfTile,
-											origin.getX() + m_tileSize,
-											origin.getY() + halfTile);
-					g.drawLine(line.toFloat(), pipeThickness);
-				}
-				break;
+void MainComponent::PaintEffects(juce::Graphics& g)
+{
+	// Arrival times go underneath everything else.
+	if (m_showArrivals && m_view.IsDetailed())
+		DrawArrivals(g);
 
-			case TilePiece::TYPE_NW_ELBOW:
-				{
-					line = juce::Line<int>(	origin.getX() + halfTile,
-											origin.getY(), 
-											origin.getX() + halfTile,
-											origin.getY() + halfTile);
-					g.drawLine(line.toFloat(), pipeThickness);
-					line = juce::Line<int>(	origin.getX(), 
-											origin.getY() + halfTile,
-											origin.getX() + halfTile,
-											origin.getY() + halfTile);
-					g.drawLine(line.toFloat(), pipeThickness);
-					g.fillEllipse(elbowJoint);
-				}
-				break;
+	// Only the animations' progress is read here. They are moved on by RenderFrame().
+	for (const Animator::Animation& animation : m_animator.GetAnimations())
+	{
+		juce::Point<int> origin;
+		if (animation.tileIdx >= 0)
+			origin = m_view.GetTileRect(animation.tileIdx % m_snapshot->numCols, animation.tileIdx / m_snapshot->numCols).getPosition();
 
-			case TilePiece::TYPE_NE_ELBOW:
-				{
-					line = juce::Line<int>(	origin.getX() + halfTile,
-											origin.getY(), 
-											origin.getX() + halfTile,
-											origin.getY() + halfTile);
-					g.drawLine(line.toFloat(), pipeThickness);
-					line = juce::Line<int>(	origin.getX() + halfTile,
-											origin.getY() + halfTile,
-											origin.getX() + m_tileSize,
-											origin.getY() + halfTile);
-					g.drawLine(line.toFloat(), pipeThickness);
-					g.fillEllipse(elbowJoint);
-				}
+		switch (animation.type)
+		{
+			case Animator::ANIM_EXPLOSION:
+				DrawExplosion(animation.progress, origin, g);
 				break;
 
-			case TilePiece::TYPE_SE_ELBOW:
-				{
-					line = juce::Line<int>(	origin.getX() + halfTile,
-											origin.getY() + halfTile,
-											origin.getX() + halfTile,
-											origin.getY() + m_tileSize);
-					g.drawLine(line.toFloat(), pipeThickness);
-					line = juce::Line<int>(	origin.getX() + halfTile,
-											origin.getY() + halfTile,
-											origin.getX() + m_tileSize,
-											origin.getY() + halfTile);
-					g.drawLine(line.toFloat(), pipeThickness);
-					g.fillEllipse(elbowJoint);
-				}
+			case Animator::ANIM_SPILL:
+				DrawSpill(animation.progress, origin, g);
 				break;
 
-			case TilePiece::TYPE_SW_ELBOW:
-				{
-					line = juce::Line<int>(	origin.getX() + halfTile,
-											origin.getY() + halfTile,
-											origin.getX() + halfTile,
-											origin.getY() + m_tileSize);
-					g.drawLine(line.toFloat(), pipeThickness);
-					line = juce::Line<int>(	origin.getX(), 
-											origin.getY() + halfTile,
-											origin.getX() + halfTile,
-											origin.getY() + halfTile);
-					g.drawLine(line.toFloat(), pipeThickness);
-					g.fillEllipse(elbowJoint);
-				}
-				break;
-
-			case TilePiece::TYPE_CROSS:
-				{
-					Cross* crossTile = dynamic_cast<Cross*>(pipe);
-					if (crossTile->GetBackgroundWay() == Cross::WAY_HORIZONTAL)
-					{
-						// Draw horizontal pipe first. 
-						// Vertical pipe will be drawn in DrawCrossSecondWay()
-						line = juce::Line<int>(	origin.getX(), 
-												origin.getY() + halfTile,
-												origin.getX() + m_tileSize,
-												origin.getY() + halfTile);
-					}
-					else
-					{
-						// Draw vertica pipe first. 
-						// Horizontal pipe will be drawn in DrawCrossSecondWay()
-						line = juce::Line<int>(	origin.getX() + halfTile,
-												origin.getY(), 
-												origin.getX() + halfTile,
-												origin.getY() + m_tileSize);
-					}
-
-					g.drawLine(line.toFloat(), pipeThickness);
-				}
+			case Animator::ANIM_FLASH:
+				DrawLevelFlash(animation.progress, g);
 				break;
 
 			default:
 				break;
-			}
 		}
 	}
+
+	// All particles in one go, on top.
+	m_particles->Render(g);
 }
 
-void MainComponent::DrawOoze(TilePiece* tile, juce::Point<int> origin, juce::Graphics& g)
+void MainComponent::DrawLevelAndScore(juce::Graphics& g)
 {
-	if (tile->GetType() != TilePiece::TYPE_NONE)
-	{
-		Pipe* pipe = dynamic_cast<Pipe*>(tile);
-		if ((pipe != nullptr) &&
-			(!pipe->IsEmpty()))
-		{
-			static const float oozealfThickness = OOZE_THICKNESS / 2.0f;
-			bool overHalf(pipe->GetOozeLevel() >= 50.0f);
-			bool underHalf(pipe->GetOozeLevel() < 50.0f);
-			int fill = static_cast<int>(m_tileSize * pipe->GetOozeLevel() / MAX_OOZE_LEVEL);
-
-			juce::Line<int> line;
-			g.setColour(juce::Colours::limegreen);
-
-			// Ellipse rect used to have nice rounded corners in the elbow pipes.
-			int halfTile = m_tileSize / 2;
-			juce::Rectangle<float> elbowJoint(	origin.getX() + halfTile - oozealfThickness,
-												origin.getY() + halfTile - oozealfThickness,
-												OOZE_THICKNESS, 
-												OOZE_THICKNESS);
-
-			switch (pipe->GetType())
-			{
-			case TilePiece::TYPE_START_N:
-				{
-					if (overHalf)
-					{
-						line = juce::Line<int>(	origin.getX() + halfTile,
-												origin.getY() + m_tileSize - fill,
-												origin.getX() + halfTile,
-												origin.getY() + halfTile);
-						g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						g.fillEllipse(elbowJoint);
-					}
-				}
-				break;
-
-			case TilePiece::TYPE_START_S:
-				{
-					if (overHalf)
-					{
-						line = juce::Line<int>(	origin.getX() + halfTile,
-												origin.getY() + halfTile,
-												origin.getX() + halfTile,
-												origin.getY() + fill);
-						g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						g.fillEllipse(elbowJoint);
-					}
-				}
-				break;
-
-			case TilePiece::TYPE_START_E:
-				{
-					if (overHalf)
-					{
-						line = juce::Line<int>(	origin.getX() + halfTile,
-												origin.getY() + halfTile,
-												origin.getX() + fill, 
-												origin.getY() + halfTile);
-						g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						g.fillEllipse(elbowJoint);
-					}
-				}
-				break;
-
-			case TilePiece::TYPE_START_W:
-				{
-					if (overHalf)
-					{
-						line = juce::Line<int>(	origin.getX() + m_tileSize - fill,
-												origin.getY() + halfTile,
-												origin.getX() + halfTile,
-												origin.getY() + halfTile);
-						g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						g.fillEllipse(elbowJoint);
-					}
-				}
-				break;
-
-			case TilePiece::TYPE_VERTICAL:
-				{
-					if (pipe->GetFlowDirection() == Pipe::DIR_N)
-						line = juce::Line<int>(	origin.getX() + halfTile,
-												origin.getY() + m_tileSize - fill,
-												origin.getX() + halfTile,
-												origin.getY() + m_tileSize);
-					else if (pipe->GetFlowDirection() == Pipe::DIR_S)
-						line = juce::Line<int>(	origin.getX() + halfTile,
-												origin.getY(), 
-												origin.getX() + halfTile,
-												origin.getY() + fill);
-
-					g.drawLine(line.toFloat(), OOZE_THICKNESS);
-				}
-				break;
+	int playerScore = m_snapshot->score;
 
-			case TilePiece::TYPE_HORIZONTAL:
-				{
-					if (pipe->GetFlowDirection() == Pipe::DIR_E)
-						line = juce::Line<int>(	origin.getX(), 
-												origin.getY() + halfTile,
-												origin.getX() + fill, 
-												origin.getY() + halfTile);
-					else if (pipe->GetFlowDirection() == Pipe::DIR_W)
-						line = juce::Line<int>(	origin.getX() + m_tileSize - fill,
-												origin.getY() + halfTile,
-												origin.getX() + m_tileSize,
-												origin.getY() + halfTile);
-
-					g.drawLine(line.toFloat(), OOZE_THICKNESS);
-				}
-				break;
+	// Labels were laid out by resized() already.
+	g.setColour(juce::Colours::grey);
+	if (m_snapshot->puzzleMode)
+		m_puzzleLabelText.draw(g);
+	else
+		m_levelLabelText.draw(g);
+	m_scoreLabelText.draw(g);
 
-			case TilePiece::TYPE_NW_ELBOW:
-				{
-					if (pipe->GetFlowDirection() == Pipe::DIR_N)
-					{
-						if (underHalf)
-						{
-							line = juce::Line<int>(	origin.getX(), 
-													origin.getY() + halfTile,
-													origin.getX() + fill, 
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						}
-						else
-						{
-							line = juce::Line<int>(	origin.getX(), 
-													origin.getY() + halfTile,
-													origin.getX() + halfTile,
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							line = juce::Line<int>(	origin.getX() + halfTile,
-													origin.getY() + m_tileSize - fill,
-													origin.getX() + halfTile,
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							g.fillEllipse(elbowJoint);
-						}
-					}
-					else if (pipe->GetFlowDirection() == Pipe::DIR_W)
-					{
-						if (underHalf)
-						{
-							line = juce::Line<int>(	origin.getX() + halfTile,
-													origin.getY(), 
-													origin.getX() + halfTile,
-													origin.getY() + fill);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						}
-						else
-						{
-							line = juce::Line<int>(	origin.getX() + halfTile,
-													origin.getY(), 
-													origin.getX() + halfTile,
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							line = juce::Line<int>(	origin.getX() + m_tileSize - fill,
-													origin.getY() + halfTile,
-													origin.getX() + halfTile,
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							g.fillEllipse(elbowJoint);
-						}
-					}
-				}
-				break;
+	// Puzzles show the score to reach.
+	juce::String scoreText(playerScore);
+	if (m_snapshot->puzzleMode)
+		scoreText << "/" << m_snapshot->scoreToAdvance;
 
-			case TilePiece::TYPE_NE_ELBOW:
-				{
-					if (pipe->GetFlowDirection() == Pipe::DIR_N)
-					{
-						if (underHalf)
-						{
-							line = juce::Line<int>(	origin.getX() + m_tileSize - fill,
-													origin.getY() + halfTile, 
-													origin.getX() + m_tileSize,
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						}
-						else
-						{
-							line = juce::Line<int>(	origin.getX() + halfTile, 
-													origin.getY() + halfTile, 
-													origin.getX() + m_tileSize,
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							line = juce::Line<int>(	origin.getX() + halfTile, 
-													origin.getY() + m_tileSize - fill,
-													origin.getX() + halfTile, 
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							g.fillEllipse(elbowJoint);
-						}
-					}
-					else if (pipe->GetFlowDirection() == Pipe::DIR_E)
-					{
-						if (underHalf)
-						{
-							line = juce::Line<int>(	origin.getX() + halfTile, 
-													origin.getY(), 
-													origin.getX() + halfTile, 
-													origin.getY() + fill);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						}
-						else
-						{
-							line = juce::Line<int>(	origin.getX() + halfTile, 
-													origin.getY(), 
-													origin.getX() + halfTile, 
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							line = juce::Line<int>(	origin.getX() + halfTile, 
-													origin.getY() + halfTile, 
-													origin.getX() + fill, 
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							g.fillEllipse(elbowJoint);
-						}
-					}
-				}
-				break;
-
-			case TilePiece::TYPE_SE_ELBOW:
-				{
-					if (pipe->GetFlowDirection() == Pipe::DIR_S)
-					{
-						if (underHalf)
-						{
-							line = juce::Line<int>(	origin.getX() + m_tileSize - fill,
-													origin.getY() + halfTile, 
-													origin.getX() + m_tileSize,
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						}
-						else
-						{
-							line = juce::Line<int>(	origin.getX() + halfTile, 
-													origin.getY() + halfTile, 
-													origin.getX() + m_tileSize,
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							line = juce::Line<int>(	origin.getX() + halfTile, 
-													origin.getY() + halfTile, 
-													origin.getX() + halfTile, 
-													origin.getY() + fill);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							g.fillEllipse(elbowJoint);
-						}
-					}
-					else if (pipe->GetFlowDirection() == Pipe::DIR_E)
-					{
-						if (underHalf)
-						{
-							line = juce::Line<int>(	origin.getX() + halfTile, 
-													origin.getY() + m_tileSize - fill,
-													origin.getX() + halfTile, 
-													origin.getY() + m_tileSize);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						}
-						else
-						{
-							line = juce::Line<int>(	origin.getX() + halfTile, 
-													origin.getY() + halfTile, 
-													origin.getX() + halfTile, 
-													origin.getY() + m_tileSize);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							line = juce::Line<int>(	origin.getX() + halfTile, 
-													origin.getY() + halfTile, 
-													origin.getX() + fill, 
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							g.fillEllipse(elbowJoint);
-						}
-					}
-				}
-				break;
+	// If score this round is high enough to advance to next difficulty level, highlight the number.
+	const DigitAtlas& scoreDigits = (playerScore >= m_snapshot->scoreToAdvance) ? m_highlightedScoreDigits : m_scoreDigits;
+	scoreDigits.Draw(g, scoreText, m_layout.GetScoreNumberRect(), juce::Justification::left);
+	// g.drawRect(m_layout.GetScoreNumberRect(), 1.0f); // frame
 
-			case TilePiece::TYPE_SW_ELBOW:
-				{
-					if (pipe->GetFlowDirection() == Pipe::DIR_S)
-					{
-						if (underHalf)
-						{
-							line = juce::Line<int>(	origin.getX(), 
-													origin.getY() + halfTile, 
-													origin.getX() + fill, 
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						}
-						else
-						{
-							line = juce::Line<int>(	origin.getX(), 
-													origin.getY() + halfTile, 
-													origin.getX() + halfTile, 
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							line = juce::Line<int>(	origin.getX() + halfTile, 
-													origin.getY() + halfTile, 
-													origin.getX() + halfTile, 
-													origin.getY() + fill);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							g.fillEllipse(elbowJoint);
-						}
-					}
-					else if (pipe->GetFlowDirection() == Pipe::DIR_W)
-					{
-						if (underHalf)
-						{
-							line = juce::Line<int>(	origin.getX() + halfTile, 
-													origin.getY() + m_tileSize - fill,
-													origin.getX() + halfTile, 
-													origin.getY() + m_tileSize);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						}
-						else
-						{
-							line = juce::Line<int>(	origin.getX() + halfTile, 
-													origin.getY() + halfTile, 
-													origin.getX() + halfTile, 
-													origin.getY() + m_tileSize);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							line = juce::Line<int>(	origin.getX() + m_tileSize - fill,
-													origin.getY() + halfTile, 
-													origin.getX() + halfTile, 
-													origin.getY() + halfTile);
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-							g.fillEllipse(elbowJoint);
-						}
-					}
-				}
-				break;
+	// Show difficulty level number in this level's tile color.
+	int levelNumber = m_snapshot->puzzleMode ? m_snapshot->puzzleNumber : m_snapshot->difficultyLevel;
+	m_levelDigits.Draw(g, juce::String(levelNumber), m_layout.GetLevelNumberRect(), juce::Justification::left);
+	// g.drawRect(m_layout.GetLevelNumberRect(), 1.0f); // frame
+}
 
-			case TilePiece::TYPE_CROSS:
-				{
-					Cross* crossTile = dynamic_cast<Cross*>(pipe);
-					if (crossTile->GetBackgroundWay() == Cross::WAY_HORIZONTAL)
-					{
-						// Draw horizontally flowing ooze first.
-						fill = static_cast<int>(m_tileSize * crossTile->GetOozeLevel(Cross::WAY_HORIZONTAL) / MAX_OOZE_LEVEL);
-						if (fill > 0)
-						{
-							if (pipe->GetFlowDirection() == Pipe::DIR_E)
-							{
-								line = juce::Line<int>(	origin.getX(),
-														origin.getY() + halfTile,
-														origin.getX() + fill,
-														origin.getY() + halfTile);
-							}
-							else
-							{
-								line = juce::Line<int>(	origin.getX() + m_tileSize - fill,
-														origin.getY() + halfTile,
-														origin.getX() + m_tileSize,
-														origin.getY() + halfTile);
-							}
-
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						}
-					}
-
-					else
-					{
-						// Draw vertically flowing ooze first.
-						fill = static_cast<int>(m_tileSize * crossTile->GetOozeLevel(Cross::WAY_VERTICAL) / MAX_OOZE_LEVEL);
-						if (fill > 0)
-						{
-							if (pipe->GetFlowDirection() == Pipe::DIR_N)
-							{
-								line = juce::Line<int>(	origin.getX() + halfTile,
-														origin.getY() + m_tileSize - fill,
-														origin.getX() + halfTile,
-														origin.getY() + m_tileSize);
-							}
-							else
-							{
-								line = juce::Line<int>(	origin.getX() + halfTile,
-														origin.getY(),
-														origin.getX() + halfTile,
-														origin.getY() + fill);
-							}
-
-							g.drawLine(line.toFloat(), OOZE_THICKNESS);
-						}
-					}
-				}
-				break;
+void MainComponent::DrawTile(const TilePiece* tile, juce::Point<int> origin, juce::Graphics& g)
+{
+	if (tile->GetType() != TilePiece::TYPE_NONE)
+	{
+		const Pipe* pipe = dynamic_cast<const Pipe*>(tile);
+		if (pipe != nullptr)
+		{
+			// Draw tile's Background color
+			g.setColour(GetTileColourForLevel(m_snapshot->difficultyLevel));
+			g.fillRect(origin.getX(), origin.getY(), m_tileSize, m_tileSize);
 
-			default:
-				break;
-			}
+			// The pipe's shape comes from TileGeometry, and is filled in one go.
+			juce::Path pipePath;
+			TileGeometry(m_tileSize, OOZE_THICKNESS).AddPipe(pipePath, tile, origin);
+			g.setColour(juce::Colours::black);
+			g.fillPath(pipePath);
 		}
 	}
 }
 
-void MainComponent::DrawCrossSecondWay(TilePiece* tile, juce::Point<int> origin, juce::Graphics& g)
+void MainComponent::DrawOoze(const TilePiece* tile, juce::Point<int> origin, juce::Graphics& g)
+{
+	juce::Path oozePath;
+	TileGeometry(m_tileSize, OOZE_THICKNESS).AddOoze(oozePath, tile, origin);
+	if (!oozePath.isEmpty())
+	{
+		g.setColour(juce::Colours::limegreen);
+		g.fillPath(oozePath);
+	}
+}
+
+void MainComponent::DrawCrossSecondWay(const TilePiece* tile, juce::Point<int> origin, juce::Graphics& g)
 {
 	if (tile->GetType() == TilePiece::TYPE_CROSS)
 	{
-		Cross* crossTile = dynamic_cast<Cross*>(tile);
+		juce::Path pipePath;
+		juce::Path markingsPath;
+		juce::Path oozePath;
+		TileGeometry(m_tileSize, OOZE_THICKNESS).AddCrossSecondWay(pipePath, markingsPath, oozePath, tile, origin);
 
-		juce::Line<int> line;
-		int halfTile = m_tileSize / 2;
-		float pipeThickness = m_tileSize / 3.5f;
-		int pipeHalfThickness = static_cast<int>(m_tileSize / 6.0f);
+		// Pipe first, then the little lines along it in the tile's colour, and the ooze on top.
 		g.setColour(juce::Colours::black);
-
-		// Draw pipe first
-		if (crossTile->GetBackgroundWay() == Cross::WAY_HORIZONTAL)
-		{
-			// Vertical pipe.
-			line = juce::Line<int>(	origin.getX() + halfTile, 
-									origin.getY(), 
-									origin.getX() + halfTile, 
-									origin.getY() + m_tileSize);
-		}
-		else
-		{
-			// Horizontal pipe. 
-			line = juce::Line<int>(	origin.getX(), 
-									origin.getY() + halfTile, 
-									origin.getX() + m_tileSize,
-									origin.getY() + halfTile);
-		}
-		g.drawLine(line.toFloat(), pipeThickness);
-
-		// Little lines along the pipe, which make the separation between horizontal and vertical 
-		// components of the cross-pipe more visually obvious.
-		float littleLineThickness = (m_tileSize * 5.0f) / 70.0f;
-		g.setColour(GetTileColourForLevel(Controller::GetInstance()->GetDifficultyLevel()));
-		if (crossTile->GetBackgroundWay() == Cross::WAY_HORIZONTAL)
-		{
-			// Vertical little lines
-			line = juce::Line<int>(	static_cast<int>(origin.getX() + halfTile - pipeHalfThickness - 1),
-									origin.getY() + 1,
-									static_cast<int>(origin.getX() + halfTile - pipeHalfThickness - 1),
-									origin.getY() + m_tileSize - 1);
-			g.drawLine(line.toFloat(), littleLineThickness);
-			line = juce::Line<int>( static_cast<int>(origin.getX() + halfTile + pipeHalfThickness + 1),
-									origin.getY() + 1,
-									static_cast<int>(origin.getX() + halfTile + pipeHalfThickness + 1),
-									origin.getY() + m_tileSize - 1);
-			g.drawLine(line.toFloat(), littleLineThickness);
-		}
-		else
-		{
-			// Horizontal little lines
-			line = juce::Line<int>(	origin.getX() + 1,
-									origin.getY() + halfTile - static_cast<int>(pipeHalfThickness) - 1,
-									origin.getX() + m_tileSize - 1,
-									origin.getY() + halfTile - static_cast<int>(pipeHalfThickness) - 1);
-			g.drawLine(line.toFloat(), littleLineThickness);
-			line = juce::Line<int>(	origin.getX() + 1,
-									origin.getY() + halfTile + static_cast<int>(pipeHalfThickness) + 1,
-									origin.getX() + m_tileSize - 1,
-									origin.getY() + halfTile + static_cast<int>(pipeHalfThickness) + 1);
-			g.drawLine(line.toFloat(), littleLineThickness);
-		}
-
-		// Draw ooze
+		g.fillPath(pipePath);
+		g.setColour(GetTileColourForLevel(m_snapshot->difficultyLevel));
+		g.fillPath(markingsPath);
 		g.setColour(juce::Colours::limegreen);
-		int fill;
-
-		// Vertically flowing ooze
-		if (crossTile->GetBackgroundWay() == Cross::WAY_HORIZONTAL)
-		{
-			fill = static_cast<int>(m_tileSize * crossTile->GetOozeLevel(Cross::WAY_VERTICAL) / MAX_OOZE_LEVEL);
-			if (fill > 0)
-			{
-				if (crossTile->GetFlowDirection() == Pipe::DIR_N)
-				{
-					line = juce::Line<int>(	origin.getX() + halfTile,
-											origin.getY() + m_tileSize - fill,
-											origin.getX() + halfTile,
-											origin.getY() + m_tileSize);
-				}
-				else
-				{
-					line = juce::Line<int>(	origin.getX() + halfTile,
-											origin.getY(),
-											origin.getX() + halfTile,
-											origin.getY() + fill);
-				}
-
-				g.drawLine(line.toFloat(), OOZE_THICKNESS);
-			}
-		}
-
-		// Hoizontally flowing ooze
-		else
-		{
-			fill = static_cast<int>(m_tileSize * crossTile->GetOozeLevel(Cross::WAY_HORIZONTAL) / MAX_OOZE_LEVEL);
-			if (fill > 0)
-			{
-				if (crossTile->GetFlowDirection() == Pipe::DIR_E)
-				{
-					line = juce::Line<int>(	origin.getX(),
-											origin.getY() + halfTile,
-											origin.getX() + fill,
-											origin.getY() + halfTile);
-				}
-				else
-				{
-					line = juce::Line<int>(	origin.getX() + m_tileSize - fill,
-											origin.getY() + halfTile,
-											origin.getX() + m_tileSize,
-											origin.getY() + halfTile);
-				}
-
-				g.drawLine(line.toFloat(), OOZE_THICKNESS);
-			}
-		}
+		g.fillPath(oozePath);
 	}
 }
 
-void MainComponent::DrawTileDecoration(TilePiece* tile, juce::Point<int> origin, juce::Graphics& g)
+void MainComponent::DrawTileDecoration(const TilePiece* tile, juce::Point<int> origin, juce::Graphics& g)
 {
+	juce::ignoreUnused(tile);
+
 	// Frame around tile
 	g.setColour(juce::Colours::white);
 	g.drawRect(origin.getX(), origin.getY(), m_tileSize, m_tileSize, 1);
+}
 
-	if (tile->GetType() != TilePiece::TYPE_NONE)
+void MainComponent::DrawExplosion(float progress, juce::Point<int> origin, juce::Graphics& g)
+{
+	// The star shrinks and turns, until it is gone.
+	float exp = EXPLOSION_SIZE * (1.0f - progress);
+	if (exp > 0.0f)
 	{
-		Pipe* pipe = dynamic_cast<Pipe*>(tile);
-		if (pipe != nullptr)
-		{
-			// If this tile has an explosion on it, draw it.
-			int exp = pipe->PopExplosion();
-			if (exp > 0)
-			{
-				juce::Path starPath;
-				int halfTile = m_tileSize / 2;
-				starPath.addStar(juce::Point<float>(static_cast<float>(	origin.getX() + halfTile),
-																		static_cast<float>(origin.getY() + halfTile)),
-																		7,								// Number of peaks
-																		static_cast<float>(exp * 4),	// Inner radius
-																		static_cast<float>(exp * 8),	// Outer radius
-																		static_cast<float>(exp * 2));	// Rotation angle
-				g.setColour(juce::Colours::orangered);
-				g.fillPath(starPath);
-			}
-		}
+		juce::Path starPath;
+		int halfTile = m_view.GetTileSize() / 2;
+		starPath.addStar(juce::Point<float>(static_cast<float>(	origin.getX() + halfTile),
+																static_cast<float>(origin.getY() + halfTile)),
+																7,				// Number of peaks
+																exp * 4.0f,		// Inner radius
+																exp * 8.0f,		// Outer radius
+																exp * 2.0f);	// Rotation angle
+		g.setColour(juce::Colours::orangered);
+		g.fillPath(starPath);
 	}
 }
 
-void MainComponent::DrawSpill(juce::Point<int> origin, juce::Graphics& g)
+void MainComponent::DrawLevelFlash(float progress, juce::Graphics& g)
+{
+	g.setColour(juce::Colours::white.withAlpha(0.5f * (1.0f - progress)));
+	g.fillRect(m_layout.GetLevelNumberRect());
+}
+
+void MainComponent::DrawSpill(float progress, juce::Point<int> origin, juce::Graphics& g)
 {
-	if (Controller::GetInstance()->GetState() == Controller::STATE_STOPPED)
+	if ((m_snapshot->state == Controller::STATE_STOPPED) && (m_snapshot->oozingTileIdx >= 0))
 	{
-		Pipe* oozingPipe = dynamic_cast<Pipe*>(Controller::GetInstance()->GetBoard()->GetOozingTile());
+		const Pipe* oozingPipe = dynamic_cast<const Pipe*>(m_snapshot->oozingTile.get());
 		if (oozingPipe != nullptr)
 		{
-			int halfTile = m_tileSize / 2;
-			int qt(m_tileSize / 4);
-			Pipe::Direction spillDir = oozingPipe->GetFlowDirection();
-			juce::Rectangle<int> bigRec;
-			juce::Rectangle<int> smlRec;
-			switch (spillDir)
-			{
-			case Pipe::DIR_N:
-				bigRec = juce::Rectangle<int>(origin.getX(), origin.getY() - m_tileSize, m_tileSize, m_tileSize);
-				smlRec = juce::Rectangle<int>(origin.getX() + qt, origin.getY() - halfTile, halfTile, halfTile);
-				break;
-			case Pipe::DIR_S:
-				bigRec = juce::Rectangle<int>(origin.getX(), origin.getY() + m_tileSize, m_tileSize, m_tileSize);
-				smlRec = juce::Rectangle<int>(origin.getX() + qt, origin.getY() + m_tileSize, halfTile, halfTile);
-				break;
-			case Pipe::DIR_E:
-				bigRec = juce::Rectangle<int>(origin.getX() + m_tileSize, origin.getY(), m_tileSize, m_tileSize);
-				smlRec = juce::Rectangle<int>(origin.getX() + m_tileSize, origin.getY() + qt, halfTile, halfTile);
-				break;
-			case Pipe::DIR_W:
-				bigRec = juce::Rectangle<int>(origin.getX() - m_tileSize, origin.getY(), m_tileSize, m_tileSize);
-				smlRec = juce::Rectangle<int>(origin.getX() - halfTile, origin.getY() + qt, halfTile, halfTile);
-				break;
-			}
+			int tileSize = m_view.GetTileSize();
+			int halfTile = tileSize / 2;
+			int colStep(0);
+			int rowStep(0);
+			Topology::GetStep(oozingPipe->GetFlowDirection(), colStep, rowStep);
+
+			// A big puddle on the neighboring tile, and a small one three quarters of a tile away from the pipe's middle.
+			juce::Rectangle<int> tileRect(origin.getX(), origin.getY(), tileSize, tileSize);
+			juce::Rectangle<int> bigRec(tileRect.translated(colStep * tileSize, rowStep * tileSize));
+			juce::Rectangle<int> smlRec(tileRect.withSizeKeepingCentre(halfTile, halfTile).translated(colStep * tileSize * 3 / 4, rowStep * tileSize * 3 / 4));
+
+			// The spill spreads out from its middle.
+			bigRec = bigRec.withSizeKeepingCentre(static_cast<int>(bigRec.getWidth() * progress), static_cast<int>(bigRec.getHeight() * progress));
+			smlRec = smlRec.withSizeKeepingCentre(static_cast<int>(smlRec.getWidth() * progress), static_cast<int>(smlRec.getHeight() * progress));
 
 			g.setColour(juce::Colour(0x88008000)); // transparent green
 			g.fillEllipse(bigRec.toFloat());
@@ -1209,37 +1170,80 @@ void MainComponent::DrawSpill(juce::Point<int> origin, juce::Graphics& g)
 	}
 }
 
-void MainComponent::DrawOozeMeter(juce::Point<int> origin, juce::Graphics& g)
+void MainComponent::DrawArrivals(juce::Graphics& g)
+{
+	const RenderSnapshot& snapshot(*m_snapshot);
+	if (snapshot.state != Controller::STATE_RUNNING)
+		return;
+
+	g.saveState();
+	g.reduceClipRegion(m_view.GetArea());
+
+	int tileSize = m_view.GetTileSize();
+	g.setFont(juce::Font("consolas", tileSize * 0.3f, juce::Font::bold));
+
+	// Seconds on a dark badge in the middle of every pipe on the way.
+	for (const std::pair<int, int>& projected : snapshot.projectedPipes)
+	{
+		juce::Rectangle<int> rect(GetArrivalRect(projected.first, false));
+		if (!g.clipRegionIntersects(rect))
+			continue;
+
+		g.setColour(juce::Colours::black.withAlpha(0.6f));
+		g.fillEllipse(rect.toFloat());
+		g.setColour(juce::Colours::limegreen);
+		g.drawText(juce::String(projected.second * SimulationThread::TICK_INTERVAL / 1000.0, 1), rect, juce::Justification::centred, false);
+	}
+
+	// A red ring where the ooze is going to spill, just like DrawSpill() will later.
+	if (snapshot.projectedSpillIdx >= 0)
+	{
+		juce::Rectangle<int> rect(GetArrivalRect(snapshot.projectedSpillIdx, true));
+		if (g.clipRegionIntersects(rect))
+		{
+			g.setColour(juce::Colours::red);
+			g.drawEllipse(rect.toFloat().reduced(2.0f), 3.0f);
+			g.drawText(juce::String(snapshot.projectedSpillTicks * SimulationThread::TICK_INTERVAL / 1000.0, 1), rect, juce::Justification::centred, false);
+		}
+	}
+
+	g.restoreState();
+}
+
+juce::Rectangle<int> MainComponent::GetArrivalRect(int tileIdx, bool spill) const
 {
-	Board* board(Controller::GetInstance()->GetBoard());
+	int col = tileIdx % m_snapshot->numCols;
+	int row = tileIdx / m_snapshot->numCols;
+	juce::Rectangle<int> tileRect(m_view.GetTileRect(col, row));
+	if (!spill)
+		return tileRect.withSizeKeepingCentre(tileRect.getWidth() / 2, tileRect.getHeight() / 2);
+
+	// Half a tile beyond the opening the ooze spills through, where DrawSpill() puts the small puddle.
+	int offset = tileRect.getWidth() * 3 / 4;
+	int colStep(0);
+	int rowStep(0);
+	Topology::GetStep(m_snapshot->projectedSpillDir, colStep, rowStep);
+	tileRect = tileRect.translated(colStep * offset, rowStep * offset);
+
+	return tileRect.withSizeKeepingCentre(tileRect.getWidth() * 3 / 4, tileRect.getHeight() * 3 / 4);
+}
 
+void MainComponent::DrawOozeMeter(juce::Point<int> origin, juce::Graphics& g)
+{
 	// Draw empty vial (background)
 	//static constexpr int vialHeight = 118;
-	int vialHeight = static_cast<int>(getLocalBounds().getHeight() / 5.2542f);
+	int vialHeight = m_layout.GetOozeMeterRect().getHeight();
 	juce::Rectangle<int> vialRect(origin.getX(), origin.getY(), 22, vialHeight);
 	g.setColour(juce::Colours::black);
 	g.fillRect(vialRect);
 
-	// Ooze inside the vial.
+	// Ooze inside the vial. Full yellow vial once the score is high enough.
 	g.setColour(juce::Colours::limegreen);
-	int oozeMaxHeight = vialHeight - 6;
-	int oozeHeight;
-	if (m_countDown > 0)
-	{
-		// Starts at 0, goes to vialHeight		
-		oozeHeight = static_cast<int>(oozeMaxHeight - ((m_countDown * oozeMaxHeight) / Controller::GetInstance()->GetCurrentCountdown()));
-	}
-	else if (board->GetScoreValue() < Controller::MIN_SCORE_TO_ADVANCE)
-	{
-		// Starts at vialHeight, goes to 0.
-		oozeHeight = static_cast<int>(((Controller::MIN_SCORE_TO_ADVANCE - (board->GetScoreValue())) * oozeMaxHeight) / Controller::MIN_SCORE_TO_ADVANCE);
-	}
-	else
-	{
-		// Full yellow vial.
+	if ((m_interpolator->GetCountdown() <= 0.0f) && (m_snapshot->score >= Controller::MIN_SCORE_TO_ADVANCE))
 		g.setColour(juce::Colours::yellow);
-		oozeHeight = oozeMaxHeight;
-	}
+
+	int oozeMaxHeight = vialHeight - 6;
+	int oozeHeight = GetOozeMeterLevel();
 	g.fillRect(juce::Rectangle<int>(origin.getX() + 3, origin.getY() + 3 + oozeMaxHeight - oozeHeight, 16, oozeHeight));
 
 	// Vial outline and markings.
@@ -1254,36 +1258,51 @@ void MainComponent::DrawOozeMeter(juce::Point<int> origin, juce::Graphics& g)
 	g.drawRect(vialRect);
 }
 
-void MainComponent::DrawBombs(juce::Point<int> p, juce::Graphics& g)
+int MainComponent::GetOozeMeterLevel() const
 {
-	Board* board(Controller::GetInstance()->GetBoard());
-	int halfTile = m_tileSize / 2;
+	int oozeMaxHeight = m_layout.GetOozeMeterRect().getHeight() - 6;
+	float countdown = m_interpolator->GetCountdown();
+	if (countdown > 0.0f)
+	{
+		// Starts at 0, goes to vialHeight		
+		return static_cast<int>(oozeMaxHeight - ((countdown * oozeMaxHeight) / m_snapshot->roundCountdown));
+	}
+	else if (m_snapshot->score < Controller::MIN_SCORE_TO_ADVANCE)
+	{
+		// Starts at vialHeight, goes to 0.
+		return static_cast<int>(((Controller::MIN_SCORE_TO_ADVANCE - (m_snapshot->score)) * oozeMaxHeight) / Controller::MIN_SCORE_TO_ADVANCE);
+	}
+
+	return oozeMaxHeight;
+}
 
+void MainComponent::DrawBombs(juce::Graphics& g)
+{
 	for (int i = 0; i < Board::MAX_NUM_BOMBS; i++)
 	{
 		// Draw the bombs that are still available
-		if (i < board->GetNumBombs())
+		if (i < m_snapshot->numBombs)
 		{
 			g.setColour(juce::Colours::red);
-			g.fillEllipse(juce::Rectangle<int>(p.getX() + i * (m_tileSize - 1), p.getY(), halfTile, halfTile).toFloat());
+			g.fillEllipse(m_layout.GetBombRect(i).toFloat());
 		}
 
 		// Draw the one used up bomb, which will soon become available again.
-		else if (i == board->GetNumBombs())
+		else if (i == m_snapshot->numBombs)
 		{
-			g.setColour(juce::Colour(static_cast<juce::uint8>(67 + board->GetPercentUntilFreeBomb()), 67, 67));
-			g.fillEllipse(juce::Rectangle<int>(p.getX() + i * (m_tileSize - 1), p.getY(), halfTile, halfTile).toFloat());
+			g.setColour(juce::Colour(static_cast<juce::uint8>(67 + m_snapshot->percentUntilFreeBomb), 67, 67));
+			g.fillEllipse(m_layout.GetBombRect(i).toFloat());
 		}
 
 		g.setColour(juce::Colours::white);
-		g.drawEllipse(juce::Rectangle<int>(p.getX() + i * (m_tileSize - 1), p.getY(), halfTile, halfTile).toFloat(), 1.0f);
+		g.drawEllipse(m_layout.GetBombRect(i).toFloat(), 1.0f);
 	}
 }
 
 void MainComponent::DrawFastForwardButton(juce::Graphics& g)
 {
 	float radius = 13;
-	juce::Point<float> origin(m_fastForwardButtonRect.getX() + 24.0f, m_fastForwardButtonRect.getY() + 23.0f);
+	juce::Point<float> origin(m_layout.GetFastForwardRect().getX() + 24.0f, m_layout.GetFastForwardRect().getY() + 23.0f);
 
 	juce::Path ffwdPath;
 	ffwdPath.addPolygon(juce::Point<float>(static_cast<float>(origin.getX()), static_cast<float>(origin.getY())), 3, radius, -0.52f);
@@ -1292,13 +1311,20 @@ void MainComponent::DrawFastForwardButton(juce::Graphics& g)
 	float thickness = 1.5f;
 	juce::Colour iconColour(juce::Colours::grey);
 	juce::Colour frameColour(juce::Colour(27, 27, 27));
-	if (Controller::GetInstance()->GetFastForward())
+	if (m_snapshot->fastForward)
 	{
 		thickness = 2.5f;
 		iconColour = juce::Colours::red;
 		frameColour = juce::Colours::black;
 	}
 
+	// Once the round is decided, a bar behind the triangles turns the button into skip-to-results.
+	if (m_snapshot->spillInevitable)
+	{
+		ffwdPath.addRectangle(origin.getX() + 30.0f, origin.getY() - radius * 0.5f, 3.0f, radius);
+		iconColour = juce::Colours::yellow;
+	}
+
 	// Draw ff icon (two little triangles)
 	g.setColour(iconColour);
 	g.fillPath(ffwdPath);
@@ -1307,5 +1333,5 @@ void MainComponent::DrawFastForwardButton(juce::Graphics& g)
 
 	// Frame around button
 	g.setColour(frameColour);
-	g.drawRect(m_fastForwardButtonRect.toFloat(), thickness);
+	g.drawRect(m_layout.GetFastForwardRect().toFloat(), thickness);
 }
@@ -31,12 +31,24 @@ SOFTWARE.
 #pragma once
 
 #include <JuceHeader.h>
+#include "Controller.h"
+#include "BoardLayout.h"
+#include "BoardView.h"
+#include "TextCache.h"
+#include "Animator.h"
 
 
 // ---- Forward declarations ----
 
 class TilePiece;
 class ScoreWindow;
+class AutoPlayer;
+class SimulationThread;
+class SpriteCache;
+class LayerCompositor;
+class FrameInterpolator;
+class ParticleSystem;
+struct RenderSnapshot;
 
 
 // ---- Class Definition ----
@@ -46,6 +58,8 @@ class ScoreWindow;
  */
 class MainComponent  :	public juce::Component,
 						public juce::Timer,
+						public juce::HighResolutionTimer,
+						public juce::AsyncUpdater,
 						public juce::ChangeListener
 {
 public:
@@ -59,6 +73,44 @@ public:
 	 */
 	static const int GUI_REFRESH_RATE;
 
+	/**
+	 * Rate at which frames are drawn, in Hz. Faster than the game clock: the ooze is
+	 * interpolated in between ticks, see FrameInterpolator. 
+	 * Frames are timed by a juce::HighResolutionTimer, see hiResTimerCallback().
+	 */
+	static const int FRAME_RATE;
+
+	/**
+	 * Time during which an ooze spill is shown, before the score window covers up the board, in milliseconds.
+	 */
+	static const int SPILL_DISPLAY_TIME;
+
+	/**
+	 * Duration of the explosion on a pipe replaced with a bomb, in milliseconds.
+	 */
+	static const int EXPLOSION_DURATION;
+
+	/**
+	 * Time for an ooze spill to spread to its full size, in milliseconds.
+	 */
+	static const int SPILL_GROW_TIME;
+
+	/**
+	 * Duration of the flash on the level number, after leveling up, in milliseconds.
+	 */
+	static const int LEVEL_FLASH_DURATION;
+
+	/**
+	 * Time without any player interaction on the score window, in milliseconds, 
+	 * after which the attract mode starts.
+	 */
+	static const int ATTRACT_IDLE_TIMEOUT;
+
+	/**
+	 * Average time between two clicks of the AutoPlayer during the attract mode, in milliseconds.
+	 */
+	static const int BOT_CLICK_INTERVAL;
+
 	/**
 	 * Class constructor.
 	 */
@@ -90,10 +142,36 @@ public:
 	void mouseDown(const juce::MouseEvent& event) override;
 
 	/**
-	 * Reimplemented from juce::Timer.
+	 * Reimplemented from juce::Component. Dragging with the right or middle mouse button pans the board.
+	 */
+	void mouseDrag(const juce::MouseEvent& event) override;
+
+	/**
+	 * Reimplemented from juce::Component. The mouse wheel zooms the board in and out.
+	 */
+	void mouseWheelMove(const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel) override;
+
+	/**
+	 * Reimplemented from juce::Component. Pinching zooms the board in and out.
+	 */
+	void mouseMagnify(const juce::MouseEvent& event, float scaleFactor) override;
+
+	/**
+	 * Reimplemented from juce::Timer. Follows the game at every GUI refresh.
 	 */
 	void timerCallback() override;
 
+	/**
+	 * Reimplemented from juce::HighResolutionTimer. Called on the timer's own thread 
+	 * at FRAME_RATE, it hands each frame over to the message thread.
+	 */
+	void hiResTimerCallback() override;
+
+	/**
+	 * Reimplemented from juce::AsyncUpdater. Draws the frame requested by hiResTimerCallback().
+	 */
+	void handleAsyncUpdate() override;
+
 	/**
 	 * Reimplemented from juce::ChangeListener.
 	 */
@@ -115,11 +193,12 @@ public:
 	{
 		LABEL_SCORE = 0,
 		LABEL_BSCORE,
-		LABEL_VERSION
+		LABEL_VERSION,
+		LABEL_MAX
 	};
 
 	/**
-	 * Get the font to be used for the given label.
+	 * Get the font to be used for the given label, at the current window size.
 	 */
 	juce::Font GetFont(LabelID labelID) const;
 
@@ -138,7 +217,7 @@ public:
 	 *					of the tile being drawn will be located.
 	 * @param g			The graphics context used for drawing.
 	 */
-	void DrawTile(TilePiece* tile, juce::Point<int> origin, juce::Graphics& g);
+	void DrawTile(const TilePiece* tile, juce::Point<int> origin, juce::Graphics& g);
 
 	/**
 	 * Draw the ooze flowing through a pipe tile.
@@ -148,7 +227,7 @@ public:
 	 *					of the tile being drawn will be located.
 	 * @param g			The graphics context used for drawing.
 	 */
-	void DrawOoze(TilePiece* tile, juce::Point<int> origin, juce::Graphics& g);
+	void DrawOoze(const TilePiece* tile, juce::Point<int> origin, juce::Graphics& g);
 
 	/**
 	 * The DrawTile() and DrawOoze() methods only worry about the first of the "ways" of TYPE_CROSS pipes, 
@@ -160,26 +239,62 @@ public:
 	 *					of the tile being drawn will be located.
 	 * @param g			The graphics context used for drawing.
 	 */
-	void DrawCrossSecondWay(TilePiece* tile, juce::Point<int> origin, juce::Graphics& g);
+	void DrawCrossSecondWay(const TilePiece* tile, juce::Point<int> origin, juce::Graphics& g);
 
 	/**
-	 * Draw a tile piece's decoration elements, such as frame and explosion graphics.
+	 * Draw a tile piece's decoration elements, such as its frame.
 	 *
 	 * @param tile		The tile piece to draw the decorations for.
 	 * @param origin	The point on the MainComponent window where the top-left corner
 	 *					of the tile being drawn will be located.
 	 * @param g			The graphics context used for drawing.
 	 */
-	void DrawTileDecoration(TilePiece* tile, juce::Point<int> origin, juce::Graphics& g);
+	void DrawTileDecoration(const TilePiece* tile, juce::Point<int> origin, juce::Graphics& g);
+
+	/**
+	 * Draw the explosion on a tile piece. Explosions are not part of the tile sprites, 
+	 * and have to be drawn over them.
+	 *
+	 * @param progress	How far the explosion has gone, from 0 (biggest) to 1 (gone).
+	 * @param origin	The point on the MainComponent window where the top-left corner
+	 *					of the tile being drawn will be located.
+	 * @param g			The graphics context used for drawing.
+	 */
+	void DrawExplosion(float progress, juce::Point<int> origin, juce::Graphics& g);
 
 	/**
 	 * Draw ooze spill next to the last pipe on the pipeline.
 	 *
+	 * @param progress	How far the spill has spread, from 0 (nothing) to 1 (full size).
 	 * @param origin	The point on the MainComponent window where the top-left corner
 	 *					of the tile which caused the spill.
 	 * @param g			The graphics context used for drawing.
 	 */
-	void DrawSpill(juce::Point<int> origin, juce::Graphics& g);
+	void DrawSpill(float progress, juce::Point<int> origin, juce::Graphics& g);
+
+	/**
+	 * Draw the number of seconds until the ooze arrives on each pipe it is going to flow through next,
+	 * and mark the spot where it is going to spill, with the seconds until then. See RenderSnapshot::projectedPipes.
+	 *
+	 * @param g			The graphics context used for drawing.
+	 */
+	void DrawArrivals(juce::Graphics& g);
+
+	/**
+	 * Get the area of the window covered by the arrival time on the given pipe, or by the projected spill next to it.
+	 *
+	 * @param tileIdx	Position of the pipe on the board, i.e. col + (row * numCols).
+	 * @param spill		True for the projected spill.
+	 */
+	juce::Rectangle<int> GetArrivalRect(int tileIdx, bool spill) const;
+
+	/**
+	 * Draw a flash over the level number.
+	 *
+	 * @param progress	How far the flash has faded, from 0 (brightest) to 1 (gone).
+	 * @param g			The graphics context used for drawing.
+	 */
+	void DrawLevelFlash(float progress, juce::Graphics& g);
 
 	/**
 	 * Draw the "ooze meter", i.e. the vial that indicates the countdown until ooze starts pumping out.
@@ -189,42 +304,395 @@ public:
 	 */
 	void DrawOozeMeter(juce::Point<int> origin, juce::Graphics& g);
 
+	/**
+	 * Get the height of the ooze inside the ooze meter, following the interpolated countdown, and then the score.
+	 *
+	 * @return	The height in pixels, from 0 to the full height of the vial's inside.
+	 */
+	int GetOozeMeterLevel() const;
+
 	/**
 	 * Draw the bombs next to the board, used to replace pipe tiles.
+	 * The location comes from the layout, see BoardLayout::GetBombRect().
 	 *
-	 * @param origin	The point on the MainComponent window to use as origin.
 	 * @param g			The graphics context used for drawing.
 	 */
-	void DrawBombs(juce::Point<int> origin, juce::Graphics& g);
+	void DrawBombs(juce::Graphics& g);
 
 	/**
 	 * Draw the fast-forward button. 
-	 * The location is hard coded, see m_fastForwardButtonRect.
+	 * The location comes from the layout, see BoardLayout::GetFastForwardRect().
 	 *
 	 * @param g			The graphics context used for drawing.
 	 */
 	void DrawFastForwardButton(juce::Graphics& g);
 
+	/**
+	 * Start the attract mode: a fresh game is started, which is played by an AutoPlayer
+	 * until someone clicks on the window.
+	 */
+	void StartAttractMode();
+
+	/**
+	 * Stop the attract mode, and start a fresh game for the player.
+	 */
+	void StopAttractMode();
+
+	/**
+	 * Switch to puzzle mode, and start the first puzzle. See Controller::StartPuzzleMode().
+	 * If there are no puzzles available, the current game carries on.
+	 *
+	 * @param file	Puzzle file to play. If it doesn't exist, the puzzle file opened at startup is used.
+	 */
+	void StartPuzzleMode(const juce::File& file);
+
+	/**
+	 * Replace the settings of all difficulty levels with those in a level file, and start a new game.
+	 * See Controller::LoadLevelConfig().
+	 *
+	 * @param file	Level file to load.
+	 */
+	void LoadLevelConfig(const juce::File& file);
+
+	/**
+	 * Resize the board, and start a new game on it. See Controller::SetBoardSize().
+	 *
+	 * @param numCols	Number of columns on the board.
+	 * @param numRows	Number of rows on the board.
+	 * @param endless	If true, play on an endless board instead.
+	 */
+	void SetBoardSize(int numCols, int numRows, bool endless = false);
+
+	/**
+	 * Change one of the rules of regular rounds, and start a new game. See Controller::SetRule().
+	 *
+	 * @param rule	The rule to change.
+	 * @param value	New value of the rule.
+	 */
+	void SetRule(Controller::Rule rule, int value);
+
+	/**
+	 * Show or hide the arrival times of the ooze on the pipes ahead of it, and where it is going to spill.
+	 * See DrawArrivals().
+	 *
+	 * @param show	True to show the overlay.
+	 */
+	void SetShowArrivals(bool show);
+
 
 private:
 	/**
-	 * Width & height of a tile piece, in pixels.
+	 * React to a click on the game window. This is used by mouseDown(), and by the 
+	 * AutoPlayer during the attract mode, so that both place pipes the exact same way.
+	 * Only the tiles within the view can be clicked on.
+	 * The click is handed over to the SimulationThread, which carries it out at its next chance.
+	 *
+	 * @param clickPos	The clicked point on the MainComponent window.
+	 */
+	void HandleClick(juce::Point<int> clickPos);
+
+	/**
+	 * Compare the current snapshot against what was drawn last, and only repaint the parts of the 
+	 * window which changed: tiles whose ooze or pipe changed, running animations, the queue, the ooze meter, 
+	 * the bombs, the score and the fast-forward button. Changes which affect the whole window, 
+	 * like a new round or a new difficulty level, repaint it all.
+	 */
+	void RepaintChanges();
+
+	/**
+	 * Fit the view to the layout and to the board of the current snapshot. 
+	 * At the start of each round, the view moves to the ooze source.
+	 */
+	void UpdateView();
+
+	/**
+	 * Called whenever the view was panned or zoomed. The board and effects are redrawn with the next frame.
+	 */
+	void ViewChanged();
+
+	/**
+	 * Ask the SimulationThread for the tiles around the visible cells, once the tiles in the snapshots 
+	 * no longer cover them, or cover many more. See SimulationThread::SetRegion().
+	 */
+	void UpdateRegion();
+
+	/**
+	 * Draw the visible tiles as flat colours, when they are too small to make out their pipes.
+	 *
+	 * @param cells		Columns and rows to draw.
+	 * @param g			The graphics context used for drawing.
+	 */
+	void DrawBoardOverview(juce::Rectangle<int> cells, juce::Graphics& g);
+
+	/**
+	 * Called at every frame. Moves the ooze on towards the latest snapshot, and repaints 
+	 * whatever changed. Frames in which nothing changed are skipped.
+	 */
+	void RenderFrame();
+
+	/**
+	 * Start animations for whatever happened in a fresh snapshot: explosions, a spill, or a new level.
+	 *
+	 * @param now	Current time, in milliseconds, see juce::Time::getMillisecondCounterHiRes().
+	 */
+	void StartAnimations(double now);
+
+	/**
+	 * Get the area of the window covered by an animation, in any of its frames.
+	 */
+	juce::Rectangle<int> GetAnimationRect(const Animator::Animation& animation) const;
+
+	/**
+	 * Let ooze drip from a spill, if any, and move all particles on. 
+	 *
+	 * @param seconds	Time since the last frame, in seconds.
+	 * @return	True if there were any particles to draw.
+	 */
+	bool UpdateParticles(float seconds);
+
+	/**
+	 * Get the middle of the ooze spill next to the given tile, where the ooze flows to.
+	 *
+	 * @param tileIdx	Position of the tile which caused the spill, i.e. col + (row * numCols). See RenderSnapshot::oozingTileIdx.
+	 * @return	The point on the MainComponent window.
+	 */
+	juce::Point<float> GetSpillCentre(int tileIdx) const;
+
+	/**
+	 * Layers of the window, from bottom to top. See m_compositor.
+	 */
+	enum Layer
+	{
+		LAYER_BACKGROUND = 0,
+		LAYER_BOARD,
+		LAYER_HUD,
+		LAYER_EFFECTS,
+		LAYER_MAX
+	};
+
+	/**
+	 * Mark part of a layer for rasterising, and the same part of the window for repainting.
+	 *
+	 * @param layer	The layer which changed.
+	 * @param area	The changed area, relative to the MainComponent window.
+	 */
+	void Invalidate(Layer layer, juce::Rectangle<int> area);
+
+	/**
+	 * Rasterise the invalid parts of all layers, on the compositor's worker threads.
+	 */
+	void RenderLayers();
+
+	/**
+	 * Scale the font of the given label according to the window size.
+	 * Used by resized(), to fill m_fonts.
+	 */
+	juce::Font CreateFont(LabelID labelID) const;
+
+	/**
+	 * Lay out the static labels anew, i.e. m_levelLabelText, m_scoreLabelText etc.
+	 * Used by resized(), after m_layout and m_fonts are up to date.
+	 */
+	void LayoutLabels();
+
+	/**
+	 * Painters of each layer. They may run at the same time on different threads, 
+	 * and must only read the current snapshot and the window's layout.
+	 *
+	 * @param g		The graphics context of the layer's image, clipped to the invalid part of the layer.
+	 */
+	void PaintBackground(juce::Graphics& g);
+	void PaintBoard(juce::Graphics& g);
+	void PaintHud(juce::Graphics& g);
+	void PaintEffects(juce::Graphics& g);
+
+	/**
+	 * Start a new round, and restart the ooze countdown.
+	 *
+	 * @param cmd	See Controller::Reset().
+	 */
+	void StartRound(Controller::Command cmd);
+
+	/**
+	 * Called at every tick during the attract mode. Asks the AutoPlayer for its next move
+	 * ahead of time, and performs its clicks at a human-like pace.
+	 */
+	void UpdateAutoPlayer();
+
+	/**
+	 * Positions and sizes of everything on the window, updated by resized().
+	 */
+	BoardLayout m_layout;
+
+	/**
+	 * Width & height of a tile piece, in pixels. Same as m_layout.GetTileSize().
+	 * Tiles on the board are drawn at the view's tile size instead.
 	 */
 	int m_tileSize = 0;
 
+	/**
+	 * Part of the board on display, panned and zoomed by the player.
+	 */
+	BoardView m_view;
+
+	/**
+	 * Round at which the view was last moved to the ooze source.
+	 */
+	int m_viewRound = -1;
+
+	/**
+	 * Cells of the board last requested from the SimulationThread, see UpdateRegion().
+	 */
+	juce::Rectangle<int> m_requestedRegion;
+
+	/**
+	 * Distance dragged so far while panning, see mouseDrag().
+	 */
+	juce::Point<int> m_dragOffset;
+
+	/**
+	 * Fonts of each label, scaled to the window size by resized().
+	 */
+	juce::Font m_fonts[LABEL_MAX];
+
+	/**
+	 * Labels which never change while the window keeps its size, laid out by resized().
+	 */
+	juce::GlyphArrangement m_levelLabelText;
+	juce::GlyphArrangement m_puzzleLabelText;
+	juce::GlyphArrangement m_scoreLabelText;
+	juce::GlyphArrangement m_versionText;
+	juce::GlyphArrangement m_demoText;
+
+	/**
+	 * Pre-rendered digits of the score, the highlighted score, and the level number.
+	 */
+	DigitAtlas m_scoreDigits;
+	DigitAtlas m_highlightedScoreDigits;
+	DigitAtlas m_levelDigits;
+
 	/**
 	 * Subcomponent for displaying the player's score after each round.
 	 */
 	std::unique_ptr<ScoreWindow> m_scoreWindow;
 
 	/**
-	 * Number of timerCallback ticks until Ooze starts pumping out.
+	 * Thread which runs the game itself.
 	 */
-	int m_countDown;
+	std::unique_ptr<SimulationThread> m_simulation;
 
-	int m_blockInteraction;
+	/**
+	 * Latest snapshot of the game, picked up from m_simulation. Only used on the message thread.
+	 */
+	const RenderSnapshot* m_snapshot = nullptr;
 
-	juce::CriticalSection m_lock;
+	/**
+	 * True if a fresh snapshot was picked up, or the view moved, since the last frame was drawn.
+	 */
+	bool m_frameDue = false;
+
+	/**
+	 * Ooze levels and countdown, smoothed out in between snapshots. Tiles on the board are drawn from here.
+	 */
+	std::unique_ptr<FrameInterpolator> m_interpolator;
+
+	/**
+	 * True if the arrival times of the ooze are drawn on the effects layer, see SetShowArrivals().
+	 */
+	bool m_showArrivals = false;
+
+	/**
+	 * Explosions, spills and flashes. Moved on by RenderFrame(), and only read by the painters.
+	 */
+	Animator m_animator;
+
+	/**
+	 * Splashes, drips and debris, drawn on the effects layer. 
+	 */
+	std::unique_ptr<ParticleSystem> m_particles;
+
+	/**
+	 * Time of the last frame, in milliseconds, and the fraction of a drip carried over to the next frame.
+	 */
+	double m_lastFrameTime = 0.0;
+	float m_drips = 0.0f;
+
+	/**
+	 * What StartAnimations() saw in the previous snapshot: explosions on each tile of its region, the game state, 
+	 * the round, and the level (or puzzle) number.
+	 */
+	std::vector<int> m_animatedExplosions;
+	juce::Rectangle<int> m_animatedRegion;
+	Controller::GameState m_animatedState = Controller::STATE_STOPPED;
+	int m_animatedRound = -1;
+	int m_animatedLevel = 0;
+
+	/**
+	 * What was on display after the last repaint, used by RepaintChanges().
+	 */
+	struct DrawnState
+	{
+		/**
+		 * False if the whole window needs repainting anyway, e.g. after a resize.
+		 */
+		bool valid = false;
+
+		/**
+		 * Sprite keys (see SpriteCache::GetKey()) of the tiles in the snapshot and in the queue.
+		 */
+		std::vector<juce::uint32> tileKeys;
+		std::vector<juce::uint32> queueKeys;
+
+		/**
+		 * Position of the board on the window, and cells of the board in the snapshot.
+		 */
+		juce::Rectangle<int> boardBounds;
+		juce::Rectangle<int> region;
+
+		int roundNumber = 0;
+		int difficultyLevel = 0;
+		bool demo = false;
+		int oozeMeterLevel = 0;
+		int score = 0;
+		int scoreToAdvance = 0;
+		bool puzzleMode = false;
+		int puzzleNumber = 0;
+		int numBombs = 0;
+		int percentUntilFreeBomb = 0;
+		bool fastForward = false;
+		bool spillInevitable = false;
+
+		/**
+		 * Arrival times of the ooze, if shown. See RenderSnapshot::projectedPipes.
+		 */
+		std::vector<std::pair<int, int>> projectedPipes;
+		int projectedSpillIdx = -1;
+		int projectedSpillTicks = 0;
+	};
+	DrawnState m_drawnState;
+
+	/**
+	 * Number of the last round seen ending, and the time when it was seen, in milliseconds. 
+	 */
+	int m_stoppedRound = -1;
+	juce::uint32 m_stoppedTime = 0;
+
+	/**
+	 * Number of the last round whose ending was dealt with, by showing the score window or starting a new round.
+	 */
+	int m_handledRound = -1;
+
+	/**
+	 * Pre-rendered images of the tiles, drawn with DrawTile(), DrawOoze(), DrawCrossSecondWay() and DrawTileDecoration().
+	 * The queue's tiles have the layout's tile size, the board's have the view's.
+	 */
+	std::unique_ptr<SpriteCache> m_spriteCache;
+	std::unique_ptr<SpriteCache> m_boardSprites;
+
+	/**
+	 * Retained layers of the window: background and labels, board tiles, HUD, and effects such as explosions and spills.
+	 */
+	std::unique_ptr<LayerCompositor> m_compositor;
 
 	/**
 	 * Hyperlink to the download URL.
@@ -232,9 +700,24 @@ private:
 	std::unique_ptr<juce::HyperlinkButton> m_hyperlink;
 
 	/**
-	 * Rectangle containing the fast-forward button.
+	 * Bot which plays the game during the attract mode. Null while a human is playing.
+	 */
+	std::unique_ptr<AutoPlayer> m_autoPlayer;
+
+	/**
+	 * Number of timerCallback ticks during which the score window has been left untouched.
+	 */
+	int m_idleTicks = 0;
+
+	/**
+	 * Mouse position at the previous timerCallback tick, used to detect activity on the score window.
+	 */
+	juce::Point<int> m_lastMousePos;
+
+	/**
+	 * Number of timerCallback ticks until the AutoPlayer's next click.
 	 */
-	juce::Rectangle<int> m_fastForwardButtonRect;
+	int m_ticksUntilBotClick = 0;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
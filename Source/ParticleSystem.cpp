@@ -0,0 +1,260 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "ParticleSystem.h"
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define PARTICLE_KERNEL_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#include <emmintrin.h>
+	#define PARTICLE_KERNEL_SSE2 1
+#endif
+
+
+// ---- Helper types and constants ----
+
+/**
+ * Number of particles moved at once by the kernel in Update().
+ */
+#if defined(PARTICLE_KERNEL_AVX2)
+static const int SIMD_WIDTH(8);
+#elif defined(PARTICLE_KERNEL_SSE2)
+static const int SIMD_WIDTH(4);
+#else
+static const int SIMD_WIDTH(1);
+#endif
+
+const int ParticleSystem::FADE_STEPS(4);
+
+/**
+ * Look and motion of each kind of particle. Speeds, gravity and sizes are in tiles (per second, per second squared).
+ */
+struct KindSettings
+{
+	juce::uint32 colour;
+	float speed;
+	float lift;
+	float gravity;
+	float minLife;
+	float maxLife;
+	float minSize;
+	float maxSize;
+};
+
+static const KindSettings KINDS[ParticleSystem::KIND_MAX] =
+{
+	//	colour			speed	lift	gravity	minLife	maxLife	minSize	maxSize
+	{	0xff32cd32,		2.5f,	1.5f,	8.0f,	0.4f,	0.9f,	0.04f,	0.08f	},	// KIND_SPLASH: limegreen
+	{	0xff008000,		0.2f,	0.0f,	3.0f,	0.8f,	1.6f,	0.03f,	0.06f	},	// KIND_DRIP: dark green
+	{	0xffff4500,		4.0f,	2.0f,	10.0f,	0.3f,	0.7f,	0.03f,	0.07f	},	// KIND_DEBRIS: orangered
+};
+
+
+// ---- Class Implementation ----
+
+ParticleSystem::ParticleSystem(int capacity)
+	: m_capacity(capacity)
+{
+	// All buffers are allocated here, once and for all.
+	int paddedSize = ((capacity + SIMD_WIDTH - 1) / SIMD_WIDTH) * SIMD_WIDTH;
+	m_x.resize(paddedSize, 0.0f);
+	m_y.resize(paddedSize, 0.0f);
+	m_velocityX.resize(paddedSize, 0.0f);
+	m_velocityY.resize(paddedSize, 0.0f);
+	m_gravity.resize(paddedSize, 0.0f);
+	m_life.resize(paddedSize, 0.0f);
+	m_fade.resize(paddedSize, 0.0f);
+	m_size.resize(paddedSize, 0.0f);
+	m_kinds.resize(paddedSize, 0);
+
+	m_batches.resize(KIND_MAX * FADE_STEPS);
+	for (juce::RectangleList<float>& batch : m_batches)
+		batch.ensureStorageAllocated(capacity);
+}
+
+ParticleSystem::~ParticleSystem()
+{
+
+}
+
+const char* ParticleSystem::GetKernelName()
+{
+#if defined(PARTICLE_KERNEL_AVX2)
+	return "AVX2";
+#elif defined(PARTICLE_KERNEL_SSE2)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
+
+void ParticleSystem::Emit(Kind kind, juce::Point<float> origin, int count, float tileSize)
+{
+	const KindSettings& settings(KINDS[kind]);
+
+	for (int n = 0; (n < count) && (m_numParticles < m_capacity); n++)
+	{
+		int i = m_numParticles++;
+
+		float angle = m_random.nextFloat() * juce::MathConstants<float>::twoPi;
+		float speed = (0.3f + (0.7f * m_random.nextFloat())) * settings.speed * tileSize;
+		float life = settings.minLife + ((settings.maxLife - settings.minLife) * m_random.nextFloat());
+
+		m_x[i] = origin.getX();
+		m_y[i] = origin.getY();
+		m_velocityX[i] = std::cos(angle) * speed;
+		m_velocityY[i] = (std::sin(angle) * speed) - (settings.lift * tileSize);
+		m_gravity[i] = settings.gravity * tileSize;
+		m_life[i] = life;
+		m_fade[i] = 1.0f / life;
+		m_size[i] = (settings.minSize + ((settings.maxSize - settings.minSize) * m_random.nextFloat())) * tileSize;
+		m_kinds[i] = kind;
+	}
+}
+
+void ParticleSystem::Clear()
+{
+	m_numParticles = 0;
+	for (juce::RectangleList<float>& batch : m_batches)
+		batch.clear();
+
+	m_bounds = juce::Rectangle<int>();
+}
+
+void ParticleSystem::Update(float seconds)
+{
+	int paddedSize = ((m_numParticles + SIMD_WIDTH - 1) / SIMD_WIDTH) * SIMD_WIDTH;
+	float* x = m_x.data();
+	float* y = m_y.data();
+	const float* velocityX = m_velocityX.data();
+	float* velocityY = m_velocityY.data();
+	const float* gravity = m_gravity.data();
+	float* life = m_life.data();
+
+	// Move all particles. Lanes past the last particle are moved too, but never looked at.
+	for (int i = 0; i < paddedSize; i += SIMD_WIDTH)
+	{
+#if defined(PARTICLE_KERNEL_AVX2)
+		__m256 dt = _mm256_set1_ps(seconds);
+		__m256 vy = _mm256_add_ps(_mm256_loadu_ps(velocityY + i), _mm256_mul_ps(_mm256_loadu_ps(gravity + i), dt));
+		_mm256_storeu_ps(velocityY + i, vy);
+		_mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(_mm256_loadu_ps(velocityX + i), dt)));
+		_mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(vy, dt)));
+		_mm256_storeu_ps(life + i, _mm256_sub_ps(_mm256_loadu_ps(life + i), dt));
+#elif defined(PARTICLE_KERNEL_SSE2)
+		__m128 dt = _mm_set1_ps(seconds);
+		__m128 vy = _mm_add_ps(_mm_loadu_ps(velocityY + i), _mm_mul_ps(_mm_loadu_ps(gravity + i), dt));
+		_mm_storeu_ps(velocityY + i, vy);
+		_mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(velocityX + i), dt)));
+		_mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(vy, dt)));
+		_mm_storeu_ps(life + i, _mm_sub_ps(_mm_loadu_ps(life + i), dt));
+#else
+		velocityY[i] += gravity[i] * seconds;
+		x[i] += velocityX[i] * seconds;
+		y[i] += velocityY[i] * seconds;
+		life[i] -= seconds;
+#endif
+	}
+
+	// Remove the particles whose time is up, by moving the last particle into their place.
+	int i = 0;
+	while (i < m_numParticles)
+	{
+		if (m_life[i] > 0.0f)
+		{
+			i++;
+			continue;
+		}
+
+		int last = --m_numParticles;
+		m_x[i] = m_x[last];
+		m_y[i] = m_y[last];
+		m_velocityX[i] = m_velocityX[last];
+		m_velocityY[i] = m_velocityY[last];
+		m_gravity[i] = m_gravity[last];
+		m_life[i] = m_life[last];
+		m_fade[i] = m_fade[last];
+		m_size[i] = m_size[last];
+		m_kinds[i] = m_kinds[last];
+	}
+
+	// Batch up the rest by colour, for Render().
+	for (juce::RectangleList<float>& batch : m_batches)
+		batch.clear();
+
+	if (m_numParticles == 0)
+	{
+		m_bounds = juce::Rectangle<int>();
+		return;
+	}
+
+	float left(m_x[0]), top(m_y[0]), right(m_x[0]), bottom(m_y[0]);
+	for (int p = 0; p < m_numParticles; p++)
+	{
+		int step = std::min(FADE_STEPS - 1, static_cast<int>(m_life[p] * m_fade[p] * FADE_STEPS));
+		float size = m_size[p];
+		m_batches[(m_kinds[p] * FADE_STEPS) + step].addWithoutMerging(juce::Rectangle<float>(m_x[p] - (size / 2.0f), m_y[p] - (size / 2.0f), size, size));
+
+		left = std::min(left, m_x[p] - size);
+		top = std::min(top, m_y[p] - size);
+		right = std::max(right, m_x[p] + size);
+		bottom = std::max(bottom, m_y[p] + size);
+	}
+
+	m_bounds = juce::Rectangle<float>::leftTopRightBottom(left, top, right, bottom).getSmallestIntegerContainer().expanded(1);
+}
+
+void ParticleSystem::Render(juce::Graphics& g) const
+{
+	for (int kind = 0; kind < KIND_MAX; kind++)
+	{
+		for (int step = 0; step < FADE_STEPS; step++)
+		{
+			const juce::RectangleList<float>& batch(m_batches[(kind * FADE_STEPS) + step]);
+			if (!batch.isEmpty())
+			{
+				g.setColour(juce::Colour(KINDS[kind].colour).withAlpha(static_cast<float>(step + 1) / FADE_STEPS));
+				g.fillRectList(batch);
+			}
+		}
+	}
+}
+
+int ParticleSystem::GetNumParticles() const
+{
+	return m_numParticles;
+}
+
+juce::Rectangle<int> ParticleSystem::GetBounds() const
+{
+	return m_bounds;
+}
@@ -0,0 +1,160 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+// ---- Class Definition ----
+
+/**
+ * Pool of small particles, such as ooze splashes, drips, and debris of exploding pipes.
+ *
+ * The particles are kept in struct-of-arrays form, in buffers of fixed capacity which are allocated once 
+ * by the constructor. Update() moves all of them with AVX2 or SSE2 kernels (whichever the build targets), 
+ * falling back to plain C++ otherwise, and then sorts them into one batch of rectangles per kind and 
+ * brightness. Render() draws each batch with a single call, and does not change anything, so it may run 
+ * on any thread while Emit() and Update() are not running.
+ */
+class ParticleSystem
+{
+public:
+	/**
+	 * Kinds of particles, each with its own colour and motion.
+	 */
+	enum Kind
+	{
+		KIND_SPLASH = 0,
+		KIND_DRIP,
+		KIND_DEBRIS,
+		KIND_MAX
+	};
+
+	/**
+	 * Number of brightness steps in which particles fade out. Each step of each kind is one batch.
+	 */
+	static const int FADE_STEPS;
+
+	/**
+	 * Class constructor.
+	 *
+	 * @param capacity	Max number of particles alive at the same time. Further particles are dropped.
+	 */
+	ParticleSystem(int capacity = 4096);
+
+	/**
+	 * Class destructor.
+	 */
+	~ParticleSystem();
+
+	/**
+	 * Get the name of the instruction set used by Update(), e.g. "AVX2".
+	 */
+	static const char* GetKernelName();
+
+	/**
+	 * Create new particles, flying off in all directions from the same point.
+	 *
+	 * @param kind		Kind of the particles.
+	 * @param origin	Starting point, relative to the MainComponent window.
+	 * @param count		Number of particles.
+	 * @param tileSize	Width & height of a tile piece, in pixels. Speed, gravity and size of the particles are relative to it.
+	 */
+	void Emit(Kind kind, juce::Point<float> origin, int count, float tileSize);
+
+	/**
+	 * Remove all particles, e.g. when a new round starts.
+	 */
+	void Clear();
+
+	/**
+	 * Move all particles on, remove those whose time is up, and batch up the rest for Render().
+	 *
+	 * @param seconds	Time since the last call, in seconds.
+	 */
+	void Update(float seconds);
+
+	/**
+	 * Draw all particles, as of the last call to Update().
+	 *
+	 * @param g		The graphics context used for drawing.
+	 */
+	void Render(juce::Graphics& g) const;
+
+	/**
+	 * Get the number of particles alive.
+	 */
+	int GetNumParticles() const;
+
+	/**
+	 * Get the area covered by all particles, as of the last call to Update(). Empty if there are none.
+	 */
+	juce::Rectangle<int> GetBounds() const;
+
+private:
+	int m_capacity;
+	int m_numParticles = 0;
+
+	/**
+	 * Per-particle state, padded to a multiple of the SIMD width. Only the first m_numParticles are alive.
+	 * Positions are in pixels, velocities in pixels per second, and accelerations in pixels per second squared.
+	 */
+	std::vector<float> m_x;
+	std::vector<float> m_y;
+	std::vector<float> m_velocityX;
+	std::vector<float> m_velocityY;
+	std::vector<float> m_gravity;
+
+	/**
+	 * Remaining lifetime in seconds, and its inverse at the start, for fading out.
+	 */
+	std::vector<float> m_life;
+	std::vector<float> m_fade;
+
+	/**
+	 * Width & height of each particle, in pixels, and its Kind.
+	 */
+	std::vector<float> m_size;
+	std::vector<int> m_kinds;
+
+	/**
+	 * Rectangles to fill with the same colour, indexed by (kind * FADE_STEPS) + fade step.
+	 */
+	std::vector<juce::RectangleList<float>> m_batches;
+
+	juce::Rectangle<int> m_bounds;
+
+	juce::Random m_random;
+
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParticleSystem)
+};
@@ -0,0 +1,380 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "Planner.h"
+#include "Board.h"
+#include "Queue.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+
+// ---- Helper types and constants ----
+
+/**
+ * Weights used when rating a game situation, see Planner::Evaluate().
+ */
+static constexpr int RATING_PER_SCORE_POINT = 4;
+static constexpr int RATING_PER_BOMB = 6;
+static constexpr int RATING_OPEN_END = 20;
+static constexpr int RATING_PER_FREE_NEIGHBOR = 4;
+static constexpr int RATING_BLOCKED_END = -10;
+static constexpr int RATING_WALL_END = -30;
+static constexpr int RATING_PER_SPILLING_BRANCH = -10;
+
+/**
+ * Pipes are only considered within this distance (in tiles) from the end of the pipeline.
+ */
+static constexpr int CANDIDATE_RADIUS = 2;
+
+/**
+ * Largest number of columns or rows captured in a Planner::Situation. The queue only holds a handful 
+ * of pieces, so tiles further away from the ooze than this would never be reached by the search.
+ */
+static constexpr int MAX_CAPTURE_SIZE = 16;
+
+
+// ---- Class Implementation ----
+
+void Planner::Situation::Capture(const Board& board, const Queue& pipeQueue)
+{
+	// Center the captured part of the board around the ooze.
+	int boardOozeCol(0);
+	int boardOozeRow(0);
+	board.GetOozingCoords(boardOozeCol, boardOozeRow);
+	numCols = std::min(board.GetNumCols(), MAX_CAPTURE_SIZE);
+	numRows = std::min(board.GetNumRows(), MAX_CAPTURE_SIZE);
+	originCol = std::max(0, std::min(boardOozeCol - (numCols / 2), board.GetNumCols() - numCols));
+	originRow = std::max(0, std::min(boardOozeRow - (numRows / 2), board.GetNumRows() - numRows));
+
+	topology = Topology::KIND_RECTANGULAR;
+	if ((numCols == board.GetNumCols()) && (numRows == board.GetNumRows()))
+		topology = board.GetTopology().GetKind();
+
+	tiles.assign(numCols * numRows, TilePiece::TYPE_NONE);
+	oozeWays.assign(numCols * numRows, 0);
+
+	for (int col = 0; col < numCols; col++)
+	{
+		for (int row = 0; row < numRows; row++)
+		{
+			int idx = col + (row * numCols);
+			TilePiece* tile = board.GetTile(originCol + col, originRow + row);
+			tiles[idx] = tile->GetType();
+
+			Cross* cross = dynamic_cast<Cross*>(tile);
+			Pipe* pipe = dynamic_cast<Pipe*>(tile);
+			if (cross != nullptr)
+			{
+				// Each way of a Cross-Pipe can be used once.
+				if (cross->GetOozeLevel(Cross::WAY_HORIZONTAL) > MIN_OOZE_LEVEL)
+					oozeWays[idx] |= WAY_HORIZ;
+				if (cross->GetOozeLevel(Cross::WAY_VERTICAL) > MIN_OOZE_LEVEL)
+					oozeWays[idx] |= WAY_VERT;
+			}
+			else if ((pipe != nullptr) && !pipe->IsEmpty())
+				oozeWays[idx] = (WAY_HORIZ | WAY_VERT);
+
+			if ((pipe != nullptr) && (tile == board.GetOozingTile()))
+			{
+				oozeCol = col;
+				oozeRow = row;
+				oozeDir = pipe->GetFlowDirection();
+
+				// The way the ooze is flowing through is taken, even if still empty.
+				if (cross == nullptr)
+					oozeWays[idx] = (WAY_HORIZ | WAY_VERT);
+				else if ((oozeDir == Pipe::DIR_E) || (oozeDir == Pipe::DIR_W))
+					oozeWays[idx] |= WAY_HORIZ;
+				else
+					oozeWays[idx] |= WAY_VERT;
+			}
+		}
+	}
+
+	queue.clear();
+	for (int i = 0; i < pipeQueue.GetSize(); i++)
+		queue.push_back(pipeQueue.GetTileType(i));
+
+	numBombs = board.GetNumBombs();
+}
+
+Planner::Planner(const Situation& situation)
+	: m_situation(situation),
+	m_topology(situation.topology, situation.numCols, situation.numRows)
+{
+	m_visited.resize(m_situation.tiles.size(), 0);
+	m_candidates.resize(m_situation.queue.size());
+}
+
+Planner::Move Planner::FindMove(std::chrono::microseconds budget, int maxDepth)
+{
+	m_deadline = std::chrono::steady_clock::time_point::max();
+	if (budget.count() > 0)
+		m_deadline = std::chrono::steady_clock::now() + budget;
+	m_searchDepth = 0;
+
+	Move move;
+
+	// Iterative deepening: look one more queue piece ahead with every pass, 
+	// and only trust the result of passes which completed within the time budget.
+	int queueSize = static_cast<int>(m_situation.queue.size());
+	if ((maxDepth <= 0) || (maxDepth > queueSize))
+		maxDepth = queueSize;
+
+	for (int depth = 1; depth <= maxDepth; depth++)
+	{
+		int value;
+		m_candidateMove = -1;
+		if (!Search(0, depth, m_situation.numBombs, value))
+			break;
+
+		// No tile can be used at all.
+		if (m_candidateMove < 0)
+			break;
+
+		move.col = m_situation.originCol + (m_candidateMove % m_situation.numCols);
+		move.row = m_situation.originRow + (m_candidateMove / m_situation.numCols);
+		m_searchDepth = depth;
+	}
+
+	return move;
+}
+
+int Planner::GetSearchDepth() const
+{
+	return m_searchDepth;
+}
+
+Planner::Trace Planner::TracePipeline()
+{
+	Trace trace;
+	std::fill(m_visited.begin(), m_visited.end(), static_cast<unsigned char>(0));
+	m_branches.clear();
+
+	trace.col = m_situation.oozeCol;
+	trace.row = m_situation.oozeRow;
+	trace.end = TraceBranch(trace.col, trace.row, m_situation.oozeDir, trace.value);
+
+	// The other branches of the junctions on the way. Their pipes score as well, 
+	// but wherever they end, nothing is going to take their ooze any further.
+	while (!m_branches.empty())
+	{
+		Branch branch = m_branches.back();
+		m_branches.pop_back();
+
+		TraceBranch(branch.col, branch.row, branch.outFlowDir, trace.value);
+		trace.numSpillingBranches++;
+	}
+
+	return trace;
+}
+
+Planner::End Planner::TraceBranch(int& col, int& row, Pipe::Direction outFlowDir, int& value)
+{
+	while (true)
+	{
+		int nextCol = col;
+		int nextRow = row;
+		if (!m_topology.StepTowards(nextCol, nextRow, outFlowDir))
+			return END_WALL;
+
+		col = nextCol;
+		row = nextRow;
+
+		int idx = nextCol + (nextRow * m_situation.numCols);
+		TilePiece::Type type = m_situation.tiles[idx];
+		if (type == TilePiece::TYPE_NONE)
+			return END_OPEN;
+
+		Pipe::Direction inFlowDir = Pipe::GetOppositeDirection(outFlowDir);
+		Pipe::Direction exits[Pipe::MAX_NUM_EXITS];
+		int numExits = Pipe::GetExitDirections(type, inFlowDir, exits);
+
+		// Regular pipes can only be used once, Cross-Pipes once per way.
+		unsigned char way = (WAY_HORIZ | WAY_VERT);
+		if (type == TilePiece::TYPE_CROSS)
+			way = ((inFlowDir == Pipe::DIR_E) || (inFlowDir == Pipe::DIR_W)) ? WAY_HORIZ : WAY_VERT;
+
+		unsigned char usedWays = (m_situation.oozeWays[idx] | m_visited[idx]);
+		if ((numExits == 0) || ((usedWays & way) != 0))
+			return END_BLOCKED;
+
+		// Cross-Pipes give extra points when the ooze flows through their second way. 
+		// Junctions score for every opening the ooze leaves through.
+		if ((type == TilePiece::TYPE_CROSS) && (usedWays != 0))
+			value += TilePiece::CROSS_PIPE_SCORE_VALUE;
+		else if (Junction::IsJunction(type))
+			value += TilePiece::JUNCTION_SCORE_VALUE_PER_EXIT * numExits;
+		else
+			value += TilePiece::PIPE_SCORE_VALUE;
+
+		m_visited[idx] |= way;
+
+		// The ooze forks. The first exit carries on with this branch.
+		for (int i = 1; i < numExits; i++)
+		{
+			Branch branch;
+			branch.col = nextCol;
+			branch.row = nextRow;
+			branch.outFlowDir = exits[i];
+			m_branches.push_back(branch);
+		}
+
+		outFlowDir = exits[0];
+	}
+}
+
+int Planner::Evaluate(const Trace& trace, int bombsLeft) const
+{
+	int rating = (trace.value * RATING_PER_SCORE_POINT) + (bombsLeft * RATING_PER_BOMB);
+
+	switch (trace.end)
+	{
+		case END_OPEN:
+			{
+				// The more room around the end of the pipeline, the easier it is to continue.
+				static const Pipe::Direction allDirs[] = { Pipe::DIR_N, Pipe::DIR_S, Pipe::DIR_E, Pipe::DIR_W };
+				rating += RATING_OPEN_END;
+				for (Pipe::Direction dir : allDirs)
+				{
+					int col = trace.col;
+					int row = trace.row;
+					if (m_topology.StepTowards(col, row, dir) &&
+						(m_situation.tiles[col + (row * m_situation.numCols)] == TilePiece::TYPE_NONE))
+						rating += RATING_PER_FREE_NEIGHBOR;
+				}
+			}
+			break;
+		case END_BLOCKED:
+			rating += RATING_BLOCKED_END;
+			break;
+		case END_WALL:
+			rating += RATING_WALL_END;
+			break;
+	}
+
+	rating += trace.numSpillingBranches * RATING_PER_SPILLING_BRANCH;
+
+	return rating;
+}
+
+bool Planner::IsBombable(int idx) const
+{
+	TilePiece::Type type = m_situation.tiles[idx];
+
+	return ((type != TilePiece::TYPE_NONE) &&
+		((type < TilePiece::TYPE_START_N) || (type > TilePiece::TYPE_START_W)) &&
+		(m_situation.oozeWays[idx] == 0) &&
+		(idx != m_situation.oozeCol + (m_situation.oozeRow * m_situation.numCols)));
+}
+
+bool Planner::Search(int queuePos, int depthLeft, int bombsLeft, int& bestValue)
+{
+	if ((m_deadline != std::chrono::steady_clock::time_point::max()) && 
+		(std::chrono::steady_clock::now() > m_deadline))
+		return false;
+
+	Trace trace = TracePipeline();
+	if (depthLeft == 0)
+	{
+		bestValue = Evaluate(trace, bombsLeft);
+		return true;
+	}
+
+	// Candidate tiles: the end of the pipeline first, then the tiles around it, 
+	// and finally the empty tile furthest away from it, to get rid of unwanted pieces.
+	std::vector<int>& candidates = m_candidates[queuePos];
+	candidates.clear();
+
+	int frontIdx = trace.col + (trace.row * m_situation.numCols);
+	if ((m_situation.tiles[frontIdx] == TilePiece::TYPE_NONE) ||
+		((bombsLeft > 0) && IsBombable(frontIdx)))
+		candidates.push_back(frontIdx);
+
+	int dumpIdx(-1);
+	int dumpDistance(-1);
+	for (int row = 0; row < m_situation.numRows; row++)
+	{
+		for (int col = 0; col < m_situation.numCols; col++)
+		{
+			int idx = col + (row * m_situation.numCols);
+			if (idx == frontIdx)
+				continue;
+
+			bool empty = (m_situation.tiles[idx] == TilePiece::TYPE_NONE);
+			int distance = std::abs(col - trace.col) + std::abs(row - trace.row);
+			if ((std::abs(col - trace.col) <= CANDIDATE_RADIUS) && (std::abs(row - trace.row) <= CANDIDATE_RADIUS))
+			{
+				if (empty || ((bombsLeft > 0) && IsBombable(idx)))
+					candidates.push_back(idx);
+			}
+			else if (empty && (distance > dumpDistance))
+			{
+				dumpIdx = idx;
+				dumpDistance = distance;
+			}
+		}
+	}
+
+	if (dumpIdx >= 0)
+		candidates.push_back(dumpIdx);
+
+	if (candidates.empty())
+	{
+		bestValue = Evaluate(trace, bombsLeft);
+		return true;
+	}
+
+	bestValue = INT_MIN;
+	for (int idx : candidates)
+	{
+		TilePiece::Type oldType = m_situation.tiles[idx];
+		int bombsUsed = (oldType == TilePiece::TYPE_NONE) ? 0 : 1;
+
+		m_situation.tiles[idx] = m_situation.queue[queuePos];
+		int value;
+		bool completed = Search(queuePos + 1, depthLeft - 1, bombsLeft - bombsUsed, value);
+		m_situation.tiles[idx] = oldType;
+
+		if (!completed)
+			return false;
+
+		if (value > bestValue)
+		{
+			bestValue = value;
+			if (queuePos == 0)
+				m_candidateMove = idx;
+		}
+	}
+
+	return true;
+}
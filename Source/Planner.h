@@ -0,0 +1,260 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include "TilePiece.h"
+#include "Topology.h"
+
+
+// ---- Forward declarations ----
+
+class Board;
+class Queue;
+
+
+// ---- Class Definition ----
+
+/**
+ * Helper class which decides where to place the next pipe from the Queue, the way a player would.
+ * It works on a self-contained copy of the game (see Situation), so it can safely run on any thread,
+ * and uses an iterative deepening search over the upcoming queue pieces, which can be interrupted
+ * at any moment once the time budget runs out. The best move of the deepest completed search is returned.
+ *
+ * The search works on the runtime size of its Situation. A version specialised for the standard 10x7 board,
+ * with compile-time dimensions and bounds checks, ran the calibration sweep no faster: following the pipes 
+ * through the tiles dominates the search, not the index maths.
+ */
+class Planner
+{
+public:
+	/**
+	 * Copy of everything the Planner needs to know about the game at a given moment.
+	 */
+	struct Situation
+	{
+		int numCols = 0;
+		int numRows = 0;
+
+		/**
+		 * Location on the board of this Situation's first tile. Large boards are only captured 
+		 * in part, around the ooze, and all coordinates within the Situation are relative to this.
+		 */
+		int originCol = 0;
+		int originRow = 0;
+
+		/**
+		 * How the captured tiles connect to each other. Only toroidal if the board is, 
+		 * and it was captured as a whole, so that its opposite edges are part of the Situation.
+		 */
+		Topology::Kind topology = Topology::KIND_RECTANGULAR;
+
+		/**
+		 * Type of every tile on the board, indexed by col + (row * numCols).
+		 */
+		std::vector<TilePiece::Type> tiles;
+
+		/**
+		 * Ways of every tile on the board which already contain ooze, see WAY_HORIZ and WAY_VERT.
+		 * Indexed like tiles.
+		 */
+		std::vector<unsigned char> oozeWays;
+
+		/**
+		 * Location of the pipe ooze is currently flowing into, 
+		 * and the opening through which ooze will flow out of it.
+		 */
+		int oozeCol = 0;
+		int oozeRow = 0;
+		Pipe::Direction oozeDir = Pipe::DIR_NONE;
+
+		/**
+		 * Upcoming queue pieces. The first entry is the one which will be placed next.
+		 */
+		std::vector<TilePiece::Type> queue;
+
+		int numBombs = 0;
+
+		/**
+		 * Fill this Situation with the current contents of the given Board and Queue.
+		 * Boards larger than the search could ever make use of are only captured around the ooze.
+		 */
+		void Capture(const Board& board, const Queue& pipeQueue);
+	};
+
+	/**
+	 * A tile on which to place the next piece from the queue.
+	 */
+	struct Move
+	{
+		int col = -1;
+		int row = -1;
+
+		bool IsValid() const { return (col >= 0); }
+	};
+
+	/**
+	 * Class constructor.
+	 *
+	 * @param situation	The game situation to find a move for.
+	 */
+	Planner(const Situation& situation);
+
+	/**
+	 * Search for the best placement of the next piece in the queue.
+	 *
+	 * @param budget	Maximum time the search may take. If zero, the search is not limited in time, 
+	 *					which makes the result independent of the machine's speed.
+	 * @param maxDepth	Maximum number of queue pieces to look ahead. If zero, the whole queue is used.
+	 * @return	The best move found in time, in board coordinates. Invalid if no tile can be used at all.
+	 */
+	Move FindMove(std::chrono::microseconds budget, int maxDepth = 0);
+
+	/**
+	 * Get the number of queue pieces the last FindMove() call managed to look ahead.
+	 */
+	int GetSearchDepth() const;
+
+protected:
+	/**
+	 * Flags used in Situation::oozeWays.
+	 */
+	static constexpr unsigned char WAY_HORIZ = 0x01;
+	static constexpr unsigned char WAY_VERT = 0x02;
+
+	/**
+	 * How the pipeline in front of the ooze ends.
+	 */
+	enum End
+	{
+		END_OPEN = 0,	//< Empty tile, a pipe can be placed there.
+		END_BLOCKED,	//< A pipe which does not fit, or already contains ooze.
+		END_WALL		//< The edge of the board.
+	};
+
+	/**
+	 * Result of following the pipeline from the oozing pipe onwards.
+	 */
+	struct Trace
+	{
+		int value = 0;		//< Score points the connected pipes are worth, on all branches.
+		int col = 0;		//< Column of the tile where the pipeline ends.
+		int row = 0;		//< Row of the tile where the pipeline ends.
+		End end = END_WALL;
+
+		/**
+		 * Branches forked off at junctions along the pipeline, other than the first one, which is followed 
+		 * to the pipeline's end. The search only ever extends that end, so the ooze of the others is going to spill.
+		 */
+		int numSpillingBranches = 0;
+	};
+
+	/**
+	 * Pipe through which a branch forked off at a junction leaves, see TraceBranch().
+	 */
+	struct Branch
+	{
+		int col = 0;
+		int row = 0;
+		Pipe::Direction outFlowDir = Pipe::DIR_NONE;
+	};
+
+	/**
+	 * Follow the pipeline in front of the ooze, as far as it is currently connected. 
+	 * At every junction, the first exit leads on to the end, and the others are followed as well.
+	 */
+	Trace TracePipeline();
+
+	/**
+	 * Follow a single branch of the pipeline, until it ends. Further branches forking off are added to m_branches.
+	 *
+	 * @param col			Column of the pipe the ooze leaves. Returns the column of the tile where the branch ends.
+	 * @param row			Row of the pipe the ooze leaves. Returns the row of the tile where the branch ends.
+	 * @param outFlowDir	Opening the ooze leaves the pipe through.
+	 * @param value			Score points of the pipes on the branch are added to this.
+	 * @return	How the branch ends.
+	 */
+	End TraceBranch(int& col, int& row, Pipe::Direction outFlowDir, int& value);
+
+	/**
+	 * Give a rating to a given game situation. Higher is better.
+	 */
+	int Evaluate(const Trace& trace, int bombsLeft) const;
+
+	/**
+	 * Recursively try placing the upcoming queue pieces.
+	 *
+	 * @param queuePos		Position within the queue of the piece to place.
+	 * @param depthLeft		How many more queue pieces to place.
+	 * @param bombsLeft		Bombs which can still be used.
+	 * @param bestValue		Rating of the best sequence of placements found.
+	 * @return	False if the time budget ran out before completing the search.
+	 */
+	bool Search(int queuePos, int depthLeft, int bombsLeft, int& bestValue);
+
+	/**
+	 * True if the tile at the given index could be replaced by a bomb.
+	 */
+	bool IsBombable(int idx) const;
+
+	Situation m_situation;
+
+	/**
+	 * Neighbors of the Situation's tiles, followed by TracePipeline() and Evaluate().
+	 */
+	Topology m_topology;
+
+	/**
+	 * Scratch buffer used by TracePipeline() to mark the ways visited along the pipeline.
+	 */
+	std::vector<unsigned char> m_visited;
+
+	/**
+	 * Branches TracePipeline() still has to follow, kept across calls to avoid allocations during the search.
+	 */
+	std::vector<Branch> m_branches;
+
+	/**
+	 * Candidate tiles per search depth, kept across calls to avoid allocations during the search.
+	 */
+	std::vector<std::vector<int>> m_candidates;
+
+	std::chrono::steady_clock::time_point m_deadline;
+
+	/**
+	 * Tile index of the best first placement, found by the search currently in progress.
+	 */
+	int m_candidateMove = -1;
+
+	int m_searchDepth = 0;
+};
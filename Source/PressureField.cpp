@@ -0,0 +1,495 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+
+#include "PressureField.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cassert>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define PRESSURE_KERNEL_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+	#include <emmintrin.h>
+	#define PRESSURE_KERNEL_SSE2 1
+#endif
+
+
+// ---- Helper types and constants ----
+
+/**
+ * Number of tiles stepped at once by the kernel in StepRows().
+ */
+#if defined(PRESSURE_KERNEL_AVX2)
+static const int SIMD_WIDTH(8);
+#elif defined(PRESSURE_KERNEL_SSE2)
+static const int SIMD_WIDTH(4);
+#else
+static const int SIMD_WIDTH(1);
+#endif
+
+/**
+ * DIFFUSION_RATE is given in 64ths. Every share of Ooze passed between two tiles is rounded towards zero, so 
+ * that both tiles see the same amount change hands, and none of it is lost. This also keeps the Ooze from 
+ * creeping ahead in minute amounts, which would make the active rectangle grow by a tile with every step, 
+ * and slow down the kernels: differences of a few units are too small to move anything.
+ */
+static constexpr int DIFFUSION_SHIFT = 6;
+static constexpr int DIFFUSION_SCALE = (1 << DIFFUSION_SHIFT);
+
+/**
+ * Smallest active rectangle, in tiles, whose rows are split across worker threads.
+ */
+static constexpr int PARALLEL_MIN_CELLS = 16384;
+
+const int PressureField::DIFFUSION_RATE(13);
+const int PressureField::FULL_FILL(1 << 16);
+
+/**
+ * Openings of every type of tile, one bit per Pipe::Direction, as given by Pipe::HasOpening().
+ */
+struct OpeningsTable
+{
+	unsigned char openings[TilePiece::TYPE_MAX] = {};
+
+	OpeningsTable()
+	{
+		for (int t = TilePiece::TYPE_NONE + 1; t < TilePiece::TYPE_MAX; t++)
+		{
+			for (Pipe::Direction dir : { Pipe::DIR_N, Pipe::DIR_S, Pipe::DIR_E, Pipe::DIR_W })
+			{
+				if (Pipe::HasOpening(static_cast<TilePiece::Type>(t), dir))
+					openings[t] |= (1 << dir);
+			}
+		}
+	}
+};
+
+static const OpeningsTable OPENINGS;
+
+/**
+ * Ooze which flows from a neighbor into a tile within one step, or out of it if negative. 
+ * Zero unless the link mask is set. The SIMD versions work on all lanes at once, and round just the same.
+ */
+#if defined(PRESSURE_KERNEL_AVX2)
+static inline __m256i Transfer(__m256i link, __m256i neighbor, __m256i fill)
+{
+	__m256i share = _mm256_mullo_epi32(_mm256_sub_epi32(neighbor, fill), _mm256_set1_epi32(PressureField::DIFFUSION_RATE));
+	__m256i bias = _mm256_and_si256(_mm256_srai_epi32(share, 31), _mm256_set1_epi32(DIFFUSION_SCALE - 1));
+	return _mm256_and_si256(link, _mm256_srai_epi32(_mm256_add_epi32(share, bias), DIFFUSION_SHIFT));
+}
+#elif defined(PRESSURE_KERNEL_SSE2)
+static inline __m128i Multiply(__m128i a, __m128i b)
+{
+	// SSE2 only multiplies every other lane, so the odd lanes get a second pass. The low halves of the products are exact either way.
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i Max(__m128i a, __m128i b)
+{
+	__m128i greater = _mm_cmpgt_epi32(a, b);
+	return _mm_or_si128(_mm_and_si128(greater, a), _mm_andnot_si128(greater, b));
+}
+
+static inline __m128i Transfer(__m128i link, __m128i neighbor, __m128i fill)
+{
+	__m128i share = Multiply(_mm_sub_epi32(neighbor, fill), _mm_set1_epi32(PressureField::DIFFUSION_RATE));
+	__m128i bias = _mm_and_si128(_mm_srai_epi32(share, 31), _mm_set1_epi32(DIFFUSION_SCALE - 1));
+	return _mm_and_si128(link, _mm_srai_epi32(_mm_add_epi32(share, bias), DIFFUSION_SHIFT));
+}
+#else
+static inline int Transfer(int link, int neighbor, int fill)
+{
+	return link & (((neighbor - fill) * PressureField::DIFFUSION_RATE) / DIFFUSION_SCALE);
+}
+#endif
+
+
+// ---- Class Implementation ----
+
+PressureField::PressureField(int numCols, int numRows)
+	: m_numCols(numCols),
+	m_numRows(numRows)
+{
+	// Besides the margin on either side, every row leaves room for the lanes a kernel runs past its last tile.
+	// Those lanes only ever see tiles without Ooze or openings, and never reach into the next row.
+	m_stride = ((numCols + 1 + SIMD_WIDTH + SIMD_WIDTH - 1) / SIMD_WIDTH) * SIMD_WIDTH;
+
+	int size = m_stride * (numRows + 2);
+	m_fill.resize(size, 0);
+	m_next.resize(size, 0);
+	m_linkN.resize(size, 0);
+	m_linkS.resize(size, 0);
+	m_linkE.resize(size, 0);
+	m_linkW.resize(size, 0);
+	m_leak.resize(size, 0);
+	m_openings.resize(size, 0);
+	m_shown.resize(size, 0);
+	m_rowSpilled.resize(numRows, 0);
+	m_rowPeak.resize(numRows, 0);
+
+	Reset();
+}
+
+PressureField::~PressureField()
+{
+
+}
+
+const char* PressureField::GetKernelName()
+{
+#if defined(PRESSURE_KERNEL_AVX2)
+	return "AVX2";
+#elif defined(PRESSURE_KERNEL_SSE2)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
+
+void PressureField::Reset()
+{
+	std::fill(m_fill.begin(), m_fill.end(), 0);
+	std::fill(m_next.begin(), m_next.end(), 0);
+	std::fill(m_linkN.begin(), m_linkN.end(), 0);
+	std::fill(m_linkS.begin(), m_linkS.end(), 0);
+	std::fill(m_linkE.begin(), m_linkE.end(), 0);
+	std::fill(m_linkW.begin(), m_linkW.end(), 0);
+	std::fill(m_leak.begin(), m_leak.end(), 0);
+	std::fill(m_openings.begin(), m_openings.end(), 0);
+	std::fill(m_shown.begin(), m_shown.end(), 0);
+
+	m_activeLeft = m_numCols;
+	m_activeTop = m_numRows;
+	m_activeRight = -1;
+	m_activeBottom = -1;
+
+	m_spilled = 0;
+	m_peakFill = 0;
+}
+
+int PressureField::GetIndex(int col, int row) const
+{
+	assert((col >= 0) && (col < m_numCols) && (row >= 0) && (row < m_numRows));
+
+	return (col + 1) + ((row + 1) * m_stride);
+}
+
+void PressureField::SetTile(int col, int row, TilePiece::Type t)
+{
+	int idx = GetIndex(col, row);
+	m_openings[idx] = OPENINGS.openings[t];
+	m_fill[idx] = 0;
+	m_next[idx] = 0;
+	m_shown[idx] = 0;
+
+	// The links of the neighbors depend on this tile's openings too. Those in the margin have none.
+	UpdateLinks(idx);
+	if (row > 0)
+		UpdateLinks(idx - m_stride);
+	if (row < m_numRows - 1)
+		UpdateLinks(idx + m_stride);
+	if (col < m_numCols - 1)
+		UpdateLinks(idx + 1);
+	if (col > 0)
+		UpdateLinks(idx - 1);
+}
+
+void PressureField::UpdateLinks(int idx)
+{
+	unsigned char openings = m_openings[idx];
+	bool linkN = ((openings & (1 << Pipe::DIR_N)) != 0) && ((m_openings[idx - m_stride] & (1 << Pipe::DIR_S)) != 0);
+	bool linkS = ((openings & (1 << Pipe::DIR_S)) != 0) && ((m_openings[idx + m_stride] & (1 << Pipe::DIR_N)) != 0);
+	bool linkE = ((openings & (1 << Pipe::DIR_E)) != 0) && ((m_openings[idx + 1] & (1 << Pipe::DIR_W)) != 0);
+	bool linkW = ((openings & (1 << Pipe::DIR_W)) != 0) && ((m_openings[idx - 1] & (1 << Pipe::DIR_E)) != 0);
+
+	int numOpenings(0);
+	for (int dir = Pipe::DIR_N; dir <= Pipe::DIR_W; dir++)
+		numOpenings += ((openings >> dir) & 1);
+
+	m_linkN[idx] = linkN ? ~0 : 0;
+	m_linkS[idx] = linkS ? ~0 : 0;
+	m_linkE[idx] = linkE ? ~0 : 0;
+	m_linkW[idx] = linkW ? ~0 : 0;
+	m_leak[idx] = numOpenings - linkN - linkS - linkE - linkW;
+}
+
+void PressureField::Step(const std::vector<std::pair<int, int>>& inlets, int inflow, int numSteps, WorkerPool* workers)
+{
+	for (int step = 0; step < numSteps; step++)
+	{
+		// Whatever does not divide evenly goes to some of the steps, so that the steps add up to the inflow.
+		long long pumped = static_cast<long long>(inflow) * step / numSteps;
+		int stepInflow = static_cast<int>((static_cast<long long>(inflow) * (step + 1) / numSteps) - pumped);
+
+		for (const std::pair<int, int>& inlet : inlets)
+		{
+			m_fill[GetIndex(inlet.first, inlet.second)] += stepInflow;
+
+			m_activeLeft = std::min(m_activeLeft, inlet.first);
+			m_activeTop = std::min(m_activeTop, inlet.second);
+			m_activeRight = std::max(m_activeRight, inlet.first);
+			m_activeBottom = std::max(m_activeBottom, inlet.second);
+		}
+
+		if (m_activeLeft > m_activeRight)
+			return;
+
+		GrowActiveRect();
+
+		int numActiveRows = m_activeBottom - m_activeTop + 1;
+		int numActiveCols = m_activeRight - m_activeLeft + 1;
+		if ((workers != nullptr) && ((numActiveRows * numActiveCols) >= PARALLEL_MIN_CELLS))
+			workers->ParallelFor(numActiveRows, [this](int begin, int end) { StepRows(begin, end); });
+		else
+			StepRows(0, numActiveRows);
+
+		m_fill.swap(m_next);
+
+		m_peakFill = 0;
+		for (int row = m_activeTop; row <= m_activeBottom; row++)
+		{
+			m_spilled += m_rowSpilled[row];
+			m_peakFill = std::max(m_peakFill, m_rowPeak[row]);
+		}
+	}
+}
+
+bool PressureField::IsWet(int left, int top, int right, int bottom) const
+{
+	for (int row = top; row <= bottom; row++)
+	{
+		for (int col = left; col <= right; col++)
+		{
+			if (m_fill[GetIndex(col, row)] > 0)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+void PressureField::GrowActiveRect()
+{
+	// The Ooze can get one tile further with every step, but only from the tiles it has already reached.
+	// So the rectangle only needs to grow on the sides where its outermost tiles are wet.
+	bool growLeft(IsWet(m_activeLeft, m_activeTop, m_activeLeft, m_activeBottom));
+	bool growTop(IsWet(m_activeLeft, m_activeTop, m_activeRight, m_activeTop));
+	bool growRight(IsWet(m_activeRight, m_activeTop, m_activeRight, m_activeBottom));
+	bool growBottom(IsWet(m_activeLeft, m_activeBottom, m_activeRight, m_activeBottom));
+
+	if (growLeft)
+		m_activeLeft = std::max(0, m_activeLeft - 1);
+	if (growTop)
+		m_activeTop = std::max(0, m_activeTop - 1);
+	if (growRight)
+		m_activeRight = std::min(m_numCols - 1, m_activeRight + 1);
+	if (growBottom)
+		m_activeBottom = std::min(m_numRows - 1, m_activeBottom + 1);
+}
+
+void PressureField::StepRows(int begin, int end)
+{
+	const int* fill = m_fill.data();
+	int* next = m_next.data();
+	const int* linkN = m_linkN.data();
+	const int* linkS = m_linkS.data();
+	const int* linkE = m_linkE.data();
+	const int* linkW = m_linkW.data();
+	const int* leak = m_leak.data();
+	const int stride = m_stride;
+
+	for (int row = m_activeTop + begin; row < m_activeTop + end; row++)
+	{
+		int first = GetIndex(m_activeLeft, row);
+		int last = GetIndex(m_activeRight, row);
+
+		// Every tile evens out its fill level with each linked neighbor. Once full, it also loses 
+		// whatever is beyond full through its open ends. The last lanes of a row may run past the active rectangle, where there is nothing to move.
+		// Integer lanes sum up exactly in any order. Not even a row of thousands of leaking tiles spills 2^31 units in one step.
+#if defined(PRESSURE_KERNEL_AVX2)
+		__m256i rate = _mm256_set1_epi32(DIFFUSION_RATE);
+		__m256i full = _mm256_set1_epi32(FULL_FILL);
+		__m256i spilled = _mm256_setzero_si256();
+		__m256i peak = _mm256_setzero_si256();
+		for (int i = first; i <= last; i += SIMD_WIDTH)
+		{
+			__m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(fill + i));
+			__m256i flux = Transfer(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(linkN + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(fill + i - stride)), f);
+			flux = _mm256_add_epi32(flux, Transfer(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(linkS + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(fill + i + stride)), f));
+			flux = _mm256_add_epi32(flux, Transfer(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(linkE + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(fill + i + 1)), f));
+			flux = _mm256_add_epi32(flux, Transfer(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(linkW + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(fill + i - 1)), f));
+			__m256i overflow = _mm256_max_epi32(_mm256_sub_epi32(f, full), _mm256_setzero_si256());
+			__m256i lost = _mm256_mullo_epi32(_mm256_mullo_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(leak + i)), overflow), rate);
+			lost = _mm256_srai_epi32(lost, DIFFUSION_SHIFT);
+			__m256i level = _mm256_sub_epi32(_mm256_add_epi32(f, flux), lost);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(next + i), level);
+			spilled = _mm256_add_epi32(spilled, lost);
+			peak = _mm256_max_epi32(peak, level);
+		}
+
+		int spilledLanes[SIMD_WIDTH];
+		int peakLanes[SIMD_WIDTH];
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(spilledLanes), spilled);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(peakLanes), peak);
+#elif defined(PRESSURE_KERNEL_SSE2)
+		__m128i rate = _mm_set1_epi32(DIFFUSION_RATE);
+		__m128i full = _mm_set1_epi32(FULL_FILL);
+		__m128i spilled = _mm_setzero_si128();
+		__m128i peak = _mm_setzero_si128();
+		for (int i = first; i <= last; i += SIMD_WIDTH)
+		{
+			__m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(fill + i));
+			__m128i flux = Transfer(_mm_loadu_si128(reinterpret_cast<const __m128i*>(linkN + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(fill + i - stride)), f);
+			flux = _mm_add_epi32(flux, Transfer(_mm_loadu_si128(reinterpret_cast<const __m128i*>(linkS + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(fill + i + stride)), f));
+			flux = _mm_add_epi32(flux, Transfer(_mm_loadu_si128(reinterpret_cast<const __m128i*>(linkE + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(fill + i + 1)), f));
+			flux = _mm_add_epi32(flux, Transfer(_mm_loadu_si128(reinterpret_cast<const __m128i*>(linkW + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(fill + i - 1)), f));
+			__m128i overflow = Max(_mm_sub_epi32(f, full), _mm_setzero_si128());
+			__m128i lost = Multiply(Multiply(_mm_loadu_si128(reinterpret_cast<const __m128i*>(leak + i)), overflow), rate);
+			lost = _mm_srai_epi32(lost, DIFFUSION_SHIFT);
+			__m128i level = _mm_sub_epi32(_mm_add_epi32(f, flux), lost);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(next + i), level);
+			spilled = _mm_add_epi32(spilled, lost);
+			peak = Max(peak, level);
+		}
+
+		int spilledLanes[SIMD_WIDTH];
+		int peakLanes[SIMD_WIDTH];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(spilledLanes), spilled);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(peakLanes), peak);
+#else
+		int spilledLanes[SIMD_WIDTH] = { 0 };
+		int peakLanes[SIMD_WIDTH] = { 0 };
+		for (int i = first; i <= last; i++)
+		{
+			int f = fill[i];
+			int flux = Transfer(linkN[i], fill[i - stride], f) + Transfer(linkS[i], fill[i + stride], f) +
+				Transfer(linkE[i], fill[i + 1], f) + Transfer(linkW[i], fill[i - 1], f);
+			int lost = (leak[i] * std::max(f - FULL_FILL, 0) * DIFFUSION_RATE) >> DIFFUSION_SHIFT;
+			int level = f + flux - lost;
+			next[i] = level;
+			spilledLanes[0] += lost;
+			peakLanes[0] = std::max(peakLanes[0], level);
+		}
+#endif
+
+		long long rowSpilled(0);
+		int rowPeak(0);
+		for (int lane = 0; lane < SIMD_WIDTH; lane++)
+		{
+			rowSpilled += spilledLanes[lane];
+			rowPeak = std::max(rowPeak, peakLanes[lane]);
+		}
+
+		m_rowSpilled[row] = rowSpilled;
+		m_rowPeak[row] = rowPeak;
+	}
+}
+
+int PressureField::GetFill(int col, int row) const
+{
+	return m_fill[GetIndex(col, row)];
+}
+
+long long PressureField::GetSpilled() const
+{
+	return m_spilled;
+}
+
+int PressureField::GetPeakFill() const
+{
+	return m_peakFill;
+}
+
+void PressureField::CollectRisen(int fillStep, std::vector<std::pair<int, int>>& tiles)
+{
+	tiles.clear();
+
+	for (int row = m_activeTop; row <= m_activeBottom; row++)
+	{
+		for (int col = m_activeLeft; col <= m_activeRight; col++)
+		{
+			int idx = GetIndex(col, row);
+			if ((m_shown[idx] < FULL_FILL) && (m_fill[idx] >= m_shown[idx] + fillStep))
+			{
+				m_shown[idx] = m_fill[idx];
+				tiles.push_back(std::make_pair(col, row));
+			}
+		}
+	}
+}
+
+Pipe::Direction PressureField::GetInflowDirection(int col, int row) const
+{
+	int idx = GetIndex(col, row);
+	Pipe::Direction ret(Pipe::DIR_NONE);
+	int highest(-1);
+
+	const std::pair<Pipe::Direction, int> neighbors[] = 
+	{ 
+		{ Pipe::DIR_N, -m_stride }, { Pipe::DIR_S, m_stride }, { Pipe::DIR_E, 1 }, { Pipe::DIR_W, -1 } 
+	};
+	const int* links[] = { m_linkN.data(), m_linkS.data(), m_linkE.data(), m_linkW.data() };
+	for (int i = 0; i < 4; i++)
+	{
+		if ((links[i][idx] != 0) && (m_fill[idx + neighbors[i].second] > highest))
+		{
+			highest = m_fill[idx + neighbors[i].second];
+			ret = neighbors[i].first;
+		}
+	}
+
+	return ret;
+}
+
+bool PressureField::FindWorstLeak(int& col, int& row) const
+{
+	int worst(0);
+	for (int r = m_activeTop; r <= m_activeBottom; r++)
+	{
+		for (int c = m_activeLeft; c <= m_activeRight; c++)
+		{
+			int idx = GetIndex(c, r);
+			int leaking = m_leak[idx] * (m_fill[idx] - FULL_FILL);
+			if (leaking > worst)
+			{
+				worst = leaking;
+				col = c;
+				row = r;
+			}
+		}
+	}
+
+	return (worst > 0);
+}
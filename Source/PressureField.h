@@ -0,0 +1,241 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <vector>
+#include "TilePiece.h"
+
+
+// ---- Forward declarations ----
+
+class WorkerPool;
+
+
+// ---- Class Definition ----
+
+/**
+ * Cellular automaton behind the pressure game mode, where the Ooze is a continuous quantity which 
+ * diffuses from pipe to pipe through every pair of matching openings. Once the pipe at an open end is full, 
+ * the Ooze leaks out of it.
+ *
+ * The board is kept in struct-of-arrays form: one array of fill levels in fixed point (see FULL_FILL), and one 
+ * array of link masks per direction, which are set where two neighboring tiles both have an opening towards each 
+ * other (see Pipe::HasOpening()). A separate leak weight counts the openings of each tile which lead nowhere. 
+ * Every row is padded, and surrounded by a margin of cells without openings, so that the stencil in Step()
+ * runs over whole rows with AVX2 or SSE2 kernels (whichever the build targets), falling back to plain C++ otherwise.
+ * Only the rectangle around the cells the Ooze may already have reached is stepped, and its rows are 
+ * split across worker threads once it is large enough.
+ *
+ * All of it is integer maths, and every tile's new level only depends on its own neighborhood. So the outcome 
+ * of a round is the same whichever kernel the build uses, and however the rows are split across threads.
+ */
+class PressureField
+{
+public:
+	/**
+	 * Share of the difference in fill level between two linked tiles which evens out with every step, in 64ths.
+	 * Must stay below 16 for the automaton to be stable.
+	 */
+	static const int DIFFUSION_RATE;
+
+	/**
+	 * Fill level of a full tile. Tiles with open ends only leak what is beyond this.
+	 */
+	static const int FULL_FILL;
+
+	/**
+	 * Class constructor. All tiles start without openings and without Ooze.
+	 *
+	 * @param numCols	Number of columns of the board.
+	 * @param numRows	Number of rows of the board.
+	 */
+	PressureField(int numCols, int numRows);
+
+	/**
+	 * Class destructor.
+	 */
+	~PressureField();
+
+	/**
+	 * Get the name of the instruction set used by Step(), e.g. "AVX2".
+	 */
+	static const char* GetKernelName();
+
+	/**
+	 * Remove all tiles and all Ooze, and forget about the Ooze spilled so far.
+	 */
+	void Reset();
+
+	/**
+	 * Set the tile at the given position, which links it to those of its neighbors with matching openings.
+	 * Any Ooze already on that tile is lost.
+	 *
+	 * @param col	Column of the tile.
+	 * @param row	Row of the tile.
+	 * @param t		New type of the tile.
+	 */
+	void SetTile(int col, int row, TilePiece::Type t);
+
+	/**
+	 * Advance the automaton by the given number of steps. In every step, Ooze is first pumped into 
+	 * all inlets, and then flows along every link, from fuller tiles to emptier ones.
+	 *
+	 * @param inlets	Column and row of the tiles into which the Ooze is pumped.
+	 * @param inflow	Amount of Ooze pumped into every inlet over all steps, see FULL_FILL. It is spread 
+	 *					as evenly as possible across the steps, without losing any of it to rounding.
+	 * @param numSteps	Number of steps.
+	 * @param workers	Threads to split large boards across. If null, all rows are stepped on the calling thread.
+	 */
+	void Step(const std::vector<std::pair<int, int>>& inlets, int inflow, int numSteps, WorkerPool* workers);
+
+	/**
+	 * Get the fill level of the given tile, see FULL_FILL. Tiles which are linked into a closed 
+	 * pipeline may end up fuller than that, as the pressure builds up.
+	 */
+	int GetFill(int col, int row) const;
+
+	/**
+	 * Get the total amount of Ooze which has leaked out of open ends since the last Reset().
+	 */
+	long long GetSpilled() const;
+
+	/**
+	 * Get the highest fill level of any tile, as of the last Step().
+	 */
+	int GetPeakFill() const;
+
+	/**
+	 * Get the tiles whose fill level has risen by at least the given step since they were last returned.
+	 * This is how the Board finds the pipes whose look needs to change, without going through all of them.
+	 * Tiles are no longer returned once they are full.
+	 *
+	 * @param fillStep	Smallest rise in fill level worth reporting.
+	 * @param tiles		Returns the column and row of all such tiles. Cleared first.
+	 */
+	void CollectRisen(int fillStep, std::vector<std::pair<int, int>>& tiles);
+
+	/**
+	 * Get the linked neighbor with the highest fill level, i.e. where the Ooze of a tile came in from.
+	 *
+	 * @return	The direction of that neighbor, or DIR_NONE if the tile has no linked neighbors.
+	 */
+	Pipe::Direction GetInflowDirection(int col, int row) const;
+
+	/**
+	 * Find the tile which loses the most Ooze through its open ends, as of the last Step().
+	 *
+	 * @param col	Returns the column of that tile.
+	 * @param row	Returns the row of that tile.
+	 * @return	False if no Ooze is leaking anywhere.
+	 */
+	bool FindWorstLeak(int& col, int& row) const;
+
+private:
+	/**
+	 * Get the position of a tile in the arrays, taking the margin into account.
+	 */
+	int GetIndex(int col, int row) const;
+
+	/**
+	 * Recompute the link and leak weights of a tile from the openings of itself and its neighbors.
+	 */
+	void UpdateLinks(int idx);
+
+	/**
+	 * Check whether any tile within the given rectangle holds Ooze. Coordinates are inclusive.
+	 */
+	bool IsWet(int left, int top, int right, int bottom) const;
+
+	/**
+	 * Grow the active rectangle on every side where the Ooze may reach beyond it with the next step.
+	 */
+	void GrowActiveRect();
+
+	/**
+	 * Run one step of the stencil over the given rows of the active rectangle.
+	 * Writes to m_next, and records the Ooze spilled and the peak fill level of every row.
+	 */
+	void StepRows(int begin, int end);
+
+	int m_numCols;
+	int m_numRows;
+
+	/**
+	 * Distance between two rows in the arrays. Includes the margins, and is padded to a multiple of the SIMD width.
+	 */
+	int m_stride;
+
+	/**
+	 * Fill level of every tile, and the buffer the next step is written to.
+	 */
+	std::vector<int> m_fill;
+	std::vector<int> m_next;
+
+	/**
+	 * Link masks towards the neighbor in each direction (all bits set where linked), and the number of 
+	 * openings which lead nowhere.
+	 */
+	std::vector<int> m_linkN;
+	std::vector<int> m_linkS;
+	std::vector<int> m_linkE;
+	std::vector<int> m_linkW;
+	std::vector<int> m_leak;
+
+	/**
+	 * Openings of every tile, one bit per Pipe::Direction. The margin has none.
+	 */
+	std::vector<unsigned char> m_openings;
+
+	/**
+	 * Fill level of every tile as of the last CollectRisen().
+	 */
+	std::vector<int> m_shown;
+
+	/**
+	 * Ooze spilled and peak fill level of every row during the current step. 
+	 * Kept apart per row, so that the threads do not have to share them.
+	 */
+	std::vector<long long> m_rowSpilled;
+	std::vector<int> m_rowPeak;
+
+	/**
+	 * Rectangle outside of which all tiles are known to be dry, see GrowActiveRect().
+	 * In board coordinates, inclusive. Empty while m_activeLeft > m_activeRight.
+	 */
+	int m_activeLeft;
+	int m_activeTop;
+	int m_activeRight;
+	int m_activeBottom;
+
+	long long m_spilled;
+	int m_peakFill;
+};
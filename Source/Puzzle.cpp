@@ -0,0 +1,450 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "Puzzle.h"
+#include "Board.h"
+#include "Randomizer.h"
+#include "WorkerPool.h"
+#include <cmath>
+#include <algorithm>
+
+
+// ---- Helper types and constants ----
+
+const int Puzzle::MAX_QUEUE_SIZE(16);
+const int Puzzle::MAX_DIFFICULTY(12);
+const long long PuzzleSolver::MAX_SEARCH_NODES(4000000);
+
+/**
+ * Flags for the two ways of a tile, which can each contain ooze once. Non-cross pipes use both at once.
+ */
+static const unsigned char WAY_HORIZ(0x01);
+static const unsigned char WAY_VERT(0x02);
+static const unsigned char WAY_BOTH(WAY_HORIZ | WAY_VERT);
+
+/**
+ * Number of tiles in the random pipeline laid out for each candidate.
+ */
+static const int MIN_PATH_LENGTH(5);
+static const int MAX_PATH_LENGTH(12);
+
+/**
+ * Chance, in percent, for each pipe of the pipeline to be pre-placed rather than handed out in the queue.
+ */
+static const int PREPLACED_PERCENT(30);
+
+/**
+ * Limits for the number of extra pipes in the queue, and the number of pre-placed pipes off the pipeline.
+ */
+static const int MAX_DECOYS(3);
+static const int MIN_BLOCKERS(2);
+static const int MAX_BLOCKERS(7);
+
+/**
+ * Smallest queue and target score for a puzzle to be worth playing.
+ */
+static const int MIN_QUEUE_SIZE(4);
+static const int MIN_TARGET_SCORE(50);
+
+
+/**
+ * Get the coordinates of the neighbor of the given tile.
+ *
+ * @return	False if the neighbor would be out of bounds.
+ */
+static bool StepTowards(int numCols, int numRows, int& col, int& row, Pipe::Direction dir)
+{
+	if (dir == Pipe::DIR_NONE)
+		return false;
+
+	// Puzzles are always played on rectangular boards.
+	int colStep(0);
+	int rowStep(0);
+	Topology::GetStep(dir, colStep, rowStep);
+	col += colStep;
+	row += rowStep;
+
+	return ((col >= 0) && (col < numCols) && (row >= 0) && (row < numRows));
+}
+
+/**
+ * Get the way of a tile through which ooze entering from the given side flows.
+ */
+static unsigned char GetWay(Pipe::Direction entry)
+{
+	return ((entry == Pipe::DIR_E) || (entry == Pipe::DIR_W)) ? WAY_HORIZ : WAY_VERT;
+}
+
+/**
+ * Get the opening of a starter tile.
+ */
+static Pipe::Direction GetStartDirection(TilePiece::Type t)
+{
+	switch (t)
+	{
+		case TilePiece::TYPE_START_N:
+			return Pipe::DIR_N;
+		case TilePiece::TYPE_START_S:
+			return Pipe::DIR_S;
+		case TilePiece::TYPE_START_E:
+			return Pipe::DIR_E;
+		case TilePiece::TYPE_START_W:
+			return Pipe::DIR_W;
+		default:
+			break;
+	}
+
+	return Pipe::DIR_NONE;
+}
+
+/**
+ * Get the direction after turning left (turn == 1) or right (turn == 2), or going straight (turn == 0).
+ */
+static Pipe::Direction Turn(Pipe::Direction dir, int turn)
+{
+	static const Pipe::Direction clockwise[] = { Pipe::DIR_N, Pipe::DIR_E, Pipe::DIR_S, Pipe::DIR_W };
+
+	int i = 0;
+	while (clockwise[i] != dir)
+		i++;
+
+	if (turn == 1)
+		return clockwise[(i + 3) % 4];
+	if (turn == 2)
+		return clockwise[(i + 1) % 4];
+
+	return dir;
+}
+
+/**
+ * Get the (non-cross) pipe type through which ooze entering from one side exits through the other.
+ */
+static TilePiece::Type GetPipeType(Pipe::Direction entry, Pipe::Direction exit)
+{
+	for (int t = TilePiece::TYPE_VERTICAL; t < TilePiece::TYPE_CROSS; t++)
+	{
+		if (Pipe::GetExitDirection(static_cast<TilePiece::Type>(t), entry) == exit)
+			return static_cast<TilePiece::Type>(t);
+	}
+
+	return TilePiece::TYPE_NONE;
+}
+
+/**
+ * Most points a pipe of the given type can be worth.
+ */
+static int GetMaxScoreValue(TilePiece::Type t)
+{
+	if (t == TilePiece::TYPE_CROSS)
+		return TilePiece::PIPE_SCORE_VALUE + TilePiece::CROSS_PIPE_SCORE_VALUE;
+
+	if (t >= TilePiece::TYPE_VERTICAL)
+		return TilePiece::PIPE_SCORE_VALUE;
+
+	return 0;
+}
+
+
+// ---- Class Implementation ----
+
+PuzzleSolver::PuzzleSolver(const Puzzle& puzzle)
+	: m_numCols(puzzle.numCols),
+	m_numRows(puzzle.numRows),
+	m_tiles(puzzle.tiles),
+	m_ways(puzzle.tiles.size(), 0),
+	m_potential(0),
+	m_startCol(0),
+	m_startRow(0),
+	m_startDir(Pipe::DIR_NONE)
+{
+	std::fill(m_pieceCounts, m_pieceCounts + TilePiece::TYPE_MAX, 0);
+	for (TilePiece::Type t : puzzle.queue)
+	{
+		m_pieceCounts[t]++;
+		m_potential += GetMaxScoreValue(t);
+	}
+
+	for (int i = 0; i < static_cast<int>(m_tiles.size()); i++)
+	{
+		m_potential += GetMaxScoreValue(m_tiles[i]);
+
+		Pipe::Direction startDir = GetStartDirection(m_tiles[i]);
+		if (startDir != Pipe::DIR_NONE)
+		{
+			m_startCol = i % m_numCols;
+			m_startRow = i / m_numCols;
+			m_startDir = startDir;
+		}
+	}
+}
+
+PuzzleSolver::Result PuzzleSolver::Solve()
+{
+	m_result = Result();
+	m_scoreCounts.assign(m_potential + 1, 0);
+	m_solution = m_tiles;
+
+	// Ooze never flows back into the starter tile.
+	m_ways[m_startCol + (m_startRow * m_numCols)] = WAY_BOTH;
+
+	Search(m_startCol, m_startRow, m_startDir, 0);
+
+	m_result.numBestSolutions = m_scoreCounts[m_result.bestScore];
+	if (m_result.bestScore >= TilePiece::PIPE_SCORE_VALUE)
+		m_result.numNearSolutions = m_scoreCounts[m_result.bestScore - TilePiece::PIPE_SCORE_VALUE];
+
+	return m_result;
+}
+
+const std::vector<TilePiece::Type>& PuzzleSolver::GetSolution() const
+{
+	return m_solution;
+}
+
+int PuzzleSolver::RateDifficulty(const Result& result)
+{
+	// Every quadrupling of the search effort adds a level, and so does every tempting alternative.
+	double searchEffort = std::log2(static_cast<double>(std::max(1LL, result.numNodes))) / 2.0;
+	int rating = static_cast<int>(searchEffort) + std::min(result.numNearSolutions, 4) - 1;
+
+	return std::min(std::max(rating, 1), Puzzle::MAX_DIFFICULTY);
+}
+
+void PuzzleSolver::Search(int col, int row, Pipe::Direction dir, int score)
+{
+	if (m_result.aborted)
+		return;
+
+	m_result.numNodes++;
+	if (m_result.numNodes > MAX_SEARCH_NODES)
+	{
+		m_result.aborted = true;
+		return;
+	}
+
+	// Near solutions are still counted, so only skip pipelines which can't even get within one pipe of the best.
+	if ((score + m_potential) < (m_result.bestScore - TilePiece::PIPE_SCORE_VALUE))
+		return;
+
+	// Ooze spilling out of bounds.
+	if (!StepTowards(m_numCols, m_numRows, col, row, dir))
+	{
+		RecordPipeline(score);
+		return;
+	}
+
+	int idx = col + (row * m_numCols);
+	Pipe::Direction entry = Pipe::GetOppositeDirection(dir);
+	if (m_tiles[idx] != TilePiece::TYPE_NONE)
+	{
+		FlowThrough(idx, entry, score);
+		return;
+	}
+
+	// The ooze spills onto this empty tile, unless one of the pipes left in the queue is placed on it.
+	RecordPipeline(score);
+
+	for (int t = TilePiece::TYPE_VERTICAL; t <= TilePiece::TYPE_CROSS; t++)
+	{
+		TilePiece::Type type = static_cast<TilePiece::Type>(t);
+		if ((m_pieceCounts[t] > 0) && (Pipe::GetExitDirection(type, entry) != Pipe::DIR_NONE))
+		{
+			m_pieceCounts[t]--;
+			m_tiles[idx] = type;
+
+			FlowThrough(idx, entry, score);
+
+			m_tiles[idx] = TilePiece::TYPE_NONE;
+			m_pieceCounts[t]++;
+		}
+	}
+}
+
+void PuzzleSolver::FlowThrough(int idx, Pipe::Direction entry, int score)
+{
+	TilePiece::Type t = m_tiles[idx];
+	unsigned char way = (t == TilePiece::TYPE_CROSS) ? GetWay(entry) : WAY_BOTH;
+
+	// Starter tiles don't accept ooze, and other pipes only once per way.
+	Pipe::Direction exit = Pipe::GetExitDirection(t, entry);
+	if ((exit == Pipe::DIR_NONE) || ((m_ways[idx] & way) != 0))
+	{
+		RecordPipeline(score);
+		return;
+	}
+
+	int gained = (m_ways[idx] != 0) ? TilePiece::CROSS_PIPE_SCORE_VALUE : TilePiece::PIPE_SCORE_VALUE;
+
+	m_ways[idx] |= way;
+	m_potential -= gained;
+
+	Search(idx % m_numCols, idx / m_numCols, exit, score + gained);
+
+	m_potential += gained;
+	m_ways[idx] &= ~way;
+}
+
+void PuzzleSolver::RecordPipeline(int score)
+{
+	m_scoreCounts[score]++;
+
+	if (score > m_result.bestScore)
+	{
+		m_result.bestScore = score;
+		m_solution = m_tiles;
+	}
+}
+
+bool PuzzleGenerator::Generate(unsigned int seed, Puzzle& puzzle, int numCols, int numRows)
+{
+	Randomizer rand(seed);
+	int numCells = numCols * numRows;
+
+	// Let the Board pick the starter tile, following the usual rules.
+	Board board(numCols, numRows, &rand);
+	int startCol(0);
+	int startRow(0);
+	board.GetOozingCoords(startCol, startRow);
+
+	std::vector<TilePiece::Type> tiles(numCells, TilePiece::TYPE_NONE);
+	tiles[startCol + (startRow * numCols)] = board.GetTileType(startCol, startRow);
+
+	// Lay out a random pipeline, which may cross over itself.
+	std::vector<int> pipeline;
+	int pathLength = rand.GetWithinRange(MIN_PATH_LENGTH, MAX_PATH_LENGTH);
+	int col(startCol);
+	int row(startRow);
+	Pipe::Direction dir = GetStartDirection(tiles[startCol + (startRow * numCols)]);
+	while (static_cast<int>(pipeline.size()) < pathLength)
+	{
+		if (!StepTowards(numCols, numRows, col, row, dir))
+			break;
+
+		int idx = col + (row * numCols);
+		Pipe::Direction entry = Pipe::GetOppositeDirection(dir);
+		if (tiles[idx] == TilePiece::TYPE_NONE)
+		{
+			dir = Turn(dir, rand.GetWithinRange(0, 2));
+			tiles[idx] = GetPipeType(entry, dir);
+			pipeline.push_back(idx);
+		}
+
+		// Crossing over a straight pipe of the pipeline turns it into a Cross-Pipe.
+		else if (((tiles[idx] == TilePiece::TYPE_VERTICAL) || (tiles[idx] == TilePiece::TYPE_HORIZONTAL)) &&
+			(Pipe::GetExitDirection(tiles[idx], entry) == Pipe::DIR_NONE))
+			tiles[idx] = TilePiece::TYPE_CROSS;
+
+		else
+			break;
+	}
+
+	// Hand out some of the pipeline's pipes in the queue, the rest remain pre-placed.
+	std::vector<bool> reserved(numCells, false);
+	reserved[startCol + (startRow * numCols)] = true;
+	puzzle.queue.clear();
+	for (int idx : pipeline)
+	{
+		reserved[idx] = true;
+		if (rand.GetWithinRange(1, 100) > PREPLACED_PERCENT)
+		{
+			puzzle.queue.push_back(tiles[idx]);
+			tiles[idx] = TilePiece::TYPE_NONE;
+		}
+	}
+
+	if (static_cast<int>(puzzle.queue.size()) < MIN_QUEUE_SIZE)
+		return false;
+
+	// Decoy pipes in the queue.
+	int numDecoys = rand.GetWithinRange(0, MAX_DECOYS);
+	for (int i = 0; (i < numDecoys) && (static_cast<int>(puzzle.queue.size()) < Puzzle::MAX_QUEUE_SIZE); i++)
+		puzzle.queue.push_back(static_cast<TilePiece::Type>(rand.GetWithinRange(TilePiece::TYPE_VERTICAL, TilePiece::TYPE_CROSS)));
+
+	if (static_cast<int>(puzzle.queue.size()) > Puzzle::MAX_QUEUE_SIZE)
+		return false;
+
+	// Pre-placed pipes off the pipeline, which get in the way.
+	int numBlockers = rand.GetWithinRange(MIN_BLOCKERS, MAX_BLOCKERS);
+	for (int i = 0; i < numBlockers; i++)
+	{
+		int idx = rand.GetWithinRange(0, numCells - 1);
+		if (!reserved[idx] && (tiles[idx] == TilePiece::TYPE_NONE))
+			tiles[idx] = static_cast<TilePiece::Type>(rand.GetWithinRange(TilePiece::TYPE_VERTICAL, TilePiece::TYPE_SW_ELBOW));
+	}
+
+	// The queue order makes no difference to the solution, shuffle it so that it doesn't give the pipeline away.
+	for (int i = static_cast<int>(puzzle.queue.size()) - 1; i > 0; i--)
+		std::swap(puzzle.queue[i], puzzle.queue[rand.GetWithinRange(0, i)]);
+
+	puzzle.numCols = numCols;
+	puzzle.numRows = numRows;
+	puzzle.tiles = tiles;
+
+	PuzzleSolver solver(puzzle);
+	PuzzleSolver::Result result = solver.Solve();
+	if (!result.IsUnique() || (result.bestScore < MIN_TARGET_SCORE))
+		return false;
+
+	// Double-check the solution by letting the ooze flow through it on an actual Board.
+	board.Reset(solver.GetSolution(), 0);
+	while (board.Pump(MAX_OOZE_LEVEL))
+	{
+	}
+
+	if (board.GetScoreValue() != result.bestScore)
+		return false;
+
+	puzzle.targetScore = result.bestScore;
+	puzzle.difficulty = PuzzleSolver::RateDifficulty(result);
+
+	return true;
+}
+
+std::vector<Puzzle> PuzzleGenerator::GenerateBatch(unsigned int firstSeed, int numCandidates, WorkerPool& workers)
+{
+	std::vector<Puzzle> candidates(numCandidates);
+	std::vector<unsigned char> accepted(numCandidates, 0);
+
+	workers.ParallelFor(numCandidates, [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			accepted[i] = Generate(firstSeed + static_cast<unsigned int>(i), candidates[i]) ? 1 : 0;
+	});
+
+	std::vector<Puzzle> puzzles;
+	for (int i = 0; i < numCandidates; i++)
+	{
+		if (accepted[i] != 0)
+			puzzles.push_back(std::move(candidates[i]));
+	}
+
+	return puzzles;
+}
@@ -0,0 +1,253 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <vector>
+#include "TilePiece.h"
+
+
+// ---- Forward declarations ----
+
+class WorkerPool;
+
+
+// ---- Class Definition ----
+
+/**
+ * A puzzle: a board with pre-placed tiles, and a fixed sequence of pipes in the queue. 
+ * The ooze waits until all pipes have been placed, and the goal is to reach the target score.
+ * No bombs are available, so pipes can only be placed on empty tiles.
+ */
+struct Puzzle
+{
+	/**
+	 * Max number of pipes in the queue of a puzzle.
+	 */
+	static const int MAX_QUEUE_SIZE;
+
+	/**
+	 * Highest difficulty rating, see PuzzleSolver::RateDifficulty().
+	 */
+	static const int MAX_DIFFICULTY;
+
+	int numCols = 0;
+	int numRows = 0;
+
+	/**
+	 * Type of every pre-placed tile, indexed by col + (row * numCols). Contains exactly one starter tile.
+	 */
+	std::vector<TilePiece::Type> tiles;
+
+	/**
+	 * Pipes in the queue, in the order they are handed out to the player.
+	 */
+	std::vector<TilePiece::Type> queue;
+
+	/**
+	 * Score needed to solve the puzzle, which is the highest score possible.
+	 */
+	int targetScore = 0;
+
+	/**
+	 * Difficulty rating, from 1 to MAX_DIFFICULTY.
+	 */
+	int difficulty = 0;
+};
+
+
+/**
+ * Exhaustive search over all the ways the pipes in a Puzzle's queue can be laid out along the pipeline.
+ * Since the ooze only starts flowing once all pipes are placed, the order of the queue does not matter,
+ * and only the tiles the ooze actually flows through make a difference to the score.
+ */
+class PuzzleSolver
+{
+public:
+	/**
+	 * Outcome and statistics of the search.
+	 */
+	struct Result
+	{
+		/**
+		 * Highest score which can be reached.
+		 */
+		int bestScore = 0;
+
+		/**
+		 * Number of different pipelines reaching bestScore.
+		 */
+		int numBestSolutions = 0;
+
+		/**
+		 * Number of different pipelines falling short of bestScore by a single pipe.
+		 */
+		int numNearSolutions = 0;
+
+		/**
+		 * Number of positions visited during the search.
+		 */
+		long long numNodes = 0;
+
+		/**
+		 * True if the search was abandoned after MAX_SEARCH_NODES positions.
+		 */
+		bool aborted = false;
+
+		bool IsUnique() const { return (!aborted && (numBestSolutions == 1)); }
+	};
+
+	/**
+	 * Limit on the number of positions visited, after which the search is abandoned.
+	 */
+	static const long long MAX_SEARCH_NODES;
+
+	/**
+	 * Class constructor.
+	 *
+	 * @param puzzle	The puzzle to solve.
+	 */
+	PuzzleSolver(const Puzzle& puzzle);
+
+	/**
+	 * Search all pipelines which can be built with the puzzle's queue.
+	 *
+	 * @return	The highest score possible, and search statistics.
+	 */
+	Result Solve();
+
+	/**
+	 * Get the layout of the first pipeline found which reaches the highest score.
+	 * Only pipes which are part of the pipeline are placed.
+	 *
+	 * @return	Type of every tile, indexed like Puzzle::tiles.
+	 */
+	const std::vector<TilePiece::Type>& GetSolution() const;
+
+	/**
+	 * Derive a difficulty rating from the search statistics: the larger the search, 
+	 * and the more pipelines come close to the solution, the harder the puzzle.
+	 *
+	 * @param result	Statistics returned by Solve().
+	 * @return	Difficulty rating, from 1 to Puzzle::MAX_DIFFICULTY.
+	 */
+	static int RateDifficulty(const Result& result);
+
+protected:
+	/**
+	 * Follow the ooze out of the pipe at the given coordinates, trying all pipes
+	 * left in the queue on every empty tile it reaches.
+	 *
+	 * @param col	Column of the pipe the ooze is flowing out of.
+	 * @param row	Row of the pipe the ooze is flowing out of.
+	 * @param dir	Opening through which the ooze flows out of it.
+	 * @param score	Score gained so far.
+	 */
+	void Search(int col, int row, Pipe::Direction dir, int score);
+
+	/**
+	 * Called whenever the ooze spills, i.e. a pipeline is complete.
+	 */
+	void RecordPipeline(int score);
+
+	/**
+	 * Let the ooze flow through the given tile, and continue the search beyond it.
+	 */
+	void FlowThrough(int idx, Pipe::Direction entry, int score);
+
+	int m_numCols;
+	int m_numRows;
+
+	/**
+	 * Tiles on the board, including pipes placed during the search.
+	 */
+	std::vector<TilePiece::Type> m_tiles;
+
+	/**
+	 * Ways of every tile which already contain ooze, see WAY_HORIZ and WAY_VERT in the implementation.
+	 */
+	std::vector<unsigned char> m_ways;
+
+	/**
+	 * Number of pipes of each type left in the queue.
+	 */
+	int m_pieceCounts[TilePiece::TYPE_MAX];
+
+	/**
+	 * Most points which could still be gained, from pipes in the queue and unused pre-placed pipes.
+	 * Used to skip pipelines which cannot catch up with the best one.
+	 */
+	int m_potential;
+
+	int m_startCol;
+	int m_startRow;
+	Pipe::Direction m_startDir;
+
+	/**
+	 * Number of pipelines found for each score.
+	 */
+	std::vector<int> m_scoreCounts;
+
+	Result m_result;
+	std::vector<TilePiece::Type> m_solution;
+};
+
+
+/**
+ * Creates random puzzles, and only keeps those with a unique solution.
+ */
+class PuzzleGenerator
+{
+public:
+	/**
+	 * Create a puzzle from the given seed. A random pipeline is laid out from a random starter tile,
+	 * some of its pipes are pre-placed and the rest go into the queue, together with a few decoys.
+	 * The candidate is accepted if the PuzzleSolver finds exactly one best pipeline, 
+	 * which is then double-checked by letting the ooze flow through it on an actual Board.
+	 *
+	 * @param seed		Seed for the random decisions. The same seed always gives the same candidate.
+	 * @param puzzle	Returns the puzzle, if accepted.
+	 * @param numCols	Number of columns on the board.
+	 * @param numRows	Number of rows on the board.
+	 * @return	True if the candidate was accepted.
+	 */
+	static bool Generate(unsigned int seed, Puzzle& puzzle, int numCols = 10, int numRows = 7);
+
+	/**
+	 * Generate candidates for a range of seeds in parallel, and return the accepted ones in order of their seed.
+	 *
+	 * @param firstSeed		Seed of the first candidate.
+	 * @param numCandidates	Number of candidates, each using the next seed.
+	 * @param workers		Threads on which the candidates are generated.
+	 * @return	The accepted puzzles.
+	 */
+	static std::vector<Puzzle> GenerateBatch(unsigned int firstSeed, int numCandidates, WorkerPool& workers);
+};
@@ -0,0 +1,330 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "PuzzleDatabase.h"
+#include "WorkerPool.h"
+#include <set>
+#include <cstring>
+
+
+// ---- Helper types and constants ----
+
+const juce::String PuzzleDatabase::DEFAULT_FILE_NAME("Puzzles.pdz");
+
+static const char FILE_MAGIC[] = { 'P', 'D', 'P', 'Z' };
+static const int FILE_VERSION(1);
+static const int HEADER_SIZE(16);
+
+/**
+ * Tile types are stored in 4 bits each. Puzzles are played without junctions, 
+ * so only the types up to TilePiece::TYPE_CROSS can be stored.
+ */
+static const int NUM_PUZZLE_TYPES(TilePiece::TYPE_CROSS + 1);
+static_assert(NUM_PUZZLE_TYPES <= 16, "Puzzle tile types must fit into 4 bits.");
+
+/**
+ * Number of candidates generated in parallel at once by Generate().
+ */
+static const int CANDIDATES_PER_BATCH(8192);
+
+/**
+ * Generate() gives up once this many batches in a row brought no new puzzle, 
+ * as the generator has most likely run out of different puzzles by then.
+ */
+static const int MAX_FRUITLESS_BATCHES(64);
+
+
+/**
+ * Get the size in bytes of a puzzle record, for the given number of tiles on the board.
+ */
+static int GetRecordSize(int numCells)
+{
+	return ((numCells + 1) / 2) + 1 + (Puzzle::MAX_QUEUE_SIZE / 2) + 2 + 1;
+}
+
+static void WriteUInt16(unsigned char* dest, int value)
+{
+	dest[0] = static_cast<unsigned char>(value & 0xff);
+	dest[1] = static_cast<unsigned char>((value >> 8) & 0xff);
+}
+
+static void WriteUInt32(unsigned char* dest, unsigned int value)
+{
+	WriteUInt16(dest, static_cast<int>(value & 0xffff));
+	WriteUInt16(dest + 2, static_cast<int>(value >> 16));
+}
+
+static int ReadUInt16(const unsigned char* src)
+{
+	return src[0] | (src[1] << 8);
+}
+
+static unsigned int ReadUInt32(const unsigned char* src)
+{
+	return static_cast<unsigned int>(ReadUInt16(src)) | (static_cast<unsigned int>(ReadUInt16(src + 2)) << 16);
+}
+
+/**
+ * Pack tile types two per byte, the first one in the low nibble.
+ *
+ * @return	False if any of the types cannot be stored, see NUM_PUZZLE_TYPES.
+ */
+static bool PackTypes(const std::vector<TilePiece::Type>& types, unsigned char* dest)
+{
+	for (int i = 0; i < static_cast<int>(types.size()); i++)
+	{
+		if (types[i] >= NUM_PUZZLE_TYPES)
+			return false;
+
+		dest[i / 2] |= static_cast<unsigned char>(types[i] << ((i % 2) * 4));
+	}
+
+	return true;
+}
+
+/**
+ * Unpack tile types packed with PackTypes().
+ *
+ * @return	False if any of the values is not a valid tile type.
+ */
+static bool UnpackTypes(const unsigned char* src, int count, std::vector<TilePiece::Type>& types)
+{
+	types.resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		int t = (src[i / 2] >> ((i % 2) * 4)) & 0x0f;
+		if (t >= NUM_PUZZLE_TYPES)
+			return false;
+
+		types[i] = static_cast<TilePiece::Type>(t);
+	}
+
+	return true;
+}
+
+/**
+ * Encode a puzzle into a record of GetRecordSize() bytes.
+ *
+ * @return	False if the puzzle has tiles which cannot be stored, i.e. junctions.
+ */
+static bool EncodePuzzle(const Puzzle& puzzle, unsigned char* record)
+{
+	int numCells = puzzle.numCols * puzzle.numRows;
+	std::fill(record, record + GetRecordSize(numCells), 0);
+
+	unsigned char* p = record;
+	if (!PackTypes(puzzle.tiles, p))
+		return false;
+	p += (numCells + 1) / 2;
+
+	*p++ = static_cast<unsigned char>(puzzle.queue.size());
+	if (!PackTypes(puzzle.queue, p))
+		return false;
+	p += Puzzle::MAX_QUEUE_SIZE / 2;
+
+	WriteUInt16(p, puzzle.targetScore);
+	p += 2;
+
+	*p = static_cast<unsigned char>(puzzle.difficulty);
+
+	return true;
+}
+
+
+// ---- Class Implementation ----
+
+PuzzleDatabase::PuzzleDatabase()
+{
+
+}
+
+PuzzleDatabase::~PuzzleDatabase()
+{
+
+}
+
+juce::File PuzzleDatabase::GetDefaultFile()
+{
+	return juce::File::getSpecialLocation(juce::File::currentExecutableFile).getSiblingFile(DEFAULT_FILE_NAME);
+}
+
+bool PuzzleDatabase::Open(const juce::File& file)
+{
+	m_mappedFile = nullptr;
+	m_records = nullptr;
+	m_numPuzzles = 0;
+
+	if (!file.existsAsFile())
+		return false;
+
+	std::unique_ptr<juce::MemoryMappedFile> mappedFile(new juce::MemoryMappedFile(file, juce::MemoryMappedFile::readOnly));
+	const unsigned char* data = static_cast<const unsigned char*>(mappedFile->getData());
+	size_t size = mappedFile->getSize();
+	if ((data == nullptr) || (size < static_cast<size_t>(HEADER_SIZE)))
+		return false;
+
+	// Check the header.
+	int numCols = data[6];
+	int numRows = data[7];
+	int recordSize = ReadUInt16(data + 8);
+	unsigned int numPuzzles = ReadUInt32(data + 12);
+	if ((std::memcmp(data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) ||
+		(ReadUInt16(data + 4) != FILE_VERSION) ||
+		(recordSize != GetRecordSize(numCols * numRows)) ||
+		(size < HEADER_SIZE + (static_cast<size_t>(numPuzzles) * recordSize)))
+		return false;
+
+	m_mappedFile = std::move(mappedFile);
+	m_records = data + HEADER_SIZE;
+	m_numCols = numCols;
+	m_numRows = numRows;
+	m_recordSize = recordSize;
+	m_numPuzzles = static_cast<int>(numPuzzles);
+
+	return true;
+}
+
+int PuzzleDatabase::GetNumPuzzles() const
+{
+	return m_numPuzzles;
+}
+
+bool PuzzleDatabase::GetPuzzle(int index, Puzzle& puzzle) const
+{
+	if ((index < 0) || (index >= m_numPuzzles))
+		return false;
+
+	int numCells = m_numCols * m_numRows;
+	const unsigned char* p = m_records + (static_cast<size_t>(index) * m_recordSize);
+
+	puzzle.numCols = m_numCols;
+	puzzle.numRows = m_numRows;
+	if (!UnpackTypes(p, numCells, puzzle.tiles))
+		return false;
+
+	p += (numCells + 1) / 2;
+
+	int queueSize = *p++;
+	if ((queueSize > Puzzle::MAX_QUEUE_SIZE) || !UnpackTypes(p, queueSize, puzzle.queue))
+		return false;
+
+	p += Puzzle::MAX_QUEUE_SIZE / 2;
+
+	puzzle.targetScore = ReadUInt16(p);
+	p += 2;
+
+	puzzle.difficulty = *p;
+
+	// The Board needs exactly one starter tile.
+	int numStarters = 0;
+	for (TilePiece::Type t : puzzle.tiles)
+	{
+		if ((t >= TilePiece::TYPE_START_N) && (t <= TilePiece::TYPE_START_W))
+			numStarters++;
+	}
+
+	return (numStarters == 1);
+}
+
+bool PuzzleDatabase::Write(const juce::File& file, const std::vector<Puzzle>& puzzles)
+{
+	int numCols = puzzles.empty() ? 0 : puzzles.front().numCols;
+	int numRows = puzzles.empty() ? 0 : puzzles.front().numRows;
+	int recordSize = GetRecordSize(numCols * numRows);
+
+	std::vector<unsigned char> data(HEADER_SIZE + (puzzles.size() * recordSize), 0);
+	std::memcpy(data.data(), FILE_MAGIC, sizeof(FILE_MAGIC));
+	WriteUInt16(data.data() + 4, FILE_VERSION);
+	data[6] = static_cast<unsigned char>(numCols);
+	data[7] = static_cast<unsigned char>(numRows);
+	WriteUInt16(data.data() + 8, recordSize);
+	WriteUInt32(data.data() + 12, static_cast<unsigned int>(puzzles.size()));
+
+	for (size_t i = 0; i < puzzles.size(); i++)
+	{
+		jassert((puzzles[i].numCols == numCols) && (puzzles[i].numRows == numRows));
+		if (!EncodePuzzle(puzzles[i], data.data() + HEADER_SIZE + (i * recordSize)))
+			return false;
+	}
+
+	juce::FileOutputStream stream(file);
+	if (stream.failedToOpen())
+		return false;
+
+	stream.setPosition(0);
+	stream.truncate();
+
+	return stream.write(data.data(), data.size());
+}
+
+bool PuzzleDatabase::Generate(const juce::File& file, int numPuzzles, unsigned int firstSeed)
+{
+	if (numPuzzles <= 0)
+		return false;
+
+	WorkerPool workers;
+	std::vector<Puzzle> puzzles;
+	puzzles.reserve(numPuzzles);
+
+	// Different seeds can lead to the same puzzle, only keep the first one.
+	std::set<std::vector<unsigned char>> encodedPuzzles;
+	std::vector<unsigned char> record;
+
+	unsigned int seed = firstSeed;
+	int numFruitlessBatches = 0;
+	while (static_cast<int>(puzzles.size()) < numPuzzles)
+	{
+		if (numFruitlessBatches >= MAX_FRUITLESS_BATCHES)
+		{
+			juce::Logger::writeToLog(juce::String("Giving up, no new puzzles in the last ") + 
+				juce::String(MAX_FRUITLESS_BATCHES * CANDIDATES_PER_BATCH) + " candidates.");
+			return false;
+		}
+
+		std::vector<Puzzle> batch = PuzzleGenerator::GenerateBatch(seed, CANDIDATES_PER_BATCH, workers);
+		seed += CANDIDATES_PER_BATCH;
+
+		size_t numBefore = puzzles.size();
+		for (size_t i = 0; (i < batch.size()) && (static_cast<int>(puzzles.size()) < numPuzzles); i++)
+		{
+			record.assign(GetRecordSize(batch[i].numCols * batch[i].numRows), 0);
+			if (EncodePuzzle(batch[i], record.data()) && encodedPuzzles.insert(record).second)
+				puzzles.push_back(std::move(batch[i]));
+		}
+
+		numFruitlessBatches = (puzzles.size() == numBefore) ? (numFruitlessBatches + 1) : 0;
+
+		juce::Logger::writeToLog(juce::String("Generated ") + juce::String(static_cast<int>(puzzles.size())) + 
+			" of " + juce::String(numPuzzles) + " puzzles, from " + juce::String(static_cast<int>(seed - firstSeed)) + " candidates.");
+	}
+
+	return Write(file, puzzles);
+}
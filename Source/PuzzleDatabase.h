@@ -0,0 +1,131 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Puzzle.h"
+
+
+// ---- Class Definition ----
+
+/**
+ * Compact binary file of puzzles, which is memory-mapped rather than loaded, 
+ * so that opening it is instantaneous no matter how many puzzles it contains.
+ *
+ * The file starts with a 16 byte header: the magic "PDPZ", the format version (uint16), the number of 
+ * columns and rows (uint8 each), the size of each record in bytes (uint16), two reserved bytes, and the number 
+ * of puzzles (uint32). All puzzles follow as fixed-size records, so that any of them can be found right away:
+ * the pre-placed tiles packed two per byte, the queue length (uint8), the queue packed two pipes per byte 
+ * (Puzzle::MAX_QUEUE_SIZE pipes), the target score (uint16) and the difficulty rating (uint8).
+ * All numbers are little-endian.
+ */
+class PuzzleDatabase
+{
+public:
+	/**
+	 * Name of the puzzle file which is opened at startup, expected next to the executable.
+	 */
+	static const juce::String DEFAULT_FILE_NAME;
+
+	/**
+	 * Class constructor.
+	 */
+	PuzzleDatabase();
+
+	/**
+	 * Class destructor.
+	 */
+	~PuzzleDatabase();
+
+	/**
+	 * Get the location of the puzzle file which is opened at startup.
+	 */
+	static juce::File GetDefaultFile();
+
+	/**
+	 * Memory-map the given puzzle file. Any previously opened file is closed.
+	 *
+	 * @param file	The puzzle file to open.
+	 * @return	True if the file could be mapped, and is a valid puzzle file.
+	 */
+	bool Open(const juce::File& file);
+
+	/**
+	 * Get the number of puzzles in the opened file. 0 if no file is open.
+	 */
+	int GetNumPuzzles() const;
+
+	/**
+	 * Decode one of the puzzles in the opened file.
+	 *
+	 * @param index		Index of the puzzle, starting at 0.
+	 * @param puzzle	Returns the decoded puzzle.
+	 * @return	False if the index is out of range, or the record is corrupt.
+	 */
+	bool GetPuzzle(int index, Puzzle& puzzle) const;
+
+	/**
+	 * Write the given puzzles into a new puzzle file. All puzzles must have the same board size.
+	 * Puzzles have no junctions: tile types are stored in 4 bits, which only go up to TilePiece::TYPE_CROSS.
+	 *
+	 * @param file		The file to write. Overwritten if it exists.
+	 * @param puzzles	The puzzles to store.
+	 * @return	True if the file was written successfully. False if any puzzle has junctions.
+	 */
+	static bool Write(const juce::File& file, const std::vector<Puzzle>& puzzles);
+
+	/**
+	 * Generate a puzzle file, using all CPU cores. Progress is written to the log.
+	 *
+	 * @param file			The file to write. Overwritten if it exists.
+	 * @param numPuzzles	Number of puzzles to generate, at least 1.
+	 * @param firstSeed		Seed of the first candidate, see PuzzleGenerator::Generate().
+	 * @return	True if the file was written successfully. False if numPuzzles is out of range, 
+	 *			or if the generator ran out of different puzzles before reaching it.
+	 */
+	static bool Generate(const juce::File& file, int numPuzzles, unsigned int firstSeed = 1);
+
+private:
+	std::unique_ptr<juce::MemoryMappedFile> m_mappedFile;
+
+	/**
+	 * Start of the first record within m_mappedFile.
+	 */
+	const unsigned char* m_records = nullptr;
+
+	int m_numPuzzles = 0;
+	int m_numCols = 0;
+	int m_numRows = 0;
+	int m_recordSize = 0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PuzzleDatabase)
+};
@@ -34,17 +34,17 @@ SOFTWARE.
 
 // ---- Class Implementation ----
 
-Queue::Queue(int size)
+Queue::Queue(int size, Randomizer* rand)
+	: m_randomizer(rand)
 {
+	if (m_randomizer == nullptr)
+		m_randomizer = Randomizer::GetInstance();
+
 	m_buff.reserve(size);
-	Randomizer* rand = Randomizer::GetInstance();
 
 	// Fill initial queue with random tiles, of any type between VERTICAL and CROSS.
 	for (int i = 0; i < size; ++i)
-	{
-		TilePiece::Type t(static_cast<TilePiece::Type>(rand->GetWithinRange(TilePiece::TYPE_VERTICAL, TilePiece::TYPE_CROSS)));
-		m_buff.push_back(dynamic_cast<Pipe*>(TilePiece::CreateTile(t)));
-	}
+		m_buff.push_back(CreateNextTile());
 
 	// This will move with every Pop.
 	m_readPos = 0;
@@ -59,18 +59,53 @@ Queue::~Queue()
 
 void Queue::Reset()
 {
-	Randomizer* rand = Randomizer::GetInstance();
+	m_sequencePos = 0;
+
 	for (int i = 0; i < m_buff.size(); ++i)
 	{
 		delete m_buff[i];
-
-		TilePiece::Type t(static_cast<TilePiece::Type>(rand->GetWithinRange(TilePiece::TYPE_VERTICAL, TilePiece::TYPE_CROSS)));
-		m_buff[i] = dynamic_cast<Pipe*>(TilePiece::CreateTile(t));
+		m_buff[i] = CreateNextTile();
 	}
 
 	m_readPos = 0;
 }
 
+void Queue::SetSequence(const std::vector<TilePiece::Type>& sequence)
+{
+	m_sequence = sequence;
+
+	Reset();
+}
+
+bool Queue::IsEmpty() const
+{
+	return (GetTile(0) == nullptr);
+}
+
+void Queue::SetBranchingPipes(bool branching)
+{
+	m_branchingPipes = branching;
+}
+
+Pipe* Queue::CreateNextTile()
+{
+	TilePiece::Type t(TilePiece::TYPE_NONE);
+	if (m_sequence.empty())
+	{
+		TilePiece::Type lastType(m_branchingPipes ? TilePiece::TYPE_SPLITTER : TilePiece::TYPE_CROSS);
+		t = static_cast<TilePiece::Type>(m_randomizer->GetWithinRange(TilePiece::TYPE_VERTICAL, lastType));
+	}
+
+	else if (m_sequencePos < static_cast<int>(m_sequence.size()))
+		t = m_sequence[m_sequencePos++];
+
+	// Fixed sequence has run out, leave a gap in the queue.
+	if (t == TilePiece::TYPE_NONE)
+		return nullptr;
+
+	return dynamic_cast<Pipe*>(TilePiece::CreateTile(t, m_randomizer));
+}
+
 int Queue::GetSize() const
 {
 	return static_cast<int>(m_buff.size());
@@ -85,21 +120,23 @@ Pipe* Queue::GetTile(int pos) const
 
 TilePiece::Type Queue::GetTileType(int pos) const
 {
-	int idx = (m_readPos + pos) % m_buff.size();
+	Pipe* tile = GetTile(pos);
+	if (tile == nullptr)
+		return TilePiece::TYPE_NONE;
 
-	return m_buff[idx]->GetType();
+	return tile->GetType();
 }
 
 TilePiece::Type Queue::Pop()
 {
-	TilePiece::Type currentType(m_buff[m_readPos]->GetType());
+	if (IsEmpty())
+		return TilePiece::TYPE_NONE;
 
-	// Randomize type of m_buff[m_readPos]
-	Randomizer* rand = Randomizer::GetInstance();
-	TilePiece::Type t(static_cast<TilePiece::Type>(rand->GetWithinRange(TilePiece::TYPE_VERTICAL, TilePiece::TYPE_CROSS)));
+	TilePiece::Type currentType(m_buff[m_readPos]->GetType());
 
+	// Replace m_buff[m_readPos] with a new random pipe, or the next one of the sequence.
 	delete m_buff[m_readPos];
-	m_buff[m_readPos] = dynamic_cast<Pipe*>(TilePiece::CreateTile(t));
+	m_buff[m_readPos] = CreateNextTile();
 
 	// Move read position
 	m_readPos = (m_readPos + 1) % m_buff.size();
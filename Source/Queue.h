@@ -34,16 +34,28 @@ SOFTWARE.
 #include <vector>
 
 
+// ---- Forward declarations ----
+
+class Randomizer;
+
+
 // ---- Class Definition ----
 
 /**
  * Class which represents the pipe queue. Pipe tiles can be conceptually popped 
  * from the end of the queue, which will generate a new random pipe at the start of the queue.
+ * Alternatively, the queue can hand out a fixed sequence of pipes, see SetSequence().
  */
 class Queue
 {
 public:
-	Queue(int size);
+	/**
+	 * Class constructor.
+	 *
+	 * @param size	Number of pipes visible in the queue.
+	 * @param rand	Randomizer used to generate new pipes. If null, the Randomizer singleton is used.
+	 */
+	Queue(int size, Randomizer* rand = nullptr);
 
 	~Queue();
 
@@ -51,13 +63,54 @@ public:
 
 	int GetSize() const;
 
+	/**
+	 * Get the pipe at the given position in the queue, where 0 is the next one to be popped.
+	 *
+	 * @return	The pipe, or null if a fixed sequence has run out before that position.
+	 */
 	Pipe* GetTile(int pos) const;
 
+	/**
+	 * Get the type of the pipe at the given position in the queue, where 0 is the next one to be popped.
+	 *
+	 * @return	The pipe's type, or TYPE_NONE if a fixed sequence has run out before that position.
+	 */
 	TilePiece::Type GetTileType(int pos) const;
 
+	/**
+	 * Take the next pipe out of the queue.
+	 *
+	 * @return	The pipe's type, or TYPE_NONE if a fixed sequence has run out.
+	 */
 	TilePiece::Type Pop();
 
+	/**
+	 * Hand out the given pipes in order, instead of random ones. Once they have all been popped, 
+	 * the queue remains empty. This also resets the queue.
+	 *
+	 * @param sequence	Types of the pipes to hand out. If empty, the queue goes back to random pipes.
+	 */
+	void SetSequence(const std::vector<TilePiece::Type>& sequence);
+
+	/**
+	 * Check whether all pipes of a fixed sequence have been popped.
+	 */
+	bool IsEmpty() const;
+
+	/**
+	 * Include T-junctions and splitters among the random pipes, see Junction.
+	 * Takes effect as new pipes join the queue.
+	 */
+	void SetBranchingPipes(bool branching);
+
 protected:
+	/**
+	 * Create the pipe which joins the queue next: a random one, or the next one of the fixed sequence.
+	 *
+	 * @return	The new pipe, or null if the fixed sequence has run out.
+	 */
+	Pipe* CreateNextTile();
+
 	/**
 	 * Underlying vector containing the Pipe objects.
 	 */
@@ -67,4 +120,24 @@ protected:
 	 * Index pointing to the end of the queue.
 	 */
 	int m_readPos;
+
+	/**
+	 * Randomizer used to generate new pipes.
+	 */
+	Randomizer* m_randomizer;
+
+	/**
+	 * Fixed sequence of pipes to hand out. Empty if pipes are random.
+	 */
+	std::vector<TilePiece::Type> m_sequence;
+
+	/**
+	 * Index of the next pipe of m_sequence to join the queue.
+	 */
+	int m_sequencePos = 0;
+
+	/**
+	 * If true, random pipes may also be junctions, see SetBranchingPipes().
+	 */
+	bool m_branchingPipes = false;
 };
\ No newline at end of file
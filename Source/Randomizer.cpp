@@ -53,9 +53,16 @@ Randomizer::Randomizer()
 
 }
 
+Randomizer::Randomizer(unsigned int seed)
+	: m_mt(seed)
+{
+
+}
+
 Randomizer::~Randomizer()
 {
-	m_singleton = nullptr;
+	if (m_singleton == this)
+		m_singleton = nullptr;
 }
 
 Randomizer* Randomizer::GetInstance()
@@ -79,3 +86,11 @@ int Randomizer::GetWithinRange(int min, int max)
 	int ret = (m_distroMap[r](m_mt));
 	return ret;
 }
+
+void Randomizer::SetSeed(unsigned int seed)
+{
+	m_mt.seed(seed);
+
+	// Cached distributions may hold on to state from the previous sequence.
+	m_distroMap.clear();
+}
\ No newline at end of file
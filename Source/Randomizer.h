@@ -42,8 +42,20 @@ SOFTWARE.
 class Randomizer
 {
 public:
+	/**
+	 * Class constructor for the singleton object, seeded from std::random_device.
+	 */
 	Randomizer();
 
+	/**
+	 * Class constructor for an independent Randomizer, which is not registered as the singleton. 
+	 * Objects owning one of these, rather than using GetInstance(), can be used on any thread,
+	 * and produce the same sequence of tiles every time they are given the same seed.
+	 *
+	 * @param seed	Seed for the random number generator.
+	 */
+	Randomizer(unsigned int seed);
+
 	~Randomizer();
 
 	/**
@@ -62,6 +74,13 @@ public:
 	 */
 	int GetWithinRange(int min, int max);
 
+	/**
+	 * Restart the sequence of random numbers from the given seed.
+	 *
+	 * @param seed	Seed for the random number generator.
+	 */
+	void SetSeed(unsigned int seed);
+
 protected:
 	/**
 	 * The one and only instance of Randomizer.
@@ -0,0 +1,171 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "RenderSnapshot.h"
+#include "TilePiece.h"
+#include "Board.h"
+#include "Queue.h"
+
+
+// ---- Class Implementation ----
+
+void RenderSnapshot::CaptureTiles(const Board& board, const Queue& pipeQueue, juce::Rectangle<int> requestedRegion)
+{
+	numCols = board.GetNumCols();
+	numRows = board.GetNumRows();
+
+	juce::Rectangle<int> boardCells(0, 0, numCols, numRows);
+	region = requestedRegion.isEmpty() ? boardCells : requestedRegion.getIntersection(boardCells);
+	tiles.resize(region.getWidth() * region.getHeight());
+
+	for (int row = region.getY(); row < region.getBottom(); row++)
+	{
+		for (int col = region.getX(); col < region.getRight(); col++)
+			CopyTile(board.GetTile(col, row), tiles[GetTileIndex(col, row)]);
+	}
+
+	// The oozing pipe is needed for the spill, even when it is out of sight.
+	int oozingCol, oozingRow;
+	board.GetOozingCoords(oozingCol, oozingRow);
+	oozingTileIdx = -1;
+	if ((board.GetOozingTile() != nullptr) && boardCells.contains(oozingCol, oozingRow))
+	{
+		oozingTileIdx = oozingCol + (oozingRow * numCols);
+		CopyTile(board.GetOozingTile(), oozingTile);
+	}
+	else
+		oozingTile = nullptr;
+
+	queueTiles.resize(pipeQueue.GetSize());
+	for (int i = 0; i < pipeQueue.GetSize(); i++)
+	{
+		TilePiece* tile = pipeQueue.GetTile(i);
+		if (tile == nullptr)
+			queueTiles[i] = nullptr;
+		else
+			CopyTile(tile, queueTiles[i]);
+	}
+
+	score = board.GetScoreValue();
+	numBombs = board.GetNumBombs();
+	percentUntilFreeBomb = board.GetPercentUntilFreeBomb();
+
+	situation.Capture(board, pipeQueue);
+}
+
+void RenderSnapshot::CaptureProjection(const Board& board, int oozePerPump, int ticksUntilPump)
+{
+	projectedPipes.clear();
+	projectedSpillIdx = -1;
+
+	// Sources other than the first may still be holding back their ooze.
+	int ticksUntilRelease = ticksUntilPump;
+	if (board.GetNumFronts() > 0)
+		ticksUntilRelease += board.GetPumpsUntilRelease(0);
+
+	int numProjected = board.GetNumProjectedPipes();
+	for (int i = 0; i < numProjected; i++)
+	{
+		int col, row;
+		board.GetProjectedPipe(i, col, row);
+		if (region.contains(col, row))
+		{
+			int ticks = ticksUntilRelease + ((board.GetOozeUntilProjectedPipe(i) + oozePerPump - 1) / oozePerPump);
+			projectedPipes.push_back(std::make_pair(col + (row * numCols), ticks));
+		}
+	}
+
+	int spillCol, spillRow;
+	if (board.GetProjectedSpill(spillCol, spillRow, projectedSpillDir))
+	{
+		projectedSpillIdx = spillCol + (spillRow * numCols);
+		projectedSpillTicks = ticksUntilRelease + ((board.GetOozeUntilProjectedPipe(numProjected) + oozePerPump - 1) / oozePerPump);
+	}
+}
+
+const TilePiece* RenderSnapshot::GetTile(int col, int row) const
+{
+	int idx = GetTileIndex(col, row);
+	if (idx < 0)
+		return nullptr;
+
+	return tiles[idx].get();
+}
+
+int RenderSnapshot::GetTileIndex(int col, int row) const
+{
+	if (!region.contains(col, row))
+		return -1;
+
+	return (col - region.getX()) + ((row - region.getY()) * region.getWidth());
+}
+
+void RenderSnapshot::CopyTile(const TilePiece* source, std::unique_ptr<TilePiece>& target)
+{
+	const Cross* sourceCross = dynamic_cast<const Cross*>(source);
+	const Junction* sourceJunction = dynamic_cast<const Junction*>(source);
+	const Pipe* sourcePipe = dynamic_cast<const Pipe*>(source);
+
+	if (sourceCross != nullptr)
+	{
+		Cross* targetCross = dynamic_cast<Cross*>(target.get());
+		if (targetCross != nullptr)
+			*targetCross = *sourceCross;
+		else
+			target.reset(new Cross(*sourceCross));
+	}
+
+	else if (sourceJunction != nullptr)
+	{
+		Junction* targetJunction = dynamic_cast<Junction*>(target.get());
+		if (targetJunction != nullptr)
+			*targetJunction = *sourceJunction;
+		else
+			target.reset(new Junction(*sourceJunction));
+	}
+
+	else if (sourcePipe != nullptr)
+	{
+		Pipe* targetPipe = dynamic_cast<Pipe*>(target.get());
+		if ((targetPipe != nullptr) && (dynamic_cast<Cross*>(targetPipe) == nullptr) && (dynamic_cast<Junction*>(targetPipe) == nullptr))
+			*targetPipe = *sourcePipe;
+		else
+			target.reset(new Pipe(*sourcePipe));
+	}
+
+	else
+	{
+		if ((target == nullptr) || (dynamic_cast<Pipe*>(target.get()) != nullptr))
+			target.reset(new TilePiece(*source));
+		else
+			*target = *source;
+	}
+}
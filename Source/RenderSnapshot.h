@@ -0,0 +1,181 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Controller.h"
+#include "Planner.h"
+
+
+// ---- Forward declarations ----
+
+class TilePiece;
+
+
+// ---- Class Definition ----
+
+/**
+ * Copy of everything the MainComponent needs to draw one frame of the game, published by the 
+ * SimulationThread after every change. Once published, a snapshot is never modified again until 
+ * the GUI is done with it (see TripleBuffer), so painting never has to wait for the simulation, 
+ * and never sees a game state which is only half updated.
+ */
+struct RenderSnapshot
+{
+	int numCols = 0;
+	int numRows = 0;
+
+	/**
+	 * Columns and rows of the board whose tiles were copied into this snapshot. 
+	 * On large boards, only the cells on display are copied, see SimulationThread::SetRegion().
+	 */
+	juce::Rectangle<int> region;
+
+	/**
+	 * Copies of the tiles within the region, see GetTileIndex().
+	 */
+	std::vector<std::unique_ptr<TilePiece>> tiles;
+
+	/**
+	 * Copies of the tiles in the queue, starting with the next one. Null where a puzzle ran out of pipes.
+	 */
+	std::vector<std::unique_ptr<TilePiece>> queueTiles;
+
+	/**
+	 * Position on the board of the pipe the ooze is flowing through, i.e. col + (row * numCols). -1 if none.
+	 */
+	int oozingTileIdx = -1;
+
+	/**
+	 * Copy of the pipe the ooze is flowing through, even if it lies outside the region. Null if none.
+	 */
+	std::unique_ptr<TilePiece> oozingTile;
+
+	int score = 0;
+	int numBombs = 0;
+	int percentUntilFreeBomb = 0;
+
+	/**
+	 * Ticks left until the ooze starts flowing, and the full countdown of the round.
+	 */
+	int countdown = 0;
+	int roundCountdown = 1;
+
+	Controller::GameState state = Controller::STATE_RUNNING;
+
+	/**
+	 * Incremented at the start of every round, so that the end of each round can be told apart.
+	 */
+	int roundNumber = 0;
+
+	/**
+	 * Number of ticks since the ooze spilled. Only valid in STATE_STOPPED.
+	 */
+	int ticksSinceStopped = 0;
+
+	/**
+	 * Score of the round. Only valid in STATE_STOPPED.
+	 */
+	Controller::ScoreDetails scoreDetails = {};
+
+	bool fastForward = false;
+
+	/**
+	 * True while nothing the player does can keep the ooze from spilling any more, see Controller::IsSpillInevitable().
+	 * The fast-forward button then skips to the results.
+	 */
+	bool spillInevitable = false;
+	bool puzzleMode = false;
+	int difficultyLevel = 1;
+	int puzzleNumber = 0;
+	int scoreToAdvance = 0;
+
+	/**
+	 * Game situation, as seen by the AutoPlayer.
+	 */
+	Planner::Situation situation;
+
+	/**
+	 * Pipes within the region which the ooze is going to flow through next (see Board::GetNumProjectedPipes()), 
+	 * as their position on the board, i.e. col + (row * numCols), and the number of ticks until the ooze gets there.
+	 */
+	std::vector<std::pair<int, int>> projectedPipes;
+
+	/**
+	 * Position of the pipe the ooze is projected to spill from, the opening it spills through, and the number 
+	 * of ticks until then. The position is -1 if the ooze is going to fork instead, or has spilled already.
+	 */
+	int projectedSpillIdx = -1;
+	Pipe::Direction projectedSpillDir = Pipe::DIR_NONE;
+	int projectedSpillTicks = 0;
+
+	/**
+	 * Copy the current contents of the given Board and Queue into this snapshot.
+	 * Tile objects are reused wherever they are of the same kind, so this does not allocate
+	 * memory once the snapshot has been filled for the first time.
+	 *
+	 * @param board		The board to copy.
+	 * @param pipeQueue	The queue to copy.
+	 * @param requestedRegion	Columns and rows of the board to copy. If empty, the whole board is copied.
+	 */
+	void CaptureTiles(const Board& board, const Queue& pipeQueue, juce::Rectangle<int> requestedRegion = juce::Rectangle<int>());
+
+	/**
+	 * Copy the path of the ooze from the given Board into this snapshot, with arrival times in ticks.
+	 * Must be called after CaptureTiles(), as only the pipes within the region are copied.
+	 *
+	 * @param board			The board to copy.
+	 * @param oozePerPump	Ooze pumped at every tick, see Controller::GetCurrentOozePerPump().
+	 * @param ticksUntilPump	Ticks left until the ooze starts flowing, see countdown.
+	 */
+	void CaptureProjection(const Board& board, int oozePerPump, int ticksUntilPump);
+
+	/**
+	 * Get the tile on the board at the given position.
+	 *
+	 * @return	The tile, or null if the position lies outside the region.
+	 */
+	const TilePiece* GetTile(int col, int row) const;
+
+	/**
+	 * Get the index within tiles of the tile at the given position on the board.
+	 *
+	 * @return	(col - region.getX()) + ((row - region.getY()) * region.getWidth()), or -1 if the position lies outside the region.
+	 */
+	int GetTileIndex(int col, int row) const;
+
+	/**
+	 * Make target a copy of the given tile, of the same kind.
+	 * If target already holds a tile of the same kind, it is reused instead of allocating a new one.
+	 */
+	static void CopyTile(const TilePiece* source, std::unique_ptr<TilePiece>& target);
+};
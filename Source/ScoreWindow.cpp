@@ -31,6 +31,7 @@ SOFTWARE.
 #include <JuceHeader.h>
 #include "ScoreWindow.h"
 #include "MainComponent.h"
+#include "TextCache.h"
 
 
 // ---- Helper types and constants ----
@@ -57,7 +58,8 @@ ScoreWindow* ScoreWindow::CreateScoreWindow(Controller::ScoreDetails details)
 {
 	ScoreWindow* ret(nullptr);
 
-	if (details.advance)
+	// Puzzle scores don't make it into the high score list.
+	if (details.advance || details.puzzle)
 		ret = new AdvanceWindow(details);
 	else
 		ret = new HighScoreWindow(details);
@@ -76,7 +78,12 @@ void ScoreWindow::paint(juce::Graphics& g)
 
 	juce::String messageText("You Lose! :(\n");
 	juce::String buttonText("Restart Game");
-	if (m_details.advance)
+	if (m_details.puzzle)
+	{
+		messageText = m_details.advance ? juce::String("Puzzle Solved!\n") : juce::String("Not Quite! :(\n");
+		buttonText = m_details.advance ? juce::String("Next Puzzle") : juce::String("Retry Puzzle");
+	}
+	else if (m_details.advance)
 	{
 		messageText = juce::String("You Leveled Up!\n");
 		buttonText = juce::String("Continue to Next Level");
@@ -162,7 +169,10 @@ void AdvanceWindow::paint(juce::Graphics& g)
 // --- HighScoreWindow ---
 
 HighScoreWindow::HighScoreWindow(Controller::ScoreDetails details)
-	: ScoreWindow(details)
+	:	ScoreWindow(details),
+		m_titleFont("consolas", 32.0f, juce::Font::bold),
+		m_boldRowFont("consolas", 25.0f, juce::Font::bold), // TODO fontsize const
+		m_rowFont("consolas", 25.0f, juce::Font::plain)
 {
 	Controller* controller = Controller::GetInstance();
 	if (controller != nullptr)
@@ -214,7 +224,7 @@ void HighScoreWindow::RefreshCachedScore(std::vector<scoreEntry>& scoreHash)
 			m_nameEditor->setCaretVisible(true);
 			juce::String filter("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890.-");
 			m_nameEditor->setInputRestrictions(8, filter);
-			m_nameEditor->setFont(juce::Font("consolas", 25.0f, juce::Font::bold)); // TODO fontsize const
+			m_nameEditor->setFont(m_boldRowFont);
 			m_nameEditor->setColour(juce::TextEditor::backgroundColourId, juce::Colours::black);
 			m_nameEditor->setColour(juce::TextEditor::textColourId, juce::Colours::yellow);
 			m_nameEditor->setColour(juce::TextEditor::outlineColourId, juce::Colours::yellow);
@@ -258,32 +268,23 @@ void HighScoreWindow::resized()
 		m_okButtonRect = juce::Rectangle<int>(tileSize + 5, buttonVPos, rectWidth - 10, BUTTON_HEIGHT);
 		m_quitButtonRect = juce::Rectangle<int>(tileSize + 5, buttonVPos + BUTTON_HEIGHT + 5, rectWidth - 10, BUTTON_HEIGHT);
 	}
+
+	LayoutTable();
 }
 
-void HighScoreWindow::paint(juce::Graphics& g)
+void HighScoreWindow::LayoutTable()
 {
-	// Draws the player score breakdown panel.
-	ScoreWindow::paint(g);
+	m_tableText.clear();
 
-	int tileSize(0);
 	MainComponent* mainComp = dynamic_cast<MainComponent*>(getParentComponent());
-	if (mainComp != nullptr)
-		tileSize = mainComp->GetTileSize();
+	if (mainComp == nullptr)
+		return;
 
+	int tileSize(mainComp->GetTileSize());
 	int rectWidth = (getLocalBounds().getWidth() - 320) - (tileSize * 2);
 
-	// High-score box background colour
-	g.setColour(juce::Colour(27, 27, 27));
-	g.fillRect(juce::Rectangle<int>(tileSize + 320 - 2, tileSize, rectWidth, getLocalBounds().getHeight() - (tileSize * 2)));
-
-	// Frame
-	g.setColour(juce::Colours::black);
-	g.drawRect(juce::Rectangle<int>(tileSize + 320 - 2, tileSize, rectWidth, getLocalBounds().getHeight() - (tileSize * 2)), 4);
-
 	// Title
-	g.setColour(juce::Colours::grey);
-	g.setFont(juce::Font("consolas", 32.0f, juce::Font::bold));
-	g.drawText("High Score", juce::Rectangle<int>(tileSize + 320 - 2, tileSize + 10, rectWidth, 60), juce::Justification::centred);
+	TextCache::AddLine(m_tableText, m_titleFont, "High Score", juce::Rectangle<int>(tileSize + 320 - 2, tileSize + 10, rectWidth, 60), juce::Justification::centred);
 
 	int vPos = tileSize + 80;
 	int hPosName = tileSize + 360;
@@ -293,34 +294,54 @@ void HighScoreWindow::paint(juce::Graphics& g)
 	int nameWidth = 100;
 	int scoreWidth = 100;
 	int dateWidth = 130;
-	float fontSize = 25.0f; // TODO const
-	g.setFont(juce::Font("consolas", 25.0f, juce::Font::plain));
 
 	for (int i = 0; i < m_nameCache.size(); i++)
 	{
-		// Draw player name, OR position the TextEditor used to enter the players name
-		g.setFont(juce::Font("consolas", fontSize, juce::Font::bold));
+		// Lay out player name, OR position the TextEditor used to enter the players name
+		juce::Rectangle<int> nameRect(hPosName, vPos, nameWidth, fieldHeight);
 		if (m_nameCache[i] == "placeholder")
-			m_nameEditor->setBounds(juce::Rectangle<int>(hPosName, vPos, nameWidth, fieldHeight));
+		{
+			if (m_nameEditor)
+				m_nameEditor->setBounds(nameRect);
+		}
 		else
-			g.drawText(m_nameCache[i], juce::Rectangle<int>(hPosName, vPos, nameWidth, fieldHeight), juce::Justification::left, false);
+			TextCache::AddLine(m_tableText, m_boldRowFont, m_nameCache[i], nameRect, juce::Justification::left);
 
-		// Frame around name
-		//g.drawRect(juce::Rectangle<int>(hPosName, vPos, nameWidth, fieldHeight));
+		// Score
+		TextCache::AddLine(m_tableText, m_boldRowFont, juce::String(m_scoreCache[i]), juce::Rectangle<int>(hPosScore, vPos, scoreWidth, fieldHeight), juce::Justification::right);
 
-		// Draw score
-		g.drawText(juce::String(m_scoreCache[i]), juce::Rectangle<int>(hPosScore, vPos, scoreWidth, fieldHeight), juce::Justification::right, false);
-		//g.drawRect(juce::Rectangle<int>(hPosScore, vPos, scoreWidth, fieldHeight));
-
-		// Draw date
-		g.setFont(juce::Font("consolas", fontSize, juce::Font::plain));
-		g.drawText(juce::String(m_dateCache[i]), juce::Rectangle<int>(hPosDate, vPos, dateWidth, fieldHeight), juce::Justification::right, false);
-		//g.drawRect(juce::Rectangle<int>(hPosDate, vPos, dateWidth, fieldHeight));
+		// Date
+		TextCache::AddLine(m_tableText, m_rowFont, m_dateCache[i], juce::Rectangle<int>(hPosDate, vPos, dateWidth, fieldHeight), juce::Justification::right);
 
 		vPos += fieldHeight + 2;
 	}
 }
 
+void HighScoreWindow::paint(juce::Graphics& g)
+{
+	// Draws the player score breakdown panel.
+	ScoreWindow::paint(g);
+
+	int tileSize(0);
+	MainComponent* mainComp = dynamic_cast<MainComponent*>(getParentComponent());
+	if (mainComp != nullptr)
+		tileSize = mainComp->GetTileSize();
+
+	int rectWidth = (getLocalBounds().getWidth() - 320) - (tileSize * 2);
+
+	// High-score box background colour
+	g.setColour(juce::Colour(27, 27, 27));
+	g.fillRect(juce::Rectangle<int>(tileSize + 320 - 2, tileSize, rectWidth, getLocalBounds().getHeight() - (tileSize * 2)));
+
+	// Frame
+	g.setColour(juce::Colours::black);
+	g.drawRect(juce::Rectangle<int>(tileSize + 320 - 2, tileSize, rectWidth, getLocalBounds().getHeight() - (tileSize * 2)), 4);
+
+	// Title and rows were laid out by LayoutTable() already.
+	g.setColour(juce::Colours::grey);
+	m_tableText.draw(g);
+}
+
 void HighScoreWindow::textEditorTextChanged(juce::TextEditor& editor)
 {
 	editor.setText(editor.getText().toUpperCase(), false /* do not trigger change signal */);
@@ -371,6 +392,7 @@ void HighScoreWindow::ExitTextEditor(juce::TextEditor& editor)
 	// displayed as normal text like the rest of the entries.
 	m_nameEditor.reset(nullptr);
 
+	LayoutTable();
 	repaint();
 }
 
@@ -181,6 +181,12 @@ protected:
 	 */
 	void ExitTextEditor(juce::TextEditor& editor);
 
+	/**
+	 * Lay out the high score table into m_tableText, and position the name field, if any.
+	 * Called whenever the window's size or the cached scores change, so that paint() only needs to draw.
+	 */
+	void LayoutTable();
+
 	/**
 	 * Class constructor.
 	 */
@@ -209,6 +215,18 @@ protected:
 	 */
 	std::vector<juce::String> m_dateCache;
 
+	/**
+	 * Fonts of the table's title, of names and scores, and of dates.
+	 */
+	juce::Font m_titleFont;
+	juce::Font m_boldRowFont;
+	juce::Font m_rowFont;
+
+	/**
+	 * Title and rows of the high score table, laid out by LayoutTable().
+	 */
+	juce::GlyphArrangement m_tableText;
+
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HighScoreWindow)
 };
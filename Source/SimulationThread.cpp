@@ -0,0 +1,417 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "SimulationThread.h"
+#include "TilePiece.h"
+#include "Board.h"
+#include "Queue.h"
+
+
+// ---- Helper types and constants ----
+
+const int SimulationThread::TICK_INTERVAL(60);
+
+/**
+ * Max number of commands waiting to be carried out. Further commands are dropped.
+ */
+static const int COMMAND_QUEUE_SIZE(64);
+
+/**
+ * If the game clock falls behind by more than this many ticks (e.g. after the machine was suspended),
+ * the missed ticks are skipped instead of being caught up with.
+ */
+static const int MAX_TICKS_BEHIND(5);
+
+/**
+ * Number of ticks during which further placements are ignored, after placing a pipe.
+ */
+static const int TICKS_INTERACTION_BLOCKED(5);
+
+/**
+ * Number of pipes the ooze fills per tick while skipping to the results. The remaining path may run 
+ * through thousands of pipes on an endless board, so the skip is spread over several ticks.
+ */
+static const int SKIP_PIPES_PER_TICK(256);
+
+
+// ---- Class Implementation ----
+
+SimulationThread::SimulationThread()
+	: juce::Thread("SimulationThread"),
+	m_commandFifo(COMMAND_QUEUE_SIZE)
+{
+	m_commands.resize(COMMAND_QUEUE_SIZE);
+
+	// Reset the countdown to the start of the round
+	// (before ooze starts pumping out)
+	m_countDown = Controller::GetInstance()->GetCurrentCountdown();
+
+	// The thread is not running yet, so it is safe to publish from here.
+	PublishSnapshot();
+}
+
+SimulationThread::~SimulationThread()
+{
+	stopThread(2000);
+}
+
+void SimulationThread::run()
+{
+	double nextTickTime = juce::Time::getMillisecondCounterHiRes() + TICK_INTERVAL;
+
+	while (!threadShouldExit())
+	{
+		bool changed = ProcessCommands();
+
+		double now = juce::Time::getMillisecondCounterHiRes();
+		if (now >= nextTickTime)
+		{
+			changed |= Tick();
+
+			// Tick at a steady pace, no matter how long each tick took.
+			nextTickTime += TICK_INTERVAL;
+			if (now - nextTickTime > MAX_TICKS_BEHIND * TICK_INTERVAL)
+				nextTickTime = now + TICK_INTERVAL;
+		}
+
+		if (changed)
+			PublishSnapshot();
+
+		// Sleep until the next tick is due, unless PushCommand() wakes us up earlier.
+		int waitTime = static_cast<int>(nextTickTime - juce::Time::getMillisecondCounterHiRes());
+		if (waitTime > 0)
+			wait(waitTime);
+	}
+}
+
+bool SimulationThread::PlaceTile(int col, int row)
+{
+	Command command;
+	command.type = Command::TYPE_PLACE_TILE;
+	command.col = col;
+	command.row = row;
+
+	return PushCommand(command);
+}
+
+bool SimulationThread::ToggleFastForward()
+{
+	Command command;
+	command.type = Command::TYPE_TOGGLE_FAST_FORWARD;
+
+	return PushCommand(command);
+}
+
+bool SimulationThread::SkipToResults()
+{
+	Command command;
+	command.type = Command::TYPE_SKIP_TO_RESULTS;
+
+	return PushCommand(command);
+}
+
+bool SimulationThread::StartRound(Controller::Command cmd)
+{
+	Command command;
+	command.type = Command::TYPE_START_ROUND;
+	command.roundCommand = cmd;
+
+	return PushCommand(command);
+}
+
+bool SimulationThread::StartPuzzleMode(const juce::File& file)
+{
+	Command command;
+	command.type = Command::TYPE_START_PUZZLES;
+	command.file = file;
+
+	return PushCommand(command);
+}
+
+bool SimulationThread::LoadLevelConfig(const juce::File& file)
+{
+	Command command;
+	command.type = Command::TYPE_LOAD_LEVELS;
+	command.file = file;
+
+	return PushCommand(command);
+}
+
+bool SimulationThread::SetBoardSize(int numCols, int numRows, bool endless)
+{
+	Command command;
+	command.type = Command::TYPE_SET_BOARD_SIZE;
+	command.numCols = numCols;
+	command.numRows = numRows;
+	command.endless = endless;
+
+	return PushCommand(command);
+}
+
+bool SimulationThread::SetRule(Controller::Rule rule, int value)
+{
+	Command command;
+	command.type = Command::TYPE_SET_RULE;
+	command.rule = rule;
+	command.value = value;
+
+	return PushCommand(command);
+}
+
+bool SimulationThread::SetRegion(juce::Rectangle<int> region)
+{
+	Command command;
+	command.type = Command::TYPE_SET_REGION;
+	command.col = region.getX();
+	command.row = region.getY();
+	command.numCols = region.getWidth();
+	command.numRows = region.getHeight();
+
+	return PushCommand(command);
+}
+
+const RenderSnapshot& SimulationThread::AcquireSnapshot(bool* fresh)
+{
+	return m_snapshots.Acquire(fresh);
+}
+
+bool SimulationThread::PushCommand(const Command& command)
+{
+	int start1, size1, start2, size2;
+	m_commandFifo.prepareToWrite(1, start1, size1, start2, size2);
+	if ((size1 + size2) < 1)
+		return false;
+
+	m_commands[(size1 > 0) ? start1 : start2] = command;
+	m_commandFifo.finishedWrite(1);
+
+	notify();
+
+	return true;
+}
+
+bool SimulationThread::ProcessCommands()
+{
+	bool processed(false);
+
+	int numReady = m_commandFifo.getNumReady();
+	while (numReady > 0)
+	{
+		int start1, size1, start2, size2;
+		m_commandFifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+		for (int i = 0; i < size1; i++)
+			Execute(m_commands[start1 + i]);
+
+		for (int i = 0; i < size2; i++)
+			Execute(m_commands[start2 + i]);
+
+		m_commandFifo.finishedRead(size1 + size2);
+		processed = true;
+
+		numReady = m_commandFifo.getNumReady();
+	}
+
+	return processed;
+}
+
+void SimulationThread::Execute(const Command& command)
+{
+	Controller* controller(Controller::GetInstance());
+	bool interactive((controller->GetState() == Controller::STATE_RUNNING) && (m_blockInteraction == 0) && !m_skipping);
+
+	switch (command.type)
+	{
+		case Command::TYPE_PLACE_TILE:
+			{
+				// Nothing left to place, once the pipes of a puzzle have run out.
+				Board* board(controller->GetBoard());
+				if (!interactive || 
+					controller->GetQueue()->IsEmpty() ||
+					(board->GetPlacement(command.col, command.row) == Board::PLACEMENT_NONE))
+					break;
+
+				// Grab the next piece in the queue, and place it on the board.
+				Board::Placement placement = board->PlaceTile(command.col, command.row, controller->GetQueue()->Pop());
+
+				// Trigger approproate sound effect. Replacing pipes on the grid is explosive.
+				if (placement == Board::PLACEMENT_BOMB)
+					controller->QueueSound(Controller::SOUND_EXPLODE);
+				else
+					controller->QueueSound(Controller::SOUND_CLICK);
+
+				// To prevent accidental double-clicking disable actions for a few ticks.
+				m_blockInteraction += TICKS_INTERACTION_BLOCKED;
+			}
+			break;
+
+		case Command::TYPE_TOGGLE_FAST_FORWARD:
+			{
+				// This increases the ooze amount in GetCurrentOozePerPump().
+				if (interactive)
+					controller->SetFastForward(!controller->GetFastForward());
+			}
+			break;
+
+		case Command::TYPE_SKIP_TO_RESULTS:
+			{
+				// The round has to be decided already, as the player might have clicked just before a pipe got placed.
+				if ((controller->GetState() != Controller::STATE_RUNNING) ||
+					!controller->IsSpillInevitable(m_countDown, TICKS_INTERACTION_BLOCKED))
+					break;
+
+				// Tick() takes it from here, filling a slice of the remaining pipes at a time.
+				m_countDown = 0;
+				m_skipping = true;
+			}
+			break;
+
+		case Command::TYPE_START_ROUND:
+			Reset(command.roundCommand);
+			break;
+
+		case Command::TYPE_START_PUZZLES:
+			{
+				if (controller->StartPuzzleMode(command.file))
+					Reset(Controller::CMD_RESTART);
+			}
+			break;
+
+		case Command::TYPE_LOAD_LEVELS:
+			{
+				// The level settings are read on every tick, so they may only change on this thread.
+				if (controller->LoadLevelConfig(command.file))
+					Reset(Controller::CMD_RESTART);
+			}
+			break;
+
+		case Command::TYPE_SET_BOARD_SIZE:
+			{
+				controller->SetBoardSize(command.numCols, command.numRows, command.endless);
+				Reset(Controller::CMD_RESTART);
+			}
+			break;
+
+		case Command::TYPE_SET_RULE:
+			{
+				controller->SetRule(command.rule, command.value);
+				Reset(Controller::CMD_RESTART);
+			}
+			break;
+
+		case Command::TYPE_SET_REGION:
+			m_region = juce::Rectangle<int>(command.col, command.row, command.numCols, command.numRows);
+			break;
+
+		default:
+			break;
+	}
+}
+
+bool SimulationThread::Tick()
+{
+	Controller* controller(Controller::GetInstance());
+	bool changed(false);
+
+	if (controller->GetState() == Controller::STATE_RUNNING)
+	{
+		// When it reaches 0, clicks are enabled again.
+		if (m_blockInteraction > 0)
+			m_blockInteraction--;
+
+		// Countdown to start pumping ooze.
+		if (m_countDown > 0)
+		{
+			// If fast-forward button is currently toggled on, decrease countdown faster.
+			if (controller->GetFastForward())
+				m_countDown -= 5;
+
+			// Puzzles give the player all the time they need to place the pipes.
+			else if (!controller->IsPuzzleMode() || controller->GetQueue()->IsEmpty())
+				m_countDown -= 1;
+		}
+
+		// Skipping to the results, the ooze fills whole pipes until it spills. The player can no longer 
+		// change the outcome, so this ends the round with the same score as pumping at the regular pace.
+		else if (m_skipping)
+		{
+			for (int i = 0; (i < SKIP_PIPES_PER_TICK) && (controller->GetState() == Controller::STATE_RUNNING); i++)
+				controller->Pump(true);
+		}
+
+		// Pump more ooze, until it spills.
+		else
+			controller->Pump();
+
+		changed = true;
+	}
+
+	// Explosions fade out tick by tick, even after the spill.
+	if (controller->GetBoard()->PopExplosions())
+		changed = true;
+
+	return changed;
+}
+
+void SimulationThread::Reset(Controller::Command cmd)
+{
+	Controller* controller(Controller::GetInstance());
+	controller->Reset(cmd);
+
+	// Countdown to ooze pumping.
+	m_countDown = controller->GetCurrentCountdown();
+	m_blockInteraction = 0;
+	m_skipping = false;
+	m_roundNumber++;
+}
+
+void SimulationThread::PublishSnapshot()
+{
+	Controller* controller(Controller::GetInstance());
+	RenderSnapshot& snapshot = m_snapshots.GetBackBuffer();
+
+	snapshot.CaptureTiles(*controller->GetBoard(), *controller->GetQueue(), m_region);
+	snapshot.countdown = m_countDown;
+	snapshot.CaptureProjection(*controller->GetBoard(), controller->GetCurrentOozePerPump(), m_countDown);
+	snapshot.roundCountdown = controller->GetCurrentCountdown();
+	snapshot.state = controller->GetState();
+	snapshot.roundNumber = m_roundNumber;
+	snapshot.scoreDetails = controller->GetScoreDetails();
+	snapshot.fastForward = controller->GetFastForward();
+	snapshot.spillInevitable = (controller->GetState() == Controller::STATE_RUNNING) && 
+		controller->IsSpillInevitable(m_countDown, TICKS_INTERACTION_BLOCKED);
+	snapshot.puzzleMode = controller->IsPuzzleMode();
+	snapshot.difficultyLevel = controller->GetDifficultyLevel();
+	snapshot.puzzleNumber = controller->GetPuzzleNumber();
+	snapshot.scoreToAdvance = controller->GetScoreToAdvance();
+
+	m_snapshots.Publish();
+}
@@ -0,0 +1,268 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Controller.h"
+#include "RenderSnapshot.h"
+#include "TripleBuffer.h"
+
+
+// ---- Class Definition ----
+
+/**
+ * Thread which runs the game: it keeps the game clock, pumps the ooze, and carries out the player's 
+ * placements. It is the only thread touching the Controller's Board and Queue while the game is running.
+ *
+ * The GUI talks to it through a lock-free command queue (see PlaceTile() and friends), and in return
+ * gets a RenderSnapshot after every change (see AcquireSnapshot()). Neither side ever waits for the other, 
+ * so a slow paint cannot hold up the game clock, and a busy tick cannot slow down painting.
+ * All methods except run() are to be called from the message thread only.
+ */
+class SimulationThread : public juce::Thread
+{
+public:
+	/**
+	 * Time between two ticks of the game clock, in milliseconds.
+	 * Level countdowns and ooze speeds are given in ticks, see LevelConfig.
+	 */
+	static const int TICK_INTERVAL;
+
+	/**
+	 * Class constructor. The first snapshot is available right away, the game starts once the thread is started.
+	 */
+	SimulationThread();
+
+	/**
+	 * Class destructor. Stops the thread.
+	 */
+	~SimulationThread() override;
+
+	/**
+	 * Reimplemented from juce::Thread.
+	 */
+	void run() override;
+
+	/**
+	 * Place the next pipe from the queue onto the board, if the game rules allow it.
+	 *
+	 * @param col	Column of the tile on the board.
+	 * @param row	Row of the tile on the board.
+	 * @return	False if the command queue is full.
+	 */
+	bool PlaceTile(int col, int row);
+
+	/**
+	 * Toggle fast-forward mode, see Controller::SetFastForward().
+	 *
+	 * @return	False if the command queue is full.
+	 */
+	bool ToggleFastForward();
+
+	/**
+	 * Pump the ooze until it spills, as fast as it goes, if nothing the player does can prevent the spill any more.
+	 * The ooze fills a slice of the remaining pipes per tick, so that snapshots and commands keep coming meanwhile.
+	 * See Controller::IsSpillInevitable() and RenderSnapshot::spillInevitable.
+	 *
+	 * @return	False if the command queue is full.
+	 */
+	bool SkipToResults();
+
+	/**
+	 * Start a new round, see Controller::Reset().
+	 *
+	 * @param cmd	CMD_RESTART or CMD_CONTINUE.
+	 * @return	False if the command queue is full.
+	 */
+	bool StartRound(Controller::Command cmd);
+
+	/**
+	 * Switch to puzzle mode and start the first puzzle, see Controller::StartPuzzleMode().
+	 * If there are no puzzles, the current round carries on.
+	 *
+	 * @param file	Puzzle file to play. If it doesn't exist, the puzzle file opened at startup is used.
+	 * @return	False if the command queue is full.
+	 */
+	bool StartPuzzleMode(const juce::File& file);
+
+	/**
+	 * Replace the settings of all difficulty levels with those in a level file, and start a new game.
+	 * See Controller::LoadLevelConfig(). If the file cannot be loaded, the current round carries on.
+	 *
+	 * @param file	Level file to load.
+	 * @return	False if the command queue is full.
+	 */
+	bool LoadLevelConfig(const juce::File& file);
+
+	/**
+	 * Resize the board, and start a new game on it. See Controller::SetBoardSize().
+	 *
+	 * @param numCols	Number of columns on the board.
+	 * @param numRows	Number of rows on the board.
+	 * @param endless	If true, play on an endless board instead.
+	 * @return	False if the command queue is full.
+	 */
+	bool SetBoardSize(int numCols, int numRows, bool endless = false);
+
+	/**
+	 * Change one of the rules of regular rounds, and start a new game. See Controller::SetRule().
+	 *
+	 * @param rule	The rule to change.
+	 * @param value	New value of the rule.
+	 * @return	False if the command queue is full.
+	 */
+	bool SetRule(Controller::Rule rule, int value);
+
+	/**
+	 * Limit the board tiles copied into each snapshot to the given cells, i.e. the ones on display.
+	 * This keeps publishing a snapshot cheap, no matter how large the board is. See RenderSnapshot::region.
+	 *
+	 * @param region	Columns and rows to copy. If empty, the whole board is copied.
+	 * @return	False if the command queue is full.
+	 */
+	bool SetRegion(juce::Rectangle<int> region);
+
+	/**
+	 * Get the latest snapshot of the game. It remains valid and unchanged until the next call.
+	 *
+	 * @param fresh		Optional, set to true if the game changed since the last call.
+	 * @return	The latest snapshot.
+	 */
+	const RenderSnapshot& AcquireSnapshot(bool* fresh = nullptr);
+
+private:
+	/**
+	 * Request sent from the message thread to the SimulationThread.
+	 */
+	struct Command
+	{
+		enum Type
+		{
+			TYPE_NONE = 0,
+			TYPE_PLACE_TILE,
+			TYPE_TOGGLE_FAST_FORWARD,
+			TYPE_SKIP_TO_RESULTS,
+			TYPE_START_ROUND,
+			TYPE_START_PUZZLES,
+			TYPE_LOAD_LEVELS,
+			TYPE_SET_BOARD_SIZE,
+			TYPE_SET_RULE,
+			TYPE_SET_REGION
+		};
+
+		Type type = TYPE_NONE;
+		int col = -1;
+		int row = -1;
+		int numCols = 0;
+		int numRows = 0;
+		bool endless = false;
+		Controller::Rule rule = Controller::RULE_NUM_SOURCES;
+		int value = 0;
+		Controller::Command roundCommand = Controller::CMD_NONE;
+		juce::File file;
+	};
+
+	/**
+	 * Add a command to the queue, and wake up the thread to carry it out.
+	 *
+	 * @return	False if the command queue is full.
+	 */
+	bool PushCommand(const Command& command);
+
+	/**
+	 * Carry out all commands waiting in the queue.
+	 *
+	 * @return	True if any command was carried out.
+	 */
+	bool ProcessCommands();
+
+	/**
+	 * Carry out a single command.
+	 */
+	void Execute(const Command& command);
+
+	/**
+	 * Advance the game by one tick of the game clock.
+	 *
+	 * @return	True if anything visible changed.
+	 */
+	bool Tick();
+
+	/**
+	 * Start a new round. See Controller::Reset().
+	 */
+	void Reset(Controller::Command cmd);
+
+	/**
+	 * Fill the back buffer with the current state of the game, and hand it over to the GUI.
+	 */
+	void PublishSnapshot();
+
+	/**
+	 * Lock-free single-producer / single-consumer queue of commands, stored in m_commands.
+	 */
+	juce::AbstractFifo m_commandFifo;
+	std::vector<Command> m_commands;
+
+	/**
+	 * Snapshots being filled, handed over, and drawn.
+	 */
+	TripleBuffer<RenderSnapshot> m_snapshots;
+
+	/**
+	 * Number of ticks until Ooze starts pumping out.
+	 */
+	int m_countDown = 0;
+
+	/**
+	 * Number of ticks during which placements are ignored, to prevent accidental double-clicking.
+	 */
+	int m_blockInteraction = 0;
+
+	/**
+	 * True once SkipToResults() was carried out, until the next round starts. See Tick().
+	 */
+	bool m_skipping = false;
+
+	/**
+	 * Incremented at the start of every round.
+	 */
+	int m_roundNumber = 0;
+
+	/**
+	 * Cells of the board copied into each snapshot, see SetRegion().
+	 */
+	juce::Rectangle<int> m_region;
+
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SimulationThread)
+};
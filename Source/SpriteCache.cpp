@@ -0,0 +1,221 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "SpriteCache.h"
+#include "TilePiece.h"
+
+
+
+// ---- Helper types and constants ----
+
+const int SpriteCache::OOZE_FRAMES(64);
+
+/**
+ * Layout of the sprite keys, see SpriteCache::GetKey(). 
+ * Bits 0-4: tile type, 5-7: flow direction (entry direction, for Junctions), 8-9: background way of Cross-Pipes,
+ * 10-16: ooze step (of the horizontal way, for Cross-Pipes), 17-23: ooze step of the vertical way of Cross-Pipes.
+ */
+static constexpr int KEY_DIRECTION_SHIFT = 5;
+static constexpr int KEY_WAY_SHIFT = 8;
+static constexpr int KEY_OOZE_SHIFT = 10;
+static constexpr int KEY_SECOND_OOZE_SHIFT = 17;
+static constexpr juce::uint32 KEY_TYPE_MASK = 0x1f;
+static constexpr juce::uint32 KEY_DIRECTION_MASK = 0x7;
+static constexpr juce::uint32 KEY_WAY_MASK = 0x3;
+static constexpr juce::uint32 KEY_OOZE_MASK = 0x7f;
+
+
+// ---- Class Implementation ----
+
+SpriteCache::SpriteCache(SpriteCache::Renderer renderer)
+	: m_renderer(renderer)
+{
+}
+
+void SpriteCache::SetStyle(int tileSize, juce::Colour colour, float scale)
+{
+	if ((tileSize != m_tileSize) ||
+		(colour != m_colour) ||
+		(scale != m_scale))
+	{
+		m_sprites.clear();
+
+		m_tileSize = tileSize;
+		m_colour = colour;
+		m_scale = scale;
+	}
+}
+
+void SpriteCache::DrawTile(const TilePiece* tile, juce::Point<int> origin, juce::Graphics& g)
+{
+	if (m_tileSize <= 0)
+		return;
+
+	juce::uint32 key = GetKey(tile);
+
+	auto it = m_sprites.find(key);
+	if (it == m_sprites.end())
+	{
+		// Sprites have as many pixels as the tile will cover on the display, so that they are not resampled when drawn.
+		int spriteSize = juce::roundToInt(m_tileSize * m_scale);
+		juce::Image sprite(juce::Image::ARGB, spriteSize, spriteSize, true);
+		{
+			juce::Graphics spriteGraphics(sprite);
+			spriteGraphics.addTransform(juce::AffineTransform::scale(m_scale));
+
+			std::unique_ptr<TilePiece> standIn(CreateStandIn(key));
+			m_renderer(standIn.get(), spriteGraphics);
+		}
+
+		it = m_sprites.emplace(key, sprite).first;
+	}
+
+	g.drawImage(it->second, juce::Rectangle<int>(origin.getX(), origin.getY(), m_tileSize, m_tileSize).toFloat());
+}
+
+int SpriteCache::GetNumSprites() const
+{
+	return static_cast<int>(m_sprites.size());
+}
+
+juce::uint32 SpriteCache::GetOozeStep(int level)
+{
+	int step = level * OOZE_FRAMES / MAX_OOZE_LEVEL;
+
+	return static_cast<juce::uint32>(juce::jlimit(0, OOZE_FRAMES, step));
+}
+
+juce::uint32 SpriteCache::GetKey(const TilePiece* tile)
+{
+	juce::uint32 key = static_cast<juce::uint32>(tile->GetType());
+
+	const Pipe* pipe = dynamic_cast<const Pipe*>(tile);
+	const Cross* crossTile = dynamic_cast<const Cross*>(tile);
+	const Junction* junction = dynamic_cast<const Junction*>(tile);
+
+	if (crossTile != nullptr)
+		key |= static_cast<juce::uint32>(crossTile->GetBackgroundWay()) << KEY_WAY_SHIFT;
+
+	// The flow direction makes no difference to the look of an empty pipe.
+	if ((pipe != nullptr) &&
+		(!pipe->IsEmpty()))
+	{
+		// Junctions flow out through all openings but one, so the way in tells the look apart.
+		Pipe::Direction dir((junction != nullptr) ? junction->GetEntryDirection() : pipe->GetFlowDirection());
+		key |= static_cast<juce::uint32>(dir) << KEY_DIRECTION_SHIFT;
+
+		if (crossTile != nullptr)
+		{
+			key |= GetOozeStep(crossTile->GetOozeLevel(Cross::WAY_HORIZONTAL)) << KEY_OOZE_SHIFT;
+			key |= GetOozeStep(crossTile->GetOozeLevel(Cross::WAY_VERTICAL)) << KEY_SECOND_OOZE_SHIFT;
+		}
+		else
+		{
+			key |= GetOozeStep(pipe->GetOozeLevel()) << KEY_OOZE_SHIFT;
+		}
+	}
+
+	return key;
+}
+
+TilePiece* SpriteCache::CreateStandIn(juce::uint32 key)
+{
+	TilePiece::Type type = static_cast<TilePiece::Type>(key & KEY_TYPE_MASK);
+	Pipe::Direction dir = static_cast<Pipe::Direction>((key >> KEY_DIRECTION_SHIFT) & KEY_DIRECTION_MASK);
+	Cross::Way backgroundWay = static_cast<Cross::Way>((key >> KEY_WAY_SHIFT) & KEY_WAY_MASK);
+	int level = static_cast<int>((key >> KEY_OOZE_SHIFT) & KEY_OOZE_MASK) * MAX_OOZE_LEVEL / OOZE_FRAMES;
+	int secondLevel = static_cast<int>((key >> KEY_SECOND_OOZE_SHIFT) & KEY_OOZE_MASK) * MAX_OOZE_LEVEL / OOZE_FRAMES;
+
+	if (type == TilePiece::TYPE_NONE)
+		return new TilePiece(type);
+
+	if (type == TilePiece::TYPE_CROSS)
+	{
+		Cross* crossTile = new Cross(backgroundWay);
+		if (dir != Pipe::DIR_NONE)
+		{
+			int horizLevel = level;
+			int vertLevel = secondLevel;
+			bool flowingHoriz((dir == Pipe::DIR_E) || (dir == Pipe::DIR_W));
+
+			// Fill the way which the ooze is not flowing through first, so that the flow direction ends up as in the original.
+			if (flowingHoriz && (vertLevel > MIN_OOZE_LEVEL))
+			{
+				crossTile->SetFlowEntry(Pipe::DIR_N);
+				crossTile->Pump(vertLevel);
+			}
+			else if (!flowingHoriz && (horizLevel > MIN_OOZE_LEVEL))
+			{
+				crossTile->SetFlowEntry(Pipe::DIR_W);
+				crossTile->Pump(horizLevel);
+			}
+
+			crossTile->SetFlowEntry(Pipe::GetOppositeDirection(dir));
+			int flowingLevel = flowingHoriz ? horizLevel : vertLevel;
+			if (flowingLevel > MIN_OOZE_LEVEL)
+				crossTile->Pump(flowingLevel);
+		}
+
+		return crossTile;
+	}
+
+	if (Junction::IsJunction(type))
+	{
+		Junction* junction = new Junction(type);
+		if ((dir != Pipe::DIR_NONE) &&
+			(level > MIN_OOZE_LEVEL))
+		{
+			junction->SetFlowEntry(dir);
+			junction->Pump(level);
+		}
+
+		return junction;
+	}
+
+	Pipe* pipe = new Pipe(type);
+	if ((dir != Pipe::DIR_NONE) && 
+		(level > MIN_OOZE_LEVEL))
+	{
+		// Starter pipes come with their flow direction. Other pipes get it from the opening where the ooze entered.
+		if (!pipe->IsStart())
+		{
+			for (Pipe::Direction entry : { Pipe::DIR_N, Pipe::DIR_S, Pipe::DIR_E, Pipe::DIR_W })
+			{
+				if (Pipe::GetExitDirection(type, entry) == dir)
+					pipe->SetFlowEntry(entry);
+			}
+		}
+
+		pipe->Pump(level);
+	}
+
+	return pipe;
+}
@@ -0,0 +1,130 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <unordered_map>
+
+
+// ---- Forward declarations ----
+
+class TilePiece;
+
+
+// ---- Class Definition ----
+
+/**
+ * Pre-rendered images of tiles, so that drawing the board takes one image blit per tile, 
+ * instead of rebuilding every pipe out of lines and ellipses on every frame.
+ *
+ * A sprite holds the whole look of a tile: pipe, ooze and frame. Tiles which look alike share a sprite,
+ * i.e. tiles of the same type, with the same flow direction, the same background way (for Cross-Pipes), 
+ * and the same ooze level, rounded down to one of OOZE_FRAMES steps. Sprites are rendered the first 
+ * time they are needed, and are all thrown away when the tile size, tile colour or display scale changes.
+ * Explosions are not part of the sprites, and need to be drawn on top.
+ */
+class SpriteCache
+{
+public:
+	/**
+	 * Number of steps in which the ooze level of a pipe is rounded, from empty to full.
+	 */
+	static const int OOZE_FRAMES;
+
+	/**
+	 * Function which draws a tile with its top-left corner at (0, 0). 
+	 */
+	typedef std::function<void(const TilePiece* tile, juce::Graphics& g)> Renderer;
+
+	/**
+	 * Class constructor.
+	 *
+	 * @param renderer	Function used for drawing the tiles into the sprites.
+	 */
+	SpriteCache(Renderer renderer);
+
+	/**
+	 * Set what the sprites should look like. If anything differs from the previous call, 
+	 * all sprites are thrown away. Cheap enough to call on every frame.
+	 *
+	 * @param tileSize	Width & height of a tile piece, in pixels.
+	 * @param colour	Background colour of pipe tiles, which depends on the difficulty level.
+	 * @param scale		Number of physical pixels per logical pixel on the display.
+	 */
+	void SetStyle(int tileSize, juce::Colour colour, float scale);
+
+	/**
+	 * Draw a tile, rendering its sprite first if needed.
+	 *
+	 * @param tile		The tile piece to draw.
+	 * @param origin	The point where the top-left corner of the tile will be located.
+	 * @param g			The graphics context used for drawing.
+	 */
+	void DrawTile(const TilePiece* tile, juce::Point<int> origin, juce::Graphics& g);
+
+	/**
+	 * Get the number of sprites rendered so far with the current style.
+	 */
+	int GetNumSprites() const;
+
+	/**
+	 * Get the key of the sprite which looks like the given tile. 
+	 * Tiles with the same key look the same, apart from explosions.
+	 */
+	static juce::uint32 GetKey(const TilePiece* tile);
+
+private:
+	/**
+	 * Create a tile which looks just like the tiles with the given sprite key, 
+	 * with its ooze levels rounded down to the sprite's.
+	 *
+	 * @param key	The sprite key, see GetKey().
+	 * @return	The new tile. The caller takes ownership.
+	 */
+	static TilePiece* CreateStandIn(juce::uint32 key);
+
+	/**
+	 * Round an ooze level down to one of OOZE_FRAMES steps.
+	 */
+	static juce::uint32 GetOozeStep(int level);
+
+	Renderer m_renderer;
+
+	int m_tileSize = 0;
+	juce::Colour m_colour;
+	float m_scale = 1.0f;
+
+	std::unordered_map<juce::uint32, juce::Image> m_sprites;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpriteCache)
+};
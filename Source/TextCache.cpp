@@ -0,0 +1,121 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "TextCache.h"
+
+
+
+// ---- Helper types and constants ----
+
+const juce::String DigitAtlas::CHARACTERS("0123456789/-");
+
+
+// ---- Class Implementation ----
+
+void TextCache::AddLine(juce::GlyphArrangement& arrangement, const juce::Font& font, const juce::String& text, 
+						juce::Rectangle<int> area, juce::Justification justification)
+{
+	// Same steps as juce::Graphics::drawText().
+	int firstGlyph = arrangement.getNumGlyphs();
+	arrangement.addCurtailedLineOfText(font, text, 0.0f, 0.0f, static_cast<float>(area.getWidth()), false);
+	arrangement.justifyGlyphs(	firstGlyph, arrangement.getNumGlyphs() - firstGlyph,
+								static_cast<float>(area.getX()), static_cast<float>(area.getY()),
+								static_cast<float>(area.getWidth()), static_cast<float>(area.getHeight()), 
+								justification);
+}
+
+DigitAtlas::DigitAtlas()
+{
+}
+
+void DigitAtlas::SetStyle(const juce::Font& font, juce::Colour colour, float scale)
+{
+	if ((font == m_font) &&
+		(colour == m_colour) &&
+		(scale == m_scale))
+		return;
+
+	m_font = font;
+	m_colour = colour;
+	m_scale = scale;
+
+	// One cell per character, as wide as a character of the (monospaced) font.
+	m_cellWidth = std::ceil(font.getStringWidthFloat("0"));
+	m_cellHeight = std::ceil(font.getHeight());
+	int numCells = CHARACTERS.length();
+
+	m_atlas = juce::Image(juce::Image::ARGB, 
+						std::max(1, juce::roundToInt(numCells * m_cellWidth * scale)), 
+						std::max(1, juce::roundToInt(m_cellHeight * scale)), true);
+
+	juce::Graphics g(m_atlas);
+	g.addTransform(juce::AffineTransform::scale(scale));
+	g.setFont(font);
+	g.setColour(colour);
+	for (int i = 0; i < numCells; i++)
+	{
+		juce::Rectangle<float> cell(i * m_cellWidth, 0.0f, m_cellWidth, m_cellHeight);
+		g.drawText(CHARACTERS.substring(i, i + 1), cell, juce::Justification::centred, false);
+	}
+}
+
+void DigitAtlas::Draw(juce::Graphics& g, const juce::String& text, juce::Rectangle<int> area, juce::Justification justification) const
+{
+	if (!m_atlas.isValid())
+		return;
+
+	// Horizontal position, as with justified text. 
+	float textWidth = text.length() * m_cellWidth;
+	float x = static_cast<float>(area.getX());
+	if (justification.testFlags(juce::Justification::right))
+		x += area.getWidth() - textWidth;
+	else if (justification.testFlags(juce::Justification::horizontallyCentred))
+		x += (area.getWidth() - textWidth) / 2.0f;
+
+	float y = area.getY() + (area.getHeight() - m_cellHeight) / 2.0f;
+
+	for (int i = 0; i < text.length(); i++)
+	{
+		// Characters not fitting into the area are cut off.
+		if (x + m_cellWidth > area.getRight())
+			break;
+
+		int cell = CHARACTERS.indexOfChar(text[i]);
+		if (cell >= 0)
+		{
+			g.drawImage(m_atlas,	juce::roundToInt(x), juce::roundToInt(y), juce::roundToInt(m_cellWidth), juce::roundToInt(m_cellHeight),
+									juce::roundToInt(cell * m_cellWidth * m_scale), 0, 
+									juce::roundToInt(m_cellWidth * m_scale), juce::roundToInt(m_cellHeight * m_scale));
+		}
+
+		x += m_cellWidth;
+	}
+}
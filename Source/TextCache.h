@@ -0,0 +1,110 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+
+
+// ---- Class Definition ----
+
+/**
+ * Helpers for laying out text ahead of time, so that painting does not have to.
+ */
+class TextCache
+{
+public:
+	/**
+	 * Lay out a single line of text within a rectangle, exactly like juce::Graphics::drawText() would,
+	 * and add it to a GlyphArrangement. The arrangement can then be drawn on every repaint.
+	 *
+	 * @param arrangement		The arrangement to add the text to.
+	 * @param font				Font of the text.
+	 * @param text				The text.
+	 * @param area				Rectangle to fit the text into. Text which doesn't fit is cut off.
+	 * @param justification		How to position the text within area.
+	 */
+	static void AddLine(juce::GlyphArrangement& arrangement, const juce::Font& font, const juce::String& text, 
+						juce::Rectangle<int> area, juce::Justification justification);
+};
+
+
+/**
+ * Pre-rendered images of the characters used by counters, i.e. digits, '/' and '-', in a single font and colour.
+ * Counters which change on every frame are then drawn as a few image blits, without any text layout.
+ * The font is expected to be monospaced, so that all characters have the same width.
+ */
+class DigitAtlas
+{
+public:
+	/**
+	 * Characters available in the atlas. Any other characters are skipped when drawing.
+	 */
+	static const juce::String CHARACTERS;
+
+	/**
+	 * Class constructor. Nothing is drawn until SetStyle() is called.
+	 */
+	DigitAtlas();
+
+	/**
+	 * Set the font and colour of the characters. If anything differs from the previous call,
+	 * the atlas is rendered anew. Cheap enough to call on every frame.
+	 *
+	 * @param font		Font of the characters.
+	 * @param colour	Colour of the characters.
+	 * @param scale		Number of physical pixels per logical pixel on the display.
+	 */
+	void SetStyle(const juce::Font& font, juce::Colour colour, float scale);
+
+	/**
+	 * Draw a counter. Looks like juce::Graphics::drawText() would with the same font and colour.
+	 *
+	 * @param g					The graphics context used for drawing.
+	 * @param text				The counter's text.
+	 * @param area				Rectangle to fit the text into. Text which doesn't fit is cut off.
+	 * @param justification		How to position the text within area: left, right or horizontally centred. 
+	 *							It is always centred vertically.
+	 */
+	void Draw(juce::Graphics& g, const juce::String& text, juce::Rectangle<int> area, juce::Justification justification) const;
+
+private:
+	juce::Font m_font;
+	juce::Colour m_colour;
+	float m_scale = 0.0f;
+
+	/**
+	 * All characters side by side, in the order of CHARACTERS, each in a cell of m_cellWidth x m_cellHeight logical pixels.
+	 */
+	juce::Image m_atlas;
+	float m_cellWidth = 0.0f;
+	float m_cellHeight = 0.0f;
+};
@@ -0,0 +1,294 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "TileGeometry.h"
+
+
+
+// ---- Helper types and constants ----
+
+/**
+ * Bit masks of the openings of a pipe, one bit per Pipe::Direction.
+ */
+static constexpr unsigned int OPENING_N = (1 << Pipe::DIR_N);
+static constexpr unsigned int OPENING_S = (1 << Pipe::DIR_S);
+static constexpr unsigned int OPENING_E = (1 << Pipe::DIR_E);
+static constexpr unsigned int OPENING_W = (1 << Pipe::DIR_W);
+
+/**
+ * Shape of a type of tile: its openings, and whether the arms leading to them meet in a rounded joint.
+ */
+struct TileShape
+{
+	unsigned int openings;
+	bool joint;
+};
+
+/**
+ * Shapes of all types of tile, indexed by TilePiece::Type.
+ */
+static const TileShape TILE_SHAPES[TilePiece::TYPE_MAX] =
+{
+	{ 0,										false },	// TYPE_NONE
+	{ OPENING_N,								true },		// TYPE_START_N
+	{ OPENING_S,								true },		// TYPE_START_S
+	{ OPENING_E,								true },		// TYPE_START_E
+	{ OPENING_W,								true },		// TYPE_START_W
+	{ OPENING_N | OPENING_S,					false },	// TYPE_VERTICAL
+	{ OPENING_E | OPENING_W,					false },	// TYPE_HORIZONTAL
+	{ OPENING_N | OPENING_W,					true },		// TYPE_NW_ELBOW
+	{ OPENING_N | OPENING_E,					true },		// TYPE_NE_ELBOW
+	{ OPENING_S | OPENING_E,					true },		// TYPE_SE_ELBOW
+	{ OPENING_S | OPENING_W,					true },		// TYPE_SW_ELBOW
+	{ OPENING_N | OPENING_S | OPENING_E | OPENING_W,	false },	// TYPE_CROSS, drawn one way at a time.
+	{ OPENING_N | OPENING_E | OPENING_S,		true },		// TYPE_NES_TEE
+	{ OPENING_E | OPENING_S | OPENING_W,		true },		// TYPE_ESW_TEE
+	{ OPENING_S | OPENING_W | OPENING_N,		true },		// TYPE_SWN_TEE
+	{ OPENING_W | OPENING_N | OPENING_E,		true },		// TYPE_WNE_TEE
+	{ OPENING_N | OPENING_S | OPENING_E | OPENING_W,	true },		// TYPE_SPLITTER
+};
+
+static const Pipe::Direction ALL_DIRECTIONS[] = { Pipe::DIR_N, Pipe::DIR_S, Pipe::DIR_E, Pipe::DIR_W };
+
+/**
+ * Get the openings of one way of a Cross-Pipe.
+ */
+static unsigned int GetWayOpenings(Cross::Way way)
+{
+	return (way == Cross::WAY_HORIZONTAL) ? (OPENING_E | OPENING_W) : (OPENING_N | OPENING_S);
+}
+
+
+// ---- Class Implementation ----
+
+TileGeometry::TileGeometry(int tileSize, float oozeThickness)
+	: m_tileSize(tileSize),
+	m_halfTile(tileSize / 2),
+	m_pipeThickness(tileSize / 3.5f),
+	m_oozeThickness(oozeThickness)
+{
+}
+
+void TileGeometry::AddPipe(juce::Path& path, const TilePiece* tile, juce::Point<int> origin) const
+{
+	TilePiece::Type type = tile->GetType();
+	if ((type <= TilePiece::TYPE_NONE) || (type >= TilePiece::TYPE_MAX))
+		return;
+
+	unsigned int openings = TILE_SHAPES[type].openings;
+	const Cross* crossTile = dynamic_cast<const Cross*>(tile);
+	if (crossTile != nullptr)
+		openings = GetWayOpenings(crossTile->GetBackgroundWay());
+
+	// One arm from the centre to each opening.
+	juce::Point<int> centre(GetEdgePoint(origin, Pipe::DIR_NONE));
+	for (Pipe::Direction dir : ALL_DIRECTIONS)
+	{
+		if ((openings & (1 << dir)) != 0)
+			AddStroke(path, centre, GetEdgePoint(origin, dir), m_pipeThickness);
+	}
+
+	// Rounded joint where the arms meet.
+	if (TILE_SHAPES[type].joint)
+		path.addEllipse(centre.getX() - (m_pipeThickness / 2.0f), centre.getY() - (m_pipeThickness / 2.0f), m_pipeThickness, m_pipeThickness);
+}
+
+void TileGeometry::AddOoze(juce::Path& path, const TilePiece* tile, juce::Point<int> origin) const
+{
+	const Pipe* pipe = dynamic_cast<const Pipe*>(tile);
+	if ((pipe == nullptr) || pipe->IsEmpty())
+		return;
+
+	const Cross* crossTile = dynamic_cast<const Cross*>(tile);
+	if (crossTile != nullptr)
+	{
+		AddCrossOoze(path, crossTile, crossTile->GetBackgroundWay(), origin);
+		return;
+	}
+
+	// Junctions are filled from their entry towards every exit at once.
+	const TileShape& shape(TILE_SHAPES[pipe->GetType()]);
+	const Junction* junction = dynamic_cast<const Junction*>(tile);
+	if (junction != nullptr)
+	{
+		Pipe::Direction exits[Pipe::MAX_NUM_EXITS];
+		int numExits = Pipe::GetExitDirections(junction->GetType(), junction->GetEntryDirection(), exits);
+		for (int i = 0; i < numExits; i++)
+			AddOozeFlow(path, origin, junction->GetEntryDirection(), exits[i], junction->GetOozeLevel(), shape.joint);
+
+		return;
+	}
+
+	// The ooze comes in through the opening which is not the exit. Starter pipes have none.
+	Pipe::Direction exit = pipe->GetFlowDirection();
+	Pipe::Direction entry = Pipe::DIR_NONE;
+	for (Pipe::Direction dir : ALL_DIRECTIONS)
+	{
+		if ((dir != exit) && ((shape.openings & (1 << dir)) != 0))
+			entry = dir;
+	}
+
+	AddOozeFlow(path, origin, entry, exit, pipe->GetOozeLevel(), shape.joint);
+}
+
+void TileGeometry::AddCrossSecondWay(juce::Path& pipePath, juce::Path& markingsPath, juce::Path& oozePath, const TilePiece* tile, juce::Point<int> origin) const
+{
+	const Cross* crossTile = dynamic_cast<const Cross*>(tile);
+	if (crossTile == nullptr)
+		return;
+
+	Cross::Way way = (crossTile->GetBackgroundWay() == Cross::WAY_HORIZONTAL) ? Cross::WAY_VERTICAL : Cross::WAY_HORIZONTAL;
+
+	// Pipe first.
+	juce::Point<int> centre(GetEdgePoint(origin, Pipe::DIR_NONE));
+	unsigned int openings = GetWayOpenings(way);
+	for (Pipe::Direction dir : ALL_DIRECTIONS)
+	{
+		if ((openings & (1 << dir)) != 0)
+			AddStroke(pipePath, centre, GetEdgePoint(origin, dir), m_pipeThickness);
+	}
+
+	// Little lines along the pipe, which make the separation between horizontal and vertical 
+	// components of the cross-pipe more visually obvious.
+	float littleLineThickness = (m_tileSize * 5.0f) / 70.0f;
+	int offset = static_cast<int>(m_tileSize / 6.0f) + 1;
+	for (int side : { -1, 1 })
+	{
+		if (way == Cross::WAY_VERTICAL)
+			AddStroke(markingsPath,	juce::Point<int>(centre.getX() + side * offset, origin.getY() + 1), 
+									juce::Point<int>(centre.getX() + side * offset, origin.getY() + m_tileSize - 1), littleLineThickness);
+		else
+			AddStroke(markingsPath,	juce::Point<int>(origin.getX() + 1, centre.getY() + side * offset), 
+									juce::Point<int>(origin.getX() + m_tileSize - 1, centre.getY() + side * offset), littleLineThickness);
+	}
+
+	AddCrossOoze(oozePath, crossTile, way, origin);
+}
+
+void TileGeometry::AddStroke(juce::Path& path, juce::Point<int> start, juce::Point<int> end, float thickness)
+{
+	if (start == end)
+		return;
+
+	float halfThickness = thickness / 2.0f;
+	float left = static_cast<float>(std::min(start.getX(), end.getX()));
+	float right = static_cast<float>(std::max(start.getX(), end.getX()));
+	float top = static_cast<float>(std::min(start.getY(), end.getY()));
+	float bottom = static_cast<float>(std::max(start.getY(), end.getY()));
+
+	// Strokes are either horizontal or vertical. Their thickness goes across, as with butt-ended lines.
+	if (start.getY() == end.getY())
+		path.addRectangle(left, top - halfThickness, right - left, thickness);
+	else
+		path.addRectangle(left - halfThickness, top, thickness, bottom - top);
+}
+
+juce::Point<int> TileGeometry::GetEdgePoint(juce::Point<int> origin, Pipe::Direction dir) const
+{
+	switch (dir)
+	{
+	case Pipe::DIR_N:
+		return juce::Point<int>(origin.getX() + m_halfTile, origin.getY());
+	case Pipe::DIR_S:
+		return juce::Point<int>(origin.getX() + m_halfTile, origin.getY() + m_tileSize);
+	case Pipe::DIR_E:
+		return juce::Point<int>(origin.getX() + m_tileSize, origin.getY() + m_halfTile);
+	case Pipe::DIR_W:
+		return juce::Point<int>(origin.getX(), origin.getY() + m_halfTile);
+	default:
+		break;
+	}
+
+	return juce::Point<int>(origin.getX() + m_halfTile, origin.getY() + m_halfTile);
+}
+
+juce::Point<int> TileGeometry::GetOozeFront(juce::Point<int> origin, Pipe::Direction travelDir, int distance) const
+{
+	switch (travelDir)
+	{
+	case Pipe::DIR_N:
+		return juce::Point<int>(origin.getX() + m_halfTile, origin.getY() + m_tileSize - distance);
+	case Pipe::DIR_S:
+		return juce::Point<int>(origin.getX() + m_halfTile, origin.getY() + distance);
+	case Pipe::DIR_E:
+		return juce::Point<int>(origin.getX() + distance, origin.getY() + m_halfTile);
+	case Pipe::DIR_W:
+		return juce::Point<int>(origin.getX() + m_tileSize - distance, origin.getY() + m_halfTile);
+	default:
+		break;
+	}
+
+	return GetEdgePoint(origin, Pipe::DIR_NONE);
+}
+
+void TileGeometry::AddOozeFlow(juce::Path& path, juce::Point<int> origin, Pipe::Direction entry, Pipe::Direction exit, int level, bool joint) const
+{
+	int fill = m_tileSize * level / MAX_OOZE_LEVEL;
+	bool overHalf(level >= (MAX_OOZE_LEVEL / 2));
+	juce::Point<int> centre(GetEdgePoint(origin, Pipe::DIR_NONE));
+
+	// Straight through, without any turn at the centre.
+	if ((entry != Pipe::DIR_NONE) && (Pipe::GetOppositeDirection(entry) == exit) && (!joint))
+	{
+		AddStroke(path, GetEdgePoint(origin, entry), GetOozeFront(origin, exit, fill), m_oozeThickness);
+		return;
+	}
+
+	// From the entry towards the centre.
+	if (entry != Pipe::DIR_NONE)
+	{
+		juce::Point<int> front = overHalf ? centre : GetOozeFront(origin, Pipe::GetOppositeDirection(entry), fill);
+		AddStroke(path, GetEdgePoint(origin, entry), front, m_oozeThickness);
+	}
+
+	// From the centre towards the exit.
+	if (overHalf)
+	{
+		AddStroke(path, centre, GetOozeFront(origin, exit, fill), m_oozeThickness);
+
+		if (joint)
+			path.addEllipse(centre.getX() - (m_oozeThickness / 2.0f), centre.getY() - (m_oozeThickness / 2.0f), m_oozeThickness, m_oozeThickness);
+	}
+}
+
+void TileGeometry::AddCrossOoze(juce::Path& path, const Cross* crossTile, Cross::Way way, juce::Point<int> origin) const
+{
+	// Cross-Pipes only keep the current flow direction. Ooze in a way it no longer flows through 
+	// is drawn as coming in from the east or from the north, which makes no difference once that way is full.
+	Pipe::Direction flowDir = crossTile->GetFlowDirection();
+	Pipe::Direction entry;
+	if (way == Cross::WAY_HORIZONTAL)
+		entry = (flowDir == Pipe::DIR_E) ? Pipe::DIR_W : Pipe::DIR_E;
+	else
+		entry = (flowDir == Pipe::DIR_N) ? Pipe::DIR_S : Pipe::DIR_N;
+
+	AddOozeFlow(path, origin, entry, Pipe::GetOppositeDirection(entry), crossTile->GetOozeLevel(way), false);
+}
@@ -0,0 +1,127 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TilePiece.h"
+
+
+// ---- Class Definition ----
+
+/**
+ * Outlines of pipes and ooze, for any type of tile. The shapes of all tile types are defined in a single table,
+ * in terms of which openings a pipe has, and whether its arms meet in a rounded joint. 
+ * 
+ * Shapes are added to juce::Paths rather than drawn directly, so that all parts of the same colour can be 
+ * filled in one go, for as many tiles as wanted. All shapes of one colour wind the same way, so they 
+ * can overlap within the same path.
+ */
+class TileGeometry
+{
+public:
+	/**
+	 * Class constructor.
+	 *
+	 * @param tileSize			Width & height of a tile piece, in pixels.
+	 * @param oozeThickness		Thickness of ooze inside pipes, in pixels.
+	 */
+	TileGeometry(int tileSize, float oozeThickness);
+
+	/**
+	 * Add the outline of a pipe. Of Cross-Pipes, only the background way is added, see AddCrossSecondWay().
+	 *
+	 * @param path		The path to add the outline to.
+	 * @param tile		The tile. Nothing is added for empty tiles.
+	 * @param origin	The point where the top-left corner of the tile is located.
+	 */
+	void AddPipe(juce::Path& path, const TilePiece* tile, juce::Point<int> origin) const;
+
+	/**
+	 * Add the outline of the ooze inside a pipe. Of Cross-Pipes, only the background way is added, see AddCrossSecondWay().
+	 *
+	 * @param path		The path to add the outline to.
+	 * @param tile		The tile. Nothing is added for empty tiles, or pipes without ooze.
+	 * @param origin	The point where the top-left corner of the tile is located.
+	 */
+	void AddOoze(juce::Path& path, const TilePiece* tile, juce::Point<int> origin) const;
+
+	/**
+	 * Add the outlines of the foreground way of a Cross-Pipe, which goes on top of its background way. 
+	 * Nothing is added for tiles of any other type.
+	 *
+	 * @param pipePath		The path to add the outline of the pipe to.
+	 * @param markingsPath	The path to add the little lines to, which run along both sides of the pipe in the tile's colour.
+	 * @param oozePath		The path to add the outline of the ooze inside the pipe to.
+	 * @param tile			The tile.
+	 * @param origin		The point where the top-left corner of the tile is located.
+	 */
+	void AddCrossSecondWay(juce::Path& pipePath, juce::Path& markingsPath, juce::Path& oozePath, const TilePiece* tile, juce::Point<int> origin) const;
+
+private:
+	/**
+	 * Add a straight, axis-aligned stroke. Same outline as juce::Graphics::drawLine() would draw.
+	 */
+	static void AddStroke(juce::Path& path, juce::Point<int> start, juce::Point<int> end, float thickness);
+
+	/**
+	 * Get the point in the middle of the given edge of a tile, or its centre for DIR_NONE.
+	 */
+	juce::Point<int> GetEdgePoint(juce::Point<int> origin, Pipe::Direction dir) const;
+
+	/**
+	 * Get the front of ooze which has flowed the given distance through a tile, 
+	 * coming in through the edge opposite to the travel direction.
+	 */
+	juce::Point<int> GetOozeFront(juce::Point<int> origin, Pipe::Direction travelDir, int distance) const;
+
+	/**
+	 * Add the outline of ooze flowing from one opening of a pipe to another.
+	 *
+	 * @param path		The path to add the outline to.
+	 * @param origin	The point where the top-left corner of the tile is located.
+	 * @param entry		Opening where the ooze comes in. DIR_NONE for starter pipes, where the ooze starts in the centre.
+	 * @param exit		Opening where the ooze leaves.
+	 * @param level		Ooze level.
+	 * @param joint		True if the ooze goes around a rounded joint once it reaches the centre.
+	 */
+	void AddOozeFlow(juce::Path& path, juce::Point<int> origin, Pipe::Direction entry, Pipe::Direction exit, int level, bool joint) const;
+
+	/**
+	 * Add the outline of the ooze inside one way of a Cross-Pipe.
+	 */
+	void AddCrossOoze(juce::Path& path, const Cross* crossTile, Cross::Way way, juce::Point<int> origin) const;
+
+	int m_tileSize;
+	int m_halfTile;
+	float m_pipeThickness;
+	float m_oozeThickness;
+};
@@ -31,12 +31,19 @@ SOFTWARE.
 #include "TilePiece.h"
 #include "Randomizer.h"
 #include <assert.h>
+#include <algorithm>
 
 
 // ---- Helper types and constants ----
 
 const int TilePiece::PIPE_SCORE_VALUE(10);
 const int TilePiece::CROSS_PIPE_SCORE_VALUE(15);
+const int TilePiece::JUNCTION_SCORE_VALUE_PER_EXIT(10);
+
+/**
+ * All directions in which Ooze can flow, in the order of Pipe::Direction.
+ */
+static const Pipe::Direction ALL_DIRECTIONS[] = { Pipe::DIR_N, Pipe::DIR_S, Pipe::DIR_E, Pipe::DIR_W };
 
 
 // ---- Class Implementation ----
@@ -58,7 +65,7 @@ TilePiece::~TilePiece()
 
 }
 
-TilePiece* TilePiece::CreateTile(TilePiece::Type t)
+TilePiece* TilePiece::CreateTile(TilePiece::Type t, Randomizer* rand)
 {
 	TilePiece* ret(nullptr);
 
@@ -80,7 +87,14 @@ TilePiece* TilePiece::CreateTile(TilePiece::Type t)
 			ret = new Pipe(t);
 			break;
 		case TYPE_CROSS:
-			ret = new Cross();
+			ret = new Cross(rand);
+			break;
+		case TYPE_NES_TEE:
+		case TYPE_ESW_TEE:
+		case TYPE_SWN_TEE:
+		case TYPE_WNE_TEE:
+		case TYPE_SPLITTER:
+			ret = new Junction(t);
 			break;
 		default:
 			break;
@@ -127,7 +141,7 @@ int TilePiece::GetScoreValue() const
 
 Pipe::Pipe(TilePiece::Type t)
 	: TilePiece(t),
-	m_oozeLevel(0.0f),
+	m_oozeLevel(MIN_OOZE_LEVEL),
 	m_exploding(0)
 {
 	// Starter pipes have only one possible
@@ -157,20 +171,28 @@ Pipe::~Pipe()
 
 }
 
-float Pipe::Pump(float amount)
+int Pipe::Pump(int amount)
 {
 	assert(m_oozeLevel < MAX_OOZE_LEVEL);
+	assert(amount >= 0);
 
-	m_oozeLevel += amount;
+	m_oozeLevel = static_cast<std::uint16_t>(std::min(m_oozeLevel + amount, MAX_OOZE_LEVEL));
 
 	return m_oozeLevel;
 }
 
-float Pipe::GetOozeLevel() const
+int Pipe::GetOozeLevel() const
 {
 	return m_oozeLevel;
 }
 
+void Pipe::SetOozeLevel(int level)
+{
+	assert((level >= MIN_OOZE_LEVEL) && (level <= MAX_OOZE_LEVEL));
+
+	m_oozeLevel = static_cast<std::uint16_t>(level);
+}
+
 bool Pipe::IsFull() const
 {
 	return (m_oozeLevel >= MAX_OOZE_LEVEL);
@@ -183,7 +205,12 @@ bool Pipe::IsEmpty() const
 
 bool Pipe::HasOpening(Pipe::Direction dir) const
 {
-	switch (m_type)
+	return HasOpening(m_type, dir);
+}
+
+bool Pipe::HasOpening(TilePiece::Type t, Pipe::Direction dir)
+{
+	switch (t)
 	{
 	case TYPE_START_N:
 		return (dir == DIR_N);
@@ -206,7 +233,16 @@ bool Pipe::HasOpening(Pipe::Direction dir) const
 	case TYPE_SW_ELBOW:
 		return ((dir == DIR_S) || (dir == DIR_W));
 	case TYPE_CROSS:
+	case TYPE_SPLITTER:
 		return true;
+	case TYPE_NES_TEE:
+		return (dir != DIR_W);
+	case TYPE_ESW_TEE:
+		return (dir != DIR_N);
+	case TYPE_SWN_TEE:
+		return (dir != DIR_E);
+	case TYPE_WNE_TEE:
+		return (dir != DIR_S);
 	default:
 		break;
 	}
@@ -233,104 +269,113 @@ Pipe::Direction Pipe::GetOppositeDirection(Pipe::Direction dir)
 	return DIR_NONE;
 }
 
-bool Pipe::SetFlowEntry(Pipe::Direction dir)
+Pipe::Direction Pipe::GetExitDirection(TilePiece::Type t, Pipe::Direction entry)
 {
-	bool ret(false);
-
-	if (IsEmpty())
+	switch (t)
 	{
-		switch (m_type)
-		{
-		case TYPE_VERTICAL:
-			if (dir == DIR_N)
-			{
-				m_flowDirection = DIR_S;
-				ret = true;
+	case TYPE_VERTICAL:
+		if (entry == DIR_N)
+			return DIR_S;
+		if (entry == DIR_S)
+			return DIR_N;
+		break;
 
-			}
-			else if (dir == DIR_S)
-			{
-				m_flowDirection = DIR_N;
-				ret = true;
-			}
-			break;
+	case TYPE_HORIZONTAL:
+		if (entry == DIR_E)
+			return DIR_W;
+		if (entry == DIR_W)
+			return DIR_E;
+		break;
 
-		case TYPE_HORIZONTAL:
-			if (dir == DIR_E)
-			{
-				m_flowDirection = DIR_W;
-				ret = true;
+	case TYPE_NW_ELBOW:
+		if (entry == DIR_N)
+			return DIR_W;
+		if (entry == DIR_W)
+			return DIR_N;
+		break;
 
-			}
-			else if (dir == DIR_W)
-			{
-				m_flowDirection = DIR_E;
-				ret = true;
-			}
-			break;
+	case TYPE_NE_ELBOW:
+		if (entry == DIR_N)
+			return DIR_E;
+		if (entry == DIR_E)
+			return DIR_N;
+		break;
 
-		case TYPE_NW_ELBOW:
-			if (dir == DIR_N)
-			{
-				m_flowDirection = DIR_W;
-				ret = true;
+	case TYPE_SE_ELBOW:
+		if (entry == DIR_S)
+			return DIR_E;
+		if (entry == DIR_E)
+			return DIR_S;
+		break;
 
-			}
-			else if (dir == DIR_W)
-			{
-				m_flowDirection = DIR_N;
-				ret = true;
-			}
-			break;
+	case TYPE_SW_ELBOW:
+		if (entry == DIR_S)
+			return DIR_W;
+		if (entry == DIR_W)
+			return DIR_S;
+		break;
 
-		case TYPE_NE_ELBOW:
-			if (dir == DIR_N)
-			{
-				m_flowDirection = DIR_E;
-				ret = true;
+	case TYPE_CROSS:
+		// Ooze flows straight through either way of a Cross-Pipe.
+		return GetOppositeDirection(entry);
+
+	case TYPE_NES_TEE:
+	case TYPE_ESW_TEE:
+	case TYPE_SWN_TEE:
+	case TYPE_WNE_TEE:
+	case TYPE_SPLITTER:
+		{
+			// Junctions have several exits, the first of which counts as the main one.
+			Pipe::Direction exits[MAX_NUM_EXITS];
+			if (GetExitDirections(t, entry, exits) > 0)
+				return exits[0];
+		}
+		break;
 
-			}
-			else if (dir == DIR_E)
-			{
-				m_flowDirection = DIR_N;
-				ret = true;
-			}
-			break;
+	default:
+		// Starter pipes and empty tiles can't be entered.
+		break;
+	}
 
-		case TYPE_SE_ELBOW:
-			if (dir == DIR_S)
-			{
-				m_flowDirection = DIR_E;
-				ret = true;
+	return DIR_NONE;
+}
 
-			}
-			else if (dir == DIR_E)
-			{
-				m_flowDirection = DIR_S;
-				ret = true;
-			}
-			break;
+int Pipe::GetExitDirections(TilePiece::Type t, Pipe::Direction entry, Pipe::Direction* exits)
+{
+	if (!Junction::IsJunction(t))
+	{
+		exits[0] = GetExitDirection(t, entry);
+		return (exits[0] != DIR_NONE) ? 1 : 0;
+	}
 
-		case TYPE_SW_ELBOW:
-			if (dir == DIR_S)
-			{
-				m_flowDirection = DIR_W;
-				ret = true;
+	// Ooze leaves a junction through every opening but the one it came in through.
+	if ((entry == DIR_NONE) || !HasOpening(t, entry))
+		return 0;
 
-			}
-			else if (dir == DIR_W)
-			{
-				m_flowDirection = DIR_S;
-				ret = true;
-			}
-			break;
+	int numExits(0);
+	for (Pipe::Direction dir : ALL_DIRECTIONS)
+	{
+		if ((dir != entry) && HasOpening(t, dir))
+			exits[numExits++] = dir;
+	}
 
-		case TYPE_CROSS:
-			assert(false); 
-			break;
+	return numExits;
+}
 
-		default:
-			break;
+bool Pipe::SetFlowEntry(Pipe::Direction dir)
+{
+	// Cross-Pipes override this method.
+	assert(m_type != TYPE_CROSS);
+
+	bool ret(false);
+
+	if (IsEmpty())
+	{
+		Pipe::Direction exitDir = GetExitDirection(m_type, dir);
+		if (exitDir != DIR_NONE)
+		{
+			m_flowDirection = exitDir;
+			ret = true;
 		}
 	}
 
@@ -358,6 +403,11 @@ int Pipe::PopExplosion()
 	return m_exploding;
 }
 
+int Pipe::GetExplosion() const
+{
+	return m_exploding;
+}
+
 int Pipe::GetScoreValue() const
 {
 	switch (m_type)
@@ -392,27 +442,39 @@ int Pipe::GetScoreValue() const
 *****************************************************************/
 
 
-Cross::Cross()
+Cross::Cross(Randomizer* rand)
 	: Pipe(TilePiece::TYPE_CROSS),
-	m_horizOozeLevel(0.0f),
-	m_vertOozeLevel(0.0f),
+	m_horizOozeLevel(MIN_OOZE_LEVEL),
+	m_vertOozeLevel(MIN_OOZE_LEVEL),
 	m_horizWayFree(true),
 	m_vertWayFree(true)
 {
 	// Randomly determine whether the horizontal component of the cross should go on the
 	// foreground, of the vertical one. This is just for cosmetic flavor.
-	Randomizer* rand = Randomizer::GetInstance();
+	if (rand == nullptr)
+		rand = Randomizer::GetInstance();
+
 	m_backgroundWay = static_cast<Way>(rand->GetWithinRange(WAY_VERTICAL, WAY_HORIZONTAL));
 }
 
-float Cross::Pump(float amount)
+Cross::Cross(Cross::Way backgroundWay)
+	: Pipe(TilePiece::TYPE_CROSS),
+	m_horizOozeLevel(MIN_OOZE_LEVEL),
+	m_vertOozeLevel(MIN_OOZE_LEVEL),
+	m_horizWayFree(true),
+	m_vertWayFree(true),
+	m_backgroundWay(backgroundWay)
+{
+}
+
+int Cross::Pump(int amount)
 {
 	if ((m_flowDirection == DIR_E) ||
 		(m_flowDirection == DIR_W))
 	{
 		assert(m_horizOozeLevel < MAX_OOZE_LEVEL);
 
-		m_horizOozeLevel += amount;
+		m_horizOozeLevel = static_cast<std::uint16_t>(std::min(m_horizOozeLevel + amount, MAX_OOZE_LEVEL));
 		if (m_horizOozeLevel >= MAX_OOZE_LEVEL)
 			m_horizWayFree = false;
 
@@ -424,7 +486,7 @@ float Cross::Pump(float amount)
 	{
 		assert(m_vertOozeLevel < MAX_OOZE_LEVEL);
 
-		m_vertOozeLevel += amount;
+		m_vertOozeLevel = static_cast<std::uint16_t>(std::min(m_vertOozeLevel + amount, MAX_OOZE_LEVEL));
 		if (m_vertOozeLevel >= MAX_OOZE_LEVEL)
 			m_vertWayFree = false;
 
@@ -432,10 +494,10 @@ float Cross::Pump(float amount)
 	}
 
 	assert(false);
-	return 0.0f;
+	return MIN_OOZE_LEVEL;
 }
 
-float Cross::GetOozeLevel(Cross::Way w) const
+int Cross::GetOozeLevel(Cross::Way w) const
 {
 	if (w == WAY_HORIZONTAL)
 		return m_horizOozeLevel;
@@ -443,6 +505,16 @@ float Cross::GetOozeLevel(Cross::Way w) const
 	return m_vertOozeLevel;
 }
 
+void Cross::SetOozeLevel(Cross::Way w, int level)
+{
+	assert((level >= MIN_OOZE_LEVEL) && (level <= MAX_OOZE_LEVEL));
+
+	if (w == WAY_HORIZONTAL)
+		m_horizOozeLevel = static_cast<std::uint16_t>(level);
+	else
+		m_vertOozeLevel = static_cast<std::uint16_t>(level);
+}
+
 bool Cross::IsFull() const
 {
 	if ((m_flowDirection == DIR_E) ||
@@ -514,3 +586,47 @@ Cross::Way Cross::GetBackgroundWay() const
 {
 	return m_backgroundWay;
 }
+
+
+/****************************************************************
+* Junction
+*****************************************************************/
+
+
+Junction::Junction(TilePiece::Type t)
+	: Pipe(t),
+	m_entryDirection(DIR_NONE)
+{
+	assert(IsJunction(t));
+}
+
+bool Junction::SetFlowEntry(Pipe::Direction dir)
+{
+	Pipe::Direction exits[MAX_NUM_EXITS];
+	if (!IsEmpty() || (GetExitDirections(m_type, dir, exits) == 0))
+		return false;
+
+	m_entryDirection = dir;
+	m_flowDirection = exits[0];
+
+	return true;
+}
+
+Pipe::Direction Junction::GetEntryDirection() const
+{
+	return m_entryDirection;
+}
+
+int Junction::GetScoreValue() const
+{
+	if (!IsFull())
+		return 0;
+
+	Pipe::Direction exits[MAX_NUM_EXITS];
+	return JUNCTION_SCORE_VALUE_PER_EXIT * GetExitDirections(m_type, m_entryDirection, exits);
+}
+
+bool Junction::IsJunction(TilePiece::Type t)
+{
+	return ((t >= TYPE_NES_TEE) && (t <= TYPE_SPLITTER));
+}
@@ -30,11 +30,24 @@ SOFTWARE.
 
 #pragma once
 
+#include <cstdint>
+
+
+// ---- Forward declarations ----
+
+class Randomizer;
+
 
 // ---- Helper types and constants ----
 
-static constexpr float MAX_OOZE_LEVEL = 100.0f;
-static constexpr float MIN_OOZE_LEVEL = 0.0f;
+/**
+ * Ooze levels and amounts are integers in fixed point, so that the Ooze flows exactly the same way with
+ * every compiler, build flag and platform, which replays, checksums and lockstep games rely on. 
+ * One percent of a pipe is OOZE_PER_PERCENT units, and a full pipe fits into 16 bits.
+ */
+static constexpr int OOZE_PER_PERCENT = 100;
+static constexpr int MAX_OOZE_LEVEL = 100 * OOZE_PER_PERCENT;
+static constexpr int MIN_OOZE_LEVEL = 0;
 
 
 // ---- Class definition ----
@@ -55,6 +68,11 @@ public:
 	 */
 	static const int CROSS_PIPE_SCORE_VALUE;
 
+	/**
+	 * Score value of a full T-junction or splitter, for each opening through which the Ooze flows on.
+	 */
+	static const int JUNCTION_SCORE_VALUE_PER_EXIT;
+
 
 	/**
 	 * Types of TilePiece.
@@ -73,6 +91,11 @@ public:
 		TYPE_SE_ELBOW,
 		TYPE_SW_ELBOW,
 		TYPE_CROSS,
+		TYPE_NES_TEE,
+		TYPE_ESW_TEE,
+		TYPE_SWN_TEE,
+		TYPE_WNE_TEE,
+		TYPE_SPLITTER,
 		TYPE_MAX
 	};
 
@@ -82,7 +105,15 @@ public:
 
 	virtual ~TilePiece();
 
-	static TilePiece* CreateTile(Type t = TilePiece::TYPE_NONE);
+	/**
+	 * Create a new tile of the given type.
+	 *
+	 * @param t		Type of the tile to create.
+	 * @param rand	Randomizer used for any random properties of the tile. 
+	 *				If null, the Randomizer singleton is used.
+	 * @return	The new tile. The caller takes ownership.
+	 */
+	static TilePiece* CreateTile(Type t = TilePiece::TYPE_NONE, Randomizer* rand = nullptr);
 
 	Type GetType() const;
 
@@ -121,9 +152,23 @@ public:
 
 	virtual ~Pipe();
 
-	virtual float Pump(float amount);
+	/**
+	 * Pump Ooze into the pipe. The level stops at MAX_OOZE_LEVEL, the excess is lost.
+	 *
+	 * @param amount	Amount of Ooze, in fixed point units. See OOZE_PER_PERCENT.
+	 * @return	The new fill level.
+	 */
+	virtual int Pump(int amount);
 
-	float GetOozeLevel() const;
+	int GetOozeLevel() const;
+
+	/**
+	 * Overwrite the Ooze fill level, bypassing the game rules of Pump().
+	 * Only meant for copies of pipes which are drawn in between two ticks of the game clock.
+	 *
+	 * @param level		The new fill level.
+	 */
+	void SetOozeLevel(int level);
 
 	virtual bool IsFull() const;
 
@@ -131,8 +176,39 @@ public:
 
 	bool HasOpening(Pipe::Direction dir) const;
 
+	/**
+	 * Check whether pipes of the given type have an opening on the given side.
+	 */
+	static bool HasOpening(TilePiece::Type t, Pipe::Direction dir);
+
 	static Pipe::Direction GetOppositeDirection(Pipe::Direction dir);
 
+	/**
+	 * Get the opening through which Ooze would leave a pipe of the given type,
+	 * after having entered it through the given opening.
+	 *
+	 * @param t		Type of the pipe.
+	 * @param entry	Opening through which the Ooze enters the pipe.
+	 * @return	The exit opening, or DIR_NONE if Ooze cannot enter the pipe that way.
+	 */
+	static Pipe::Direction GetExitDirection(TilePiece::Type t, Pipe::Direction entry);
+
+	/**
+	 * Largest number of openings through which Ooze can leave a pipe at once, see GetExitDirections().
+	 */
+	static constexpr int MAX_NUM_EXITS = 3;
+
+	/**
+	 * Get all openings through which Ooze would leave a pipe of the given type, after having entered it 
+	 * through the given opening. Junctions have several, all other pipes have one at most.
+	 *
+	 * @param t		Type of the pipe.
+	 * @param entry	Opening through which the Ooze enters the pipe.
+	 * @param exits	Returns the exit openings, in the order of Pipe::Direction. Room for MAX_NUM_EXITS is needed.
+	 * @return	The number of exit openings. 0 if Ooze cannot enter the pipe that way.
+	 */
+	static int GetExitDirections(TilePiece::Type t, Pipe::Direction entry, Pipe::Direction* exits);
+
 	virtual bool SetFlowEntry(Pipe::Direction dir);
 
 	virtual Pipe::Direction GetFlowDirection() const;
@@ -141,13 +217,20 @@ public:
 
 	int PopExplosion();
 
+	/**
+	 * Get the remaining duration of the explosion on this pipe, without counting it down.
+	 *
+	 * @return	Number of frames until the explosion is over. 0 if not exploding.
+	 */
+	int GetExplosion() const;
+
 	int GetScoreValue() const override;
 
 protected:
 	/**
 	 * TODO
 	 */
-	float m_oozeLevel;
+	std::uint16_t m_oozeLevel;
 
 	/**
 	 * TODO
@@ -177,11 +260,32 @@ public:
 		WAY_HORIZONTAL
 	};
 
-	Cross();
+	/**
+	 * Class constructor.
+	 *
+	 * @param rand	Randomizer used to pick the background way. If null, the Randomizer singleton is used.
+	 */
+	Cross(Randomizer* rand = nullptr);
+
+	/**
+	 * Class constructor, for a Cross-Pipe with a known background way.
+	 *
+	 * @param backgroundWay	Which way, WAY_VERTICAL or WAY_HORIZONTAL, will be drawn on the background.
+	 */
+	Cross(Way backgroundWay);
+
+	int Pump(int amount) override;
 
-	float Pump(float amount) override;
+	int GetOozeLevel(Way w) const;
 
-	float GetOozeLevel(Way w) const;
+	/**
+	 * Overwrite the Ooze fill level of either way, bypassing the game rules of Pump().
+	 * Only meant for copies of pipes which are drawn in between two ticks of the game clock.
+	 *
+	 * @param w			WAY_VERTICAL or WAY_HORIZONTAL.
+	 * @param level		The new fill level.
+	 */
+	void SetOozeLevel(Way w, int level);
 
 	bool IsFull() const override;
 
@@ -198,13 +302,13 @@ protected:
 	 * Replaces Pipe::m_oozeLevel, and keeps track of the Ooze fill level within
 	 * the horizontal part of the Cross-Pipe.
 	 */
-	float m_horizOozeLevel;
+	std::uint16_t m_horizOozeLevel;
 
 	/**
 	 * Replaces Pipe::m_oozeLevel, and keeps track of the Ooze fill level within
 	 * the vertical part of the Cross-Pipe.
 	 */
-	float m_vertOozeLevel;
+	std::uint16_t m_vertOozeLevel;
 
 	bool m_horizWayFree;
 	bool m_vertWayFree;
@@ -214,4 +318,34 @@ protected:
 	 * on the background. The second way, will then appear on the foreground. 
 	 */
 	Way m_backgroundWay;
+};
+
+/**
+ * Class which represents pipes where the Ooze forks: T-junctions and splitters. The Ooze fills the pipe
+ * through one opening, and once it is full, flows on through all other openings at once. 
+ * GetFlowDirection() returns the first of those, see GetExitDirections().
+ */
+class Junction : public Pipe
+{
+public:
+	Junction(TilePiece::Type t);
+
+	bool SetFlowEntry(Pipe::Direction dir) override;
+
+	/**
+	 * Get the opening through which the Ooze entered the pipe.
+	 *
+	 * @return	The entry opening, or DIR_NONE if the Ooze has not reached the pipe yet.
+	 */
+	Pipe::Direction GetEntryDirection() const;
+
+	int GetScoreValue() const override;
+
+	/**
+	 * Check whether pipes of the given type are junctions.
+	 */
+	static bool IsJunction(TilePiece::Type t);
+
+protected:
+	Pipe::Direction m_entryDirection;
 };
\ No newline at end of file
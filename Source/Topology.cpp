@@ -0,0 +1,95 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "Topology.h"
+
+
+// ---- Helper types and constants ----
+
+/**
+ * Number of entries in Pipe::Direction, including DIR_NONE.
+ */
+static constexpr int NUM_DIRECTIONS = Pipe::DIR_W + 1;
+
+/**
+ * Step in columns and rows towards each Pipe::Direction, indexed by the direction.
+ */
+static constexpr int COL_STEPS[NUM_DIRECTIONS] = { 0, 0, 0, 1, -1 };
+static constexpr int ROW_STEPS[NUM_DIRECTIONS] = { 0, -1, 1, 0, 0 };
+
+/**
+ * Fill the neighbor table of either the columns or the rows.
+ *
+ * @param kind		Layout of the board.
+ * @param size		Number of columns, or of rows.
+ * @param steps		COL_STEPS or ROW_STEPS.
+ * @param table		Table to fill, with NUM_DIRECTIONS * size entries.
+ */
+static void FillTable(Topology::Kind kind, int size, const int* steps, std::vector<int>& table)
+{
+	table.resize(NUM_DIRECTIONS * size);
+	for (int dir = 0; dir < NUM_DIRECTIONS; dir++)
+	{
+		for (int pos = 0; pos < size; pos++)
+		{
+			int next = pos + steps[dir];
+			if (kind == Topology::KIND_TOROIDAL)
+				next = (next + size) % size;
+			else if ((next < 0) || (next >= size))
+				next = -1;
+
+			table[(dir * size) + pos] = next;
+		}
+	}
+}
+
+
+// ---- Class Implementation ----
+
+Topology::Topology(Topology::Kind kind, int numCols, int numRows)
+	: m_kind(kind),
+	m_numCols(numCols),
+	m_numRows(numRows)
+{
+	FillTable(m_kind, m_numCols, COL_STEPS, m_nextCols);
+	FillTable(m_kind, m_numRows, ROW_STEPS, m_nextRows);
+}
+
+Topology::Kind Topology::GetKind() const
+{
+	return m_kind;
+}
+
+void Topology::GetStep(Pipe::Direction dir, int& colStep, int& rowStep)
+{
+	colStep = COL_STEPS[dir];
+	rowStep = ROW_STEPS[dir];
+}
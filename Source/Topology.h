@@ -0,0 +1,118 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <vector>
+#include "TilePiece.h"
+
+
+// ---- Class Definition ----
+
+/**
+ * How the tiles of a board connect to each other: which tile lies next to a given one in each Pipe::Direction,
+ * and where the board has edges. The neighbors are precomputed into tables, one entry per column and direction 
+ * and one per row and direction, so that following the ooze takes two lookups whatever the layout, instead of
+ * branching on the direction and on the edges. Since columns and rows are looked up separately, the tables stay 
+ * small even for endless boards. Pipes only have the four openings of Pipe::Direction, so only rectangular 
+ * and toroidal boards are supported.
+ */
+class Topology
+{
+public:
+	/**
+	 * Supported layouts.
+	 */
+	enum Kind
+	{
+		KIND_RECTANGULAR = 0,	//< The board ends at its edges. Ooze flowing over an edge spills.
+		KIND_TOROIDAL,			//< Opposite edges are joined: ooze flowing over one edge comes back in at the other.
+		KIND_MAX
+	};
+
+	/**
+	 * Class constructor.
+	 *
+	 * @param kind		Layout of the board.
+	 * @param numCols	Number of columns on the board.
+	 * @param numRows	Number of rows on the board.
+	 */
+	Topology(Kind kind, int numCols, int numRows);
+
+	Kind GetKind() const;
+
+	/**
+	 * Move the given coordinates to the neighboring tile in the given direction.
+	 *
+	 * @param col	Column of a tile on the board. Overwritten with the neighbor's column.
+	 * @param row	Row of a tile on the board. Overwritten with the neighbor's row.
+	 * @param dir	Direction of the neighbor. DIR_NONE leaves the coordinates as they are.
+	 * @return	False if there is no neighbor in that direction, i.e. beyond the edge of a rectangular board. 
+	 *			The coordinates are left untouched then.
+	 */
+	bool StepTowards(int& col, int& row, Pipe::Direction dir) const
+	{
+		int nextCol = m_nextCols[(dir * m_numCols) + col];
+		int nextRow = m_nextRows[(dir * m_numRows) + row];
+		if ((nextCol < 0) || (nextRow < 0))
+			return false;
+
+		col = nextCol;
+		row = nextRow;
+		return true;
+	}
+
+	/**
+	 * Get the step in columns and rows towards the given direction. This is also the direction in which 
+	 * a tile's neighbor is drawn, on both supported layouts.
+	 *
+	 * @param dir		Direction to step towards. DIR_NONE does not move.
+	 * @param colStep	Returns -1, 0 or 1.
+	 * @param rowStep	Returns -1, 0 or 1.
+	 */
+	static void GetStep(Pipe::Direction dir, int& colStep, int& rowStep);
+
+private:
+	Kind m_kind;
+
+	int m_numCols;
+	int m_numRows;
+
+	/**
+	 * Column of the neighbor, at (dir * m_numCols) + col, or -1 if there is none.
+	 */
+	std::vector<int> m_nextCols;
+
+	/**
+	 * Row of the neighbor, at (dir * m_numRows) + row, or -1 if there is none.
+	 */
+	std::vector<int> m_nextRows;
+};
@@ -0,0 +1,121 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <atomic>
+
+
+// ---- Class Definition ----
+
+/**
+ * Lock-free triple buffer, which hands over the latest version of an object from one writer thread
+ * to one reader thread. The writer fills the back buffer and publishes it, while the reader holds on 
+ * to the front buffer for as long as it likes. Neither of them ever waits for the other: the third 
+ * buffer in the middle is swapped atomically, and versions the reader never picked up are overwritten.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+	/**
+	 * Class constructor. 
+	 */
+	TripleBuffer()
+		: m_middle(2)
+	{
+
+	}
+
+	/**
+	 * Get the buffer to fill. Only to be called by the writer thread.
+	 */
+	T& GetBackBuffer()
+	{
+		return m_buffers[m_back];
+	}
+
+	/**
+	 * Hand over the back buffer to the reader, and get a new back buffer in return.
+	 * Only to be called by the writer thread.
+	 */
+	void Publish()
+	{
+		int previous = m_middle.exchange(m_back | FRESH_BIT, std::memory_order_acq_rel);
+		m_back = (previous & INDEX_MASK);
+	}
+
+	/**
+	 * Get the latest published buffer. It remains untouched by the writer until Acquire() is called again.
+	 * Only to be called by the reader thread.
+	 *
+	 * @param fresh		Optional, set to true if a new buffer was published since the last call.
+	 * @return	The front buffer.
+	 */
+	const T& Acquire(bool* fresh = nullptr)
+	{
+		bool isFresh = ((m_middle.load(std::memory_order_acquire) & FRESH_BIT) != 0);
+		if (isFresh)
+		{
+			int previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+			m_front = (previous & INDEX_MASK);
+		}
+
+		if (fresh != nullptr)
+			*fresh = isFresh;
+
+		return m_buffers[m_front];
+	}
+
+private:
+	/**
+	 * Set on the middle index when it holds a buffer the reader has not picked up yet.
+	 */
+	static constexpr int FRESH_BIT = 0x4;
+	static constexpr int INDEX_MASK = 0x3;
+
+	T m_buffers[3];
+
+	/**
+	 * Index of the back buffer, only used by the writer.
+	 */
+	int m_back = 0;
+
+	/**
+	 * Index of the front buffer, only used by the reader.
+	 */
+	int m_front = 1;
+
+	/**
+	 * Index of the buffer in the middle, plus FRESH_BIT.
+	 */
+	std::atomic<int> m_middle;
+};
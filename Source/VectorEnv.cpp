@@ -0,0 +1,236 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "VectorEnv.h"
+#include "Board.h"
+#include "Queue.h"
+#include "Randomizer.h"
+#include <cstring>
+#include <cassert>
+#include <algorithm>
+
+
+// ---- Helper types and constants ----
+
+const int VectorEnv::NUM_TILE_TYPES(TilePiece::TYPE_CROSS + 1);
+
+/**
+ * Added to the seed for every new round of a game, so that consecutive rounds differ.
+ */
+static const unsigned int EPISODE_SEED_STRIDE(0x9E3779B9u);
+
+/**
+ * Value of the observation bytes which are "on".
+ */
+static const unsigned char OBS_ON(255);
+
+
+// ---- Class Implementation ----
+
+VectorEnv::Game::Game(unsigned int s, const Config& config)
+	: randomizer(new Randomizer(s)),
+	board(new Board(config.numCols, config.numRows, randomizer.get())),
+	queue(new Queue(config.queueSize, randomizer.get())),
+	countdown(config.countdown),
+	seed(s),
+	episode(0)
+{
+
+}
+
+VectorEnv::Game::~Game()
+{
+	// Board and Queue hold on to the Randomizer, delete them first.
+	queue.reset();
+	board.reset();
+}
+
+VectorEnv::VectorEnv(int numEnvs)
+	: VectorEnv(numEnvs, Config())
+{
+
+}
+
+VectorEnv::VectorEnv(int numEnvs, const Config& config)
+	: m_config(config),
+	m_workers(config.numThreads)
+{
+	m_numCells = m_config.numCols * m_config.numRows;
+	m_observationSize = ((NUM_TILE_TYPES + 2) * m_numCells) + (m_config.queueSize * NUM_TILE_TYPES) + 2;
+
+	m_games.reserve(numEnvs);
+	for (int i = 0; i < numEnvs; i++)
+		m_games.emplace_back(new Game(static_cast<unsigned int>(i), m_config));
+}
+
+VectorEnv::~VectorEnv()
+{
+
+}
+
+int VectorEnv::GetNumEnvs() const
+{
+	return static_cast<int>(m_games.size());
+}
+
+int VectorEnv::GetObservationSize() const
+{
+	return m_observationSize;
+}
+
+int VectorEnv::GetNumActions() const
+{
+	return m_numCells + 1;
+}
+
+void VectorEnv::Reset(const unsigned int* seeds, unsigned char* observations)
+{
+	m_workers.ParallelFor(GetNumEnvs(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			Game& game = *m_games[i];
+			game.episode = 0;
+			ResetGame(game, seeds[i]);
+			WriteObservation(game, observations + (static_cast<size_t>(i) * m_observationSize));
+		}
+	});
+}
+
+void VectorEnv::Step(const int* actions, unsigned char* observations, float* rewards, unsigned char* dones)
+{
+	m_workers.ParallelFor(GetNumEnvs(), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			Game& game = *m_games[i];
+			int scoreBefore = game.board->GetScoreValue();
+			bool alive = StepGame(game, actions[i]);
+
+			rewards[i] = static_cast<float>(game.board->GetScoreValue() - scoreBefore);
+			dones[i] = alive ? 0 : 1;
+
+			// Start the next round right away, with a seed derived from the one passed to Reset().
+			if (!alive)
+			{
+				game.episode++;
+				ResetGame(game, game.seed + (game.episode * EPISODE_SEED_STRIDE));
+			}
+
+			WriteObservation(game, observations + (static_cast<size_t>(i) * m_observationSize));
+		}
+	});
+}
+
+void VectorEnv::ResetGame(Game& game, unsigned int seed)
+{
+	if (game.episode == 0)
+		game.seed = seed;
+
+	game.randomizer->SetSeed(seed);
+	game.board->Reset();
+	game.queue->Reset();
+	game.countdown = m_config.countdown;
+}
+
+bool VectorEnv::StepGame(Game& game, int action)
+{
+	// Place the pipe in front of the queue, the same way a player's click would.
+	if ((action >= 0) && (action < m_numCells))
+	{
+		int col = action % m_config.numCols;
+		int row = action / m_config.numCols;
+		if (game.board->GetPlacement(col, row) != Board::PLACEMENT_NONE)
+			game.board->PlaceTile(col, row, game.queue->Pop());
+	}
+
+	for (int tick = 0; tick < m_config.ticksPerStep; tick++)
+	{
+		if (game.countdown > 0)
+			game.countdown--;
+
+		else if (!game.board->Pump(m_config.oozePerPump))
+			return false;
+	}
+
+	return true;
+}
+
+void VectorEnv::WriteObservation(const Game& game, unsigned char* observation) const
+{
+	std::memset(observation, 0, m_observationSize);
+
+	unsigned char* oozePlane = observation + (NUM_TILE_TYPES * m_numCells);
+	unsigned char* frontPlane = oozePlane + m_numCells;
+	unsigned char* queuePlanes = frontPlane + m_numCells;
+	unsigned char* extras = queuePlanes + (m_config.queueSize * NUM_TILE_TYPES);
+
+	const Board& board = *game.board;
+	for (int row = 0; row < m_config.numRows; row++)
+	{
+		for (int col = 0; col < m_config.numCols; col++)
+		{
+			int idx = col + (row * m_config.numCols);
+			const TilePiece* tile = board.GetTile(col, row);
+			TilePiece::Type t = tile->GetType();
+			assert(t < NUM_TILE_TYPES);
+			observation[(t * m_numCells) + idx] = OBS_ON;
+
+			// All tiles other than TYPE_NONE are created as Pipes, see TilePiece::CreateTile().
+			if (t != TilePiece::TYPE_NONE)
+			{
+				int level(MIN_OOZE_LEVEL);
+				if (t == TilePiece::TYPE_CROSS)
+				{
+					const Cross* cross = static_cast<const Cross*>(tile);
+					level = std::max(cross->GetOozeLevel(Cross::WAY_HORIZONTAL), cross->GetOozeLevel(Cross::WAY_VERTICAL));
+				}
+				else
+					level = static_cast<const Pipe*>(tile)->GetOozeLevel();
+
+				level = std::min(std::max(level, MIN_OOZE_LEVEL), MAX_OOZE_LEVEL);
+				oozePlane[idx] = static_cast<unsigned char>(((level * OBS_ON) + (MAX_OOZE_LEVEL / 2)) / MAX_OOZE_LEVEL);
+			}
+		}
+	}
+
+	int oozeCol(0);
+	int oozeRow(0);
+	board.GetOozingCoords(oozeCol, oozeRow);
+	frontPlane[oozeCol + (oozeRow * m_config.numCols)] = OBS_ON;
+
+	const Queue& queue = *game.queue;
+	for (int i = 0; i < m_config.queueSize; i++)
+		queuePlanes[(i * NUM_TILE_TYPES) + queue.GetTileType(i)] = OBS_ON;
+
+	extras[0] = static_cast<unsigned char>((m_config.countdown > 0) ? ((game.countdown * OBS_ON) / m_config.countdown) : 0);
+	extras[1] = static_cast<unsigned char>(board.GetNumBombs());
+}
@@ -0,0 +1,203 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include "WorkerPool.h"
+#include "TilePiece.h"
+
+
+// ---- Forward declarations ----
+
+class Board;
+class Queue;
+class Randomizer;
+
+
+// ---- Class Definition ----
+
+/**
+ * Environment for training placement policies, which steps many independent games in lockstep.
+ * Each game owns its own Board, Queue and Randomizer, so that games are reproducible from their
+ * seed and can be stepped in parallel across all CPU cores. It does not depend on JUCE.
+ *
+ * Observations are written into a contiguous, caller-provided buffer of GetNumEnvs() * GetObservationSize()
+ * bytes, one block per game, laid out as follows (numCells = numCols * numRows, cells indexed by col + (row * numCols)):
+ *	- NUM_TILE_TYPES planes of numCells bytes: one-hot tile type, 255 where the tile is of that type.
+ *	- One plane of numCells bytes: ooze level of each tile, scaled from 0 to 255.
+ *	- One plane of numCells bytes: 255 on the pipe ooze is currently flowing into.
+ *	- queueSize * NUM_TILE_TYPES bytes: one-hot type of each pipe in the queue, front of the queue first.
+ *	- One byte: countdown until the ooze starts flowing, scaled from 255 (just started) to 0.
+ *	- One byte: number of bombs left.
+ */
+class VectorEnv
+{
+public:
+	/**
+	 * Number of tile types told apart by the observations: TilePiece::TYPE_NONE up to TilePiece::TYPE_CROSS.
+	 * The games are played without junctions, so the observation layout stays the same as new types get added.
+	 */
+	static const int NUM_TILE_TYPES;
+
+	/**
+	 * Rules shared by all games in the environment. Defaults are those of the first level.
+	 */
+	struct Config
+	{
+		int numCols = 10;
+		int numRows = 7;
+		int queueSize = 5;
+
+		/**
+		 * Ooze pumped into the pipes at every tick, once the countdown is over, in fixed point units (see OOZE_PER_PERCENT).
+		 */
+		int oozePerPump = 1 * OOZE_PER_PERCENT;
+
+		/**
+		 * Number of ticks until the ooze starts flowing.
+		 */
+		int countdown = 320;
+
+		/**
+		 * Number of ticks simulated by each call to Step(). The default matches the number 
+		 * of ticks a player has to wait between two placements in the game.
+		 */
+		int ticksPerStep = 5;
+
+		/**
+		 * Number of threads used to step the games. If 0, one thread per CPU core is used.
+		 */
+		int numThreads = 0;
+	};
+
+	/**
+	 * Class constructor, using the default Config.
+	 *
+	 * @param numEnvs	Number of independent games to step in lockstep.
+	 */
+	VectorEnv(int numEnvs);
+
+	/**
+	 * Class constructor.
+	 *
+	 * @param numEnvs	Number of independent games to step in lockstep.
+	 * @param config	Rules shared by all games.
+	 */
+	VectorEnv(int numEnvs, const Config& config);
+
+	/**
+	 * Class destructor.
+	 */
+	~VectorEnv();
+
+	int GetNumEnvs() const;
+
+	/**
+	 * Get the number of bytes of the observation of a single game.
+	 */
+	int GetObservationSize() const;
+
+	/**
+	 * Get the number of possible actions per game. Actions 0 to numCells - 1 place the pipe in front
+	 * of the queue on the tile at index col + (row * numCols). Action numCells does nothing.
+	 */
+	int GetNumActions() const;
+
+	/**
+	 * Start a new round on every game.
+	 *
+	 * @param seeds			GetNumEnvs() seeds, one per game.
+	 * @param observations	Returns the initial observation of every game.
+	 */
+	void Reset(const unsigned int* seeds, unsigned char* observations);
+
+	/**
+	 * Perform one action on every game, then simulate Config::ticksPerStep ticks. Actions which are 
+	 * not allowed by the game rules (see Board::GetPlacement()) do nothing. Games in which the ooze 
+	 * spills are restarted right away with a new seed, and the observation returned for them is the 
+	 * first one of the new round.
+	 *
+	 * @param actions		GetNumEnvs() actions, one per game, see GetNumActions().
+	 * @param observations	Returns the observation of every game after the step.
+	 * @param rewards		Returns the score points gained by every game during the step.
+	 * @param dones			Returns 1 for every game in which the ooze spilled during the step, 0 otherwise.
+	 */
+	void Step(const int* actions, unsigned char* observations, float* rewards, unsigned char* dones);
+
+private:
+	/**
+	 * State of a single game.
+	 */
+	struct Game
+	{
+		Game(unsigned int seed, const Config& config);
+		~Game();
+
+		std::unique_ptr<Randomizer> randomizer;
+		std::unique_ptr<Board> board;
+		std::unique_ptr<Queue> queue;
+
+		int countdown;
+		unsigned int seed;
+
+		/**
+		 * Number of rounds played since the last call to Reset(), used to derive new seeds.
+		 */
+		unsigned int episode;
+	};
+
+	/**
+	 * Start a new round on the given game.
+	 */
+	void ResetGame(Game& game, unsigned int seed);
+
+	/**
+	 * Perform one action on the given game, then simulate Config::ticksPerStep ticks.
+	 *
+	 * @return	False if the ooze spilled.
+	 */
+	bool StepGame(Game& game, int action);
+
+	/**
+	 * Write the observation of the given game, see class description for its layout.
+	 */
+	void WriteObservation(const Game& game, unsigned char* observation) const;
+
+	Config m_config;
+	int m_numCells;
+	int m_observationSize;
+
+	std::vector<std::unique_ptr<Game>> m_games;
+
+	WorkerPool m_workers;
+};
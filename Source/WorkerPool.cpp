@@ -0,0 +1,145 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#include "WorkerPool.h"
+#include <algorithm>
+
+
+// ---- Helper types and constants ----
+
+/**
+ * Number of chunks per thread each job is split into, so that threads which finish early can help out.
+ */
+static const int CHUNKS_PER_THREAD(4);
+
+
+// ---- Class Implementation ----
+
+WorkerPool::WorkerPool(int numThreads)
+	: m_nextItem(0)
+{
+	if (numThreads <= 0)
+		numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+	// The thread calling ParallelFor() takes part as well.
+	for (int i = 0; i < numThreads - 1; i++)
+		m_threads.emplace_back(&WorkerPool::WorkerLoop, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_exit = true;
+	}
+
+	m_wakeCondition.notify_all();
+
+	for (std::thread& t : m_threads)
+		t.join();
+}
+
+int WorkerPool::GetNumThreads() const
+{
+	return static_cast<int>(m_threads.size()) + 1;
+}
+
+void WorkerPool::ParallelFor(int numItems, const Job& job)
+{
+	if (numItems <= 0)
+		return;
+
+	// Not worth waking up any workers.
+	if (m_threads.empty() || (numItems == 1))
+	{
+		job(0, numItems);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_job = &job;
+		m_numItems = numItems;
+		m_chunkSize = std::max(1, numItems / (GetNumThreads() * CHUNKS_PER_THREAD));
+		m_nextItem = 0;
+		m_numBusyWorkers = static_cast<int>(m_threads.size());
+		m_generation++;
+	}
+
+	m_wakeCondition.notify_all();
+
+	RunChunks();
+
+	// Wait for the workers to finish their last chunks.
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [this] { return (m_numBusyWorkers == 0); });
+	m_job = nullptr;
+}
+
+void WorkerPool::WorkerLoop()
+{
+	unsigned int lastGeneration(0);
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeCondition.wait(lock, [&] { return (m_exit || (m_generation != lastGeneration)); });
+
+			if (m_exit)
+				return;
+
+			lastGeneration = m_generation;
+		}
+
+		RunChunks();
+
+		bool lastWorker(false);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_numBusyWorkers--;
+			lastWorker = (m_numBusyWorkers == 0);
+		}
+
+		if (lastWorker)
+			m_doneCondition.notify_one();
+	}
+}
+
+void WorkerPool::RunChunks()
+{
+	int begin = m_nextItem.fetch_add(m_chunkSize);
+	while (begin < m_numItems)
+	{
+		(*m_job)(begin, std::min(begin + m_chunkSize, m_numItems));
+		begin = m_nextItem.fetch_add(m_chunkSize);
+	}
+}
@@ -0,0 +1,125 @@
+/*
+===============================================================================
+
+Copyright (C) 2021 Bernardo Escalona. All Rights Reserved.
+
+  This file is part of Pipe Dreamer, found at:
+  https://github.com/escalonely/PipeDreamer
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===============================================================================
+*/
+
+
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+
+// ---- Class Definition ----
+
+/**
+ * Small pool of worker threads used to split batches of independent games across all CPU cores.
+ * It does not depend on JUCE, so it can be used by offline tools as well as by the game itself.
+ * ParallelFor() must not be called from more than one thread at a time.
+ */
+class WorkerPool
+{
+public:
+	/**
+	 * Function processing all items in the range [begin, end).
+	 */
+	typedef std::function<void(int begin, int end)> Job;
+
+	/**
+	 * Class constructor.
+	 *
+	 * @param numThreads	Number of threads taking part in ParallelFor(), including the calling thread.
+	 *						If 0, one thread per CPU core is used.
+	 */
+	WorkerPool(int numThreads = 0);
+
+	/**
+	 * Class destructor. Stops and joins all worker threads.
+	 */
+	~WorkerPool();
+
+	/**
+	 * Get the number of threads taking part in ParallelFor(), including the calling thread.
+	 */
+	int GetNumThreads() const;
+
+	/**
+	 * Process numItems items, split in chunks across all threads of the pool. 
+	 * The calling thread processes chunks as well, and only returns once all items are done.
+	 *
+	 * @param numItems	Total number of items to process.
+	 * @param job		Function to call for each chunk of items.
+	 */
+	void ParallelFor(int numItems, const Job& job);
+
+private:
+	/**
+	 * Main loop of each worker thread.
+	 */
+	void WorkerLoop();
+
+	/**
+	 * Claim and process chunks of the current job, until none are left.
+	 */
+	void RunChunks();
+
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_mutex;
+	std::condition_variable m_wakeCondition;
+	std::condition_variable m_doneCondition;
+
+	/**
+	 * Job currently being processed. Only valid during ParallelFor().
+	 */
+	const Job* m_job = nullptr;
+
+	int m_numItems = 0;
+	int m_chunkSize = 1;
+
+	/**
+	 * Index of the first item which has not been claimed by any thread yet.
+	 */
+	std::atomic<int> m_nextItem;
+
+	/**
+	 * Number of worker threads which have not finished the current job yet.
+	 */
+	int m_numBusyWorkers = 0;
+
+	/**
+	 * Incremented for every new job, so that sleeping workers know there is something to do.
+	 */
+	unsigned int m_generation = 0;
+
+	bool m_exit = false;
+};